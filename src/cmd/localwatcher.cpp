@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "localwatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QVarLengthArray>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace OCC {
+
+#ifdef Q_OS_LINUX
+namespace {
+    // The journal changes with every sync
+    bool isJournalFile(const QByteArray &fileName)
+    {
+        return fileName.startsWith("._sync_")
+            || fileName.startsWith(".csync_journal.db")
+            || fileName.startsWith(".sync_");
+    }
+}
+#endif
+
+LocalWatcher::LocalWatcher(const QString &root, QObject *parent)
+    : QObject(parent)
+    , _root(QDir(root).absolutePath())
+{
+#ifdef Q_OS_LINUX
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_fd == -1) {
+        qWarning() << "inotify_init1() failed:" << strerror(errno);
+        return;
+    }
+    _socket.reset(new QSocketNotifier(_fd, QSocketNotifier::Read));
+    connect(_socket.data(), &QSocketNotifier::activated, this, &LocalWatcher::slotReceivedNotification);
+
+    _isReliable = true;
+    addFolderRecursive(_root);
+#endif
+}
+
+LocalWatcher::~LocalWatcher()
+{
+#ifdef Q_OS_LINUX
+    _socket.reset();
+    if (_fd != -1) {
+        close(_fd);
+    }
+#endif
+}
+
+bool LocalWatcher::isReliable() const
+{
+    return _isReliable;
+}
+
+void LocalWatcher::addFolderRecursive(const QString &path)
+{
+    if (_pathToWatch.contains(path)) {
+        return;
+    }
+    registerPath(path);
+
+    const auto subFolders = QDir(path).entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Hidden);
+    for (const auto &subFolder : subFolders) {
+        addFolderRecursive(path + QLatin1Char('/') + subFolder);
+    }
+}
+
+void LocalWatcher::removeFoldersBelow(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    const auto pathSlash = path + QLatin1Char('/');
+    for (auto it = _pathToWatch.begin(); it != _pathToWatch.end();) {
+        if (it.key() == path || it.key().startsWith(pathSlash)) {
+            inotify_rm_watch(_fd, it.value());
+            _watchToPath.remove(it.value());
+            it = _pathToWatch.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#else
+    Q_UNUSED(path)
+#endif
+}
+
+void LocalWatcher::registerPath(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    const auto wd = inotify_add_watch(_fd, QFile::encodeName(path).constData(),
+        IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_ONLYDIR);
+    if (wd > -1) {
+        _watchToPath.insert(wd, path);
+        _pathToWatch.insert(path, wd);
+    } else if (_isReliable && (errno == ENOMEM || errno == ENOSPC)) {
+        qWarning() << "Could not watch" << path << ", the inotify watches are exhausted";
+        _isReliable = false;
+    }
+#else
+    Q_UNUSED(path)
+#endif
+}
+
+void LocalWatcher::slotReceivedNotification()
+{
+#ifdef Q_OS_LINUX
+    QVarLengthArray<char, 4096> buffer(4096);
+
+    forever {
+        const auto len = read(_fd, buffer.data(), buffer.size());
+        if (len < 0 && errno == EINVAL) {
+            // the buffer is too small for the next event
+            buffer.resize(buffer.size() * 2);
+            continue;
+        }
+        if (len <= 0) {
+            // EAGAIN once all events are read
+            return;
+        }
+
+        for (ssize_t i = 0; i + static_cast<ssize_t>(sizeof(inotify_event)) <= len;) {
+            const auto event = reinterpret_cast<const inotify_event *>(buffer.constData() + i);
+            i += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                qWarning() << "inotify event queue overflowed";
+                emit lostChanges();
+                continue;
+            }
+            if (event->len == 0 || event->wd <= -1) {
+                continue;
+            }
+            const QByteArray fileName(event->name);
+            if (isJournalFile(fileName)) {
+                continue;
+            }
+            const auto parent = _watchToPath.value(event->wd);
+            if (parent.isEmpty()) {
+                continue;
+            }
+            const auto path = parent + QLatin1Char('/') + QFile::decodeName(fileName);
+            emit pathChanged(path);
+
+            if ((event->mask & (IN_MOVED_TO | IN_CREATE)) && QFileInfo(path).isDir()) {
+                addFolderRecursive(path);
+            }
+            if (event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+                removeFoldersBelow(path);
+            }
+        }
+    }
+#endif
+}
+
+} // namespace OCC
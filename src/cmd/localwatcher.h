@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#ifndef LOCALWATCHER_H
+#define LOCALWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+class QSocketNotifier;
+
+namespace OCC {
+
+/**
+ * @brief Watches a local folder tree for changes
+ *
+ * A lean variant of the client's FolderWatcher without a dependency on
+ * Folder. Only implemented with inotify, on other systems the watcher is
+ * never reliable and the daemon rediscovers the whole folder instead.
+ *
+ * @ingroup cmd
+ */
+class LocalWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalWatcher(const QString &root, QObject *parent = nullptr);
+    ~LocalWatcher() override;
+
+    /**
+     * Returns false if changes may have been missed, for example because
+     * the inotify watches are exhausted.
+     */
+    [[nodiscard]] bool isReliable() const;
+
+signals:
+    /** Emitted with the absolute path of a changed file or directory */
+    void pathChanged(const QString &path);
+
+    /** Emitted when the watcher lost notifications */
+    void lostChanges();
+
+private:
+    void addFolderRecursive(const QString &path);
+    void removeFoldersBelow(const QString &path);
+    void registerPath(const QString &path);
+    void slotReceivedNotification();
+
+    QString _root;
+    int _fd = -1;
+    QScopedPointer<QSocketNotifier> _socket;
+    QHash<int, QString> _watchToPath;
+    QHash<QString, int> _pathToWatch;
+    bool _isReliable = false;
+};
+
+} // namespace OCC
+
+#endif // LOCALWATCHER_H
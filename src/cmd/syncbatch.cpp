@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "syncbatch.h"
+
+#include "syncengine.h"
+#include "synclimiter.h"
+
+#include <QDebug>
+
+namespace OCC {
+
+SyncBatch::SyncBatch(SyncLimiter *limiter, int restartTimes, QObject *parent)
+    : QObject(parent)
+    , _limiter(limiter)
+    , _restartTimes(restartTimes)
+{
+}
+
+void SyncBatch::addEngine(const QString &alias, SyncEngine *engine)
+{
+    _entries.push_back({ alias, engine });
+}
+
+void SyncBatch::start()
+{
+    _remaining = _entries.size();
+    if (_remaining == 0) {
+        QMetaObject::invokeMethod(this, [this] { emit finished(true); }, Qt::QueuedConnection);
+        return;
+    }
+    // _entries doesn't change anymore, the pointers to its elements stay valid
+    for (auto &entry : _entries) {
+        const auto entryPtr = &entry;
+        connect(entry.engine, &SyncEngine::finished, this, [this, entryPtr](bool success) {
+            slotSyncFinished(entryPtr, success);
+        }, Qt::QueuedConnection);
+        requestSync(entryPtr);
+    }
+}
+
+void SyncBatch::requestSync(Entry *entry)
+{
+    const auto engine = entry->engine;
+    _limiter->requestSlot([engine] {
+        // Have to be done async, else, an error before exec() does not terminate the event loop.
+        QMetaObject::invokeMethod(engine, &SyncEngine::startSync, Qt::QueuedConnection);
+    });
+}
+
+void SyncBatch::slotSyncFinished(Entry *entry, bool success)
+{
+    _limiter->releaseSlot();
+    if (entry->engine->isAnotherSyncNeeded() != NoFollowUpSync) {
+        if (entry->restartCount < _restartTimes) {
+            entry->restartCount++;
+            qDebug() << "Restarting Sync of" << entry->alias << ", because another sync is needed" << entry->restartCount;
+            requestSync(entry);
+            return;
+        }
+        qWarning() << "Another sync of" << entry->alias << "is needed, but not done because restart count is exceeded" << entry->restartCount;
+    }
+    if (!success) {
+        qWarning() << "Sync of" << entry->alias << "failed";
+        _allSucceeded = false;
+    }
+    if (--_remaining == 0) {
+        emit finished(_allSucceeded);
+    }
+}
+
+} // namespace OCC
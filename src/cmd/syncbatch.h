@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#ifndef SYNCBATCH_H
+#define SYNCBATCH_H
+
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+namespace OCC {
+
+class SyncEngine;
+class SyncLimiter;
+
+/**
+ * @brief Syncs several folders once, at most as many at a time as the limiter allows
+ *
+ * Used by nextcloudcmd --folders without --watch. A folder whose engine needs
+ * another sync is restarted up to restartTimes times, like a single folder.
+ *
+ * @ingroup cmd
+ */
+class SyncBatch : public QObject
+{
+    Q_OBJECT
+public:
+    SyncBatch(SyncLimiter *limiter, int restartTimes, QObject *parent = nullptr);
+
+    /** The engine must stay alive until finished() is emitted */
+    void addEngine(const QString &alias, SyncEngine *engine);
+
+    /** Queues the syncs of all engines with the limiter */
+    void start();
+
+signals:
+    /** Emitted once every folder is done, success is false if any of them failed */
+    void finished(bool success);
+
+private:
+    struct Entry
+    {
+        QString alias;
+        SyncEngine *engine;
+        int restartCount = 0;
+    };
+
+    void requestSync(Entry *entry);
+    void slotSyncFinished(Entry *entry, bool success);
+
+    SyncLimiter *_limiter;
+    int _restartTimes;
+    std::vector<Entry> _entries;
+    size_t _remaining = 0;
+    bool _allSucceeded = true;
+};
+
+} // namespace OCC
+
+#endif // SYNCBATCH_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "syncdaemon.h"
+
+#include "account.h"
+#include "capabilities.h"
+#include "csync_exclude.h"
+#include "filesystem.h"
+#include "networkjobs.h"
+#include "pushnotifications.h"
+#include "syncengine.h"
+#include "synclimiter.h"
+#include "common/syncjournaldb.h"
+#include "common/utility.h"
+
+#include <QDebug>
+
+namespace OCC {
+
+namespace {
+    // Collects the notifications for a burst of changes into one sync
+    constexpr auto scheduleDelay = std::chrono::seconds(1);
+    constexpr auto defaultFullLocalDiscoveryInterval = std::chrono::hours(1);
+}
+
+SyncDaemon::SyncDaemon(const AccountPtr &account, SyncEngine *engine, SyncJournalDb *journal,
+    const QString &localPath, const QString &remotePath,
+    std::chrono::seconds pollInterval, QObject *parent)
+    : QObject(parent)
+    , _account(account)
+    , _engine(engine)
+    , _journal(journal)
+    , _localPath(Utility::trailingSlashPath(localPath))
+    , _remotePath(remotePath)
+    , _watcher(localPath)
+    , _fullLocalDiscoveryInterval(defaultFullLocalDiscoveryInterval)
+{
+    const auto env = qgetenv("OWNCLOUD_FULL_LOCAL_DISCOVERY_INTERVAL");
+    if (!env.isEmpty()) {
+        _fullLocalDiscoveryInterval = std::chrono::milliseconds(env.toLongLong());
+    }
+
+    connect(_engine, &SyncEngine::finished,
+        &_localDiscoveryTracker, &LocalDiscoveryTracker::slotSyncFinished);
+    connect(_engine, &SyncEngine::itemCompleted,
+        &_localDiscoveryTracker, &LocalDiscoveryTracker::slotItemCompleted);
+    connect(_engine, &SyncEngine::finished, this, &SyncDaemon::slotSyncFinished, Qt::QueuedConnection);
+    connect(_engine, &SyncEngine::rootEtag, this, [this](const QByteArray &etag) {
+        _lastEtag = etag;
+    });
+
+    connect(&_watcher, &LocalWatcher::pathChanged, this, &SyncDaemon::slotPathChanged);
+    connect(&_watcher, &LocalWatcher::lostChanges, this, [this] {
+        _timeSinceLastFullLocalDiscovery.invalidate();
+        scheduleSync();
+    });
+
+    _scheduleTimer.setSingleShot(true);
+    _scheduleTimer.setInterval(scheduleDelay);
+    connect(&_scheduleTimer, &QTimer::timeout, this, &SyncDaemon::startSync);
+
+    _pollTimer.setInterval(pollInterval);
+    connect(&_pollTimer, &QTimer::timeout, this, &SyncDaemon::slotPollEtag);
+
+    _retryTimer.setSingleShot(true);
+    _retryTimer.setInterval(pollInterval);
+    connect(&_retryTimer, &QTimer::timeout, this, &SyncDaemon::scheduleSync);
+
+    connect(_account.data(), &Account::pushNotificationsReady, this, &SyncDaemon::slotConnectPushNotifications);
+}
+
+SyncDaemon::~SyncDaemon() = default;
+
+void SyncDaemon::setSyncLimiter(SyncLimiter *limiter)
+{
+    _syncLimiter = limiter;
+}
+
+void SyncDaemon::start()
+{
+    if (!_watcher.isReliable()) {
+        qWarning() << "Local changes are not watched, every sync rediscovers all local files";
+    }
+    _account->trySetupPushNotifications();
+    _pollTimer.start();
+    QMetaObject::invokeMethod(this, &SyncDaemon::startSync, Qt::QueuedConnection);
+}
+
+void SyncDaemon::scheduleSync()
+{
+    if (_engine->isSyncRunning()) {
+        _syncAgain = true;
+        return;
+    }
+    if (!_scheduleTimer.isActive()) {
+        _scheduleTimer.start();
+    }
+}
+
+void SyncDaemon::startSync()
+{
+    if (_engine->isSyncRunning()) {
+        _syncAgain = true;
+        return;
+    }
+    if (_waitingForSlot) {
+        return;
+    }
+    if (_syncLimiter && !_holdsSlot) {
+        _waitingForSlot = true;
+        _syncLimiter->requestSlot([this] {
+            _waitingForSlot = false;
+            _holdsSlot = true;
+            startSync();
+        });
+        return;
+    }
+    _syncAgain = false;
+    _retryTimer.stop();
+
+    const auto periodicFullLocalDiscoveryNow =
+        _fullLocalDiscoveryInterval.count() >= 0 // negative means we don't require periodic full runs
+        && _timeSinceLastFullLocalDiscovery.hasExpired(_fullLocalDiscoveryInterval.count());
+    if (_watcher.isReliable() && _timeSinceLastFullLocalDiscovery.isValid() && !periodicFullLocalDiscoveryNow) {
+        qInfo() << "Starting sync, rediscovering" << _localDiscoveryTracker.localDiscoveryPaths().size() << "local paths";
+        _engine->setLocalDiscoveryOptions(LocalDiscoveryStyle::DatabaseAndFilesystem, _localDiscoveryTracker.localDiscoveryPaths());
+        _localDiscoveryTracker.startSyncPartialDiscovery();
+    } else {
+        qInfo() << "Starting sync, rediscovering all local files";
+        _engine->setLocalDiscoveryOptions(LocalDiscoveryStyle::FilesystemOnly);
+        _localDiscoveryTracker.startSyncFullDiscovery();
+    }
+    _engine->startSync();
+}
+
+void SyncDaemon::slotSyncFinished(bool success)
+{
+    qInfo() << "Sync finished" << (success ? "successfully" : "with errors");
+    if (_holdsSlot) {
+        _holdsSlot = false;
+        _syncLimiter->releaseSlot();
+    }
+    if (success && _engine->lastLocalDiscoveryStyle() == LocalDiscoveryStyle::FilesystemOnly) {
+        _timeSinceLastFullLocalDiscovery.start();
+    }
+
+    if (_syncAgain || _engine->isAnotherSyncNeeded() != NoFollowUpSync) {
+        scheduleSync();
+    } else if (!success) {
+        // The ETag poll is off while push notifications are used and would
+        // not see a change anyway, so failed syncs get their own timer
+        qInfo() << "Retrying the sync in" << _retryTimer.intervalAsDuration().count() << "ms";
+        _retryTimer.start();
+    }
+}
+
+void SyncDaemon::slotPathChanged(const QString &path)
+{
+    if (!path.startsWith(_localPath)
+        || _engine->excludedFiles().isExcluded(path, _localPath, _engine->ignoreHiddenFiles())) {
+        return;
+    }
+
+    const auto relativePath = path.mid(_localPath.size());
+    _localDiscoveryTracker.addTouchedPath(relativePath);
+
+    // Our own changes during a sync
+    if (_engine->wasFileTouched(path)) {
+        return;
+    }
+
+    // Only the mtime or the size matter for files known to the journal
+    SyncJournalFileRecord record;
+    if (_journal->getFileRecord(relativePath.toUtf8(), &record) && record.isValid() && !record.isDirectory()
+        && !FileSystem::fileChanged(path, record._fileSize, record._modtime)) {
+        return;
+    }
+
+    scheduleSync();
+}
+
+void SyncDaemon::slotPollEtag()
+{
+    // Push notifications announce remote changes right away
+    if (_engine->isSyncRunning() || _scheduleTimer.isActive() || pushNotificationsFilesReady()) {
+        return;
+    }
+
+    auto job = new RequestEtagJob(_account, _remotePath, this);
+    job->setTimeout(60 * 1000);
+    connect(job, &RequestEtagJob::etagRetrieved, this, [this](const QByteArray &etag) {
+        if (_lastEtag != etag) {
+            qInfo() << "Remote ETag changed from" << _lastEtag << "to" << etag;
+            _lastEtag = etag;
+            scheduleSync();
+        }
+    });
+    job->start();
+}
+
+void SyncDaemon::slotConnectPushNotifications()
+{
+    if (!pushNotificationsFilesReady()) {
+        return;
+    }
+    qInfo() << "Push notifications ready, remote changes are no longer polled";
+    connect(_account->pushNotifications(), &PushNotifications::filesChanged, this, &SyncDaemon::scheduleSync, Qt::UniqueConnection);
+}
+
+bool SyncDaemon::pushNotificationsFilesReady() const
+{
+    const auto pushNotifications = _account->pushNotifications();
+    const auto pushFilesAvailable = _account->capabilities().availablePushNotifications() & PushNotificationType::Files;
+
+    return pushFilesAvailable && pushNotifications && pushNotifications->isReady();
+}
+
+} // namespace OCC
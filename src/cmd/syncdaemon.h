@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#ifndef SYNCDAEMON_H
+#define SYNCDAEMON_H
+
+#include "accountfwd.h"
+#include "localdiscoverytracker.h"
+#include "localwatcher.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+
+namespace OCC {
+
+class SyncEngine;
+class SyncJournalDb;
+class SyncLimiter;
+
+/**
+ * @brief Keeps one sync folder in sync until the process is stopped
+ *
+ * Used by nextcloudcmd --watch. The engine and the journal stay alive between
+ * the sync runs. Local changes reported by the LocalWatcher are rediscovered
+ * on their own, the whole folder only on the first run, after lost
+ * notifications and periodically. Remote changes are picked up through push
+ * notifications or, while those are not available, by polling the ETag of
+ * the remote folder. A failed sync is retried after the poll interval, also
+ * when push notifications are used.
+ *
+ * @ingroup cmd
+ */
+class SyncDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    SyncDaemon(const AccountPtr &account, SyncEngine *engine, SyncJournalDb *journal,
+        const QString &localPath, const QString &remotePath,
+        std::chrono::seconds pollInterval, QObject *parent = nullptr);
+    ~SyncDaemon() override;
+
+    /** Makes every sync run wait for a slot of the limiter, which is shared by several daemons */
+    void setSyncLimiter(SyncLimiter *limiter);
+
+    /** Runs the first sync and starts watching for changes */
+    void start();
+
+private:
+    void scheduleSync();
+    void startSync();
+    void slotSyncFinished(bool success);
+    void slotPathChanged(const QString &path);
+    void slotPollEtag();
+    void slotConnectPushNotifications();
+    [[nodiscard]] bool pushNotificationsFilesReady() const;
+
+    AccountPtr _account;
+    SyncEngine *_engine;
+    SyncJournalDb *_journal;
+    QString _localPath; // ends with a /
+    QString _remotePath;
+
+    LocalWatcher _watcher;
+    LocalDiscoveryTracker _localDiscoveryTracker;
+    QElapsedTimer _timeSinceLastFullLocalDiscovery;
+    std::chrono::milliseconds _fullLocalDiscoveryInterval;
+
+    QTimer _scheduleTimer;
+    QTimer _pollTimer;
+    QTimer _retryTimer;
+    QByteArray _lastEtag;
+    bool _syncAgain = false;
+
+    SyncLimiter *_syncLimiter = nullptr;
+    bool _waitingForSlot = false;
+    bool _holdsSlot = false;
+};
+
+} // namespace OCC
+
+#endif // SYNCDAEMON_H
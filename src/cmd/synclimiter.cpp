@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "synclimiter.h"
+
+namespace OCC {
+
+SyncLimiter::SyncLimiter(int maxConcurrentSyncs, QObject *parent)
+    : QObject(parent)
+    , _maxConcurrentSyncs(qMax(1, maxConcurrentSyncs))
+{
+}
+
+void SyncLimiter::requestSlot(const std::function<void()> &start)
+{
+    if (_running < _maxConcurrentSyncs) {
+        ++_running;
+        start();
+        return;
+    }
+    _waiting.enqueue(start);
+}
+
+void SyncLimiter::releaseSlot()
+{
+    Q_ASSERT(_running > 0);
+    if (!_waiting.isEmpty()) {
+        // the slot goes straight to the next sync
+        _waiting.dequeue()();
+        return;
+    }
+    --_running;
+}
+
+} // namespace OCC
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#ifndef SYNCLIMITER_H
+#define SYNCLIMITER_H
+
+#include <QObject>
+#include <QQueue>
+
+#include <functional>
+
+namespace OCC {
+
+/**
+ * @brief Limits how many sync runs of a nextcloudcmd process run at once
+ *
+ * A sync asks for a slot with requestSlot() and gives it back with
+ * releaseSlot() once it is done. Requests beyond the limit are started in
+ * the order they were made whenever a slot becomes free.
+ *
+ * @ingroup cmd
+ */
+class SyncLimiter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SyncLimiter(int maxConcurrentSyncs, QObject *parent = nullptr);
+
+    /** Calls start right away if a slot is free, otherwise once one becomes free */
+    void requestSlot(const std::function<void()> &start);
+    void releaseSlot();
+
+    [[nodiscard]] int runningSyncs() const { return _running; }
+
+private:
+    int _maxConcurrentSyncs;
+    int _running = 0;
+    QQueue<std::function<void()>> _waiting;
+};
+
+} // namespace OCC
+
+#endif // SYNCLIMITER_H
@@ -48,7 +48,12 @@ static QCryptographicHash::Algorithm algorithmTypeToQCryptoHashAlgorithm(Checksu
 }
 
 ChecksumCalculator::ChecksumCalculator(const QString &filePath, const QByteArray &checksumTypeName)
-    : _device(new QFile(filePath))
+    : ChecksumCalculator(checksumTypeName)
+{
+    _device.reset(new QFile(filePath));
+}
+
+ChecksumCalculator::ChecksumCalculator(const QByteArray &checksumTypeName)
 {
     if (checksumTypeName == checkSumMD5C) {
         _algorithmType = AlgorithmType::MD5;
@@ -77,7 +82,7 @@ QByteArray ChecksumCalculator::calculate()
 {
     QByteArray result;
 
-    if (!_isInitialized) {
+    if (!_isInitialized || !_device) {
         return result;
     }
 
@@ -121,14 +126,7 @@ QByteArray ChecksumCalculator::calculate()
         }
     }
 
-    if (_algorithmType == AlgorithmType::Adler32) {
-        result = QByteArray::number(_adlerHash, 16);
-    } else {
-        Q_ASSERT(_cryptographicHash);
-        if (_cryptographicHash) {
-            result = _cryptographicHash->result().toHex();
-        }
-    }
+    result = this->result();
 
     {
         QMutexLocker locker(&_deviceMutex);
@@ -156,7 +154,25 @@ void ChecksumCalculator::initChecksumAlgorithm()
     _isInitialized = true;
 }
 
+QByteArray ChecksumCalculator::result() const
+{
+    if (!_isInitialized) {
+        return {};
+    }
+
+    if (_algorithmType == AlgorithmType::Adler32) {
+        return QByteArray::number(_adlerHash, 16);
+    }
+    Q_ASSERT(_cryptographicHash);
+    return _cryptographicHash ? _cryptographicHash->result().toHex() : QByteArray{};
+}
+
 bool ChecksumCalculator::addChunk(const QByteArray &chunk, const qint64 size)
+{
+    return addData(chunk.constData(), size);
+}
+
+bool ChecksumCalculator::addData(const char *data, const qint64 size)
 {
     Q_ASSERT(_algorithmType != AlgorithmType::Undefined);
     if (_algorithmType == AlgorithmType::Undefined) {
@@ -165,12 +181,12 @@ bool ChecksumCalculator::addChunk(const QByteArray &chunk, const qint64 size)
     }
 
     if (_algorithmType == AlgorithmType::Adler32) {
-        _adlerHash = adler32(_adlerHash, (const Bytef *)chunk.data(), size);
+        _adlerHash = adler32(_adlerHash, (const Bytef *)data, size);
         return true;
     } else {
         Q_ASSERT(_cryptographicHash);
         if (_cryptographicHash) {
-            _cryptographicHash->addData(chunk.data(), size);
+            _cryptographicHash->addData(data, size);
             return true;
         }
     }
@@ -42,9 +42,24 @@ public:
     };
 
     ChecksumCalculator(const QString &filePath, const QByteArray &checksumTypeName);
+
+    /** Creates a calculator without a backing file.
+     *
+     * The data is fed incrementally through addData(), which allows checksumming
+     * a stream while it is being written somewhere else.
+     */
+    explicit ChecksumCalculator(const QByteArray &checksumTypeName);
     ~ChecksumCalculator();
     [[nodiscard]] QByteArray calculate();
 
+    /// Whether the checksum type was recognized
+    [[nodiscard]] bool isInitialized() const { return _isInitialized; }
+
+    bool addData(const char *data, const qint64 size);
+
+    /// The checksum of all data passed to addData() so far
+    [[nodiscard]] QByteArray result() const;
+
 private:
     void initChecksumAlgorithm();
     bool addChunk(const QByteArray &chunk, const qint64 size);
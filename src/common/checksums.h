@@ -137,6 +137,14 @@ public:
      */
     void start(const QString &filePath, const QByteArray &checksumHeader);
 
+    /**
+     * Check an already calculated checksum against the provided checksumHeader
+     *
+     * Like start(), but for data that was checksummed while it was written.
+     * The signals are emitted before this returns.
+     */
+    void validate(const QByteArray &checksumHeader, const QByteArray &checksumType, const QByteArray &checksum);
+
     [[nodiscard]] QByteArray calculatedChecksumType() const;
     [[nodiscard]] QByteArray calculatedChecksum() const;
 
@@ -150,6 +158,8 @@ private slots:
 
 private:
     ComputeChecksum *prepareStart(const QByteArray &checksumHeader);
+    /// Returns false if the result was already emitted
+    bool parseExpectedChecksum(const QByteArray &checksumHeader);
 
     QByteArray _expectedChecksumType;
     QByteArray _expectedChecksum;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "pinstatetrie.h"
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace {
+
+constexpr auto pinStateCount = static_cast<int>(OCC::PinState::Excluded) + 1;
+
+QByteArray firstComponent(const QByteArray &path, int *position)
+{
+    const auto slash = path.indexOf('/', *position);
+    const auto end = slash < 0 ? path.size() : slash;
+    auto component = path.mid(*position, end - *position);
+    *position = end + 1;
+    return component;
+}
+
+}
+
+namespace OCC {
+
+struct PinStateTrie::Node
+{
+    PinState state = PinState::Inherited;
+    // How many nodes of this subtree, including this one, have each pin state except Inherited
+    std::array<qint64, pinStateCount> subtreeCounts = {};
+    std::map<QByteArray, std::unique_ptr<Node>> children;
+};
+
+PinStateTrie::PinStateTrie()
+    : _root(std::make_unique<Node>())
+{
+}
+
+PinStateTrie::~PinStateTrie() = default;
+
+void PinStateTrie::clear()
+{
+    _root = std::make_unique<Node>();
+}
+
+void PinStateTrie::setForPath(const QByteArray &path, PinState state)
+{
+    std::vector<Node *> trail { _root.get() };
+    int position = 0;
+    while (position < path.size()) {
+        auto &child = trail.back()->children[firstComponent(path, &position)];
+        if (!child) {
+            child = std::make_unique<Node>();
+        }
+        trail.push_back(child.get());
+    }
+
+    const auto oldState = trail.back()->state;
+    trail.back()->state = state;
+    for (const auto node : trail) {
+        if (oldState != PinState::Inherited) {
+            --node->subtreeCounts[static_cast<int>(oldState)];
+        }
+        if (state != PinState::Inherited) {
+            ++node->subtreeCounts[static_cast<int>(state)];
+        }
+    }
+}
+
+void PinStateTrie::wipeForPathAndBelow(const QByteArray &path)
+{
+    if (path.isEmpty()) {
+        clear();
+        return;
+    }
+
+    std::vector<Node *> trail { _root.get() };
+    int position = 0;
+    QByteArray component;
+    forever {
+        component = firstComponent(path, &position);
+        if (position > path.size()) {
+            break;
+        }
+        const auto it = trail.back()->children.find(component);
+        if (it == trail.back()->children.end()) {
+            return;
+        }
+        trail.push_back(it->second.get());
+    }
+
+    auto &parentChildren = trail.back()->children;
+    const auto it = parentChildren.find(component);
+    if (it == parentChildren.end()) {
+        return;
+    }
+    const auto removedCounts = it->second->subtreeCounts;
+    parentChildren.erase(it);
+    for (const auto node : trail) {
+        for (int i = 0; i < pinStateCount; ++i) {
+            node->subtreeCounts[i] -= removedCounts[i];
+        }
+    }
+}
+
+const PinStateTrie::Node *PinStateTrie::findNode(const QByteArray &path) const
+{
+    const Node *node = _root.get();
+    int position = 0;
+    while (node && position < path.size()) {
+        const auto it = node->children.find(firstComponent(path, &position));
+        node = it == node->children.end() ? nullptr : it->second.get();
+    }
+    return node;
+}
+
+PinState PinStateTrie::rawForPath(const QByteArray &path) const
+{
+    const auto node = findNode(path);
+    return node ? node->state : PinState::Inherited;
+}
+
+PinState PinStateTrie::effectiveForPath(const QByteArray &path) const
+{
+    // If the root has no pin state, assume AlwaysLocal
+    auto result = PinState::AlwaysLocal;
+    const Node *node = _root.get();
+    int position = 0;
+    forever {
+        if (node->state != PinState::Inherited) {
+            result = node->state;
+        }
+        if (position >= path.size()) {
+            break;
+        }
+        const auto it = node->children.find(firstComponent(path, &position));
+        if (it == node->children.end()) {
+            break;
+        }
+        node = it->second.get();
+    }
+    return result;
+}
+
+PinState PinStateTrie::effectiveForPathRecursive(const QByteArray &path) const
+{
+    const auto basePin = effectiveForPath(path);
+    const auto node = findNode(path);
+    if (!node) {
+        return basePin;
+    }
+
+    for (int i = 0; i < pinStateCount; ++i) {
+        const auto state = static_cast<PinState>(i);
+        if (state != basePin && node->subtreeCounts[i] > 0) {
+            return PinState::Inherited;
+        }
+    }
+    return basePin;
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "ocsynclib.h"
+#include "common/pinstate.h"
+
+#include <QByteArray>
+
+#include <memory>
+
+namespace OCC {
+
+/**
+ * @brief In-memory copy of the pin states of a sync folder
+ *
+ * Stores the pin states in a tree of path components, so that looking up
+ * the effective pin state of a path only walks down its parents. Each node
+ * also counts the pin states used below it, which makes the recursive lookup
+ * independent of the size of the subtree.
+ *
+ * Paths have no leading or trailing slashes, "" is the root.
+ * The semantics match the SyncJournalDb::PinStateInterface functions.
+ */
+class OCSYNC_EXPORT PinStateTrie
+{
+public:
+    PinStateTrie();
+    ~PinStateTrie();
+
+    /// Forgets all pin states
+    void clear();
+
+    void setForPath(const QByteArray &path, PinState state);
+    void wipeForPathAndBelow(const QByteArray &path);
+
+    /// The pin state stored for exactly this path, Inherited if there is none
+    [[nodiscard]] PinState rawForPath(const QByteArray &path) const;
+    /// The pin state of the path or its closest parent with one, AlwaysLocal if there is none
+    [[nodiscard]] PinState effectiveForPath(const QByteArray &path) const;
+    /// Like effectiveForPath(), but Inherited if an item below the path has a different pin state
+    [[nodiscard]] PinState effectiveForPathRecursive(const QByteArray &path) const;
+
+private:
+    Q_DISABLE_COPY(PinStateTrie)
+
+    struct Node;
+    [[nodiscard]] const Node *findNode(const QByteArray &path) const;
+
+    std::unique_ptr<Node> _root;
+};
+
+}
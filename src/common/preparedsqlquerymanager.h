@@ -66,6 +66,7 @@ public:
         GetFilesBelowPathQuery,
         GetAllFilesQuery,
         ListFilesInPathQuery,
+        ListSubdirectoriesInPathQuery,
         SetFileRecordQuery,
         SetFileRecordChecksumQuery,
         SetFileRecordLocalMetadataQuery,
@@ -75,8 +76,21 @@ public:
         GetUploadInfoQuery,
         SetUploadInfoQuery,
         DeleteUploadInfoQuery,
+        GetContentChunksQuery,
+        SetContentChunksQuery,
+        DeleteContentChunksQuery,
+        DeleteContentChunksRecursively,
         DeleteFileRecordPhash,
         DeleteFileRecordRecursively,
+        SetFilenameIndexQuery,
+        DeleteFilenameIndexPhash,
+        DeleteFilenameIndexRecursively,
+        FindFileRecordsByNameQuery,
+        GetRecordAggregateQuery,
+        GetDirectoryAggregateQuery,
+        InsertDirectoryAggregateQuery,
+        UpdateDirectoryAggregateQuery,
+        DeleteDirectoryAggregatesRecursively,
         GetErrorBlacklistQuery,
         SetErrorBlacklistQuery,
         GetSelectiveSyncListQuery,
@@ -97,9 +111,6 @@ public:
         DeleteCaseClashConflictRecordQuery,
         GetAllCaseClashConflictPathQuery,
         DeleteConflictRecordQuery,
-        GetRawPinStateQuery,
-        GetEffectivePinStateQuery,
-        GetSubPinsQuery,
         CountDehydratedFilesQuery,
         SetPinStateQuery,
         WipePinStateQuery,
@@ -46,6 +46,11 @@ namespace OCC {
 
 Q_LOGGING_CATEGORY(lcDb, "nextcloud.sync.database", QtInfoMsg)
 
+// Stored as PRAGMA user_version once checkConnect() created and updated all
+// tables. Must be increased with every change to createTables() or
+// updateDatabaseStructure().
+static constexpr int journalSchemaVersion = 4;
+
 #define GET_FILE_RECORD_QUERY \
         "SELECT path, inode, modtime, type, md5, fileid, remotePerm, filesize," \
         "  ignoredChildrenRemote, contentchecksumtype.name || ':' || contentChecksum, e2eMangledName, isE2eEncrypted, " \
@@ -80,6 +85,27 @@ static void fillFileRecordFromGetQuery(SyncJournalFileRecord &rec, SqlQuery &que
     rec._sharedByMe = query.intValue(22) > 0;
 }
 
+// Directories are made of their content, only files and placeholders add to the aggregates
+static SyncJournalDb::DirectoryAggregate recordAggregate(int type, qint64 size, qint64 modtime)
+{
+    SyncJournalDb::DirectoryAggregate aggregate;
+    aggregate._valid = true;
+    switch (type) {
+    case ItemTypeFile:
+    case ItemTypeVirtualFileDehydration:
+        aggregate._fileCount = 1;
+        Q_FALLTHROUGH();
+    case ItemTypeVirtualFile:
+    case ItemTypeVirtualFileDownload:
+        aggregate._size = size;
+        aggregate._latestModtime = modtime;
+        break;
+    default:
+        break;
+    }
+    return aggregate;
+}
+
 static QByteArray defaultJournalMode(const QString &dbPath)
 {
 #if defined(Q_OS_WIN)
@@ -318,6 +344,9 @@ bool SyncJournalDb::checkConnect()
         return false;
     }
 
+    QElapsedTimer openTimer;
+    openTimer.start();
+
     // The database file is created by this call (SQLITE_OPEN_CREATE)
     if (!_db.openOrCreateReadWrite(_dbFile)) {
         QString error = _db.error();
@@ -394,10 +423,181 @@ bool SyncJournalDb::checkConnect()
                                     sqlite3_result_int64(ctx, c_jhash64(reinterpret_cast<const uint8_t*>(text),
                                                                         end - text, 0));
                                 }, nullptr, nullptr);
+    const auto pragmaTime = openTimer.restart();
 
     /* Because insert is so slow, we do everything in a transaction, and only need one call to commit */
     startTransaction();
 
+    const auto schemaUpToDate = isSchemaUpToDate();
+    if (!schemaUpToDate) {
+        const auto journalMode = _journalMode;
+        if (!createTables()) {
+            if (_journalMode != journalMode) {
+                commitTransaction();
+                _db.close();
+                return checkConnect();
+            }
+            return false;
+        }
+    }
+    const auto tablesTime = openTimer.restart();
+
+    SqlQuery createQuery(_db);
+
+    bool forceRemoteDiscovery = false;
+
+    SqlQuery versionQuery("SELECT major, minor, patch FROM version;", _db);
+    if (!versionQuery.next().hasData) {
+        forceRemoteDiscovery = true;
+
+        createQuery.prepare("INSERT INTO version VALUES (?1, ?2, ?3, ?4);");
+        createQuery.bindValue(1, MIRALL_VERSION_MAJOR);
+        createQuery.bindValue(2, MIRALL_VERSION_MINOR);
+        createQuery.bindValue(3, MIRALL_VERSION_PATCH);
+        createQuery.bindValue(4, static_cast<qulonglong>(MIRALL_VERSION_BUILD));
+        if (!createQuery.exec()) {
+            return sqlFail(QStringLiteral("Update version"), createQuery);
+        }
+
+    } else {
+        int major = versionQuery.intValue(0);
+        int minor = versionQuery.intValue(1);
+        int patch = versionQuery.intValue(2);
+
+        if (major == 1 && minor == 8 && (patch == 0 || patch == 1)) {
+            qCInfo(lcDb) << "possibleUpgradeFromMirall_1_8_0_or_1 detected!";
+            forceRemoteDiscovery = true;
+        }
+
+        // There was a bug in versions <2.3.0 that could lead to stale
+        // local files and a remote discovery will fix them.
+        // See #5190 #5242.
+        if (major == 2 && minor < 3) {
+            qCInfo(lcDb) << "upgrade form client < 2.3.0 detected! forcing remote discovery";
+            forceRemoteDiscovery = true;
+        }
+
+        // Not comparing the BUILD id here, correct?
+        if (!(major == MIRALL_VERSION_MAJOR && minor == MIRALL_VERSION_MINOR && patch == MIRALL_VERSION_PATCH)) {
+            createQuery.prepare("UPDATE version SET major=?1, minor=?2, patch =?3, custom=?4 "
+                                "WHERE major=?5 AND minor=?6 AND patch=?7;");
+            createQuery.bindValue(1, MIRALL_VERSION_MAJOR);
+            createQuery.bindValue(2, MIRALL_VERSION_MINOR);
+            createQuery.bindValue(3, MIRALL_VERSION_PATCH);
+            createQuery.bindValue(4, static_cast<qulonglong>(MIRALL_VERSION_BUILD));
+            createQuery.bindValue(5, major);
+            createQuery.bindValue(6, minor);
+            createQuery.bindValue(7, patch);
+            if (!createQuery.exec()) {
+                return sqlFail(QStringLiteral("Update version"), createQuery);
+            }
+        }
+    }
+
+    commitInternal(QStringLiteral("checkConnect"));
+
+    bool rc = true;
+    if (!schemaUpToDate) {
+        rc = updateDatabaseStructure();
+        if (!rc) {
+            qCWarning(lcDb) << "Failed to update the database structure!";
+        } else {
+            // The next open of this database can skip the checks above
+            SqlQuery query(_db);
+            query.prepare("PRAGMA user_version = " + QByteArray::number(journalSchemaVersion) + ";");
+            if (!query.exec() || !query.next().ok) {
+                qCWarning(lcDb) << "Could not store the schema version" << query.error();
+            }
+        }
+    }
+    const auto structureTime = openTimer.restart();
+
+    /*
+     * If we are upgrading from a client version older than 1.5,
+     * we cannot read from the database because we need to fetch the files id and etags.
+     *
+     *  If 1.8.0 caused missing data in the local tree, so we also don't read from DB
+     *  to get back the files that were gone.
+     *  In 1.8.1 we had a fix to re-get the data, but this one here is better
+     */
+    if (forceRemoteDiscovery) {
+        forceRemoteDiscoveryNextSyncLocked();
+    }
+    const auto deleteDownloadInfo = _queryManager.get(PreparedSqlQueryManager::DeleteDownloadInfoQuery, QByteArrayLiteral("DELETE FROM downloadinfo WHERE path=?1"), _db);
+    if (!deleteDownloadInfo) {
+        qCDebug(lcDb) << "database error:" << deleteDownloadInfo->error();
+        return sqlFail(QStringLiteral("prepare _deleteDownloadInfoQuery"), *deleteDownloadInfo);
+    }
+
+
+    const auto deleteUploadInfoQuery = _queryManager.get(PreparedSqlQueryManager::DeleteUploadInfoQuery, QByteArrayLiteral("DELETE FROM uploadinfo WHERE path=?1"), _db);
+    if (!deleteUploadInfoQuery) {
+        qCDebug(lcDb) << "database error:" << deleteUploadInfoQuery->error();
+        return sqlFail(QStringLiteral("prepare _deleteUploadInfoQuery"), *deleteUploadInfoQuery);
+    }
+
+    QByteArray sql("SELECT lastTryEtag, lastTryModtime, retrycount, errorstring, lastTryTime, ignoreDuration, renameTarget, errorCategory, requestId "
+                   "FROM blacklist WHERE path=?1");
+    if (Utility::fsCasePreserving()) {
+        // if the file system is case preserving we have to check the blacklist
+        // case insensitively
+        sql += " COLLATE NOCASE";
+    }
+    const auto getErrorBlacklistQuery = _queryManager.get(PreparedSqlQueryManager::GetErrorBlacklistQuery, sql, _db);
+    if (!getErrorBlacklistQuery) {
+        qCDebug(lcDb) << "database error:" << getErrorBlacklistQuery->error();
+        return sqlFail(QStringLiteral("prepare _getErrorBlacklistQuery"), *getErrorBlacklistQuery);
+    }
+
+    // don't start a new transaction now
+    commitInternal(QStringLiteral("checkConnect End"), false);
+
+    // This avoid reading from the DB if we already know it is empty
+    // thereby speeding up the initial discovery significantly.
+    // Unlike a COUNT(*) this does not scan the whole table.
+    {
+        SqlQuery query("SELECT 1 FROM metadata LIMIT 1;", _db);
+        _metadataTableIsEmpty = query.exec() && !query.next().hasData;
+    }
+    {
+        SqlQuery query("SELECT 1 FROM sqlite_master WHERE type='table' AND name='filenames';", _db);
+        _filenameIndexAvailable = query.exec() && query.next().hasData;
+    }
+
+    // Hide 'em all!
+    FileSystem::setFileHidden(databaseFilePath(), true);
+    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-wal"), true);
+    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-shm"), true);
+    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-journal"), true);
+
+    qCInfo(lcDb) << "Opened" << _dbFile << "- pragmas:" << pragmaTime << "ms, tables:" << tablesTime
+                 << "ms, structure:" << structureTime << "ms, queries:" << openTimer.elapsed()
+                 << "ms, schema check skipped:" << schemaUpToDate;
+
+    return rc;
+}
+
+bool SyncJournalDb::isSchemaUpToDate()
+{
+    SqlQuery query(_db);
+    query.prepare("PRAGMA user_version;");
+    if (!query.exec() || !query.next().hasData || query.intValue(0) != journalSchemaVersion) {
+        return false;
+    }
+
+    // Another client version may have opened the database since,
+    // it won't have updated the user_version
+    query.prepare("SELECT major, minor, patch FROM version;");
+    if (!query.exec() || !query.next().hasData) {
+        return false;
+    }
+    return query.intValue(0) == MIRALL_VERSION_MAJOR
+        && query.intValue(1) == MIRALL_VERSION_MINOR
+        && query.intValue(2) == MIRALL_VERSION_PATCH;
+}
+
+bool SyncJournalDb::createTables()
+{
     SqlQuery createQuery(_db);
     createQuery.prepare("CREATE TABLE IF NOT EXISTS metadata("
                         "phash INTEGER(8),"
@@ -434,9 +634,7 @@ bool SyncJournalDb::checkConnect()
             && sqlite3_extended_errcode(_db.sqliteDb()) == SQLITE_IOERR_SHMMAP) {
             qCWarning(lcDb) << "IO error SHMMAP on table creation, attempting with DELETE journal mode";
             _journalMode = "DELETE";
-            commitTransaction();
-            _db.close();
-            return checkConnect();
+            return false;
         }
 
         return sqlFail(QStringLiteral("Create table metadata"), createQuery);
@@ -475,6 +673,18 @@ bool SyncJournalDb::checkConnect()
         return sqlFail(QStringLiteral("Create table uploadinfo"), createQuery);
     }
 
+    createQuery.prepare("CREATE TABLE IF NOT EXISTS contentchunks("
+                        "path VARCHAR(4096),"
+                        "etag VARCHAR(32),"
+                        "averagesize INTEGER(8),"
+                        "chunks BLOB,"
+                        "PRIMARY KEY(path)"
+                        ");");
+
+    if (!createQuery.exec()) {
+        return sqlFail(QStringLiteral("Create table contentchunks"), createQuery);
+    }
+
     // create the blacklist table.
     createQuery.prepare("CREATE TABLE IF NOT EXISTS blacklist ("
                         "path VARCHAR(4096),"
@@ -567,7 +777,7 @@ bool SyncJournalDb::checkConnect()
         return sqlFail(QStringLiteral("Create table version"), createQuery);
     }
 
-     // create the e2EeLockedFolders table.
+    // create the e2EeLockedFolders table.
     createQuery.prepare(
         "CREATE TABLE IF NOT EXISTS e2EeLockedFolders("
         "folderId VARCHAR(128) PRIMARY KEY,"
@@ -577,114 +787,7 @@ bool SyncJournalDb::checkConnect()
         return sqlFail(QStringLiteral("Create table e2EeLockedFolders"), createQuery);
     }
 
-    bool forceRemoteDiscovery = false;
-
-    SqlQuery versionQuery("SELECT major, minor, patch FROM version;", _db);
-    if (!versionQuery.next().hasData) {
-        forceRemoteDiscovery = true;
-
-        createQuery.prepare("INSERT INTO version VALUES (?1, ?2, ?3, ?4);");
-        createQuery.bindValue(1, MIRALL_VERSION_MAJOR);
-        createQuery.bindValue(2, MIRALL_VERSION_MINOR);
-        createQuery.bindValue(3, MIRALL_VERSION_PATCH);
-        createQuery.bindValue(4, static_cast<qulonglong>(MIRALL_VERSION_BUILD));
-        if (!createQuery.exec()) {
-            return sqlFail(QStringLiteral("Update version"), createQuery);
-        }
-
-    } else {
-        int major = versionQuery.intValue(0);
-        int minor = versionQuery.intValue(1);
-        int patch = versionQuery.intValue(2);
-
-        if (major == 1 && minor == 8 && (patch == 0 || patch == 1)) {
-            qCInfo(lcDb) << "possibleUpgradeFromMirall_1_8_0_or_1 detected!";
-            forceRemoteDiscovery = true;
-        }
-
-        // There was a bug in versions <2.3.0 that could lead to stale
-        // local files and a remote discovery will fix them.
-        // See #5190 #5242.
-        if (major == 2 && minor < 3) {
-            qCInfo(lcDb) << "upgrade form client < 2.3.0 detected! forcing remote discovery";
-            forceRemoteDiscovery = true;
-        }
-
-        // Not comparing the BUILD id here, correct?
-        if (!(major == MIRALL_VERSION_MAJOR && minor == MIRALL_VERSION_MINOR && patch == MIRALL_VERSION_PATCH)) {
-            createQuery.prepare("UPDATE version SET major=?1, minor=?2, patch =?3, custom=?4 "
-                                "WHERE major=?5 AND minor=?6 AND patch=?7;");
-            createQuery.bindValue(1, MIRALL_VERSION_MAJOR);
-            createQuery.bindValue(2, MIRALL_VERSION_MINOR);
-            createQuery.bindValue(3, MIRALL_VERSION_PATCH);
-            createQuery.bindValue(4, static_cast<qulonglong>(MIRALL_VERSION_BUILD));
-            createQuery.bindValue(5, major);
-            createQuery.bindValue(6, minor);
-            createQuery.bindValue(7, patch);
-            if (!createQuery.exec()) {
-                return sqlFail(QStringLiteral("Update version"), createQuery);
-            }
-        }
-    }
-
-    commitInternal(QStringLiteral("checkConnect"));
-
-    bool rc = updateDatabaseStructure();
-    if (!rc) {
-        qCWarning(lcDb) << "Failed to update the database structure!";
-    }
-
-    /*
-     * If we are upgrading from a client version older than 1.5,
-     * we cannot read from the database because we need to fetch the files id and etags.
-     *
-     *  If 1.8.0 caused missing data in the local tree, so we also don't read from DB
-     *  to get back the files that were gone.
-     *  In 1.8.1 we had a fix to re-get the data, but this one here is better
-     */
-    if (forceRemoteDiscovery) {
-        forceRemoteDiscoveryNextSyncLocked();
-    }
-    const auto deleteDownloadInfo = _queryManager.get(PreparedSqlQueryManager::DeleteDownloadInfoQuery, QByteArrayLiteral("DELETE FROM downloadinfo WHERE path=?1"), _db);
-    if (!deleteDownloadInfo) {
-        qCDebug(lcDb) << "database error:" << deleteDownloadInfo->error();
-        return sqlFail(QStringLiteral("prepare _deleteDownloadInfoQuery"), *deleteDownloadInfo);
-    }
-
-
-    const auto deleteUploadInfoQuery = _queryManager.get(PreparedSqlQueryManager::DeleteUploadInfoQuery, QByteArrayLiteral("DELETE FROM uploadinfo WHERE path=?1"), _db);
-    if (!deleteUploadInfoQuery) {
-        qCDebug(lcDb) << "database error:" << deleteUploadInfoQuery->error();
-        return sqlFail(QStringLiteral("prepare _deleteUploadInfoQuery"), *deleteUploadInfoQuery);
-    }
-
-    QByteArray sql("SELECT lastTryEtag, lastTryModtime, retrycount, errorstring, lastTryTime, ignoreDuration, renameTarget, errorCategory, requestId "
-                   "FROM blacklist WHERE path=?1");
-    if (Utility::fsCasePreserving()) {
-        // if the file system is case preserving we have to check the blacklist
-        // case insensitively
-        sql += " COLLATE NOCASE";
-    }
-    const auto getErrorBlacklistQuery = _queryManager.get(PreparedSqlQueryManager::GetErrorBlacklistQuery, sql, _db);
-    if (!getErrorBlacklistQuery) {
-        qCDebug(lcDb) << "database error:" << getErrorBlacklistQuery->error();
-        return sqlFail(QStringLiteral("prepare _getErrorBlacklistQuery"), *getErrorBlacklistQuery);
-    }
-
-    // don't start a new transaction now
-    commitInternal(QStringLiteral("checkConnect End"), false);
-
-    // This avoid reading from the DB if we already know it is empty
-    // thereby speeding up the initial discovery significantly.
-    _metadataTableIsEmpty = (getFileRecordCount() == 0);
-
-    // Hide 'em all!
-    FileSystem::setFileHidden(databaseFilePath(), true);
-    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-wal"), true);
-    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-shm"), true);
-    FileSystem::setFileHidden(databaseFilePath() + QStringLiteral("-journal"), true);
-
-    return rc;
+    return true;
 }
 
 void SyncJournalDb::close()
@@ -697,6 +800,8 @@ void SyncJournalDb::close()
     _db.close();
     clearEtagStorageFilter();
     _metadataTableIsEmpty = false;
+    _pinStates.clear();
+    _pinStatesLoaded = false;
 }
 
 
@@ -706,6 +811,71 @@ bool SyncJournalDb::updateDatabaseStructure()
         return false;
     if (!updateErrorBlacklistTableStructure())
         return false;
+    if (!updateFilenameIndex())
+        return false;
+    if (!updateDirectoryAggregatesTable())
+        return false;
+    return true;
+}
+
+bool SyncJournalDb::updateDirectoryAggregatesTable()
+{
+    SqlQuery query(_db);
+    query.prepare("CREATE TABLE IF NOT EXISTS directoryaggregates("
+                  "path TEXT PRIMARY KEY,"
+                  "size INTEGER,"
+                  "filecount INTEGER,"
+                  "modtime INTEGER"
+                  ");");
+    if (!query.exec()) {
+        return sqlFail(QStringLiteral("updateDirectoryAggregatesTable: create table"), query);
+    }
+
+    // Older client versions don't update the aggregates, recompute them all.
+    // Every entry is added to its parent directory and from there to the
+    // directories above it, up to the sync folder with the empty path.
+    static_assert(ItemTypeFile == 0 && ItemTypeVirtualFile == 4 && ItemTypeVirtualFileDownload == 5 && ItemTypeVirtualFileDehydration == 6, "");
+    query.prepare("DELETE FROM directoryaggregates;");
+    if (!query.exec()) {
+        return sqlFail(QStringLiteral("updateDirectoryAggregatesTable: clear"), query);
+    }
+    query.prepare("INSERT INTO directoryaggregates (path, size, filecount, modtime)"
+                  " WITH RECURSIVE parents(dir, size, filecount, modtime) AS ("
+                  "  SELECT rtrim(path, replace(path, '/', '')), filesize, type IN (0, 6), modtime FROM metadata WHERE type IN (0, 4, 5, 6)"
+                  "  UNION ALL"
+                  "  SELECT rtrim(rtrim(dir, '/'), replace(rtrim(dir, '/'), '/', '')), size, filecount, modtime FROM parents WHERE dir != ''"
+                  " )"
+                  " SELECT rtrim(dir, '/'), SUM(size), SUM(filecount), MAX(modtime) FROM parents GROUP BY dir;");
+    if (!query.exec()) {
+        return sqlFail(QStringLiteral("updateDirectoryAggregatesTable: fill"), query);
+    }
+    commitInternal(QStringLiteral("update database structure: fill directory aggregates"));
+
+    return true;
+}
+
+bool SyncJournalDb::updateFilenameIndex()
+{
+    SqlQuery query(_db);
+    if (tableColumns("filenames").isEmpty()) {
+        // The trigram tokenizer needs SQLite 3.34 with FTS5, without it only
+        // the server is searched for file names
+        query.prepare("CREATE VIRTUAL TABLE filenames USING fts5(name, tokenize='trigram');");
+        if (!query.exec()) {
+            qCWarning(lcDb) << "Could not create the filename index:" << query.error();
+            return true;
+        }
+    }
+
+    // Index the records that are new or were written by a client version
+    // without the index, the file name is the part after the last '/'
+    query.prepare("INSERT INTO filenames (rowid, name) SELECT phash, substr(path, length(rtrim(path, replace(path, '/', ''))) + 1) FROM metadata"
+                  " WHERE phash NOT IN (SELECT rowid FROM filenames);");
+    if (!query.exec()) {
+        return sqlFail(QStringLiteral("updateFilenameIndex: fill index"), query);
+    }
+    commitInternal(QStringLiteral("update database structure: fill filename index"));
+
     return true;
 }
 
@@ -986,6 +1156,11 @@ Result<void, QString> SyncJournalDb::setFileRecord(const SyncJournalFileRecord &
     parseChecksumHeader(record._checksumHeader, &checksumType, &checksum);
     int contentChecksumTypeId = mapChecksumType(checksumType);
 
+    DirectoryAggregate previousAggregate;
+    if (!getRecordAggregate(phash, &previousAggregate)) {
+        return tr("Failed to read the previous file record.");
+    }
+
     const auto query = _queryManager.get(PreparedSqlQueryManager::SetFileRecordQuery, QByteArrayLiteral("INSERT OR REPLACE INTO metadata "
                                                                                                         "(phash, pathlen, path, inode, uid, gid, mode, modtime, type, md5, fileid, remotePerm, filesize, ignoredChildrenRemote, "
                                                                                                         "contentChecksum, contentChecksumTypeId, e2eMangledName, isE2eEncrypted, lock, lockType, lockOwnerDisplayName, lockOwnerId, "
@@ -1035,6 +1210,24 @@ Result<void, QString> SyncJournalDb::setFileRecord(const SyncJournalFileRecord &
     // Can't be true anymore.
     _metadataTableIsEmpty = false;
 
+    if (!updateDirectoryAggregates(record._path, previousAggregate, recordAggregate(record._type, record._fileSize, record._modtime))) {
+        return tr("Failed to update the directory totals.");
+    }
+
+    if (_filenameIndexAvailable) {
+        // Search works without the name of this record, no need to fail
+        const auto indexQuery = _queryManager.get(PreparedSqlQueryManager::SetFilenameIndexQuery, QByteArrayLiteral("INSERT OR REPLACE INTO filenames (rowid, name) VALUES (?1, ?2);"), _db);
+        if (!indexQuery) {
+            qCWarning(lcDb) << "Could not prepare the filename index query";
+        } else {
+            indexQuery->bindValue(1, phash);
+            indexQuery->bindValue(2, record._path.mid(record._path.lastIndexOf('/') + 1));
+            if (!indexQuery->exec()) {
+                qCWarning(lcDb) << "Could not add" << record.path() << "to the filename index:" << indexQuery->error();
+            }
+        }
+    }
+
     return {};
 }
 
@@ -1227,12 +1420,88 @@ bool SyncJournalDb::deleteFileRecord(const QString &filename, bool recursively)
             }
 
             const qint64 phash = getPHash(filename.toUtf8());
+
+            // The aggregate of a directory only goes away with its content
+            DirectoryAggregate removedAggregate;
+            if (!getRecordAggregate(phash, &removedAggregate)) {
+                return false;
+            }
+            if (recursively) {
+                const auto subtreeAggregate = getDirectoryAggregate(filename);
+                if (!subtreeAggregate._valid) {
+                    return false;
+                }
+                removedAggregate._size += subtreeAggregate._size;
+                removedAggregate._fileCount += subtreeAggregate._fileCount;
+            }
+            if (!updateDirectoryAggregates(filename.toUtf8(), removedAggregate, recordAggregate(ItemTypeDirectory, 0, 0))) {
+                return false;
+            }
+
             query->bindValue(1, phash);
 
             if (!query->exec()) {
                 qCDebug(lcDb) << "database error:" << query->error();
                 return false;
             }
+
+            if (_filenameIndexAvailable) {
+                const auto indexQuery = _queryManager.get(PreparedSqlQueryManager::DeleteFilenameIndexPhash, QByteArrayLiteral("DELETE FROM filenames WHERE rowid=?1"), _db);
+                if (!indexQuery) {
+                    qCDebug(lcDb) << "database error:" << indexQuery->error();
+                    return false;
+                }
+                indexQuery->bindValue(1, phash);
+                if (!indexQuery->exec()) {
+                    qCDebug(lcDb) << "database error:" << indexQuery->error();
+                    return false;
+                }
+            }
+        }
+
+        if (recursively && _filenameIndexAvailable) {
+            // Needs the records, remove the names before them
+            const auto query = _queryManager.get(PreparedSqlQueryManager::DeleteFilenameIndexRecursively, QByteArrayLiteral("DELETE FROM filenames WHERE rowid IN (SELECT phash FROM metadata WHERE " IS_PREFIX_PATH_OF("?1", "path") ")"), _db);
+            if (!query) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
+
+            query->bindValue(1, filename);
+            if (!query->exec()) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
+        }
+
+        {
+            const auto query = recursively
+                ? _queryManager.get(PreparedSqlQueryManager::DeleteContentChunksRecursively, QByteArrayLiteral("DELETE FROM contentchunks WHERE " IS_PREFIX_PATH_OR_EQUAL("?1", "path")), _db)
+                : _queryManager.get(PreparedSqlQueryManager::DeleteContentChunksQuery, QByteArrayLiteral("DELETE FROM contentchunks WHERE path=?1"), _db);
+            if (!query) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
+
+            query->bindValue(1, filename);
+            if (!query->exec()) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
+        }
+
+        if (recursively) {
+            const auto query = _queryManager.get(PreparedSqlQueryManager::DeleteDirectoryAggregatesRecursively, QByteArrayLiteral("DELETE FROM directoryaggregates WHERE " IS_PREFIX_PATH_OR_EQUAL("?1", "path")), _db);
+            if (!query) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
+
+            query->bindValue(1, filename);
+            if (!query->exec()) {
+                qCDebug(lcDb) << "database error:" << query->error();
+                return false;
+            }
         }
 
         if (recursively) {
@@ -1495,17 +1764,115 @@ bool SyncJournalDb::getFilesBelowPath(const QByteArray &path, const std::functio
             qCDebug(lcDb) << "database error:" << query->error();
             return false;
         }
-        query->bindValue(1, path);
-        return _exec(*query);
+        query->bindValue(1, path);
+        return _exec(*query);
+    }
+}
+
+bool SyncJournalDb::listFilesInPath(const QByteArray& path,
+                                    const std::function<void (const SyncJournalFileRecord &)>& rowCallback)
+{
+    QMutexLocker locker(&_mutex);
+
+    if (_metadataTableIsEmpty) {
+        return true;
+    }
+
+    if (!checkConnect()) {
+        return false;
+    }
+
+    const auto query = _queryManager.get(PreparedSqlQueryManager::ListFilesInPathQuery, QByteArrayLiteral(GET_FILE_RECORD_QUERY " WHERE parent_hash(path) = ?1 ORDER BY path||'/' ASC"), _db);
+    if (!query) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+    query->bindValue(1, getPHash(path));
+
+    if (!query->exec()) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+
+    forever {
+        auto next = query->next();
+        if (!next.ok) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return false;
+        }
+
+        if (!next.hasData) {
+            break;
+        }
+
+        SyncJournalFileRecord rec;
+        fillFileRecordFromGetQuery(rec, *query);
+        if (!rec._path.startsWith(path) || rec._path.indexOf("/", path.size() + 1) > 0) {
+            qWarning(lcDb) << "hash collision" << path << rec.path();
+            continue;
+        }
+        rowCallback(rec);
+    }
+
+    return true;
+}
+
+bool SyncJournalDb::listSubdirectoriesInPath(const QByteArray &path,
+                                             const std::function<void (const SyncJournalFileRecord &)> &rowCallback)
+{
+    QMutexLocker locker(&_mutex);
+
+    if (_metadataTableIsEmpty) {
+        return true;
+    }
+
+    if (!checkConnect()) {
+        return false;
+    }
+
+    const auto query = _queryManager.get(PreparedSqlQueryManager::ListSubdirectoriesInPathQuery, QByteArrayLiteral(GET_FILE_RECORD_QUERY " WHERE parent_hash(path) = ?1 AND type = ?2 ORDER BY path||'/' ASC"), _db);
+    if (!query) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+    query->bindValue(1, getPHash(path));
+    query->bindValue(2, ItemTypeDirectory);
+
+    if (!query->exec()) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+
+    forever {
+        auto next = query->next();
+        if (!next.ok) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return false;
+        }
+
+        if (!next.hasData) {
+            break;
+        }
+
+        SyncJournalFileRecord rec;
+        fillFileRecordFromGetQuery(rec, *query);
+        if (!rec._path.startsWith(path) || rec._path.indexOf("/", path.size() + 1) > 0) {
+            qWarning(lcDb) << "hash collision" << path << rec.path();
+            continue;
+        }
+        rowCallback(rec);
     }
+
+    return true;
 }
 
-bool SyncJournalDb::listFilesInPath(const QByteArray& path,
-                                    const std::function<void (const SyncJournalFileRecord &)>& rowCallback)
+bool SyncJournalDb::findFileRecordsByName(const QString &term, int limit,
+                                          const std::function<void (const SyncJournalFileRecord &)> &rowCallback)
 {
     QMutexLocker locker(&_mutex);
 
-    if (_metadataTableIsEmpty) {
+    // The trigram index can not look up anything shorter
+    if (term.size() < 3 || _metadataTableIsEmpty) {
         return true;
     }
 
@@ -1513,12 +1880,21 @@ bool SyncJournalDb::listFilesInPath(const QByteArray& path,
         return false;
     }
 
-    const auto query = _queryManager.get(PreparedSqlQueryManager::ListFilesInPathQuery, QByteArrayLiteral(GET_FILE_RECORD_QUERY " WHERE parent_hash(path) = ?1 ORDER BY path||'/' ASC"), _db);
+    if (!_filenameIndexAvailable) {
+        return true;
+    }
+
+    const auto query = _queryManager.get(PreparedSqlQueryManager::FindFileRecordsByNameQuery, QByteArrayLiteral(GET_FILE_RECORD_QUERY " WHERE phash IN (SELECT rowid FROM filenames WHERE name MATCH ?1 ORDER BY rank LIMIT ?2)"), _db);
     if (!query) {
         qCDebug(lcDb) << "database error:" << query->error();
         return false;
     }
-    query->bindValue(1, getPHash(path));
+
+    // Looked up as one phrase in which quotes are doubled
+    auto phrase = term.normalized(QString::NormalizationForm_C);
+    phrase.replace(QLatin1Char('"'), QStringLiteral("\"\""));
+    query->bindValue(1, QString(QLatin1Char('"') + phrase + QLatin1Char('"')));
+    query->bindValue(2, limit);
 
     if (!query->exec()) {
         qCDebug(lcDb) << "database error:" << query->error();
@@ -1538,33 +1914,16 @@ bool SyncJournalDb::listFilesInPath(const QByteArray& path,
 
         SyncJournalFileRecord rec;
         fillFileRecordFromGetQuery(rec, *query);
-        if (!rec._path.startsWith(path) || rec._path.indexOf("/", path.size() + 1) > 0) {
-            qWarning(lcDb) << "hash collision" << path << rec.path();
-            continue;
-        }
         rowCallback(rec);
     }
 
     return true;
 }
 
-int SyncJournalDb::getFileRecordCount()
+bool SyncJournalDb::isFilenameIndexAvailable()
 {
     QMutexLocker locker(&_mutex);
-
-    SqlQuery query(_db);
-    query.prepare("SELECT COUNT(*) FROM metadata");
-
-    if (!query.exec()) {
-        return -1;
-    }
-
-    if (query.next().hasData) {
-        int count = query.intValue(0);
-        return count;
-    }
-
-    return -1;
+    return checkConnect() && _filenameIndexAvailable;
 }
 
 bool SyncJournalDb::updateFileRecordChecksum(const QString &filename,
@@ -1616,6 +1975,11 @@ bool SyncJournalDb::updateLocalMetadata(const QString &filename,
         return false;
     }
 
+    DirectoryAggregate previousAggregate;
+    if (!getRecordAggregate(phash, &previousAggregate)) {
+        return false;
+    }
+
     const auto query = _queryManager.get(PreparedSqlQueryManager::SetFileRecordLocalMetadataQuery, QByteArrayLiteral("UPDATE metadata"
                                                                                                                      " SET inode=?2, modtime=?3, filesize=?4, lock=?5, lockType=?6,"
                                                                                                                      " lockOwnerDisplayName=?7, lockOwnerId=?8, lockOwnerEditor = ?9,"
@@ -1643,7 +2007,12 @@ bool SyncJournalDb::updateLocalMetadata(const QString &filename,
         qCDebug(lcDb) << "database error:" << query->error();
         return false;
     }
-    return true;
+
+    DirectoryAggregate aggregate;
+    if (!getRecordAggregate(phash, &aggregate)) {
+        return false;
+    }
+    return updateDirectoryAggregates(filename.toUtf8(), previousAggregate, aggregate);
 }
 
 Optional<SyncJournalDb::HasHydratedDehydrated> SyncJournalDb::hasHydratedOrDehydratedFiles(const QByteArray &filename)
@@ -1716,6 +2085,128 @@ static bool deleteBatch(SqlQuery &query, const QStringList &entries, const QStri
     return true;
 }
 
+SyncJournalDb::DirectoryAggregate SyncJournalDb::getDirectoryAggregate(const QString &path)
+{
+    QMutexLocker locker(&_mutex);
+
+    DirectoryAggregate res;
+
+    if (checkConnect()) {
+        const auto query = _queryManager.get(PreparedSqlQueryManager::GetDirectoryAggregateQuery, QByteArrayLiteral("SELECT size, filecount, modtime FROM directoryaggregates WHERE path=?1"), _db);
+        if (!query) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return res;
+        }
+
+        // A null QString would be bound as NULL, the sync folder's path is ''
+        query->bindValue(1, path.toUtf8());
+
+        if (!query->exec()) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return res;
+        }
+
+        // Directories without any files have no row
+        const auto next = query->next();
+        if (!next.ok) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return res;
+        }
+        if (next.hasData) {
+            res._size = query->int64Value(0);
+            res._fileCount = query->int64Value(1);
+            res._latestModtime = query->int64Value(2);
+        }
+        res._valid = true;
+    }
+    return res;
+}
+
+bool SyncJournalDb::getRecordAggregate(qint64 phash, DirectoryAggregate *aggregate)
+{
+    *aggregate = recordAggregate(ItemTypeDirectory, 0, 0);
+    if (_metadataTableIsEmpty) {
+        return true;
+    }
+
+    const auto query = _queryManager.get(PreparedSqlQueryManager::GetRecordAggregateQuery, QByteArrayLiteral("SELECT type, filesize, modtime FROM metadata WHERE phash=?1"), _db);
+    if (!query) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+
+    query->bindValue(1, phash);
+
+    if (!query->exec()) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+
+    const auto next = query->next();
+    if (!next.ok) {
+        qCDebug(lcDb) << "database error:" << query->error();
+        return false;
+    }
+    if (next.hasData) {
+        *aggregate = recordAggregate(query->intValue(0), query->int64Value(1), query->int64Value(2));
+    }
+    return true;
+}
+
+bool SyncJournalDb::updateDirectoryAggregates(const QByteArray &path, const DirectoryAggregate &before, const DirectoryAggregate &after)
+{
+    const auto sizeDelta = after._size - before._size;
+    const auto fileCountDelta = after._fileCount - before._fileCount;
+    // The parents have seen the previous modtime already
+    if (sizeDelta == 0 && fileCountDelta == 0 && after._latestModtime <= before._latestModtime) {
+        return true;
+    }
+
+    const auto updateQuery = _queryManager.get(PreparedSqlQueryManager::UpdateDirectoryAggregateQuery, QByteArrayLiteral("UPDATE directoryaggregates"
+                                                                                                                         " SET size = size + ?2, filecount = filecount + ?3, modtime = MAX(modtime, ?4)"
+                                                                                                                         " WHERE path=?1"),
+        _db);
+    if (!updateQuery) {
+        qCDebug(lcDb) << "database error:" << updateQuery->error();
+        return false;
+    }
+    const auto insertQuery = _queryManager.get(PreparedSqlQueryManager::InsertDirectoryAggregateQuery, QByteArrayLiteral("INSERT INTO directoryaggregates (path, size, filecount, modtime) VALUES (?1, ?2, ?3, ?4)"), _db);
+    if (!insertQuery) {
+        qCDebug(lcDb) << "database error:" << insertQuery->error();
+        return false;
+    }
+
+    auto parent = path;
+    do {
+        const auto slashIndex = parent.lastIndexOf('/');
+        parent.truncate(slashIndex > 0 ? slashIndex : 0);
+
+        updateQuery->bindValue(1, parent);
+        updateQuery->bindValue(2, sizeDelta);
+        updateQuery->bindValue(3, fileCountDelta);
+        updateQuery->bindValue(4, after._latestModtime);
+        if (!updateQuery->exec()) {
+            qCDebug(lcDb) << "database error:" << updateQuery->error();
+            return false;
+        }
+        if (updateQuery->numRowsAffected() > 0) {
+            continue;
+        }
+
+        // The first file below this directory
+        insertQuery->bindValue(1, parent);
+        insertQuery->bindValue(2, sizeDelta);
+        insertQuery->bindValue(3, fileCountDelta);
+        insertQuery->bindValue(4, after._latestModtime);
+        if (!insertQuery->exec()) {
+            qCDebug(lcDb) << "database error:" << insertQuery->error();
+            return false;
+        }
+    } while (!parent.isEmpty());
+
+    return true;
+}
+
 SyncJournalDb::DownloadInfo SyncJournalDb::getDownloadInfo(const QString &file)
 {
     QMutexLocker locker(&_mutex);
@@ -1956,6 +2447,78 @@ QVector<uint> SyncJournalDb::deleteStaleUploadInfos(const QSet<QString> &keep)
     return ids;
 }
 
+SyncJournalDb::ContentChunksInfo SyncJournalDb::getContentChunks(const QString &file)
+{
+    QMutexLocker locker(&_mutex);
+
+    ContentChunksInfo res;
+
+    if (checkConnect()) {
+        const auto query = _queryManager.get(PreparedSqlQueryManager::GetContentChunksQuery, QByteArrayLiteral("SELECT etag, averagesize, chunks FROM contentchunks WHERE path=?1"), _db);
+        if (!query) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return res;
+        }
+        query->bindValue(1, file);
+
+        if (!query->exec()) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return res;
+        }
+
+        if (query->next().hasData) {
+            res._etag = query->baValue(0);
+            res._averageSize = query->int64Value(1);
+            res._chunks = query->baValue(2);
+            res._valid = true;
+        }
+    }
+    return res;
+}
+
+void SyncJournalDb::setContentChunks(const QString &file, const ContentChunksInfo &info)
+{
+    QMutexLocker locker(&_mutex);
+
+    if (!checkConnect()) {
+        return;
+    }
+
+    if (info._valid) {
+        const auto query = _queryManager.get(PreparedSqlQueryManager::SetContentChunksQuery, QByteArrayLiteral("INSERT OR REPLACE INTO contentchunks "
+                                                                                                              "(path, etag, averagesize, chunks) "
+                                                                                                              "VALUES (?1, ?2, ?3, ?4)"),
+            _db);
+        if (!query) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return;
+        }
+
+        query->bindValue(1, file);
+        query->bindValue(2, info._etag);
+        query->bindValue(3, info._averageSize);
+        query->bindValue(4, info._chunks);
+
+        if (!query->exec()) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return;
+        }
+    } else {
+        const auto query = _queryManager.get(PreparedSqlQueryManager::DeleteContentChunksQuery, QByteArrayLiteral("DELETE FROM contentchunks WHERE path=?1"), _db);
+        if (!query) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return;
+        }
+
+        query->bindValue(1, file);
+
+        if (!query->exec()) {
+            qCDebug(lcDb) << "database error:" << query->error();
+            return;
+        }
+    }
+}
+
 SyncJournalErrorBlacklistRecord SyncJournalDb::errorBlacklistEntry(const QString &file)
 {
     QMutexLocker locker(&_mutex);
@@ -2033,6 +2596,7 @@ void SyncJournalDb::deleteStaleFlagsEntries()
     if (!delQuery.exec()) {
         sqlFail(QStringLiteral("deleteStaleFlagsEntries"), delQuery);
     }
+    _pinStatesLoaded = false;
 }
 
 int SyncJournalDb::errorBlackListEntryCount()
@@ -2712,6 +3276,23 @@ void SyncJournalDb::clearFileTable()
         qCDebug(lcDb) << "database error:" << query.error();
         sqlFail(QStringLiteral("clearFileTable"), query);
     }
+
+    query.prepare("DELETE FROM directoryaggregates;");
+    if (!query.exec()) {
+        sqlFail(QStringLiteral("clearFileTable: directory aggregates"), query);
+    }
+
+    query.prepare("DELETE FROM contentchunks;");
+    if (!query.exec()) {
+        sqlFail(QStringLiteral("clearFileTable: content chunks"), query);
+    }
+
+    if (_filenameIndexAvailable) {
+        query.prepare("DELETE FROM filenames;");
+        if (!query.exec()) {
+            sqlFail(QStringLiteral("clearFileTable: filename index"), query);
+        }
+    }
 }
 
 void SyncJournalDb::markVirtualFileForDownloadRecursively(const QByteArray &path)
@@ -2837,113 +3418,68 @@ void SyncJournalDb::deleteE2EeLockedFolder(const QByteArray &folderId)
     }
 }
 
-Optional<PinState> SyncJournalDb::PinStateInterface::rawForPath(const QByteArray &path)
+bool SyncJournalDb::ensurePinStatesLoaded()
 {
-    QMutexLocker lock(&_db->_mutex);
-    if (!_db->checkConnect())
-        return {};
+    if (_pinStatesLoaded) {
+        return true;
+    }
 
-    const auto query = _db->_queryManager.get(PreparedSqlQueryManager::GetRawPinStateQuery, QByteArrayLiteral("SELECT pinState FROM flags WHERE path == ?1;"), _db->_db);
-    if (!query) {
-        qCDebug(lcDb) << "database error:" << query->error();
-        return {};
+    SqlQuery query("SELECT path, pinState FROM flags;", _db);
+    if (!query.exec()) {
+        qCWarning(lcDb) << "database error:" << query.error();
+        return false;
     }
-    query->bindValue(1, path);
-    if (!query->exec()) {
-        qCDebug(lcDb) << "database error:" << query->error();
-        return {};
+
+    _pinStates.clear();
+    forever {
+        auto next = query.next();
+        if (!next.ok) {
+            qCWarning(lcDb) << "database error:" << query.error();
+            _pinStates.clear();
+            return false;
+        }
+        if (!next.hasData) {
+            break;
+        }
+        const auto state = query.intValue(1);
+        if (state < static_cast<int>(PinState::Inherited) || state > static_cast<int>(PinState::Excluded)) {
+            qCWarning(lcDb) << "Ignoring invalid pin state" << state << "of" << query.baValue(0);
+            continue;
+        }
+        _pinStates.setForPath(query.baValue(0), static_cast<PinState>(state));
     }
+    _pinStatesLoaded = true;
+    return true;
+}
 
-    auto next = query->next();
-    if (!next.ok)
+Optional<PinState> SyncJournalDb::PinStateInterface::rawForPath(const QByteArray &path)
+{
+    QMutexLocker lock(&_db->_mutex);
+    if (!_db->checkConnect() || !_db->ensurePinStatesLoaded())
         return {};
-    // no-entry means Inherited
-    if (!next.hasData)
-        return PinState::Inherited;
 
-    return static_cast<PinState>(query->intValue(0));
+    // no-entry means Inherited
+    return _db->_pinStates.rawForPath(path);
 }
 
 Optional<PinState> SyncJournalDb::PinStateInterface::effectiveForPath(const QByteArray &path)
 {
     QMutexLocker lock(&_db->_mutex);
-    if (!_db->checkConnect()) {
-        return {};
-    }
-
-    const auto query = _db->_queryManager.get(PreparedSqlQueryManager::GetEffectivePinStateQuery, QByteArrayLiteral("SELECT pinState FROM flags WHERE"
-                                                                                                                    // explicitly allow "" to represent the root path
-                                                                                                                    // (it'd be great if paths started with a / and "/" could be the root)
-                                                                                                                    " (" IS_PREFIX_PATH_OR_EQUAL("path", "?1") " OR path == '')"
-                                                                                                                                                               " AND pinState is not null AND pinState != 0"
-                                                                                                                                                               " ORDER BY length(path) DESC LIMIT 1;"),
-        _db->_db);
-    if (!query) {
-        qCDebug(lcDb) << "database error:" << query->error();
-        return {};
-    }
-    query->bindValue(1, path);
-    if (!query->exec()) {
-        qCDebug(lcDb) << "database error:" << query->error();
+    if (!_db->checkConnect() || !_db->ensurePinStatesLoaded()) {
         return {};
     }
 
-    auto next = query->next();
-    if (!next.ok)
-        return {};
-    // If the root path has no setting, assume AlwaysLocal
-    if (!next.hasData)
-        return PinState::AlwaysLocal;
-
-    return static_cast<PinState>(query->intValue(0));
+    return _db->_pinStates.effectiveForPath(path);
 }
 
 Optional<PinState> SyncJournalDb::PinStateInterface::effectiveForPathRecursive(const QByteArray &path)
 {
-    // Get the item's effective pin state. We'll compare subitem's pin states
-    // against this.
-    const auto basePin = effectiveForPath(path);
-    if (!basePin) {
-        return {};
-    }
-
     QMutexLocker lock(&_db->_mutex);
-    if (!_db->checkConnect()) {
-        return {};
-    }
-
-    // Find all the non-inherited pin states below the item
-    const auto query = _db->_queryManager.get(PreparedSqlQueryManager::GetSubPinsQuery, QByteArrayLiteral("SELECT DISTINCT pinState FROM flags WHERE"
-                                                                                                          " (" IS_PREFIX_PATH_OF("?1", "path") " OR ?1 == '')"
-                                                                                                                                               " AND pinState is not null and pinState != 0;"),
-        _db->_db);
-    if (!query) {
-        qCDebug(lcDb) << "database error:" << query->error();
-        return {};
-    }
-    query->bindValue(1, path);
-    if (!query->exec()) {
-        qCDebug(lcDb) << "database error:" << query->error();
+    if (!_db->checkConnect() || !_db->ensurePinStatesLoaded()) {
         return {};
     }
 
-    // Check if they are all identical
-    forever {
-        auto next = query->next();
-        if (!next.ok) {
-            qCDebug(lcDb) << "database error:" << query->error();
-            return {};
-        }
-        if (!next.hasData) {
-            break;
-        }
-        const auto subPin = static_cast<PinState>(query->intValue(0));
-        if (subPin != *basePin) {
-            return PinState::Inherited;
-        }
-    }
-
-    return *basePin;
+    return _db->_pinStates.effectiveForPathRecursive(path);
 }
 
 void SyncJournalDb::PinStateInterface::setForPath(const QByteArray &path, PinState state)
@@ -2969,6 +3505,11 @@ void SyncJournalDb::PinStateInterface::setForPath(const QByteArray &path, PinSta
     query->bindValue(2, state);
     if (!query->exec()) {
         qCDebug(lcDb) << "database error:" << query->error();
+        _db->_pinStatesLoaded = false;
+        return;
+    }
+    if (_db->_pinStatesLoaded) {
+        _db->_pinStates.setForPath(path, state);
     }
 }
 
@@ -2990,6 +3531,11 @@ void SyncJournalDb::PinStateInterface::wipeForPathAndBelow(const QByteArray &pat
     query->bindValue(1, path);
     if (!query->exec()) {
         qCDebug(lcDb) << "database error:" << query->error();
+        _db->_pinStatesLoaded = false;
+        return;
+    }
+    if (_db->_pinStatesLoaded) {
+        _db->_pinStates.wipeForPathAndBelow(path);
     }
 }
 
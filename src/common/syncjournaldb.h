@@ -32,6 +32,7 @@
 #include "common/syncjournalfilerecord.h"
 #include "common/result.h"
 #include "common/pinstate.h"
+#include "common/pinstatetrie.h"
 
 namespace OCC {
 class SyncJournalFileRecord;
@@ -69,6 +70,18 @@ public:
     [[nodiscard]] bool getFileRecordsByFileId(const QByteArray &fileId, const std::function<void(const SyncJournalFileRecord &)> &rowCallback);
     [[nodiscard]] bool getFilesBelowPath(const QByteArray &path, const std::function<void(const SyncJournalFileRecord&)> &rowCallback);
     [[nodiscard]] bool listFilesInPath(const QByteArray &path, const std::function<void(const SyncJournalFileRecord&)> &rowCallback);
+    /// Lists the directories directly inside \a path, the empty path lists the top level directories
+    [[nodiscard]] bool listSubdirectoriesInPath(const QByteArray &path, const std::function<void(const SyncJournalFileRecord&)> &rowCallback);
+    /**
+     * Finds up to \a limit records whose file name contains \a term, ignoring the case.
+     *
+     * Looks the names up in the filename index. Terms shorter than three
+     * characters find nothing, and neither does a journal without the index
+     * because SQLite was built without FTS5 or is older than 3.34.
+     */
+    [[nodiscard]] bool findFileRecordsByName(const QString &term, int limit, const std::function<void(const SyncJournalFileRecord &)> &rowCallback);
+    /// Whether findFileRecordsByName() can find anything
+    [[nodiscard]] bool isFilenameIndexAvailable();
     [[nodiscard]] Result<void, QString> setFileRecord(const SyncJournalFileRecord &record);
     [[nodiscard]] bool getRootE2eFolderRecord(const QString &remoteFolderPath, SyncJournalFileRecord *rec);
     [[nodiscard]] bool listAllE2eeFoldersWithEncryptionStatusLessThan(const int status, const std::function<void(const SyncJournalFileRecord &)> &rowCallback);
@@ -141,6 +154,25 @@ public:
         qint64 _fileSize = 0LL;
     };
 
+    /**
+     * Totals of a directory's subtree, updated with every record write.
+     *
+     * The size adds up the files and the placeholders, the file count only
+     * the files that are available locally (SyncJournalFileRecord::isFile()).
+     * The modtime is the newest one written below the directory, deleting
+     * files does not lower it.
+     */
+    struct DirectoryAggregate
+    {
+        qint64 _size = 0;
+        qint64 _fileCount = 0;
+        qint64 _latestModtime = 0;
+        bool _valid = false;
+    };
+
+    /// The empty path is the sync folder. Not \a _valid if the journal could not be read.
+    DirectoryAggregate getDirectoryAggregate(const QString &path);
+
     DownloadInfo getDownloadInfo(const QString &file);
     void setDownloadInfo(const QString &file, const DownloadInfo &i);
     QVector<DownloadInfo> getAndDeleteStaleDownloadInfos(const QSet<QString> &keep);
@@ -151,6 +183,22 @@ public:
     // Return the list of transfer ids that were removed.
     QVector<uint> deleteStaleUploadInfos(const QSet<QString> &keep);
 
+    /**
+     * The content-defined chunks of a file's version on the server, see
+     * ContentChunker. Used to upload only the changed parts of the next version.
+     */
+    struct ContentChunksInfo
+    {
+        QByteArray _etag; /// the version the chunks describe
+        qint64 _averageSize = 0;
+        QByteArray _chunks; /// ContentChunker::serialize()
+        bool _valid = false;
+    };
+
+    ContentChunksInfo getContentChunks(const QString &file);
+    /// An invalid \a info removes the entry
+    void setContentChunks(const QString &file, const ContentChunksInfo &info);
+
     SyncJournalErrorBlacklistRecord errorBlacklistEntry(const QString &);
     [[nodiscard]] bool deleteStaleErrorBlacklistEntries(const QSet<QString> &keep);
 
@@ -301,6 +349,9 @@ public:
     /** Grouping for all functions relating to pin states,
      *
      * Use internalPinStates() to get at them.
+     *
+     * The pin states are read from the database once and then looked up in
+     * memory, changes are written to both.
      */
     struct OCSYNC_EXPORT PinStateInterface
     {
@@ -401,10 +452,18 @@ public slots:
     void deleteCaseClashConflictByPathRecord(const QString &path);
 
 private:
-    int getFileRecordCount();
     [[nodiscard]] bool updateDatabaseStructure();
+    bool createTables();
+    bool isSchemaUpToDate();
     [[nodiscard]] bool updateMetadataTableStructure();
     [[nodiscard]] bool updateErrorBlacklistTableStructure();
+    [[nodiscard]] bool updateFilenameIndex();
+    [[nodiscard]] bool updateDirectoryAggregatesTable();
+
+    // What the stored record with \a phash adds to the aggregates of its parents
+    [[nodiscard]] bool getRecordAggregate(qint64 phash, DirectoryAggregate *aggregate);
+    // Replaces \a before with \a after in the aggregates of all parents of \a path
+    [[nodiscard]] bool updateDirectoryAggregates(const QByteArray &path, const DirectoryAggregate &before, const DirectoryAggregate &after);
     bool sqlFail(const QString &log, const SqlQuery &query);
     void commitInternal(const QString &context, bool startTrans = true);
     void startTransaction();
@@ -415,6 +474,9 @@ private:
     // Same as forceRemoteDiscoveryNextSync but without acquiring the lock
     void forceRemoteDiscoveryNextSyncLocked();
 
+    // Fills _pinStates from the flags table unless that was done already
+    bool ensurePinStatesLoaded();
+
     // Returns the integer id of the checksum type
     //
     // Returns 0 on failure and for empty checksum types.
@@ -426,6 +488,11 @@ private:
     QMap<QByteArray, int> _checksymTypeCache;
     int _transaction = 0;
     bool _metadataTableIsEmpty = false;
+    bool _filenameIndexAvailable = false;
+
+    // The content of the flags table, valid while _pinStatesLoaded is set
+    PinStateTrie _pinStates;
+    bool _pinStatesLoaded = false;
 
     /* Storing etags to these folders, or their parent folders, is filtered out.
      *
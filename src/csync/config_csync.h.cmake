@@ -11,4 +11,6 @@
 #cmakedefine HAVE_UTIMES 1
 #cmakedefine HAVE_LSTAT 1
 
+#cmakedefine HAVE_LIBURING 1
+
 
@@ -37,6 +37,7 @@
 #include <QString>
 #include <QFileInfo>
 #include <QDir>
+#include <QMutex>
 #include <QVariant>
 
 /** Expands C-like escape sequences (in place)
@@ -316,37 +317,13 @@ void ExcludedFiles::loadExcludeFilePatterns(const QString &basePath, QFile &file
 bool ExcludedFiles::reloadExcludeFiles()
 {
     _allExcludes.clear();
-    // clear all regex
-    _bnameTraversalRegexFile.clear();
-    _bnameTraversalRegexDir.clear();
-    _fullTraversalRegexFile.clear();
-    _fullTraversalRegexDir.clear();
-    _fullRegexFile.clear();
-    _fullRegexDir.clear();
+    _patternSets.clear();
 
     bool success = true;
     const auto keys = _excludeFiles.keys();
     for (const auto& basePath : keys) {
-        const auto itValue = _excludeFiles.find(basePath);
-        if (itValue == std::end(_excludeFiles)) {
-            continue;
-        }
-        auto &excludeFiles = *itValue;
-        for (auto excludeFileIt = std::begin(excludeFiles); excludeFileIt != std::end(excludeFiles); ) {
-            const auto &excludeFile = *excludeFileIt;
-            QFile file(excludeFile);
-            if (!file.exists()) {
-                excludeFileIt = excludeFiles.erase(excludeFileIt);
-                continue;
-            }
-
-            if (file.open(QIODevice::ReadOnly)) {
-                loadExcludeFilePatterns(basePath, file);
-            } else {
-                success = false;
-                qWarning() << "System exclude list file could not be opened:" << excludeFile;
-            }
-            ++excludeFileIt;
+        if (!loadExcludeFiles(basePath)) {
+            success = false;
         }
     }
 
@@ -359,6 +336,46 @@ bool ExcludedFiles::reloadExcludeFiles()
     return success;
 }
 
+void ExcludedFiles::reloadDirectoryExcludeFiles(const BasePathString &basePath)
+{
+    _allExcludes.remove(basePath);
+    _patternSets.remove(basePath);
+
+    loadExcludeFiles(basePath);
+    const auto manualExcludes = _manualExcludes.value(basePath);
+    if (!manualExcludes.isEmpty()) {
+        _allExcludes[basePath].append(manualExcludes);
+        prepare(basePath);
+    }
+}
+
+bool ExcludedFiles::loadExcludeFiles(const BasePathString &basePath)
+{
+    const auto itValue = _excludeFiles.find(basePath);
+    if (itValue == std::end(_excludeFiles)) {
+        return true;
+    }
+    bool success = true;
+    auto &excludeFiles = *itValue;
+    for (auto excludeFileIt = std::begin(excludeFiles); excludeFileIt != std::end(excludeFiles); ) {
+        const auto &excludeFile = *excludeFileIt;
+        QFile file(excludeFile);
+        if (!file.exists()) {
+            excludeFileIt = excludeFiles.erase(excludeFileIt);
+            continue;
+        }
+
+        if (file.open(QIODevice::ReadOnly)) {
+            loadExcludeFilePatterns(basePath, file);
+        } else {
+            success = false;
+            qWarning() << "System exclude list file could not be opened:" << excludeFile;
+        }
+        ++excludeFileIt;
+    }
+    return success;
+}
+
 bool ExcludedFiles::versionDirectiveKeepNextLine(const QByteArray &directive) const
 {
     if (!directive.startsWith("#!version"))
@@ -439,7 +456,8 @@ CSYNC_EXCLUDE_TYPE ExcludedFiles::traversalPatternMatch(const QString &path, Ite
         const QString absolutePath = basePath + QStringLiteral(".sync-exclude.lst");
         if (FileSystem::isReadable(absolutePath)) {
             addExcludeFilePath(absolutePath);
-            reloadExcludeFiles();
+            // Only the patterns of this directory change
+            reloadDirectoryExcludeFiles(basePath);
         } else {
 #if !defined QT_NO_DEBUG
             qWarning() << "System exclude list file could not be read:" << absolutePath;
@@ -458,13 +476,12 @@ CSYNC_EXCLUDE_TYPE ExcludedFiles::traversalPatternMatch(const QString &path, Ite
     QString basePath(_localPath + path);
     while (basePath.size() > _localPath.size()) {
         basePath = leftIncludeLast(basePath, QLatin1Char('/'));
+        const auto patternSet = _patternSets.value(basePath);
         QRegularExpressionMatch m;
-        if (filetype == ItemTypeDirectory
-            && _bnameTraversalRegexDir.contains(basePath)) {
-            m = _bnameTraversalRegexDir[basePath].match(bnameStr);
-        } else if (filetype == ItemTypeFile
-            && _bnameTraversalRegexFile.contains(basePath)) {
-            m = _bnameTraversalRegexFile[basePath].match(bnameStr);
+        if (filetype == ItemTypeDirectory && patternSet) {
+            m = patternSet->bnameTraversalRegexDir.match(bnameStr);
+        } else if (filetype == ItemTypeFile && patternSet) {
+            m = patternSet->bnameTraversalRegexFile.match(bnameStr);
         } else {
             continue;
         }
@@ -482,13 +499,12 @@ CSYNC_EXCLUDE_TYPE ExcludedFiles::traversalPatternMatch(const QString &path, Ite
     basePath = _localPath + path;
     while (basePath.size() > _localPath.size()) {
         basePath = leftIncludeLast(basePath, QLatin1Char('/'));
+        const auto patternSet = _patternSets.value(basePath);
         QRegularExpressionMatch m;
-        if (filetype == ItemTypeDirectory
-            && _fullTraversalRegexDir.contains(basePath)) {
-            m = _fullTraversalRegexDir[basePath].match(path);
-        } else if (filetype == ItemTypeFile
-            && _fullTraversalRegexFile.contains(basePath)) {
-            m = _fullTraversalRegexFile[basePath].match(path);
+        if (filetype == ItemTypeDirectory && patternSet) {
+            m = patternSet->fullTraversalRegexDir.match(path);
+        } else if (filetype == ItemTypeFile && patternSet) {
+            m = patternSet->fullTraversalRegexFile.match(path);
         } else {
             continue;
         }
@@ -521,13 +537,12 @@ CSYNC_EXCLUDE_TYPE ExcludedFiles::fullPatternMatch(const QString &p, ItemType fi
     QString basePath(_localPath + path);
     while (basePath.size() > _localPath.size()) {
         basePath = leftIncludeLast(basePath, QLatin1Char('/'));
+        const auto patternSet = _patternSets.value(basePath);
         QRegularExpressionMatch m;
-        if (filetype == ItemTypeDirectory
-            && _fullRegexDir.contains(basePath)) {
-            m = _fullRegexDir[basePath].match(p);
-        } else if (filetype == ItemTypeFile
-            && _fullRegexFile.contains(basePath)) {
-            m = _fullRegexFile[basePath].match(p);
+        if (filetype == ItemTypeDirectory && patternSet) {
+            m = patternSet->fullRegexDir.match(p);
+        } else if (filetype == ItemTypeFile && patternSet) {
+            m = patternSet->fullRegexFile.match(p);
         } else {
             continue;
         }
@@ -677,35 +692,56 @@ QString ExcludedFiles::extractBnameTrigger(const QString &exclude, bool wildcard
 
 void ExcludedFiles::prepare()
 {
-    // clear all regex
-    _bnameTraversalRegexFile.clear();
-    _bnameTraversalRegexDir.clear();
-    _fullTraversalRegexFile.clear();
-    _fullTraversalRegexDir.clear();
-    _fullRegexFile.clear();
-    _fullRegexDir.clear();
+    _patternSets.clear();
 
     const auto keys = _allExcludes.keys();
     for (auto const & basePath : keys)
         prepare(basePath);
 }
 
-void ExcludedFiles::prepare(const BasePathString & basePath)
+void ExcludedFiles::prepare(const BasePathString &basePath)
 {
     Q_ASSERT(_allExcludes.contains(basePath));
 
+    // The full patterns are matched against paths relative to _localPath, basePath
+    // is contained in _localPath
+    _patternSets[basePath] = sharedPatternSet(_allExcludes.value(basePath), basePath.mid(_localPath.size()), _wildcardsMatchSlash);
+}
+
+ExcludedFiles::PatternSetPtr ExcludedFiles::sharedPatternSet(const QStringList &patterns, const QString &relativeBasePath, bool wildcardsMatchSlash)
+{
+    static QMutex mutex;
+    static QHash<QString, std::weak_ptr<const PatternSet>> cache;
+
+    const auto key = QString(relativeBasePath + QChar(0) + QLatin1Char(wildcardsMatchSlash ? '1' : '0')
+        + QLatin1Char(OCC::Utility::fsCasePreserving() ? '1' : '0') + QChar(0) + patterns.join(QChar(0)));
+
+    QMutexLocker locker(&mutex);
+    if (auto patternSet = cache.value(key).lock()) {
+        return patternSet;
+    }
+    auto patternSet = buildPatternSet(patterns, relativeBasePath, wildcardsMatchSlash);
+    for (auto it = cache.begin(); it != cache.end();) {
+        it = it->expired() ? cache.erase(it) : std::next(it);
+    }
+    cache.insert(key, patternSet);
+    return patternSet;
+}
+
+ExcludedFiles::PatternSetPtr ExcludedFiles::buildPatternSet(const QStringList &patterns, const QString &relativeBasePath, bool wildcardsMatchSlash)
+{
     // Build regular expressions for the different cases.
     //
-    // To compose the _bnameTraversalRegex, _fullTraversalRegex and _fullRegex
+    // To compose the bnameTraversalRegex, fullTraversalRegex and fullRegex
     // patterns we collect several subgroups of patterns here.
     //
     // * The "full" group will contain all patterns that contain a non-trailing
     //   slash. They only make sense in the fullRegex and fullTraversalRegex.
     // * The "bname" group contains all patterns without a non-trailing slash.
-    //   These need separate handling in the _fullRegex (slash-containing
+    //   These need separate handling in the fullRegex (slash-containing
     //   patterns must be anchored to the front, these don't need it)
     // * The "bnameTrigger" group contains the bname part of all patterns in the
-    //   "full" group. These and the "bname" group become _bnameTraversalRegex.
+    //   "full" group. These and the "bname" group become bnameTraversalRegex.
     //
     // To complicate matters, the exclude patterns have two binary attributes
     // meaning we'll end up with 4 variants:
@@ -735,7 +771,7 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
         pattern.append(appendMe);
     };
 
-    for (auto exclude : _allExcludes.value(basePath)) {
+    for (auto exclude : patterns) {
         if (exclude[0] == QLatin1Char('\n'))
             continue; // empty line
         if (exclude[0] == QLatin1Char('\r'))
@@ -759,21 +795,17 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
 
         if (fullPath) {
             // The full pattern is matched against a path relative to _localPath, however exclude is
-            // relative to basePath at this point.
-            // We know for sure that both _localPath and basePath are absolute and that basePath is
-            // contained in _localPath. So we can simply remove it from the begining.
-            auto relPath = basePath.mid(_localPath.size());
-            // Make exclude relative to _localPath
-            exclude.prepend(relPath);
+            // relative to basePath at this point. Make exclude relative to _localPath
+            exclude.prepend(relativeBasePath);
         }
-        auto regexExclude = convertToRegexpSyntax(exclude, _wildcardsMatchSlash);
+        auto regexExclude = convertToRegexpSyntax(exclude, wildcardsMatchSlash);
         if (!fullPath) {
             regexAppend(bnameFileDir, bnameDir, regexExclude, matchDirOnly);
         } else {
             regexAppend(fullFileDir, fullDir, regexExclude, matchDirOnly);
 
             // For activation, trigger on the 'bname' part of the full pattern.
-            QString bnameExclude = extractBnameTrigger(exclude, _wildcardsMatchSlash);
+            QString bnameExclude = extractBnameTrigger(exclude, wildcardsMatchSlash);
             auto regexBname = convertToRegexpSyntax(bnameExclude, true);
             regexAppend(bnameTriggerFileDir, bnameTriggerDir, regexBname, matchDirOnly);
         }
@@ -802,12 +834,13 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
     // (exclude)|(excluderemove)|(bname triggers).
     // If the third group matches, the fullActivatedRegex needs to be applied
     // to the full path.
-    _bnameTraversalRegexFile[basePath].setPattern(
+    PatternSet patternSet;
+    patternSet.bnameTraversalRegexFile.setPattern(
         QStringLiteral("^(?P<exclude>%1)$|"
                        "^(?P<excluderemove>%2)$|"
                        "^(?P<trigger>%3)$")
             .arg(bnameFileDirKeep, bnameFileDirRemove, bnameTriggerFileDir));
-    _bnameTraversalRegexDir[basePath].setPattern(
+    patternSet.bnameTraversalRegexDir.setPattern(
         QStringLiteral("^(?P<exclude>%1|%2)$|"
                        "^(?P<excluderemove>%3|%4)$|"
                        "^(?P<trigger>%5|%6)$")
@@ -817,13 +850,13 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
     // the bname regex matches. Its basic form is (exclude)|(excluderemove)".
     // This pattern can be much simpler than fullRegex since we can assume a traversal
     // situation and doesn't need to look for bname patterns in parent paths.
-    _fullTraversalRegexFile[basePath].setPattern(
+    patternSet.fullTraversalRegexFile.setPattern(
         // Full patterns are anchored to the beginning
         QStringLiteral("^(?P<exclude>%1)(?:$|/)"
                        "|"
                        "^(?P<excluderemove>%2)(?:$|/)")
             .arg(fullFileDirKeep, fullFileDirRemove));
-    _fullTraversalRegexDir[basePath].setPattern(
+    patternSet.fullTraversalRegexDir.setPattern(
         QStringLiteral("^(?P<exclude>%1|%2)(?:$|/)"
                        "|"
                        "^(?P<excluderemove>%3|%4)(?:$|/)")
@@ -831,7 +864,7 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
 
     // The full regex is applied to the full path and incorporates both bname and
     // full-path patterns. It has the form "(exclude)|(excluderemove)".
-    _fullRegexFile[basePath].setPattern(
+    patternSet.fullRegexFile.setPattern(
         QStringLiteral("(?P<exclude>"
                        // Full patterns are anchored to the beginning
                        "^(?:%1)(?:$|/)|"
@@ -846,7 +879,7 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
                        "(?:^|/)(?:%5)(?:$|/)|"
                        "(?:^|/)(?:%6)/)")
             .arg(fullFileDirKeep, bnameFileDirKeep, bnameDirKeep, fullFileDirRemove, bnameFileDirRemove, bnameDirRemove));
-    _fullRegexDir[basePath].setPattern(
+    patternSet.fullRegexDir.setPattern(
         QStringLiteral("(?P<exclude>"
                        "^(?:%1|%2)(?:$|/)|"
                        "(?:^|/)(?:%3|%4)(?:$|/))"
@@ -859,16 +892,18 @@ void ExcludedFiles::prepare(const BasePathString & basePath)
     QRegularExpression::PatternOptions patternOptions = QRegularExpression::NoPatternOption;
     if (OCC::Utility::fsCasePreserving())
         patternOptions |= QRegularExpression::CaseInsensitiveOption;
-    _bnameTraversalRegexFile[basePath].setPatternOptions(patternOptions);
-    _bnameTraversalRegexFile[basePath].optimize();
-    _bnameTraversalRegexDir[basePath].setPatternOptions(patternOptions);
-    _bnameTraversalRegexDir[basePath].optimize();
-    _fullTraversalRegexFile[basePath].setPatternOptions(patternOptions);
-    _fullTraversalRegexFile[basePath].optimize();
-    _fullTraversalRegexDir[basePath].setPatternOptions(patternOptions);
-    _fullTraversalRegexDir[basePath].optimize();
-    _fullRegexFile[basePath].setPatternOptions(patternOptions);
-    _fullRegexFile[basePath].optimize();
-    _fullRegexDir[basePath].setPatternOptions(patternOptions);
-    _fullRegexDir[basePath].optimize();
+    patternSet.bnameTraversalRegexFile.setPatternOptions(patternOptions);
+    patternSet.bnameTraversalRegexFile.optimize();
+    patternSet.bnameTraversalRegexDir.setPatternOptions(patternOptions);
+    patternSet.bnameTraversalRegexDir.optimize();
+    patternSet.fullTraversalRegexFile.setPatternOptions(patternOptions);
+    patternSet.fullTraversalRegexFile.optimize();
+    patternSet.fullTraversalRegexDir.setPatternOptions(patternOptions);
+    patternSet.fullTraversalRegexDir.optimize();
+    patternSet.fullRegexFile.setPatternOptions(patternOptions);
+    patternSet.fullRegexFile.optimize();
+    patternSet.fullRegexDir.setPatternOptions(patternOptions);
+    patternSet.fullRegexDir.optimize();
+
+    return std::make_shared<const PatternSet>(std::move(patternSet));
 }
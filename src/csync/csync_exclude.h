@@ -31,6 +31,7 @@
 #include <QRegularExpression>
 
 #include <functional>
+#include <memory>
 
 enum CSYNC_EXCLUDE_TYPE {
   CSYNC_NOT_EXCLUDED   = 0,
@@ -198,11 +199,16 @@ private:
         }
     };
 
+    /// Reloads the exclude files of \a basePath only, the other patterns are kept
+    void reloadDirectoryExcludeFiles(const BasePathString &basePath);
+    /// Appends the patterns of the exclude files of \a basePath to _allExcludes
+    bool loadExcludeFiles(const BasePathString &basePath);
+
     /**
      * Generate optimized regular expressions for the exclude patterns anchored to basePath.
      *
      * The optimization works in two steps: First, all supported patterns are put
-     * into _fullRegexFile/_fullRegexDir. These regexes can be applied to the full
+     * into fullRegexFile/fullRegexDir of the PatternSet. These regexes can be applied to the full
      * path to determine whether it is excluded or not.
      *
      * The second is a performance optimization. The particularly common use
@@ -219,8 +225,8 @@ private:
      *   full("a/b/c/d") == traversal("a") || traversal("a/b") || traversal("a/b/c")
      *
      * The traversal matcher can be extremely fast because it has a fast early-out
-     * case: It checks the bname part of the path against _bnameTraversalRegex
-     * and only runs a simplified _fullTraversalRegex on the whole path if bname
+     * case: It checks the bname part of the path against bnameTraversalRegex
+     * and only runs a simplified fullTraversalRegex on the whole path if bname
      * activation for it was triggered.
      *
      * Note: The traversal matcher will return not-excluded on some paths that the
@@ -231,6 +237,27 @@ private:
 
     void prepare();
 
+    /// The compiled regular expressions of one base path, see prepare()
+    struct PatternSet
+    {
+        QRegularExpression bnameTraversalRegexFile;
+        QRegularExpression bnameTraversalRegexDir;
+        QRegularExpression fullTraversalRegexFile;
+        QRegularExpression fullTraversalRegexDir;
+        QRegularExpression fullRegexFile;
+        QRegularExpression fullRegexDir;
+    };
+    using PatternSetPtr = std::shared_ptr<const PatternSet>;
+
+    /**
+     * Returns the pattern set for \a patterns anchored at \a relativeBasePath
+     *
+     * Pattern sets are immutable and shared between all instances, so
+     * folders using the same exclude lists compile them only once.
+     */
+    static PatternSetPtr sharedPatternSet(const QStringList &patterns, const QString &relativeBasePath, bool wildcardsMatchSlash);
+    static PatternSetPtr buildPatternSet(const QStringList &patterns, const QString &relativeBasePath, bool wildcardsMatchSlash);
+
     static QString extractBnameTrigger(const QString &exclude, bool wildcardsMatchSlash);
     static QString convertToRegexpSyntax(QString exclude, bool wildcardsMatchSlash);
 
@@ -246,12 +273,7 @@ private:
     QMap<BasePathString, QStringList> _allExcludes;
 
     /// see prepare()
-    QMap<BasePathString, QRegularExpression> _bnameTraversalRegexFile;
-    QMap<BasePathString, QRegularExpression> _bnameTraversalRegexDir;
-    QMap<BasePathString, QRegularExpression> _fullTraversalRegexFile;
-    QMap<BasePathString, QRegularExpression> _fullTraversalRegexDir;
-    QMap<BasePathString, QRegularExpression> _fullRegexFile;
-    QMap<BasePathString, QRegularExpression> _fullRegexDir;
+    QMap<BasePathString, PatternSetPtr> _patternSets;
 
     bool _excludeConflictFiles = true;
 
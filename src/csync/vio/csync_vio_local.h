@@ -34,4 +34,11 @@ std::unique_ptr<csync_file_stat_t> OCSYNC_EXPORT csync_vio_local_readdir(csync_v
 
 int OCSYNC_EXPORT csync_vio_local_stat(const QString &uri, csync_file_stat_t *buf);
 
+/**
+ * Whether directories are read at once and their entries stat'ed in batches
+ * with io_uring, which is the default where it is available. Only on Linux.
+ */
+void OCSYNC_EXPORT csync_vio_local_set_batched_stat_enabled(bool enabled);
+bool OCSYNC_EXPORT csync_vio_local_batched_stat_available();
+
 #endif /* _CSYNC_VIO_LOCAL_H */
@@ -26,15 +26,29 @@
 #include <dirent.h>
 #include <cstdio>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include "c_private.h"
 #include "c_lib.h"
 #include "csync.h"
+#include "config_csync.h"
 
 #include "vio/csync_vio_local.h"
 #include "common/vfs.h"
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QFile>
 
@@ -44,56 +58,310 @@ Q_LOGGING_CATEGORY(lcCSyncVIOLocal, "nextcloud.sync.csync.vio_local", QtInfoMsg)
  * directory functions
  */
 
+#ifdef __linux__
+/*
+ * On Linux the directory is read with getdents64 into a large buffer and the
+ * entries are stat'ed relative to the open directory, so the kernel does not
+ * have to resolve the full path of every entry again.
+ */
+namespace {
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+constexpr auto direntBufferSize = 64 * 1024;
+}
+#endif
+
+#ifdef HAVE_LIBURING
+/*
+ * With io_uring all entries of a directory are read when it is opened and
+ * the statx requests for them are submitted in batches, so that the latency
+ * of a network or cold file system is paid once per batch instead of once
+ * per entry.
+ */
+namespace {
+constexpr unsigned batchedStatRingSize = 256;
+
+std::atomic<bool> batchedStatEnabled = true;
+
+struct BatchedEntry {
+    QByteArray name;
+    unsigned char type = DT_UNKNOWN;
+    bool statDone = false;
+    struct statx stx;
+};
+
+class BatchedStatRing
+{
+public:
+    BatchedStatRing()
+    {
+        const auto result = io_uring_queue_init(batchedStatRingSize, &_ring, 0);
+        _available = result == 0;
+        if (!_available) {
+            qCInfo(lcCSyncVIOLocal) << "io_uring is not available, stat'ing files one by one:" << strerror(-result);
+        }
+    }
+
+    ~BatchedStatRing()
+    {
+        if (_available) {
+            io_uring_queue_exit(&_ring);
+        }
+    }
+
+    // Each discovery thread uses its own ring
+    static BatchedStatRing *forCurrentThread()
+    {
+        thread_local BatchedStatRing ring;
+        return ring._available ? &ring : nullptr;
+    }
+
+    // Entries that could not be stat'ed keep statDone unset
+    void statAll(int dirfd, std::vector<BatchedEntry> &entries)
+    {
+        for (size_t begin = 0; _available && begin < entries.size(); begin += batchedStatRingSize) {
+            const auto end = std::min<size_t>(begin + batchedStatRingSize, entries.size());
+            auto prepared = 0;
+            for (auto i = begin; i < end; ++i) {
+                const auto sqe = io_uring_get_sqe(&_ring);
+                if (!sqe) {
+                    break;
+                }
+                const auto slot = i - begin;
+                auto &request = _requests[slot];
+                request.name = entries[i].name;
+                io_uring_prep_statx(sqe, dirfd, request.name.constData(), AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT,
+                                    STATX_TYPE | STATX_INO | STATX_MTIME | STATX_SIZE, &request.stx);
+                io_uring_sqe_set_data(sqe, reinterpret_cast<void *>(slot));
+                ++prepared;
+            }
+
+            // Every submitted request is reaped before returning, even after an error
+            const auto submitted = io_uring_submit(&_ring);
+            for (auto inFlight = std::max(submitted, 0); inFlight > 0; --inFlight) {
+                io_uring_cqe *cqe = nullptr;
+                auto result = io_uring_wait_cqe(&_ring, &cqe);
+                while (result == -EINTR) {
+                    result = io_uring_wait_cqe(&_ring, &cqe);
+                }
+                if (result < 0) {
+                    abandon(result);
+                    return;
+                }
+                const auto slot = reinterpret_cast<size_t>(io_uring_cqe_get_data(cqe));
+                if (cqe->res == 0) {
+                    entries[begin + slot].stx = _requests[slot].stx;
+                    entries[begin + slot].statDone = true;
+                }
+                io_uring_cqe_seen(&_ring, cqe);
+            }
+
+            if (submitted != prepared) {
+                // The requests that were not submitted are still queued, a new ring drops them.
+                // The remaining entries are stat'ed one by one.
+                qCWarning(lcCSyncVIOLocal) << "Submitted" << submitted << "of" << prepared << "statx requests";
+                io_uring_queue_exit(&_ring);
+                _available = io_uring_queue_init(batchedStatRingSize, &_ring, 0) == 0;
+                return;
+            }
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(BatchedStatRing)
+
+    // Called when the completions can't be waited for anymore
+    void abandon(int error)
+    {
+        qCWarning(lcCSyncVIOLocal) << "Could not wait for statx requests, stat'ing files one by one:" << strerror(-error);
+        // Requests may still be running and use their slots, so those are
+        // never freed. This thread does not use io_uring again.
+        Q_UNUSED(_requests.release());
+        io_uring_queue_exit(&_ring);
+        _available = false;
+    }
+
+    // The requests use these instead of the entries, which may be gone after an error
+    struct Request {
+        QByteArray name;
+        struct statx stx;
+    };
+
+    io_uring _ring = {};
+    bool _available = false;
+    std::unique_ptr<Request[]> _requests = std::make_unique<Request[]>(batchedStatRingSize);
+};
+}
+#endif
+
 struct csync_vio_handle_t {
-  DIR *dh;
+#ifdef __linux__
+  int fd = -1;
+  QByteArray buffer;
+  long bufferEnd = 0;
+  long bufferPosition = 0;
+#else
+  DIR *dh = nullptr;
+#endif
+#ifdef HAVE_LIBURING
+  // Set when the whole directory was read and stat'ed in csync_vio_local_opendir
+  bool batched = false;
+  std::vector<BatchedEntry> batchedEntries;
+  size_t nextBatchedEntry = 0;
+  int batchedErrno = 0;
+#endif
   QByteArray path;
 };
 
 static int _csync_vio_local_stat_mb(const mbchar_t *wuri, csync_file_stat_t *buf);
+#ifdef __linux__
+static int _csync_vio_local_stat_at(int dirfd, const char *name, csync_file_stat_t *buf);
+static const linux_dirent64 *_csync_vio_local_next_dirent(csync_vio_handle_t *handle);
+#endif
+#ifdef STATX_BASIC_STATS
+static void _csync_vio_local_fill_statx(const struct statx &stx, csync_file_stat_t *buf);
+#endif
+static void _csync_vio_local_fill_stat(const csync_stat_t &sb, csync_file_stat_t *buf);
+
+#ifdef HAVE_LIBURING
+static void _csync_vio_local_read_batched(csync_vio_handle_t *handle, BatchedStatRing *ring)
+{
+    forever {
+        errno = 0;
+        const auto dirent = _csync_vio_local_next_dirent(handle);
+        if (!dirent) {
+            // reported once all entries read so far were returned
+            handle->batchedErrno = errno;
+            break;
+        }
+        if (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0) {
+            continue;
+        }
+        BatchedEntry entry;
+        entry.name = QByteArray(dirent->d_name);
+        entry.type = dirent->d_type;
+        handle->batchedEntries.push_back(std::move(entry));
+    }
+
+    ring->statAll(handle->fd, handle->batchedEntries);
+    handle->batched = true;
+}
+
+void csync_vio_local_set_batched_stat_enabled(bool enabled)
+{
+    batchedStatEnabled = enabled;
+}
+
+bool csync_vio_local_batched_stat_available()
+{
+    return BatchedStatRing::forCurrentThread() != nullptr;
+}
+#else
+void csync_vio_local_set_batched_stat_enabled(bool)
+{
+}
+
+bool csync_vio_local_batched_stat_available()
+{
+    return false;
+}
+#endif
 
 csync_vio_handle_t *csync_vio_local_opendir(const QString &name) {
     QScopedPointer<csync_vio_handle_t> handle(new csync_vio_handle_t{});
 
     auto dirname = QFile::encodeName(name);
 
+#ifdef __linux__
+    handle->fd = open(dirname.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (handle->fd < 0) {
+        return nullptr;
+    }
+    handle->buffer.resize(direntBufferSize);
+#else
     handle->dh = _topendir(dirname.constData());
     if (!handle->dh) {
         return nullptr;
     }
+#endif
 
     handle->path = dirname;
+
+#ifdef HAVE_LIBURING
+    if (batchedStatEnabled) {
+        if (const auto ring = BatchedStatRing::forCurrentThread()) {
+            _csync_vio_local_read_batched(handle.data(), ring);
+        }
+    }
+#endif
+
     return handle.take();
 }
 
 int csync_vio_local_closedir(csync_vio_handle_t *dhandle) {
     Q_ASSERT(dhandle);
+#ifdef __linux__
+    auto rc = close(dhandle->fd);
+#else
     auto rc = _tclosedir(dhandle->dh);
+#endif
     delete dhandle;
     return rc;
 }
 
-std::unique_ptr<csync_file_stat_t> csync_vio_local_readdir(csync_vio_handle_t *handle, OCC::Vfs *vfs) {
+#ifdef __linux__
+static const linux_dirent64 *_csync_vio_local_next_dirent(csync_vio_handle_t *handle)
+{
+    if (handle->bufferPosition >= handle->bufferEnd) {
+        const auto read = syscall(SYS_getdents64, handle->fd, handle->buffer.data(), handle->buffer.size());
+        if (read <= 0) {
+            // errno is set on failure and untouched at the end of the directory
+            return nullptr;
+        }
+        handle->bufferEnd = read;
+        handle->bufferPosition = 0;
+    }
 
-  struct _tdirent *dirent = nullptr;
-  std::unique_ptr<csync_file_stat_t> file_stat;
+    const auto dirent = reinterpret_cast<const linux_dirent64 *>(handle->buffer.constData() + handle->bufferPosition);
+    handle->bufferPosition += dirent->d_reclen;
+    return dirent;
+}
+#endif
 
-  do {
-      dirent = _treaddir(handle->dh);
-      if (!dirent)
-          return {};
-  } while (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0);
+static bool _csync_vio_local_is_ascii(const char *name)
+{
+    for (; *name; ++name) {
+        if (static_cast<unsigned char>(*name) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
 
-  file_stat = std::make_unique<csync_file_stat_t>();
-  file_stat->path = QFile::decodeName(dirent->d_name).toUtf8();
-  QByteArray fullPath = handle->path % '/' % QByteArray() % const_cast<const char *>(dirent->d_name);
+// Creates the entry for a directory entry, with the type as far as it is known without a stat
+static std::unique_ptr<csync_file_stat_t> _csync_vio_local_new_entry(csync_vio_handle_t *handle, const char *name, unsigned char type)
+{
+  auto file_stat = std::make_unique<csync_file_stat_t>();
+  // Decoding does not change ASCII names, which are by far the most common ones
+  if (_csync_vio_local_is_ascii(name)) {
+      file_stat->path = QByteArray(name);
+  } else {
+      file_stat->path = QFile::decodeName(name).toUtf8();
+  }
   if (file_stat->path.isNull()) {
-      file_stat->original_path = fullPath;
-      qCWarning(lcCSyncVIOLocal) << "Invalid characters in file/directory name, please rename:" << dirent->d_name << handle->path;
+      file_stat->original_path = handle->path % '/' % QByteArray() % name;
+      qCWarning(lcCSyncVIOLocal) << "Invalid characters in file/directory name, please rename:" << name << handle->path;
   }
 
   /* Check for availability of d_type, see manpage. */
-#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__)
-  switch (dirent->d_type) {
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(__APPLE__) || defined(__linux__)
+  switch (type) {
     case DT_FIFO:
     case DT_SOCK:
     case DT_CHR:
@@ -101,7 +369,7 @@ std::unique_ptr<csync_file_stat_t> csync_vio_local_readdir(csync_vio_handle_t *h
       break;
     case DT_DIR:
     case DT_REG:
-      if (dirent->d_type == DT_DIR) {
+      if (type == DT_DIR) {
         file_stat->type = ItemTypeDirectory;
       } else {
         file_stat->type = ItemTypeFile;
@@ -110,12 +378,16 @@ std::unique_ptr<csync_file_stat_t> csync_vio_local_readdir(csync_vio_handle_t *h
     default:
       break;
   }
+#else
+  Q_UNUSED(type)
 #endif
 
-  if (file_stat->path.isNull())
-      return file_stat;
+  return file_stat;
+}
 
-  if (_csync_vio_local_stat_mb(fullPath.constData(), file_stat.get()) < 0) {
+static void _csync_vio_local_finish_entry(csync_vio_handle_t *handle, csync_file_stat_t *file_stat, int statResult, OCC::Vfs *vfs)
+{
+  if (statResult < 0) {
       // Will get excluded by _csync_detect_update.
       file_stat->type = ItemTypeSkip;
   }
@@ -124,9 +396,66 @@ std::unique_ptr<csync_file_stat_t> csync_vio_local_readdir(csync_vio_handle_t *h
   if (vfs) {
       // Directly modifies file_stat->type.
       // We can ignore the return value since we're done here anyway.
-      const auto result = vfs->statTypeVirtualFile(file_stat.get(), &handle->path);
+      const auto result = vfs->statTypeVirtualFile(file_stat, &handle->path);
       Q_UNUSED(result)
   }
+}
+
+std::unique_ptr<csync_file_stat_t> csync_vio_local_readdir(csync_vio_handle_t *handle, OCC::Vfs *vfs) {
+
+#ifdef HAVE_LIBURING
+  if (handle->batched) {
+      if (handle->nextBatchedEntry >= handle->batchedEntries.size()) {
+          errno = handle->batchedErrno;
+          return {};
+      }
+      const auto &entry = handle->batchedEntries[handle->nextBatchedEntry++];
+
+      auto file_stat = _csync_vio_local_new_entry(handle, entry.name.constData(), entry.type);
+      if (file_stat->path.isNull())
+          return file_stat;
+
+      auto statResult = 0;
+      if (entry.statDone) {
+          _csync_vio_local_fill_statx(entry.stx, file_stat.get());
+      } else {
+          // Also sets errno and covers kernels without IORING_OP_STATX
+          statResult = _csync_vio_local_stat_at(handle->fd, entry.name.constData(), file_stat.get());
+      }
+      _csync_vio_local_finish_entry(handle, file_stat.get(), statResult, vfs);
+      return file_stat;
+  }
+#endif
+
+#ifdef __linux__
+  const linux_dirent64 *dirent = nullptr;
+
+  do {
+      dirent = _csync_vio_local_next_dirent(handle);
+      if (!dirent)
+          return {};
+  } while (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0);
+#else
+  struct _tdirent *dirent = nullptr;
+
+  do {
+      dirent = _treaddir(handle->dh);
+      if (!dirent)
+          return {};
+  } while (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0);
+#endif
+
+  auto file_stat = _csync_vio_local_new_entry(handle, dirent->d_name, dirent->d_type);
+  if (file_stat->path.isNull())
+      return file_stat;
+
+#ifdef __linux__
+  const auto statResult = _csync_vio_local_stat_at(handle->fd, dirent->d_name, file_stat.get());
+#else
+  const QByteArray fullPath = handle->path % '/' % QByteArray() % const_cast<const char *>(dirent->d_name);
+  const auto statResult = _csync_vio_local_stat_mb(fullPath.constData(), file_stat.get());
+#endif
+  _csync_vio_local_finish_entry(handle, file_stat.get(), statResult, vfs);
 
   return file_stat;
 }
@@ -145,6 +474,64 @@ static int _csync_vio_local_stat_mb(const mbchar_t *wuri, csync_file_stat_t *buf
         return -1;
     }
 
+    _csync_vio_local_fill_stat(sb, buf);
+    return 0;
+}
+
+#ifdef __linux__
+static int _csync_vio_local_stat_at(int dirfd, const char *name, csync_file_stat_t *buf)
+{
+#ifdef STATX_BASIC_STATS
+    // Only ask for the fields that are used, which saves work on network file systems
+    static std::atomic<bool> statxSupported = true;
+    auto statxErrno = 0;
+    if (statxSupported) {
+        struct statx stx;
+        if (statx(dirfd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_INO | STATX_MTIME | STATX_SIZE, &stx) == 0) {
+            _csync_vio_local_fill_statx(stx, buf);
+            return 0;
+        }
+        // ENOSYS on kernels older than 4.11, EPERM when the seccomp filter of
+        // a container or sandbox does not allow the syscall
+        if (errno != ENOSYS && errno != EPERM) {
+            return -1;
+        }
+        statxErrno = errno;
+    }
+#endif
+
+    csync_stat_t sb;
+
+    if (fstatat(dirfd, name, &sb, AT_SYMLINK_NOFOLLOW) < 0) {
+        return -1;
+    }
+
+#ifdef STATX_BASIC_STATS
+    // Only stop using statx when fstatat could stat the file it refused
+    if (statxErrno != 0 && statxSupported.exchange(false)) {
+        qCInfo(lcCSyncVIOLocal) << "statx is not usable, using fstatat instead:" << strerror(statxErrno);
+    }
+#endif
+
+    _csync_vio_local_fill_stat(sb, buf);
+    return 0;
+}
+#endif
+
+#ifdef STATX_BASIC_STATS
+static void _csync_vio_local_fill_statx(const struct statx &stx, csync_file_stat_t *buf)
+{
+    csync_stat_t sb = {};
+    sb.st_mode = stx.stx_mode;
+    sb.st_ino = stx.stx_ino;
+    sb.st_mtime = stx.stx_mtime.tv_sec;
+    sb.st_size = static_cast<off_t>(stx.stx_size);
+    _csync_vio_local_fill_stat(sb, buf);
+}
+#endif
+
+static void _csync_vio_local_fill_stat(const csync_stat_t &sb, csync_file_stat_t *buf)
+{
     switch (sb.st_mode & S_IFMT) {
     case S_IFDIR:
       buf->type = ItemTypeDirectory;
@@ -170,5 +557,4 @@ static int _csync_vio_local_stat_mb(const mbchar_t *wuri, csync_file_stat_t *buf
   buf->inode = sb.st_ino;
   buf->modtime = sb.st_mtime;
   buf->size = sb.st_size;
-  return 0;
 }
@@ -226,3 +226,12 @@ int csync_vio_local_stat(const QString &uri, csync_file_stat_t *buf)
     CloseHandle(h);
     return 0;
 }
+
+void csync_vio_local_set_batched_stat_enabled(bool)
+{
+}
+
+bool csync_vio_local_batched_stat_available()
+{
+    return false;
+}
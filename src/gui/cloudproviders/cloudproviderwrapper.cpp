@@ -75,7 +75,7 @@ CloudProvidersAccountExporter* CloudProviderWrapper::accountExporter()
     return _cloudProviderAccount;
 }
 
-static bool shouldShowInRecentsMenu(const SyncFileItem &item)
+static bool shouldShowInRecentsMenu(const ProgressInfo::ItemRecord &item)
 {
     return !Progress::isIgnoredKind(item._status)
             && item._instruction != CSYNC_INSTRUCTION_EVAL
@@ -100,12 +100,15 @@ void CloudProviderWrapper::slotUpdateProgress(const QString &folder, const Progr
         return;
 
     // Build recently changed files list
-    if (!progress._lastCompletedItem.isEmpty() && shouldShowInRecentsMenu(progress._lastCompletedItem)) {
-        QString kindStr = Progress::asResultString(progress._lastCompletedItem);
+    for (const auto &completedItem : progress._completedItems) {
+        if (!shouldShowInRecentsMenu(completedItem)) {
+            continue;
+        }
+        QString kindStr = Progress::asResultString(completedItem);
         QString timeStr = QTime::currentTime().toString("hh:mm");
-        QString actionText = tr("%1 (%2, %3)").arg(progress._lastCompletedItem._file, kindStr, timeStr);
+        QString actionText = tr("%1 (%2, %3)").arg(completedItem._file, kindStr, timeStr);
         if (f) {
-            QString fullPath = f->path() + '/' + progress._lastCompletedItem._file;
+            QString fullPath = f->path() + '/' + completedItem._file;
             if (QFile(fullPath).exists()) {
                 if (_recentlyChanged.length() > 5)
                     _recentlyChanged.removeFirst();
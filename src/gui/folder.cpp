@@ -71,6 +71,9 @@ Folder::Folder(const FolderDefinition &definition,
     , _fileLog(new SyncRunFileLog)
     , _vfs(vfs.release())
 {
+    QElapsedTimer setupTimer;
+    setupTimer.start();
+
     _timeSinceLastSyncStart.start();
     _timeSinceLastSyncDone.start();
 
@@ -82,6 +85,7 @@ Folder::Folder(const FolderDefinition &definition,
 
     // check if the local path exists
     checkLocalPath();
+    const auto checkLocalPathTime = setupTimer.restart();
 
     _syncResult.setFolder(_definition.alias);
 
@@ -92,6 +96,7 @@ Folder::Folder(const FolderDefinition &definition,
     ConfigFile::setupDefaultExcludeFilePaths(_engine->excludedFiles());
     if (!reloadExcludes())
         qCWarning(lcFolder, "Could not read system exclude file");
+    const auto engineTime = setupTimer.restart();
 
     connect(_accountState.data(), &AccountState::termsOfServiceChanged,
             this, [this] ()
@@ -157,6 +162,9 @@ Folder::Folder(const FolderDefinition &definition,
 
     // Initialize the vfs plugin
     startVfs();
+
+    qCInfo(lcFolder) << "Set up folder" << _definition.alias << "- local path:" << checkLocalPathTime
+                     << "ms, engine and excludes:" << engineTime << "ms, vfs:" << setupTimer.elapsed() << "ms";
 }
 
 Folder::~Folder()
@@ -530,10 +538,13 @@ void Folder::startVfs()
 
     // Immediately mark the sqlite temporaries as excluded. They get recreated
     // on db-open and need to get marked again every time.
-    QString stateDbFile = _journal.databaseFilePath();
-    _journal.open();
-    _vfs->fileStatusChanged(stateDbFile + "-wal", SyncFileStatus::StatusExcluded);
-    _vfs->fileStatusChanged(stateDbFile + "-shm", SyncFileStatus::StatusExcluded);
+    // The other modes ignore the status, their journal is only opened on first use.
+    if (_vfs->mode() == Vfs::WindowsCfApi) {
+        QString stateDbFile = _journal.databaseFilePath();
+        _journal.open();
+        _vfs->fileStatusChanged(stateDbFile + "-wal", SyncFileStatus::StatusExcluded);
+        _vfs->fileStatusChanged(stateDbFile + "-shm", SyncFileStatus::StatusExcluded);
+    }
 }
 
 int Folder::slotDiscardDownloadProgress()
@@ -1134,6 +1145,11 @@ SyncOptions Folder::initializeSyncOptions() const
     opt.setMaxChunkSize(cfgFile.maxChunkSize());
     opt._initialChunkSize = ::qBound(opt.minChunkSize(), cfgFile.chunkSize(), opt.maxChunkSize());
     opt._targetChunkUploadDuration = cfgFile.targetChunkUploadDuration();
+    opt._minProgressPublishInterval = cfgFile.progressPublishInterval();
+    opt._bulkDownload = cfgFile.bulkDownload();
+    opt._remoteDeltaDiscovery = cfgFile.remoteDeltaDiscovery();
+    opt._deltaUpload = cfgFile.deltaUpload();
+    opt._deltaDownload = cfgFile.deltaDownload();
 
     opt.fillFromEnvironmentVariables();
     opt.verifyChunkSizes();
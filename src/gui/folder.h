@@ -332,6 +332,9 @@ public slots:
        */
     void slotTerminateSync();
 
+    /** Schedules a sync if the ETag of the remote folder changed, also used by FolderMan's batched ETag checks */
+    void etagRetrieved(const QByteArray &, const QDateTime &tp);
+
     // connected to the corresponding signals in the SyncEngine
     void slotAboutToRemoveAllFiles(OCC::SyncFileItem::Direction, std::function<void(bool)> callback);
 
@@ -424,7 +427,6 @@ private slots:
     void slotItemCompleted(const OCC::SyncFileItemPtr &, OCC::ErrorCategory errorCategory);
 
     void slotRunEtagJob();
-    void etagRetrieved(const QByteArray &, const QDateTime &tp);
     void etagRetrievedFromSyncEngine(const QByteArray &, const QDateTime &time);
 
     void slotEmitFinishedDelayed();
@@ -23,6 +23,8 @@
 #include "accountmanager.h"
 #include "filesystem.h"
 #include "lockwatcher.h"
+#include "helpers.h"
+#include "networkjobs.h"
 #include "common/asserts.h"
 #include "gui/systray.h"
 #include <pushnotifications.h>
@@ -44,6 +46,20 @@ constexpr auto settingsAccountsC = "Accounts";
 constexpr auto settingsFoldersC = "Folders";
 constexpr auto settingsVersionC = "version";
 constexpr auto maxFoldersVersion = 1;
+
+// The remote path of a folder split into its parent and its name with a
+// leading slash, both are empty for the root folder
+QPair<QString, QString> splitRemotePath(QString remotePath)
+{
+    while (remotePath.endsWith(QLatin1Char('/'))) {
+        remotePath.chop(1);
+    }
+    const auto slashPosition = remotePath.lastIndexOf(QLatin1Char('/'));
+    if (slashPosition < 0) {
+        return {QString(), remotePath.isEmpty() ? QString() : QLatin1Char('/') + remotePath};
+    }
+    return {remotePath.left(slashPosition), remotePath.mid(slashPosition)};
+}
 }
 
 namespace OCC {
@@ -184,6 +200,8 @@ int FolderMan::setupFolders()
     }
 
     qCInfo(lcFolderMan) << "Setup folders from settings file";
+    QElapsedTimer setupTimer;
+    setupTimer.start();
 
     // this is done in Application::configVersionMigration
     QStringList skipSettingsKeys;
@@ -224,6 +242,8 @@ int FolderMan::setupFolders()
         folder->processSwitchedToVirtualFiles();
     }
 
+    qCInfo(lcFolderMan) << "Set up" << _folderMap.size() << "folders in" << setupTimer.elapsed() << "ms";
+
     return _folderMap.size();
 }
 
@@ -977,12 +997,22 @@ void FolderMan::slotEtagPollTimerTimeout()
 
 void FolderMan::runEtagJobsIfPossible(const QList<Folder *> &folderMap)
 {
-    for (auto folder : folderMap) {
-        runEtagJobIfPossible(folder);
+    QList<Folder *> folders;
+    std::copy_if(folderMap.begin(), folderMap.end(), std::back_inserter(folders), [this](Folder *folder) {
+        return canRunEtagJob(folder);
+    });
+
+    const auto batches = etagBatches(folders);
+    for (const auto &batch : batches) {
+        if (batch.size() == 1) {
+            QMetaObject::invokeMethod(batch.first(), "slotRunEtagJob", Qt::QueuedConnection);
+        } else {
+            runBatchedEtagJob(batch, false);
+        }
     }
 }
 
-void FolderMan::runEtagJobIfPossible(Folder *folder)
+bool FolderMan::canRunEtagJob(Folder *folder)
 {
     const ConfigFile cfg;
     const auto polltime = cfg.remotePollInterval();
@@ -990,33 +1020,111 @@ void FolderMan::runEtagJobIfPossible(Folder *folder)
     qCInfo(lcFolderMan) << "Run etag job on folder" << folder;
 
     if (!folder) {
-        return;
+        return false;
     }
     if (folder->isSyncRunning()) {
         qCInfo(lcFolderMan) << "Can not run etag job: Sync is running";
-        return;
+        return false;
     }
     if (_scheduledFolders.contains(folder)) {
         qCInfo(lcFolderMan) << "Can not run etag job: Folder is already scheduled";
-        return;
+        return false;
     }
     if (_disabledFolders.contains(folder)) {
         qCInfo(lcFolderMan) << "Can not run etag job: Folder is disabled";
-        return;
+        return false;
     }
-    if (folder->etagJob() || folder->isBusy() || !folder->canSync()) {
+    if (folder->etagJob() || _foldersInEtagBatch.contains(folder) || folder->isBusy() || !folder->canSync()) {
         qCInfo(lcFolderMan) << "Can not run etag job: Folder is busy";
-        return;
+        return false;
     }
     // When not using push notifications, make sure polltime is reached
     if (!pushNotificationsFilesReady(folder->accountState()->account().data())) {
         if (folder->msecSinceLastSync() < polltime) {
             qCInfo(lcFolderMan) << "Can not run etag job: Polltime not reached";
-            return;
+            return false;
         }
     }
+    return true;
+}
 
-    QMetaObject::invokeMethod(folder, "slotRunEtagJob", Qt::QueuedConnection);
+QList<QList<Folder *>> FolderMan::etagBatches(const QList<Folder *> &folders) const
+{
+    QList<QList<Folder *>> batches;
+    QHash<QPair<Account *, QString>, int> batchIndex;
+    for (const auto folder : folders) {
+        const auto key = qMakePair(folder->accountState()->account().data(), splitRemotePath(folder->remotePath()).first);
+        const auto it = batchIndex.constFind(key);
+        if (it == batchIndex.constEnd()) {
+            batchIndex.insert(key, batches.size());
+            batches.append({folder});
+        } else {
+            batches[*it].append(folder);
+        }
+    }
+    return batches;
+}
+
+void FolderMan::runBatchedEtagJob(const QList<Folder *> &folders, bool scheduleOnError)
+{
+    const auto account = folders.first()->accountState()->account();
+    const auto parentPath = splitRemotePath(folders.first()->remotePath()).first;
+    qCInfo(lcFolderMan) << "Checking the ETags of" << folders.size() << "folders below" << parentPath << "with one request";
+
+    QHash<QString, QPointer<Folder>> foldersByName;
+    for (const auto folder : folders) {
+        foldersByName.insert(splitRemotePath(folder->remotePath()).second, folder);
+        _foldersInEtagBatch.insert(folder);
+    }
+
+    // The names in the listing are relative to the requested folder, the folder itself has an empty name
+    auto etags = QSharedPointer<QHash<QString, QByteArray>>::create();
+    auto job = new LsColJob(account, parentPath.isEmpty() ? QStringLiteral("/") : parentPath);
+    job->setProperties({"getetag"});
+    job->setTimeout(60 * 1000);
+    connect(job, &LsColJob::directoryListingIterated, this, [job, etags](const QString &name, const QMap<QString, QString> &properties) {
+        auto basePath = job->reply()->request().url().path();
+        if (basePath.endsWith(QLatin1Char('/'))) {
+            basePath.chop(1);
+        }
+        const auto etagText = properties.value(QStringLiteral("getetag")).toUtf8();
+        const auto etag = parseEtag(etagText.constData());
+        etags->insert(name.mid(basePath.size()), etag.isEmpty() ? etagText : etag);
+    });
+    connect(job, &LsColJob::finishedWithoutError, this, [this, job, etags, folders, foldersByName] {
+        for (const auto folder : folders) {
+            _foldersInEtagBatch.remove(folder);
+        }
+        const auto time = QDateTime::fromString(QString::fromUtf8(job->responseTimestamp()), Qt::RFC2822Date);
+        for (auto it = foldersByName.cbegin(); it != foldersByName.cend(); ++it) {
+            const auto folder = it.value();
+            if (!folder) {
+                continue;
+            }
+            const auto etag = etags->value(it.key());
+            if (etag.isEmpty()) {
+                qCInfo(lcFolderMan) << "No ETag for" << folder->remotePath() << "in the listing of its parent folder";
+                QMetaObject::invokeMethod(folder, "slotRunEtagJob", Qt::QueuedConnection);
+                continue;
+            }
+            folder->etagRetrieved(etag, time);
+        }
+    });
+    connect(job, &LsColJob::finishedWithError, this, [this, folders, foldersByName, scheduleOnError](QNetworkReply *reply) {
+        qCWarning(lcFolderMan) << "Could not check the ETags of" << folders.size() << "folders:" << (reply ? reply->errorString() : QString());
+        for (const auto folder : folders) {
+            _foldersInEtagBatch.remove(folder);
+        }
+        if (!scheduleOnError) {
+            return;
+        }
+        for (const auto &folder : foldersByName) {
+            if (folder) {
+                scheduleFolder(folder);
+            }
+        }
+    });
+    job->start();
 }
 
 void FolderMan::slotAccountRemoved(AccountState *accountState)
@@ -2003,14 +2111,26 @@ void FolderMan::slotProcessFilesPushNotification(Account *account)
 {
     qCInfo(lcFolderMan) << "Got files push notification for account" << account;
 
+    QList<Folder *> folders;
     for (auto folder : qAsConst(_folderMap)) {
         // Just run on the folders that belong to this account
-        if (folder->accountState()->account() != account) {
-            continue;
+        if (folder->accountState()->account() == account) {
+            folders.append(folder);
         }
+    }
 
-        qCInfo(lcFolderMan) << "Schedule folder" << folder << "for sync";
-        scheduleFolder(folder);
+    // The notification doesn't say which folder changed, a batch of folders
+    // first checks its ETags with one request and only the changed ones sync
+    const auto batches = etagBatches(folders);
+    for (const auto &batch : batches) {
+        if (batch.size() > 1 && std::none_of(batch.begin(), batch.end(), [this](Folder *folder) { return _foldersInEtagBatch.contains(folder); })) {
+            runBatchedEtagJob(batch, true);
+            continue;
+        }
+        for (const auto folder : batch) {
+            qCInfo(lcFolderMan) << "Schedule folder" << folder << "for sync";
+            scheduleFolder(folder);
+        }
     }
 }
 
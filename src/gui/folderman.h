@@ -56,7 +56,7 @@ class UpdateE2eeFolderUsersMetadataJob;
  *   (_folderWatchers and Folder::slotWatchedPathChanged())
  *
  * - The folder etag on the server has changed
- *   (_etagPollTimer)
+ *   (_etagPollTimer, folders below the same remote folder share one request)
  *
  * - The locks of a monitored file are released
  *   (_lockWatcher and slotWatchedFileUnlocked())
@@ -356,7 +356,20 @@ private:
     void setupFoldersHelper(QSettings &settings, AccountStatePtr account, const QStringList &ignoreKeys, bool backwardsCompatible, bool foldersWithPlaceholders);
 
     void runEtagJobsIfPossible(const QList<Folder *> &folderMap);
-    void runEtagJobIfPossible(Folder *folder);
+    [[nodiscard]] bool canRunEtagJob(Folder *folder);
+
+    /**
+     * Folders of the same account below the same remote parent folder, the
+     * ETags of all of them are retrieved with one PROPFIND
+     */
+    [[nodiscard]] QList<QList<Folder *>> etagBatches(const QList<Folder *> &folders) const;
+    /**
+     * Retrieves the ETags of a batch with one PROPFIND on the parent folder
+     *
+     * Folders missing from the listing check their ETag on their own. If the
+     * request fails, the folders are scheduled when \a scheduleOnError is set.
+     */
+    void runBatchedEtagJob(const QList<Folder *> &folders, bool scheduleOnError);
 
     bool pushNotificationsFilesReady(Account *account);
 
@@ -378,6 +391,8 @@ private:
     QTimer _etagPollTimer;
     /// The currently running etag query
     QPointer<RequestEtagJob> _currentEtagJob;
+    /// Folders whose ETag is being retrieved by runBatchedEtagJob()
+    QSet<Folder *> _foldersInEtagBatch;
 
     /// Watches files that couldn't be synced due to locks
     QScopedPointer<LockWatcher> _lockWatcher;
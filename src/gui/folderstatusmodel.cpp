@@ -21,8 +21,10 @@
 #include <account.h>
 #include <theme.h>
 
+#include <QCollator>
 #include <QFileIconProvider>
 #include <QVarLengthArray>
+#include <algorithm>
 #include <set>
 
 Q_DECLARE_METATYPE(QPersistentModelIndex)
@@ -51,6 +53,15 @@ FolderStatusModel::FolderStatusModel(QObject *parent)
 
 FolderStatusModel::~FolderStatusModel() = default;
 
+// Moves the subfolders below a row that now has \a pathIdx
+static void setPathIdx(FolderStatusModel::SubFolderInfo &info, const QVector<int> &pathIdx)
+{
+    info._pathIdx = pathIdx;
+    for (auto i = 0; i < info._subs.size(); ++i) {
+        setPathIdx(info._subs[i], QVector<int>(pathIdx) << i);
+    }
+}
+
 static bool sortByFolderHeader(const FolderStatusModel::SubFolderInfo &lhs, const FolderStatusModel::SubFolderInfo &rhs)
 {
     return QString::compare(lhs._folder->shortGuiRemotePathOrAppName(),
@@ -608,16 +619,47 @@ void FolderStatusModel::fetchMore(const QModelIndex &parent)
         return;
     }
     info->resetSubs(this, parent);
-    auto path = info->_folder->remotePathTrailingSlash();
+
+    // Show the folders known from the last sync right away and only wait
+    // for the server in the background
+    if (populateFromJournal(parent)) {
+        // A folder without unchecked subfolders is complete in the journal,
+        // it only needs to be listed again when it changed since the last sync
+        SyncJournalFileRecord rec;
+        if (info->_checked == Qt::Checked
+            && info->_folder->journalDb()->getFileRecord(removeTrailingSlash(info->_path), &rec)
+            && rec.isValid() && !rec._etag.isEmpty()) {
+            refreshIfChanged(parent, rec._etag);
+        } else {
+            startListingJob(parent);
+        }
+        return;
+    }
+
+    startListingJob(parent);
+
+    // Show 'fetching data...' hint after a while.
+    _fetchingItems[QPersistentModelIndex(parent)].start();
+    QTimer::singleShot(1000, this, &FolderStatusModel::slotShowFetchProgress);
+}
+
+QString FolderStatusModel::remotePathForListing(const SubFolderInfo &info) const
+{
+    auto path = info._folder->remotePathTrailingSlash();
 
     // info->_path always contains non-mangled name, so we need to use mangled when requesting nested folders for encrypted subfolders as required by LsColJob
-    const auto infoPath = (info->isEncrypted() && !info->_e2eMangledName.isEmpty()) ? info->_e2eMangledName : info->_path;
+    const auto infoPath = (info.isEncrypted() && !info._e2eMangledName.isEmpty()) ? info._e2eMangledName : info._path;
 
     if (infoPath != QLatin1String("/")) {
         path += infoPath;
     }
+    return path;
+}
 
-    const auto job = new LsColJob(_accountState->account(), path);
+void FolderStatusModel::startListingJob(const QModelIndex &parent)
+{
+    const auto info = infoForIndex(parent);
+    const auto job = new LsColJob(_accountState->account(), remotePathForListing(*info));
     info->_fetchingJob = job;
     const auto props = QList<QByteArray>() << "resourcetype"
                                            << "http://owncloud.org/ns:size"
@@ -639,12 +681,95 @@ void FolderStatusModel::fetchMore(const QModelIndex &parent)
 
     job->start();
 
-    QPersistentModelIndex persistentIndex(parent);
-    job->setProperty(propertyParentIndexC, QVariant::fromValue(persistentIndex));
+    job->setProperty(propertyParentIndexC, QVariant::fromValue(QPersistentModelIndex(parent)));
+}
 
-    // Show 'fetching data...' hint after a while.
-    _fetchingItems[persistentIndex].start();
-    QTimer::singleShot(1000, this, &FolderStatusModel::slotShowFetchProgress);
+void FolderStatusModel::refreshIfChanged(const QModelIndex &parent, const QByteArray &syncedEtag)
+{
+    const auto info = infoForIndex(parent);
+    const auto job = new RequestEtagJob(_accountState->account(), remotePathForListing(*info), this);
+    job->setTimeout(60 * 1000);
+    connect(job, &RequestEtagJob::etagRetrieved, this, [this, persistentIndex = QPersistentModelIndex(parent), syncedEtag](const QByteArray &etag) {
+        const auto info = infoForIndex(persistentIndex);
+        if (!info || !info->_fetched || info->_fetchingJob || etag == syncedEtag) {
+            return;
+        }
+        qCInfo(lcFolderStatus) << "Listing" << info->_path << "again, it changed since the last sync";
+        startListingJob(persistentIndex);
+    });
+    job->start();
+}
+
+bool FolderStatusModel::populateFromJournal(const QModelIndex &parent)
+{
+    const auto info = infoForIndex(parent);
+    // The journal only knows the mangled names below encrypted folders and
+    // nothing below unchecked ones
+    if (info->isEncrypted() || info->_checked == Qt::Unchecked) {
+        return false;
+    }
+
+    const auto journal = info->_folder->journalDb();
+    const auto isRoot = info->_path == QLatin1String("/");
+    const auto parentPath = isRoot ? QString() : info->_path;
+    if (!isRoot) {
+        SyncJournalFileRecord rec;
+        if (!journal->getFileRecord(removeTrailingSlash(parentPath), &rec) || !rec.isDirectory()) {
+            return false;
+        }
+    }
+
+    auto ok = true;
+    const auto selectiveSyncBlackList = journal->getSelectiveSyncList(SyncJournalDb::SelectiveSyncBlackList, &ok);
+    if (!ok || selectiveSyncBlackList.contains(QStringLiteral("/"))) {
+        return false;
+    }
+
+    QVector<SubFolderInfo> newSubs;
+    ok = journal->listSubdirectoriesInPath(removeTrailingSlash(parentPath).toUtf8(), [&](const SyncJournalFileRecord &rec) {
+        const auto relativePath = rec.path() + QLatin1Char('/');
+        if (info->_folder->isFileExcludedRelative(relativePath)) {
+            return;
+        }
+        // The server's size also counts the unsynced parts of the folder
+        const auto hasUnsyncedContent = std::any_of(selectiveSyncBlackList.cbegin(), selectiveSyncBlackList.cend(), [&relativePath](const QString &path) {
+            return path.startsWith(relativePath);
+        });
+        const auto aggregate = hasUnsyncedContent ? SyncJournalDb::DirectoryAggregate{} : journal->getDirectoryAggregate(rec.path());
+
+        SubFolderInfo newInfo;
+        newInfo._path = relativePath;
+        newInfo._name = rec.path().mid(parentPath.size());
+        newInfo._size = aggregate._valid ? aggregate._size : -1; // otherwise only known once the folder is listed on the server
+        newInfo._fileId = rec.numericFileId();
+        newInfo._isExternal = rec._remotePerm.hasPermission(RemotePermissions::IsMounted);
+        newInfo._isEncrypted = rec.isE2eEncrypted();
+        if (newInfo._isEncrypted && !rec._e2eMangledName.isEmpty()) {
+            newInfo._e2eMangledName = rec._e2eMangledName + QLatin1Char('/');
+        }
+        newSubs.append(newInfo);
+    });
+    if (!ok) {
+        qCWarning(lcFolderStatus) << "Could not list the subfolders of" << info->_path << "from the journal";
+        return false;
+    }
+
+    // Unchecked subfolders are not synced, their names come from the blacklist
+    for (const auto &path : selectiveSyncBlackList) {
+        if (path.size() > parentPath.size() && path.startsWith(parentPath) && path.indexOf(QLatin1Char('/'), parentPath.size()) == path.size() - 1) {
+            SubFolderInfo newInfo;
+            newInfo._path = path;
+            newInfo._name = removeTrailingSlash(path.mid(parentPath.size()));
+            newInfo._size = -1;
+            newSubs.append(newInfo);
+        }
+    }
+
+    if (newSubs.isEmpty()) {
+        return false;
+    }
+    setSubfolders(parent, std::move(newSubs), false);
+    return true;
 }
 
 void FolderStatusModel::resetAndFetch(const QModelIndex &parent)
@@ -694,73 +819,32 @@ void FolderStatusModel::slotUpdateDirectories(const QStringList &list)
         return;
     }
     ASSERT(parentInfo->_fetchingJob == job);
-    ASSERT(parentInfo->_subs.isEmpty());
-
-    if (parentInfo->hasLabel()) {
-        beginRemoveRows(parentIdx, 0, 0);
-        parentInfo->_hasError = false;
-        parentInfo->_fetchingLabel = false;
-        endRemoveRows();
-    }
-
-    parentInfo->_lastErrorString.clear();
     parentInfo->_fetchingJob = nullptr;
-    parentInfo->_fetched = true;
 
     const auto url = parentInfo->_folder->remoteUrl();
     const auto pathToRemove = Utility::trailingSlashPath(url.path());
 
-    QStringList selectiveSyncBlackList;
-    auto ok1 = true;
-    auto ok2 = true;
-    if (parentInfo->_checked == Qt::PartiallyChecked) {
-        selectiveSyncBlackList = parentInfo->_folder->journalDb()->getSelectiveSyncList(SyncJournalDb::SelectiveSyncBlackList, &ok1);
-    }
-    auto selectiveSyncUndecidedList = parentInfo->_folder->journalDb()->getSelectiveSyncList(SyncJournalDb::SelectiveSyncUndecidedList, &ok2);
-
-    if (!(ok1 && ok2)) {
-        qCWarning(lcFolderStatus) << "Could not retrieve selective sync info from journal";
-        return;
-    }
-
-    std::set<QString> selectiveSyncUndecidedSet; // not QSet because it's not sorted
-    for (const auto &str : selectiveSyncUndecidedList) {
-        if (str.startsWith(parentInfo->_path) || parentInfo->_path == QLatin1String("/")) {
-            selectiveSyncUndecidedSet.insert(str);
-        }
-    }
     const auto permissionMap = job->property(propertyPermissionMap).toMap();
     const auto encryptionMap = job->property(propertyEncryptionMap).toMap();
 
-    auto sortedSubfolders = list;
-    if (!sortedSubfolders.isEmpty()) {
-        sortedSubfolders.removeFirst(); // skip the parent item (first in the list)
+    auto subfolders = list;
+    if (!subfolders.isEmpty()) {
+        subfolders.removeFirst(); // skip the parent item (first in the list)
     }
-    Utility::sortFilenames(sortedSubfolders);
-
-    QVarLengthArray<int, 10> undecidedIndexes;
 
     QVector<SubFolderInfo> newSubs;
-    newSubs.reserve(sortedSubfolders.size());
-    for (const auto &path : sortedSubfolders) {
+    newSubs.reserve(subfolders.size());
+    for (const auto &path : subfolders) {
         auto relativePath = path.mid(pathToRemove.size());
         if (parentInfo->_folder->isFileExcludedRelative(relativePath)) {
             continue;
         }
 
         SubFolderInfo newInfo;
-        newInfo._folder = parentInfo->_folder;
-        newInfo._pathIdx = parentInfo->_pathIdx;
-        newInfo._pathIdx << newSubs.size();
         newInfo._isExternal = permissionMap.value(removeTrailingSlash(path)).toString().contains("M");
         newInfo._isEncrypted = encryptionMap.value(removeTrailingSlash(path)).toString() == QStringLiteral("1");
         newInfo._path = relativePath;
 
-        newInfo._isNonDecryptable = newInfo.isEncrypted()
-            && _accountState->account()->e2e()
-            && !_accountState->account()->e2e()->_publicKey.isNull()
-            && _accountState->account()->e2e()->_privateKey.isNull();
-
         SyncJournalFileRecord rec;
         if (!parentInfo->_folder->journalDb()->getFileRecordByE2eMangledName(removeTrailingSlash(relativePath), &rec)) {
             qCWarning(lcFolderStatus) << "Could not get file record by E2E Mangled Name from local DB" << removeTrailingSlash(relativePath);
@@ -786,8 +870,85 @@ void FolderStatusModel::slotUpdateDirectories(const QStringList &list)
         if (relativePath.isEmpty()) {
             continue;
         }
+        newSubs.append(newInfo);
+    }
+
+    setSubfolders(parentIdx, std::move(newSubs), true);
+}
+
+void FolderStatusModel::setSubfolders(const QModelIndex &parentIdx, QVector<SubFolderInfo> newSubs, bool isServerListing)
+{
+    const auto parentInfo = infoForIndex(parentIdx);
+
+    if (parentInfo->hasLabel()) {
+        beginRemoveRows(parentIdx, 0, 0);
+        parentInfo->_hasError = false;
+        parentInfo->_fetchingLabel = false;
+        endRemoveRows();
+    }
+
+    parentInfo->_lastErrorString.clear();
+    parentInfo->_fetched = true;
+
+    QStringList selectiveSyncBlackList;
+    auto ok1 = true;
+    auto ok2 = true;
+    if (parentInfo->_checked == Qt::PartiallyChecked) {
+        selectiveSyncBlackList = parentInfo->_folder->journalDb()->getSelectiveSyncList(SyncJournalDb::SelectiveSyncBlackList, &ok1);
+    }
+    auto selectiveSyncUndecidedList = parentInfo->_folder->journalDb()->getSelectiveSyncList(SyncJournalDb::SelectiveSyncUndecidedList, &ok2);
+
+    if (!(ok1 && ok2)) {
+        qCWarning(lcFolderStatus) << "Could not retrieve selective sync info from journal";
+        return;
+    }
+
+    std::set<QString> selectiveSyncUndecidedSet; // not QSet because it's not sorted
+    for (const auto &str : selectiveSyncUndecidedList) {
+        if (str.startsWith(parentInfo->_path) || parentInfo->_path == QLatin1String("/")) {
+            selectiveSyncUndecidedSet.insert(str);
+        }
+    }
+
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    std::sort(newSubs.begin(), newSubs.end(), [&collator](const SubFolderInfo &lhs, const SubFolderInfo &rhs) {
+        return collator.compare(lhs._path, rhs._path) < 0;
+    });
+
+    // The rows shown from the journal keep what the user changed in them
+    // until the server listing arrives: the check state and the subfolders
+    const auto sameRows = std::equal(newSubs.cbegin(), newSubs.cend(), parentInfo->_subs.cbegin(), parentInfo->_subs.cend(),
+        [](const SubFolderInfo &lhs, const SubFolderInfo &rhs) { return lhs._path == rhs._path; });
+    QHash<QString, int> oldRows;
+    for (auto i = 0; i < parentInfo->_subs.size(); ++i) {
+        oldRows.insert(parentInfo->_subs.at(i)._path, i);
+    }
+
+    QVarLengthArray<int, 10> undecidedIndexes;
+
+    for (auto i = 0; i < newSubs.size(); ++i) {
+        auto &newInfo = newSubs[i];
+        const auto &relativePath = newInfo._path;
+        newInfo._folder = parentInfo->_folder;
+        newInfo._pathIdx = parentInfo->_pathIdx;
+        newInfo._pathIdx << i;
 
-        if (parentInfo->_checked == Qt::Unchecked) {
+        newInfo._isNonDecryptable = newInfo.isEncrypted()
+            && _accountState->account()->e2e()
+            && !_accountState->account()->e2e()->_publicKey.isNull()
+            && _accountState->account()->e2e()->_privateKey.isNull();
+
+        if (const auto oldRow = oldRows.constFind(relativePath); oldRow != oldRows.constEnd()) {
+            const auto &oldInfo = parentInfo->_subs.at(*oldRow);
+            newInfo._checked = oldInfo._checked;
+            if (!sameRows) {
+                newInfo._fetched = oldInfo._fetched;
+                newInfo._subs = oldInfo._subs;
+                setPathIdx(newInfo, newInfo._pathIdx);
+            }
+        } else if (parentInfo->_checked == Qt::Unchecked) {
             newInfo._checked = Qt::Unchecked;
         } else if (parentInfo->_checked == Qt::Checked) {
             newInfo._checked = Qt::Checked;
@@ -817,18 +978,47 @@ void FolderStatusModel::slotUpdateDirectories(const QStringList &list)
                 selectiveSyncUndecidedSet.erase(it, it2);
             }
         }
-        newSubs.append(newInfo);
     }
 
-    if (!newSubs.isEmpty()) {
-        beginInsertRows(parentIdx, 0, newSubs.size() - 1);
-        parentInfo->_subs = std::move(newSubs);
-        endInsertRows();
+    if (sameRows) {
+        // Only the details of the rows changed. They are updated in place,
+        // the indexes of expanded rows point into them.
+        for (auto i = 0; i < newSubs.size(); ++i) {
+            auto &sub = parentInfo->_subs[i];
+            const auto &newInfo = newSubs.at(i);
+            sub._name = newInfo._name;
+            sub._e2eMangledName = newInfo._e2eMangledName;
+            sub._size = newInfo._size;
+            sub._fileId = newInfo._fileId;
+            sub._isExternal = newInfo._isExternal;
+            sub._isEncrypted = newInfo._isEncrypted;
+            sub._isNonDecryptable = newInfo._isNonDecryptable;
+            sub._isUndecided = newInfo._isUndecided;
+        }
+        if (!parentInfo->_subs.isEmpty()) {
+            emit dataChanged(index(0, 0, parentIdx), index(parentInfo->_subs.size() - 1, 0, parentIdx));
+        }
+    } else {
+        if (!parentInfo->_subs.isEmpty()) {
+            beginRemoveRows(parentIdx, 0, parentInfo->_subs.size() - 1);
+            parentInfo->_subs.clear();
+            endRemoveRows();
+        }
+        if (!newSubs.isEmpty()) {
+            beginInsertRows(parentIdx, 0, newSubs.size() - 1);
+            parentInfo->_subs = std::move(newSubs);
+            endInsertRows();
+        }
     }
 
     for (const auto undecidedIndex : qAsConst(undecidedIndexes)) {
         emit suggestExpand(index(undecidedIndex, 0, parentIdx));
     }
+
+    // Only the server knows whether the undecided folders still exist
+    if (!isServerListing) {
+        return;
+    }
     /* Try to remove from the undecided lists the items that are not on the server. */
     const auto it = std::remove_if(selectiveSyncUndecidedList.begin(), selectiveSyncUndecidedList.end(),
         [&](const QString &s) { return selectiveSyncUndecidedSet.count(s); });
@@ -853,6 +1043,12 @@ void FolderStatusModel::slotLscolFinishedWithError(QNetworkReply *reply)
         qCDebug(lcFolderStatus) << reply->errorString();
         parentInfo->_lastErrorString = reply->errorString();
 
+        // Keep showing the folders from the journal when refreshing them failed
+        if (parentInfo->_fetched && !parentInfo->_subs.isEmpty() && reply->error() != QNetworkReply::ContentNotFoundError) {
+            parentInfo->_fetchingJob.clear();
+            return;
+        }
+
         parentInfo->resetSubs(this, idx);
 
         if (reply->error() == QNetworkReply::ContentNotFoundError) {
@@ -1012,9 +1208,11 @@ void FolderStatusModel::slotSetProgress(const ProgressInfo &progress)
     }
 
     // Status is Starting, Propagation or Done
-    if (!progress._lastCompletedItem.isEmpty()
-        && Progress::isWarningKind(progress._lastCompletedItem._status)) {
-        subFolderProgress->_warningCount++;
+    // Updates are throttled, all items completed since the previous one are in _completedItems
+    for (const auto &item : progress._completedItems) {
+        if (Progress::isWarningKind(item._status)) {
+            subFolderProgress->_warningCount++;
+        }
     }
 
     // find the single item to display:  This is going to be the bigger item, or the last completed
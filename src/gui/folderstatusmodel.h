@@ -69,7 +69,7 @@ public:
         bool _isExternal = false;
         bool _isEncrypted = false;
 
-        bool _fetched = false; // If we did the LSCOL for this folder already
+        bool _fetched = false; // If the subfolders were listed from the journal or by a LSCOL already
         QPointer<LsColJob> _fetchingJob; // Currently running LsColJob
         bool _hasError = false; // If the last fetching job ended in an error
         QString _lastErrorString;
@@ -149,6 +149,14 @@ private slots:
 private:
     [[nodiscard]] QStringList createBlackList(const OCC::FolderStatusModel::SubFolderInfo &root,
         const QStringList &oldBlackList) const;
+
+    [[nodiscard]] QString remotePathForListing(const SubFolderInfo &info) const;
+    void startListingJob(const QModelIndex &parent);
+    /** Lists the folder on the server again if its ETag differs from \a syncedEtag */
+    void refreshIfChanged(const QModelIndex &parent, const QByteArray &syncedEtag);
+    /** Adds the subfolders known from the journal, returns false if it does not know them */
+    bool populateFromJournal(const QModelIndex &parent);
+    void setSubfolders(const QModelIndex &parentIdx, QVector<SubFolderInfo> newSubs, bool isServerListing);
     const AccountState *_accountState = nullptr;
     bool _dirty = false; // If the selective sync checkboxes were changed
 
@@ -535,21 +535,16 @@ void ownCloudGui::slotUpdateProgress(const QString &folder, const ProgressInfo &
     } else if (progress.status() == ProgressInfo::Done) {
         QTimer::singleShot(2000, this, &ownCloudGui::slotComputeOverallSyncStatus);
     }
-    if (progress.status() != ProgressInfo::Propagation) {
-        return;
-    }
-
-    slotComputeOverallSyncStatus();
 
-    if (!progress._lastCompletedItem.isEmpty()) {
-
-        QString kindStr = Progress::asResultString(progress._lastCompletedItem);
+    // Updates are throttled, the final one may still bring items completed during the propagation
+    for (const auto &completedItem : progress._completedItems) {
+        QString kindStr = Progress::asResultString(completedItem);
         QString timeStr = QTime::currentTime().toString("hh:mm");
-        QString actionText = tr("%1 (%2, %3)").arg(progress._lastCompletedItem._file, kindStr, timeStr);
+        QString actionText = tr("%1 (%2, %3)").arg(completedItem._file, kindStr, timeStr);
         auto *action = new QAction(actionText, this);
         Folder *f = FolderMan::instance()->folder(folder);
         if (f) {
-            QString fullPath = f->path() + '/' + progress._lastCompletedItem._file;
+            QString fullPath = f->path() + '/' + completedItem._file;
             if (FileSystem::fileExists(fullPath)) {
                 connect(action, &QAction::triggered, this, [this, fullPath] { this->slotOpenPath(fullPath); });
             } else {
@@ -561,6 +556,10 @@ void ownCloudGui::slotUpdateProgress(const QString &folder, const ProgressInfo &
         }
         _recentItemsActions.append(action);
     }
+
+    if (progress.status() == ProgressInfo::Propagation) {
+        slotComputeOverallSyncStatus();
+    }
 }
 
 void ownCloudGui::slotLogin()
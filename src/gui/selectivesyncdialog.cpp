@@ -13,6 +13,7 @@
  */
 #include "selectivesyncdialog.h"
 #include "account.h"
+#include "common/syncjournaldb.h"
 #include "common/utility.h"
 #include "configfile.h"
 #include "folder.h"
@@ -124,10 +125,12 @@ void SelectiveSyncWidget::refreshFolders()
     _folderTree->clear();
     _loading->show();
     _loading->move(10, _folderTree->header()->height() + 10);
+    insertFromJournal(QString());
 }
 
-void SelectiveSyncWidget::setFolderInfo(const QString &folderPath, const QString &rootName, const QStringList &oldBlackList)
+void SelectiveSyncWidget::setFolderInfo(const QString &folderPath, const QString &rootName, const QStringList &oldBlackList, SyncJournalDb *journal)
 {
+    _journal = journal;
     _folderPath = folderPath;
     if (_folderPath.startsWith(QLatin1Char('/'))) {
         // remove leading '/'
@@ -185,6 +188,10 @@ void SelectiveSyncWidget::recursiveInsert(QTreeWidgetItem *parent, QStringList p
             }
             //            item->setData(0, Qt::UserRole, pathTrail.first());
             item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+        } else if (pathTrail.size() == 1 && size >= 0) {
+            // Folders shown from the journal get their size from the server listing
+            item->setText(1, Utility::octetsToString(size));
+            item->setData(1, Qt::UserRole, size);
         }
 
         pathTrail.removeFirst();
@@ -192,19 +199,70 @@ void SelectiveSyncWidget::recursiveInsert(QTreeWidgetItem *parent, QStringList p
     }
 }
 
+QString SelectiveSyncWidget::folderServerPath() const
+{
+    QUrl url = _account->davUrl();
+    auto path = Utility::trailingSlashPath(url.path());
+    path.append(_folderPath);
+    if (!_folderPath.isEmpty())
+        path.append('/');
+    return path;
+}
+
 void SelectiveSyncWidget::slotUpdateDirectories(QStringList list)
 {
-    auto job = qobject_cast<LsColJob *>(sender());
+    updateDirectories(std::move(list), qobject_cast<LsColJob *>(sender()));
+}
+
+void SelectiveSyncWidget::insertFromJournal(const QString &dir)
+{
+    if (!_journal) {
+        return;
+    }
+
+    // Only the server knows the names inside encrypted folders
+    SyncJournalFileRecord dirRecord;
+    if (!dir.isEmpty() && (!_journal->getFileRecord(dir, &dirRecord) || dirRecord.isE2eEncrypted())) {
+        return;
+    }
+
+    const auto pathToRemove = folderServerPath();
+    const auto dirPath = dir.isEmpty() ? QString() : dir + QLatin1Char('/');
+    QStringList list(pathToRemove + dirPath);
+    const auto ok = _journal->listSubdirectoriesInPath(dir.toUtf8(), [&](const SyncJournalFileRecord &rec) {
+        if (!rec.isE2eEncrypted()) {
+            list.append(pathToRemove + rec.path() + QLatin1Char('/'));
+        }
+    });
+    if (!ok) {
+        return;
+    }
+
+    // Unchecked folders are not synced, only the blacklist knows them
+    for (const auto &path : qAsConst(_oldBlackList)) {
+        if (path.size() > dirPath.size() && path.startsWith(dirPath) && path.indexOf(QLatin1Char('/'), dirPath.size()) == path.size() - 1) {
+            list.append(pathToRemove + path);
+        }
+    }
+
+    if (list.size() > 1) {
+        updateDirectories(list, nullptr);
+    }
+}
+
+void SelectiveSyncWidget::updateDirectories(QStringList list, LsColJob *job)
+{
     QScopedValueRollback<bool> isInserting(_inserting);
     _inserting = true;
 
     auto *root = dynamic_cast<SelectiveSyncTreeViewItem *>(_folderTree->topLevelItem(0));
 
-    QUrl url = _account->davUrl();
-    auto pathToRemove = Utility::trailingSlashPath(url.path());
-    pathToRemove.append(_folderPath);
-    if (!_folderPath.isEmpty())
-        pathToRemove.append('/');
+    const auto pathToRemove = folderServerPath();
+    // The first entry is the listed folder itself
+    auto listedPath = list.isEmpty() ? QString() : list.first();
+    if (!listedPath.endsWith('/')) {
+        listedPath.append('/');
+    }
 
     // Check for excludes.
     QMutableListIterator<QString> it(list);
@@ -241,7 +299,9 @@ void SelectiveSyncWidget::slotUpdateDirectories(QStringList list)
         root->setIcon(0, Theme::instance()->applicationIcon());
         root->setData(0, Qt::UserRole, QString());
         root->setCheckState(0, Qt::Checked);
-        qint64 size = job ? job->_folderInfos[pathToRemove].size : -1;
+    }
+    if (job && job->_folderInfos.contains(pathToRemove)) {
+        const auto size = job->_folderInfos[pathToRemove].size;
         if (size >= 0) {
             root->setText(1, Utility::octetsToString(size));
             root->setData(1, Qt::UserRole, size);
@@ -249,8 +309,12 @@ void SelectiveSyncWidget::slotUpdateDirectories(QStringList list)
     }
 
     Utility::sortFilenames(list);
+    QSet<QString> listedNames;
     foreach (QString path, list) {
-        auto size = job ? job->_folderInfos[path].size : 0;
+        if (path.size() > listedPath.size() && path.startsWith(listedPath)) {
+            listedNames.insert(path.mid(listedPath.size()).section('/', 0, 0));
+        }
+        auto size = job ? job->_folderInfos[path].size : -1;
         path.remove(pathToRemove);
 
         // Don't allow to select subfolders of encrypted subfolders
@@ -272,6 +336,20 @@ void SelectiveSyncWidget::slotUpdateDirectories(QStringList list)
         recursiveInsert(root, paths, path, size);
     }
 
+    // Drop the folders shown from the journal that are gone on the server
+    if (job && listedPath.startsWith(pathToRemove)) {
+        QTreeWidgetItem *listedItem = root;
+        const auto listedTrail = listedPath.mid(pathToRemove.size()).split('/', Qt::SkipEmptyParts);
+        for (const auto &name : listedTrail) {
+            listedItem = listedItem ? findFirstChild(listedItem, name) : nullptr;
+        }
+        for (int i = listedItem ? listedItem->childCount() - 1 : -1; i >= 0; --i) {
+            if (!listedNames.contains(listedItem->child(i)->text(0))) {
+                delete listedItem->takeChild(i);
+            }
+        }
+    }
+
     // Root is partially checked if any children are not checked
     for (int i = 0; i < root->childCount(); ++i) {
         const auto child = root->child(i);
@@ -334,6 +412,7 @@ void SelectiveSyncWidget::slotItemExpanded(QTreeWidgetItem *item)
     if (!_folderPath.isEmpty()) {
         prefix = _folderPath + QLatin1Char('/');
     }
+    insertFromJournal(dir);
     auto *job = new LsColJob(_account, prefix + dir);
     job->setProperties(QList<QByteArray>() << "resourcetype"
                                            << "http://owncloud.org/ns:size");
@@ -480,7 +559,7 @@ SelectiveSyncDialog::SelectiveSyncDialog(AccountPtr account, Folder *folder, QWi
     init(account);
     QStringList selectiveSyncList = _folder->journalDb()->getSelectiveSyncList(SyncJournalDb::SelectiveSyncBlackList, &ok);
     if (ok) {
-        _selectiveSync->setFolderInfo(_folder->remotePath(), _folder->alias(), selectiveSyncList);
+        _selectiveSync->setFolderInfo(_folder->remotePath(), _folder->alias(), selectiveSyncList, _folder->journalDb());
     } else {
         _okButton->setEnabled(false);
     }
@@ -26,6 +26,8 @@ class QLabel;
 namespace OCC {
 
 class Folder;
+class LsColJob;
+class SyncJournalDb;
 
 /**
  * @brief The SelectiveSyncWidget contains a folder tree with labels
@@ -49,8 +51,9 @@ public:
     qint64 estimatedSize(QTreeWidgetItem *root = nullptr);
 
     // oldBlackList is a list of excluded paths, each including a trailing /
+    // The folders known to the journal are shown while the server is asked for the others
     void setFolderInfo(const QString &folderPath, const QString &rootName,
-        const QStringList &oldBlackList = QStringList());
+        const QStringList &oldBlackList = QStringList(), SyncJournalDb *journal = nullptr);
 
     [[nodiscard]] QSize sizeHint() const override;
 
@@ -64,6 +67,9 @@ private slots:
 
 private:
     void refreshFolders();
+    [[nodiscard]] QString folderServerPath() const;
+    void updateDirectories(QStringList list, LsColJob *job);
+    void insertFromJournal(const QString &dir);
     void recursiveInsert(QTreeWidgetItem *parent, QStringList pathTrail, QString path, qint64 size);
 
     AccountPtr _account;
@@ -71,6 +77,7 @@ private:
     QString _folderPath;
     QString _rootName;
     QStringList _oldBlackList;
+    SyncJournalDb *_journal = nullptr;
 
     bool _inserting = false; // set to true when we are inserting new items on the list
     QLabel *_loading;
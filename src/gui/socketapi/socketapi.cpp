@@ -91,6 +91,12 @@
 namespace {
 constexpr auto encryptJobPropertyFolder = "folder";
 constexpr auto encryptJobPropertyPath = "path";
+
+// Lines handled in one pass of the event loop, file managers send a status
+// request for every file of a directory they open
+constexpr int maxLinesPerPass = 200;
+// Requests of a client are not read while more replies than this wait to be sent to it
+constexpr qint64 maxPendingReplyBytes = 1024 * 1024;
 }
 
 namespace {
@@ -217,6 +223,27 @@ namespace OCC {
 Q_LOGGING_CATEGORY(lcSocketApi, "nextcloud.gui.socketapi", QtInfoMsg)
 Q_LOGGING_CATEGORY(lcPublicLink, "nextcloud.gui.socketapi.publiclink", QtInfoMsg)
 
+namespace {
+    // Maps the commands as received on the socket to the index of their command_ method
+    QHash<QByteArray, int> buildCommandTable()
+    {
+        QHash<QByteArray, int> table;
+        const auto &metaObject = SocketApi::staticMetaObject;
+        for (int i = metaObject.methodOffset(); i < metaObject.methodCount(); ++i) {
+            const auto name = metaObject.method(i).name();
+            if (!name.startsWith("command_")) {
+                continue;
+            }
+            auto command = name.mid(8);
+            if (command.startsWith("V2_")) {
+                command = QByteArrayLiteral("V2/") + command.mid(3);
+            }
+            table.insert(command, i);
+        }
+        return table;
+    }
+}
+
 
 void SocketListener::sendMessage(const QString &message, bool doWait) const
 {
@@ -334,6 +361,7 @@ void SocketApi::slotNewConnection()
     }
     qCDebug(lcSocketApi) << "New connection" << socket;
     connect(socket, &QIODevice::readyRead, this, &SocketApi::slotReadSocket);
+    connect(socket, &QIODevice::bytesWritten, this, &SocketApi::slotSocketBytesWritten);
     connect(socket, SIGNAL(disconnected()), this, SLOT(onLostConnection()));
     connect(socket, &QObject::destroyed, this, &SocketApi::slotSocketDestroyed);
     ASSERT(socket->readAll().isEmpty());
@@ -369,6 +397,22 @@ void SocketApi::slotReadSocket()
 {
     auto *socket = qobject_cast<QIODevice *>(sender());
     ASSERT(socket);
+    readSocket(socket);
+}
+
+void SocketApi::slotSocketBytesWritten()
+{
+    auto *socket = qobject_cast<QIODevice *>(sender());
+    ASSERT(socket);
+    // Continue with the requests held back while the replies piled up
+    if (socket->bytesToWrite() < maxPendingReplyBytes / 2 && socket->canReadLine()) {
+        readSocket(socket);
+    }
+}
+
+void SocketApi::readSocket(QIODevice *socket)
+{
+    static const auto commandTable = buildCommandTable();
 
     // Find the SocketListener
     //
@@ -378,32 +422,35 @@ void SocketApi::slotReadSocket()
     // a SocketListener that doesn't send any messages.
     static auto invalidListener = QSharedPointer<SocketListener>::create(nullptr);
     const auto listener = _listeners.value(socket, invalidListener);
-    while (socket->canReadLine()) {
-        // Make sure to normalize the input from the socket to
-        // make sure that the path will match, especially on OS X.
-        const QString line = QString::fromUtf8(socket->readLine().trimmed()).normalized(QString::NormalizationForm_C);
+    for (int lines = 0; socket->canReadLine(); ++lines) {
+        // Continues in slotSocketBytesWritten() once the client read its replies
+        if (socket->bytesToWrite() >= maxPendingReplyBytes) {
+            qCDebug(lcSocketApi) << "Holding back the requests of" << socket << "until it read the replies";
+            return;
+        }
+        // Give the rest of the UI a chance before continuing
+        if (lines == maxLinesPerPass) {
+            QMetaObject::invokeMethod(this, [this, socket = QPointer<QIODevice>(socket)] {
+                if (socket) {
+                    readSocket(socket);
+                }
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        const auto line = socket->readLine().trimmed();
         qCDebug(lcSocketApi) << "Received SocketAPI message <--" << line << "from" << socket;
-        const int argPos = line.indexOf(QLatin1Char(':'));
-        const QByteArray command = line.mid(0, argPos).toUtf8().toUpper();
-        const int indexOfMethod = [&] {
-            QByteArray functionWithArguments = QByteArrayLiteral("command_");
-            if (command.startsWith("ASYNC_")) {
-                functionWithArguments += command + QByteArrayLiteral("(QSharedPointer<SocketApiJob>)");
-            } else if (command.startsWith("V2/")) {
-                functionWithArguments += QByteArrayLiteral("V2_") + command.mid(3) + QByteArrayLiteral("(QSharedPointer<SocketApiJobV2>)");
-            } else {
-                functionWithArguments += command + QByteArrayLiteral("(QString,SocketListener*)");
-            }
-            Q_ASSERT(staticMetaObject.normalizedSignature(functionWithArguments) == functionWithArguments);
-            const auto out = staticMetaObject.indexOfMethod(functionWithArguments);
-            if (out == -1) {
-                listener->sendError(QStringLiteral("Function %1 not found").arg(QString::fromUtf8(functionWithArguments)));
-            }
-            ASSERT(out != -1)
-            return out;
-        }();
+        const auto argPos = line.indexOf(':');
+        const auto command = line.left(argPos).toUpper();
+        const auto indexOfMethod = commandTable.value(command, -1);
+        if (indexOfMethod == -1) {
+            listener->sendError(QStringLiteral("Function command_%1 not found").arg(QString::fromUtf8(command)));
+        }
+        ASSERT(indexOfMethod != -1)
 
-        const auto argument = QString{argPos != -1 ? line.mid(argPos + 1) : QString()};
+        // Make sure to normalize the input from the socket to
+        // make sure that the path will match, especially on OS X.
+        const auto argument = argPos != -1 ? QString::fromUtf8(line.mid(argPos + 1)).normalized(QString::NormalizationForm_C) : QString();
         if (command.startsWith("ASYNC_")) {
             const auto arguments = argument.split('|');
             if (arguments.size() != 2) {
@@ -1144,6 +1191,24 @@ void SocketApi::command_V2_UPLOAD_FILES_FROM(const QSharedPointer<SocketApiJobV2
     uploadJob->start();
 }
 
+void SocketApi::command_V2_NETWORK_STATISTICS(const QSharedPointer<SocketApiJobV2> &job) const
+{
+    const auto reset = job->arguments().value(QStringLiteral("reset")).toBool();
+    QJsonArray out;
+    const auto accounts = AccountManager::instance()->accounts();
+    for (const auto &acc : accounts) {
+        auto &statistics = acc->account()->networkStatistics();
+        out << QJsonObject({ { "name", acc->account()->displayName() },
+            { "id", acc->account()->id() },
+            { "statistics", statistics.toJson() } });
+        qCInfo(lcSocketApi) << "Network statistics of" << acc->account()->displayName() << statistics.summary();
+        if (reset) {
+            statistics.reset();
+        }
+    }
+    job->success({ { "accounts", out } });
+}
+
 void SocketApi::emailPrivateLink(const QString &link)
 {
     Utility::openEmailComposer(
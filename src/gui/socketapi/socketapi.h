@@ -79,6 +79,7 @@ private slots:
     void onLostConnection();
     void slotSocketDestroyed(QObject *obj);
     void slotReadSocket();
+    void slotSocketBytesWritten();
 
     static void copyUrlToClipboard(const QString &link);
     static void emailPrivateLink(const QString &link);
@@ -111,6 +112,9 @@ private:
 
     void broadcastMessage(const QString &msg, bool doWait = false);
 
+    // Handles the complete request lines of a client
+    void readSocket(QIODevice *socket);
+
     // opens share dialog, sends reply
     void processShareRequest(const QString &localFile, SocketListener *listener);
     void processLeaveShareRequest(const QString &localFile, SocketListener *listener);
@@ -156,6 +160,9 @@ private:
     Q_INVOKABLE void command_V2_LIST_ACCOUNTS(const QSharedPointer<OCC::SocketApiJobV2> &job) const;
     Q_INVOKABLE void command_V2_UPLOAD_FILES_FROM(const QSharedPointer<OCC::SocketApiJobV2> &job) const;
 
+    // Debugging: request statistics of the accounts, {"reset": true} starts counting anew
+    Q_INVOKABLE void command_V2_NETWORK_STATISTICS(const QSharedPointer<OCC::SocketApiJobV2> &job) const;
+
     // Fetch the private link and call targetFun
     void fetchPrivateLinkUrlHelper(const QString &localFile, const std::function<void(const QString &url)> &targetFun);
 
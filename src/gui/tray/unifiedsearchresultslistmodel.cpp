@@ -19,6 +19,7 @@
 #include "guiutility.h"
 #include "folderman.h"
 #include "networkjobs.h"
+#include "common/syncjournaldb.h"
 
 #include <algorithm>
 
@@ -186,6 +187,10 @@ std::pair<QString, bool> iconsFromThumbnailAndFallbackIcon(const QString &thumbn
 
 constexpr int searchTermEditingFinishedSearchStartDelay = 800;
 
+// shown before the results of the server, which can still find other files
+const auto localFilesProviderId = QStringLiteral("local-files");
+constexpr int localFilesSearchLimit = 20;
+
 // server-side bug of returning the cursor > 0 and isPaginated == 'true', using '5' as it is done on Android client's end now
 constexpr int minimumEntresNumberToShowLoadMore = 5;
 }
@@ -335,6 +340,12 @@ bool UnifiedSearchResultsListModel::isSearchInProgress() const
 
 void UnifiedSearchResultsListModel::resultClicked(const QString &providerId, const QUrl &resourceUrl) const
 {
+    if (providerId == localFilesProviderId) {
+        qCInfo(lcUnifiedSearch) << "Opening file:" << resourceUrl.toLocalFile();
+        QDesktopServices::openUrl(resourceUrl);
+        return;
+    }
+
     const QUrlQuery urlQuery{resourceUrl};
     const auto dir = urlQuery.queryItemValue(QStringLiteral("dir"), QUrl::ComponentFormattingOption::FullyDecoded);
     const auto fileName =
@@ -387,6 +398,8 @@ void UnifiedSearchResultsListModel::slotSearchTermEditingFinished()
         return;
     }
 
+    startLocalSearch();
+
     if (_providers.isEmpty()) {
         auto job = new JsonApiJob(_accountState->account(), QLatin1String("ocs/v2.php/search/providers"));
         QObject::connect(job, &JsonApiJob::jsonReceived, this, &UnifiedSearchResultsListModel::slotFetchProvidersFinished);
@@ -497,14 +510,70 @@ void UnifiedSearchResultsListModel::startSearch()
         return;
     }
 
+    // keep the results of startLocalSearch(), they come first
+    const auto itFirstServerResult = std::find_if(std::begin(_results), std::end(_results), [](const UnifiedSearchResult &result) {
+        return result._providerId != localFilesProviderId;
+    });
+    if (itFirstServerResult != std::end(_results)) {
+        const auto first = static_cast<int>(std::distance(std::begin(_results), itFirstServerResult));
+        beginRemoveRows({}, first, _results.size() - 1);
+        _results.erase(itFirstServerResult, std::end(_results));
+        endRemoveRows();
+    }
+
+    for (const auto &provider : qAsConst(_providers)) {
+        startSearchForProvider(provider._id);
+    }
+}
+
+void UnifiedSearchResultsListModel::startLocalSearch()
+{
     if (!_results.isEmpty()) {
         beginResetModel();
         _results.clear();
         endResetModel();
     }
 
-    for (const auto &provider : qAsConst(_providers)) {
-        startSearchForProvider(provider._id);
+    const auto folderMan = FolderMan::instance();
+    if (!folderMan) {
+        return;
+    }
+
+    UnifiedSearchProvider provider;
+    provider._id = localFilesProviderId;
+    provider._name = tr("Synced files");
+    provider._order = std::numeric_limits<qint32>::min();
+
+    QVector<UnifiedSearchResult> results;
+    for (const auto folder : folderMan->map()) {
+        if (folder->accountState() != _accountState || results.size() >= localFilesSearchLimit) {
+            continue;
+        }
+
+        const auto found = folder->journalDb()->findFileRecordsByName(_searchTerm, localFilesSearchLimit - results.size(), [&](const SyncJournalFileRecord &record) {
+            const auto isDirectory = record.isDirectory();
+            const auto path = record.path();
+            const auto slashIndex = path.lastIndexOf(QLatin1Char('/'));
+
+            UnifiedSearchResult result;
+            result._providerId = provider._id;
+            result._providerName = provider._name;
+            result._order = provider._order;
+            result._title = path.mid(slashIndex + 1);
+            result._subline = slashIndex > 0 ? folder->shortGuiRemotePathOrAppName() + QLatin1Char('/') + path.left(slashIndex)
+                                             : folder->shortGuiRemotePathOrAppName();
+            result._resourceUrl = QUrl::fromLocalFile(folder->path() + path);
+            result._darkIcons = isDirectory ? QStringLiteral(":/client/theme/white/folder.svg") : imagePlaceholderUrlForProviderId(provider._id, true);
+            result._lightIcons = isDirectory ? QStringLiteral(":/client/theme/black/folder.svg") : imagePlaceholderUrlForProviderId(provider._id, false);
+            results.push_back(result);
+        });
+        if (!found) {
+            qCWarning(lcUnifiedSearch) << "Could not search the file names of" << folder->path();
+        }
+    }
+
+    if (!results.isEmpty()) {
+        appendResults(results, provider);
     }
 }
 
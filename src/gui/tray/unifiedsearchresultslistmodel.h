@@ -87,6 +87,8 @@ public:
 
 private:
     void startSearch();
+    // look up the search term in the file names of the sync journals, no server round trip needed
+    void startLocalSearch();
     void startSearchForProvider(const QString &providerId, qint32 cursor = -1);
 
     void parseResultsForProvider(const QJsonObject &data, const QString &providerId, bool fetchedMore = false);
@@ -161,11 +161,69 @@ QNetworkReply *AbstractNetworkJob::sendRequest(const QByteArray &verb,
 void AbstractNetworkJob::adoptRequest(QNetworkReply *reply)
 {
     addTimer(reply);
+    // in case the previous reply is replaced before it finished
+    finishRequestStatistics(true);
     setReply(reply);
     setupConnections(reply);
+    startRequestStatistics(reply);
     newReplyHook(reply);
 }
 
+void AbstractNetworkJob::startRequestStatistics(QNetworkReply *reply)
+{
+    if (!_account) {
+        return;
+    }
+
+    _requestStatistics = {};
+    _requestStatistics.verb = HttpLogger::requestVerb(*reply);
+    _requestStatisticsPending = true;
+    _requestTimer.start();
+    _account->networkStatistics().requestStarted();
+
+    // QNAM does not tell whether a connection was reused: a request that had to
+    // wait for a new connection or a TLS handshake counts as a new connection.
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this] {
+        _requestStatistics.newConnection = true;
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [this] {
+        if (_requestStatistics.queueWaitMsecs < 0) {
+            _requestStatistics.queueWaitMsecs = _requestTimer.elapsed();
+        }
+    });
+#endif
+    connect(reply, &QNetworkReply::encrypted, this, [this] {
+        _requestStatistics.newConnection = true;
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this] {
+        if (_requestStatistics.timeToFirstByteMsecs < 0) {
+            _requestStatistics.timeToFirstByteMsecs = _requestTimer.elapsed();
+        }
+    });
+    connect(reply, &QNetworkReply::uploadProgress, this, [this](qint64 bytesSent, qint64) {
+        _requestStatistics.bytesSent = qMax(_requestStatistics.bytesSent, bytesSent);
+    });
+    connect(reply, &QNetworkReply::downloadProgress, this, [this](qint64 bytesReceived, qint64) {
+        _requestStatistics.bytesReceived = qMax(_requestStatistics.bytesReceived, bytesReceived);
+    });
+}
+
+void AbstractNetworkJob::finishRequestStatistics(bool failed)
+{
+    if (!_requestStatisticsPending) {
+        return;
+    }
+    _requestStatisticsPending = false;
+
+    _requestStatistics.durationMsecs = _requestTimer.elapsed();
+    _requestStatistics.failed = failed;
+    if (_reply) {
+        _requestStatistics.http2 = _reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+    }
+    _account->networkStatistics().requestFinished(_requestStatistics);
+}
+
 QUrl AbstractNetworkJob::makeAccountUrl(const QString &relativePath) const
 {
     return Utility::concatUrlPath(_account->url(), relativePath);
@@ -179,6 +237,7 @@ QUrl AbstractNetworkJob::makeDavUrl(const QString &relativePath) const
 void AbstractNetworkJob::slotFinished()
 {
     _timer.stop();
+    finishRequestStatistics(_reply->error() != QNetworkReply::NoError);
 
     if (_reply->error() == QNetworkReply::SslHandshakeFailedError) {
         qCWarning(lcNetworkJob) << "SslHandshakeFailedError: " << errorString() << " : can be caused by a webserver wanting SSL client certificates";
@@ -351,6 +410,7 @@ QString AbstractNetworkJob::errorStringParsingBodyException(const QByteArray &bo
 
 AbstractNetworkJob::~AbstractNetworkJob()
 {
+    finishRequestStatistics(true);
     setReply(nullptr);
 }
 
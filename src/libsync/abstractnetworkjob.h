@@ -19,6 +19,7 @@
 
 #include "accountfwd.h"
 #include "common/asserts.h"
+#include "networkstatistics.h"
 
 #include <QObject>
 #include <QNetworkRequest>
@@ -212,6 +213,8 @@ protected:
 
 private:
     QNetworkReply *addTimer(QNetworkReply *reply);
+    void startRequestStatistics(QNetworkReply *reply);
+    void finishRequestStatistics(bool failed);
     bool _ignoreCredentialFailure = false;
     QPointer<QNetworkReply> _reply; // (QPointer because the NetworkManager may be destroyed before the jobs at exit)
     QString _path;
@@ -219,6 +222,11 @@ private:
     int _redirectCount = 0;
     int _http2ResendCount = 0;
 
+    // Measurements of the running request, reported to the account's NetworkStatistics
+    QElapsedTimer _requestTimer;
+    NetworkStatistics::Request _requestStatistics;
+    bool _requestStatisticsPending = false;
+
     // Set by the xyzRequest() functions and needed to be able to redirect
     // requests, should it be required.
     //
@@ -21,6 +21,7 @@
 #include "clientsideencryption.h"
 #include "clientstatusreporting.h"
 #include "common/utility.h"
+#include "networkstatistics.h"
 #include "syncfileitem.h"
 
 #include <QByteArray>
@@ -319,6 +320,9 @@ public:
     /// Called by network jobs on credential errors, emits invalidCredentials()
     void handleInvalidCredentials();
 
+    /// Statistics about the requests sent by the network jobs of this account
+    NetworkStatistics &networkStatistics() { return _networkStatistics; }
+
     ClientSideEncryption* e2e();
 
     /// Used in RemoteWipe
@@ -520,6 +524,7 @@ private:
     QSharedPointer<QNetworkAccessManager> _am;
     QScopedPointer<AbstractCredentials> _credentials;
     bool _http2Supported = false;
+    NetworkStatistics _networkStatistics;
 
     /// Certificates that were explicitly rejected by the user
     QList<QSslCertificate> _rejectedCertificates;
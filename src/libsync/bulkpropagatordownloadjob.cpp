@@ -0,0 +1,704 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "bulkpropagatordownloadjob.h"
+
+#include "account.h"
+#include "capabilities.h"
+#include "filesystem.h"
+#include "propagatedownload.h"
+#include "common/checksumcalculator.h"
+#include "common/checksums.h"
+#include "common/syncjournaldb.h"
+#include "common/utility.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QSet>
+#include <QUrl>
+
+#include <algorithm>
+#include <functional>
+
+namespace OCC {
+
+Q_LOGGING_CATEGORY(lcBulkPropagatorDownloadJob, "nextcloud.sync.propagator.bulkdownload", QtInfoMsg)
+
+QString createDownloadTmpFileName(const QString &previous);
+
+namespace {
+
+constexpr qint64 tarBlockSize = 512;
+
+// Upper bound for GNU long name and pax header entries, which are buffered
+constexpr qint64 maxMetadataEntrySize = 64 * 1024;
+
+// Keeps the request URL well below common server limits
+constexpr qint64 maxRequestedNamesSize = 2048;
+
+/*
+ * Incremental reader for tar streams (ustar, GNU long names and pax path records).
+ *
+ * The archive is written into this device as it arrives from the network and
+ * the file entries are handed out through the callbacks, so nothing but the
+ * current header block needs to be buffered.
+ */
+class TarArchiveReader : public QIODevice
+{
+public:
+    std::function<void(const QString &name, qint64 size)> entryStarted;
+    std::function<void(const char *data, qint64 size)> entryData;
+    std::function<void()> entryFinished;
+
+    /// Whether the end-of-archive marker was received
+    [[nodiscard]] bool isAtEnd() const { return _state == State::End; }
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    enum class State {
+        Header,
+        Data,
+        Padding,
+        End
+    };
+
+    enum class EntryKind {
+        File,
+        LongName,
+        PaxHeader,
+        Skipped
+    };
+
+    bool parseHeader();
+    void finishEntryData();
+    void parsePaxHeader();
+
+    State _state = State::Header;
+    EntryKind _kind = EntryKind::Skipped;
+    QByteArray _block;
+    QByteArray _metadata;
+    qint64 _remaining = 0;
+    qint64 _padding = 0;
+    QString _nextName;
+    qint64 _nextSize = -1;
+};
+
+qint64 parseOctal(const char *field, int length, bool *ok)
+{
+    qint64 value = 0;
+    int i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+        ++i;
+    }
+    *ok = i < length;
+    for (; i < length && field[i] != ' ' && field[i] != '\0'; ++i) {
+        if (field[i] < '0' || field[i] > '7') {
+            *ok = false;
+            return 0;
+        }
+        value = value * 8 + (field[i] - '0');
+    }
+    return value;
+}
+
+qint64 parseNumericField(const char *field, int length, bool *ok)
+{
+    // GNU base-256 encoding for values that don't fit the octal field
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        qint64 value = 0;
+        for (int i = 1; i < length; ++i) {
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+        *ok = value >= 0;
+        return value;
+    }
+    return parseOctal(field, length, ok);
+}
+
+QByteArray stringField(const char *field, int length)
+{
+    return QByteArray(field, static_cast<int>(qstrnlen(field, length)));
+}
+
+qint64 TarArchiveReader::writeData(const char *data, qint64 len)
+{
+    qint64 pos = 0;
+    while (pos < len) {
+        const auto available = len - pos;
+        switch (_state) {
+        case State::Header: {
+            const auto count = qMin(tarBlockSize - _block.size(), available);
+            _block.append(data + pos, count);
+            pos += count;
+            if (_block.size() == tarBlockSize) {
+                if (!parseHeader()) {
+                    return -1;
+                }
+                _block.clear();
+            }
+            break;
+        }
+        case State::Data: {
+            const auto count = qMin(_remaining, available);
+            if (_kind == EntryKind::File) {
+                entryData(data + pos, count);
+            } else if (_kind != EntryKind::Skipped) {
+                _metadata.append(data + pos, count);
+            }
+            pos += count;
+            _remaining -= count;
+            if (_remaining == 0) {
+                finishEntryData();
+            }
+            break;
+        }
+        case State::Padding: {
+            const auto count = qMin(_padding, available);
+            pos += count;
+            _padding -= count;
+            if (_padding == 0) {
+                _state = State::Header;
+            }
+            break;
+        }
+        case State::End:
+            pos = len;
+            break;
+        }
+    }
+    return len;
+}
+
+bool TarArchiveReader::parseHeader()
+{
+    const auto block = _block.constData();
+
+    if (std::all_of(block, block + tarBlockSize, [](char c) { return c == '\0'; })) {
+        _state = State::End;
+        return true;
+    }
+
+    bool ok = false;
+    const auto storedChecksum = parseOctal(block + 148, 8, &ok);
+    qint64 unsignedChecksum = 0;
+    qint64 signedChecksum = 0;
+    for (int i = 0; i < tarBlockSize; ++i) {
+        const auto c = (i >= 148 && i < 156) ? ' ' : block[i];
+        unsignedChecksum += static_cast<unsigned char>(c);
+        signedChecksum += static_cast<signed char>(c);
+    }
+    if (!ok || (storedChecksum != unsignedChecksum && storedChecksum != signedChecksum)) {
+        setErrorString(QStringLiteral("Invalid tar header checksum"));
+        return false;
+    }
+
+    auto size = parseNumericField(block + 124, 12, &ok);
+    if (!ok) {
+        setErrorString(QStringLiteral("Invalid tar entry size"));
+        return false;
+    }
+
+    const auto typeFlag = block[156];
+    switch (typeFlag) {
+    case '0':
+    case '\0':
+    case '7': {
+        if (_nextSize >= 0) {
+            size = _nextSize;
+        }
+        auto name = _nextName;
+        if (name.isEmpty()) {
+            auto rawName = stringField(block, 100);
+            const auto prefix = stringField(block + 345, 155);
+            if (qstrncmp(block + 257, "ustar", 5) == 0 && !prefix.isEmpty()) {
+                rawName = prefix + '/' + rawName;
+            }
+            name = QString::fromUtf8(rawName);
+        }
+        _kind = EntryKind::File;
+        entryStarted(name, size);
+        break;
+    }
+    case 'L':
+    case 'x':
+        if (size > maxMetadataEntrySize) {
+            setErrorString(QStringLiteral("Tar metadata entry too large"));
+            return false;
+        }
+        _kind = typeFlag == 'L' ? EntryKind::LongName : EntryKind::PaxHeader;
+        break;
+    default:
+        // directories, links, global pax headers...
+        _kind = EntryKind::Skipped;
+        break;
+    }
+
+    if (_kind != EntryKind::LongName && _kind != EntryKind::PaxHeader) {
+        _nextName.clear();
+        _nextSize = -1;
+    }
+
+    _remaining = size;
+    _padding = (tarBlockSize - size % tarBlockSize) % tarBlockSize;
+    _state = State::Data;
+    if (_remaining == 0) {
+        finishEntryData();
+    }
+    return true;
+}
+
+void TarArchiveReader::finishEntryData()
+{
+    switch (_kind) {
+    case EntryKind::File:
+        entryFinished();
+        break;
+    case EntryKind::LongName:
+        _nextName = QString::fromUtf8(stringField(_metadata.constData(), static_cast<int>(_metadata.size())));
+        break;
+    case EntryKind::PaxHeader:
+        parsePaxHeader();
+        break;
+    case EntryKind::Skipped:
+        break;
+    }
+    _metadata.clear();
+    _state = _padding > 0 ? State::Padding : State::Header;
+}
+
+void TarArchiveReader::parsePaxHeader()
+{
+    // Records look like "<length> <key>=<value>\n", where length covers the whole record
+    qsizetype pos = 0;
+    while (pos < _metadata.size()) {
+        const auto space = _metadata.indexOf(' ', pos);
+        if (space < 0) {
+            return;
+        }
+        bool ok = false;
+        const auto length = _metadata.mid(pos, space - pos).toLongLong(&ok);
+        if (!ok || length <= space - pos + 1 || pos + length > _metadata.size()) {
+            return;
+        }
+        const auto record = _metadata.mid(space + 1, pos + length - 1 - (space + 1));
+        const auto separator = record.indexOf('=');
+        if (separator > 0) {
+            const auto key = record.left(separator);
+            if (key == "path") {
+                _nextName = QString::fromUtf8(record.mid(separator + 1));
+            } else if (key == "size") {
+                _nextSize = record.mid(separator + 1).toLongLong();
+            }
+        }
+        pos += length;
+    }
+}
+
+QString fileNameOf(const SyncFileItemPtr &item)
+{
+    return item->_file.mid(item->_file.lastIndexOf(QLatin1Char('/')) + 1);
+}
+
+}
+
+BulkPropagatorDownloadJob::BulkPropagatorDownloadJob(OwncloudPropagator *propagator, const QString &folder)
+    : PropagatorJob(propagator)
+    , _folder(folder)
+    , _fallbackJobs(propagator)
+{
+    connect(&_fallbackJobs, &PropagatorJob::finished, this, &BulkPropagatorDownloadJob::slotFallbackJobsFinished);
+}
+
+BulkPropagatorDownloadJob::~BulkPropagatorDownloadJob()
+{
+    if (auto p = propagator()) {
+        p->_activeJobList.removeAll(this);
+    }
+}
+
+void BulkPropagatorDownloadJob::appendItem(const SyncFileItemPtr &item)
+{
+    const auto name = fileNameOf(item);
+    _items.append(item);
+    _pendingItems.insert(name, item);
+    _requestedNamesSize += name.size();
+}
+
+bool BulkPropagatorDownloadJob::isFull() const
+{
+    return _items.size() >= batchSize || _requestedNamesSize >= maxRequestedNamesSize;
+}
+
+bool BulkPropagatorDownloadJob::scheduleSelfOrChild()
+{
+    if (_state == Finished) {
+        return false;
+    }
+
+    if (_state == NotYetStarted) {
+        _state = Running;
+        qCInfo(lcBulkPropagatorDownloadJob) << "Starting bulk download of" << _items.size() << "files in" << _folder << "by" << this;
+        QMetaObject::invokeMethod(this, &BulkPropagatorDownloadJob::startArchiveDownload, Qt::QueuedConnection);
+        return true;
+    }
+
+    if (_archiveFinished) {
+        return _fallbackJobs.scheduleSelfOrChild();
+    }
+    return false;
+}
+
+PropagatorJob::JobParallelism BulkPropagatorDownloadJob::parallelism() const
+{
+    return FullParallelism;
+}
+
+void BulkPropagatorDownloadJob::abort(PropagatorJob::AbortType abortType)
+{
+    if (_job && _job->reply()) {
+        _job->reply()->abort();
+    }
+
+    if (abortType == AbortType::Asynchronous) {
+        connect(&_fallbackJobs, &PropagatorCompositeJob::abortFinished, this, &BulkPropagatorDownloadJob::abortFinished);
+    }
+    _fallbackJobs.abort(abortType);
+}
+
+qint64 BulkPropagatorDownloadJob::committedDiskSpace() const
+{
+    auto needed = _fallbackJobs.committedDiskSpace();
+    if (_state == Running && !_archiveFinished) {
+        for (const auto &item : _pendingItems) {
+            needed += item->_size;
+        }
+    }
+    return needed;
+}
+
+void BulkPropagatorDownloadJob::startArchiveDownload()
+{
+    if (propagator()->_abortRequested) {
+        // The job is already running as far as the propagator is concerned,
+        // it has to finish even though nothing was downloaded.
+        _archiveFinished = true;
+        if (!_pendingItems.isEmpty()) {
+            _status = SyncFileItem::SoftError;
+        }
+        finalize();
+        return;
+    }
+
+    if (propagator()->_bulkDownloadUnsupported) {
+        startFallback();
+        return;
+    }
+
+    if (propagator()->diskSpaceCheck() != OwncloudPropagator::DiskSpaceOk) {
+        // The individual downloads report the disk space problem properly
+        startFallback();
+        return;
+    }
+
+#if !defined(Q_OS_MACOS) || __MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_15
+    // Downloads into read-only folders need their permissions adjusted temporarily,
+    // which the regular download job takes care of.
+    if (FileSystem::isFolderReadOnly(propagator()->fullLocalPath(_folder).toStdWString())) {
+        startFallback();
+        return;
+    }
+#endif
+
+    QJsonArray files;
+    for (const auto &item : qAsConst(_items)) {
+        files.append(fileNameOf(item));
+    }
+    auto url = Utility::concatUrlPath(propagator()->account()->davUrl(), propagator()->fullRemotePath(_folder));
+    url.setQuery(QStringLiteral("files=") + QString::fromLatin1(QUrl::toPercentEncoding(QJsonDocument(files).toJson(QJsonDocument::Compact))));
+
+    auto reader = std::make_unique<TarArchiveReader>();
+    reader->entryStarted = [this](const QString &name, qint64 size) { entryStarted(name, size); };
+    reader->entryData = [this](const char *data, qint64 size) { entryData(data, size); };
+    reader->entryFinished = [this] { entryFinished(); };
+    reader->open(QIODevice::WriteOnly);
+    _archiveReader = std::move(reader);
+
+    QMap<QByteArray, QByteArray> headers;
+    headers["Accept"] = "application/x-tar";
+    _job = new GETFileJob(propagator()->account(), url, _archiveReader.get(), headers, {}, 0, this);
+    _job->setBandwidthManager(&propagator()->_bandwidthManager);
+    connect(_job.data(), &GETFileJob::finishedSignal, this, &BulkPropagatorDownloadJob::slotArchiveFinished);
+    propagator()->_activeJobList.append(this);
+    _job->start();
+}
+
+void BulkPropagatorDownloadJob::slotArchiveFinished()
+{
+    propagator()->_activeJobList.removeOne(this);
+
+    const auto reply = _job->reply();
+    const auto httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const auto contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+    const auto reachedEnd = static_cast<TarArchiveReader *>(_archiveReader.get())->isAtEnd();
+
+    // An entry that was cut off by the end of the stream can't be used
+    discardCurrentEntry();
+    _archiveReader->close();
+    _archiveFinished = true;
+
+    if (_items.size() != _pendingItems.size()) {
+        propagator()->_journal->commit(QStringLiteral("bulk download"));
+    }
+
+    if (propagator()->_abortRequested) {
+        if (!_pendingItems.isEmpty() && _status == SyncFileItem::NoStatus) {
+            _status = SyncFileItem::SoftError;
+        }
+        finalize();
+        return;
+    }
+
+    const auto isArchive = httpStatus / 100 == 2 && contentType.contains("tar");
+    if (!isArchive) {
+        static const QSet<int> unsupportedStatusCodes = {400, 405, 406, 415, 501};
+        if (httpStatus / 100 == 2 || unsupportedStatusCodes.contains(httpStatus)) {
+            qCInfo(lcBulkPropagatorDownloadJob) << "Server does not support archive downloads, status" << httpStatus << contentType;
+            propagator()->_bulkDownloadUnsupported = true;
+        }
+    }
+
+    if (!_pendingItems.isEmpty()) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Bulk download of" << _folder << "left" << _pendingItems.size() << "of" << _items.size()
+                                               << "files, status" << httpStatus << "error" << _job->errorString() << "complete archive" << reachedEnd;
+        startFallback();
+        return;
+    }
+
+    finalize();
+}
+
+void BulkPropagatorDownloadJob::entryStarted(const QString &name, qint64 size)
+{
+    discardCurrentEntry();
+
+    auto fileName = name;
+    while (fileName.startsWith(QLatin1String("./"))) {
+        fileName.remove(0, 2);
+    }
+    auto it = _pendingItems.constFind(fileName);
+    if (it == _pendingItems.constEnd()) {
+        // Servers may put the entries below a directory named after the folder
+        it = _pendingItems.constFind(fileName.mid(fileName.lastIndexOf(QLatin1Char('/')) + 1));
+    }
+    if (it == _pendingItems.constEnd()) {
+        qCDebug(lcBulkPropagatorDownloadJob) << "Skipping unexpected archive entry" << name;
+        return;
+    }
+
+    const auto item = it.value();
+    if (size != item->_size) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Archive entry size" << size << "does not match" << item->_size << "for" << item->_file;
+        return;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = it.key();
+    entry->item = item;
+    entry->tmpFile.setFileName(propagator()->fullLocalPath(createDownloadTmpFileName(item->_file)));
+    if (!entry->tmpFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Could not open temporary file" << entry->tmpFile.fileName() << entry->tmpFile.errorString();
+        return;
+    }
+
+    QByteArray checksumType;
+    if (parseChecksumHeader(item->_checksumHeader, &checksumType, &entry->expectedChecksum) && !checksumType.isEmpty()) {
+        entry->transmissionChecksum = std::make_unique<ChecksumCalculator>(checksumType);
+        if (!entry->transmissionChecksum->isInitialized()) {
+            entry->transmissionChecksum.reset();
+        }
+    }
+    entry->contentChecksumType = propagator()->account()->capabilities().preferredUploadChecksumType();
+    if (!entry->contentChecksumType.isEmpty() && entry->contentChecksumType != checksumType) {
+        entry->contentChecksum = std::make_unique<ChecksumCalculator>(entry->contentChecksumType);
+        if (!entry->contentChecksum->isInitialized()) {
+            entry->contentChecksum.reset();
+        }
+    }
+
+    _currentEntry = std::move(entry);
+}
+
+void BulkPropagatorDownloadJob::entryData(const char *data, qint64 size)
+{
+    if (!_currentEntry || _currentEntry->failed) {
+        return;
+    }
+
+    if (_currentEntry->tmpFile.write(data, size) != size) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Error while writing to file" << _currentEntry->tmpFile.fileName() << _currentEntry->tmpFile.errorString();
+        _currentEntry->failed = true;
+        return;
+    }
+    if (_currentEntry->transmissionChecksum) {
+        _currentEntry->transmissionChecksum->addData(data, size);
+    }
+    if (_currentEntry->contentChecksum) {
+        _currentEntry->contentChecksum->addData(data, size);
+    }
+    _currentEntry->written += size;
+}
+
+void BulkPropagatorDownloadJob::entryFinished()
+{
+    if (!_currentEntry) {
+        return;
+    }
+
+    auto entry = std::move(_currentEntry);
+    entry->tmpFile.close();
+    if (entry->failed || !finalizeEntry(*entry)) {
+        FileSystem::remove(entry->tmpFile.fileName());
+    }
+}
+
+bool BulkPropagatorDownloadJob::finalizeEntry(Entry &entry)
+{
+    const auto &item = entry.item;
+    const auto tmpFileName = entry.tmpFile.fileName();
+    const auto filename = propagator()->fullLocalPath(item->_file);
+
+    if (entry.written != item->_size || item->_modtime <= 0) {
+        return false;
+    }
+
+    if (entry.transmissionChecksum && entry.transmissionChecksum->result() != entry.expectedChecksum) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Checksum mismatch for" << item->_file << entry.transmissionChecksum->result() << entry.expectedChecksum;
+        return false;
+    }
+
+    // Anything that appeared locally in the meantime needs the conflict handling of the regular download
+    if (propagator()->localFileNameClash(item->_file) || FileSystem::fileExists(filename)) {
+        return false;
+    }
+
+    FileSystem::setModTime(tmpFileName, item->_modtime);
+    // Re-read the time, some file systems have a worse than second accuracy (#3103)
+    const auto modtime = FileSystem::getModTime(tmpFileName);
+    if (modtime <= 0) {
+        return false;
+    }
+
+    FileSystem::setFileReadOnlyWeak(tmpFileName, (!item->_remotePerm.isNull() && !item->_remotePerm.hasPermission(RemotePermissions::CanWrite)));
+
+    QString error;
+    emit propagator()->touchedFile(filename);
+    if (!FileSystem::uncheckedRenameReplace(tmpFileName, filename, &error)) {
+        qCWarning(lcBulkPropagatorDownloadJob) << "Rename failed:" << tmpFileName << "=>" << filename << error;
+        return false;
+    }
+
+    _pendingItems.remove(entry.name);
+
+    item->_modtime = modtime;
+    item->_size = FileSystem::getSize(filename);
+    if (entry.contentChecksum) {
+        item->_checksumHeader = makeChecksumHeader(entry.contentChecksumType, entry.contentChecksum->result());
+    }
+
+    // Drop the state of an earlier, interrupted download of this file
+    const auto downloadInfo = propagator()->_journal->getDownloadInfo(item->_file);
+    if (downloadInfo._valid) {
+        FileSystem::remove(propagator()->fullLocalPath(downloadInfo._tmpfile));
+        propagator()->_journal->setDownloadInfo(item->_file, SyncJournalDb::DownloadInfo());
+    }
+
+    propagator()->reportProgress(*item, item->_size);
+
+    const auto result = propagator()->updateMetadata(*item);
+    if (!result) {
+        itemDone(item, SyncFileItem::FatalError, tr("Error updating metadata: %1").arg(result.error()));
+    } else if (*result == Vfs::ConvertToPlaceholderResult::Locked) {
+        itemDone(item, SyncFileItem::SoftError, tr("The file %1 is currently in use").arg(item->_file));
+    } else {
+        itemDone(item, SyncFileItem::Success, {});
+    }
+    return true;
+}
+
+void BulkPropagatorDownloadJob::discardCurrentEntry()
+{
+    if (!_currentEntry) {
+        return;
+    }
+
+    _currentEntry->tmpFile.close();
+    FileSystem::remove(_currentEntry->tmpFile.fileName());
+    _currentEntry.reset();
+}
+
+void BulkPropagatorDownloadJob::itemDone(const SyncFileItemPtr &item, SyncFileItem::Status status, const QString &errorString)
+{
+    item->_status = status;
+    if (item->_errorString.isEmpty()) {
+        item->_errorString = errorString;
+    }
+
+    if (status == SyncFileItem::Success) {
+        if (item->_hasBlacklistEntry) {
+            propagator()->_journal->wipeErrorBlacklistEntry(item->_file);
+        }
+    } else {
+        blacklistUpdate(propagator()->_journal, *item);
+        _status = item->_status;
+    }
+
+    emit propagator()->itemCompleted(item, status == SyncFileItem::Success ? ErrorCategory::NoError : ErrorCategory::GenericError);
+}
+
+void BulkPropagatorDownloadJob::startFallback()
+{
+    for (const auto &item : qAsConst(_items)) {
+        if (_pendingItems.contains(fileNameOf(item))) {
+            _fallbackJobs.appendTask(item);
+        }
+    }
+    _pendingItems.clear();
+    _archiveFinished = true;
+    propagator()->scheduleNextJob();
+}
+
+void BulkPropagatorDownloadJob::slotFallbackJobsFinished(SyncFileItem::Status status)
+{
+    if (status != SyncFileItem::Success && status != SyncFileItem::NoStatus) {
+        _status = status;
+    }
+    finalize();
+}
+
+void BulkPropagatorDownloadJob::finalize()
+{
+    if (_state == Finished) {
+        return;
+    }
+
+    _state = Finished;
+    qCInfo(lcBulkPropagatorDownloadJob) << "Bulk download of" << _folder << "finished, status" << _status;
+    emit finished(_status == SyncFileItem::NoStatus ? SyncFileItem::Success : _status);
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudpropagator.h"
+
+#include <QFile>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QPointer>
+
+#include <memory>
+
+namespace OCC {
+
+Q_DECLARE_LOGGING_CATEGORY(lcBulkPropagatorDownloadJob)
+
+class ChecksumCalculator;
+class GETFileJob;
+
+/**
+ * @brief Downloads many new small files of one folder with a single request
+ *
+ * The files are requested as one tar archive stream from the folder
+ * (GET on the folder with "Accept: application/x-tar" and the list of
+ * names in the "files" query parameter). The entries are extracted into
+ * their temporary download files while the stream arrives, checked against
+ * the size and checksum known from discovery and then moved into place.
+ * The journal records of all extracted files are committed together.
+ *
+ * Every item that could not be extracted, for example because the server
+ * does not support archive downloads or the entry was missing or corrupt,
+ * falls back to a regular PropagateDownloadFile job run as a sub job.
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT BulkPropagatorDownloadJob : public PropagatorJob
+{
+    Q_OBJECT
+
+public:
+    explicit BulkPropagatorDownloadJob(OwncloudPropagator *propagator, const QString &folder);
+    ~BulkPropagatorDownloadJob() override;
+
+    static constexpr int batchSize = 100;
+
+    void appendItem(const SyncFileItemPtr &item);
+    /// Whether no more items should be added to this batch
+    [[nodiscard]] bool isFull() const;
+
+    bool scheduleSelfOrChild() override;
+    [[nodiscard]] JobParallelism parallelism() const override;
+    void abort(PropagatorJob::AbortType abortType) override;
+    [[nodiscard]] qint64 committedDiskSpace() const override;
+
+private slots:
+    void slotArchiveFinished();
+    void slotFallbackJobsFinished(OCC::SyncFileItem::Status status);
+
+private:
+    struct Entry
+    {
+        QString name;
+        SyncFileItemPtr item;
+        QFile tmpFile;
+        QByteArray expectedChecksum;
+        std::unique_ptr<ChecksumCalculator> transmissionChecksum;
+        QByteArray contentChecksumType;
+        std::unique_ptr<ChecksumCalculator> contentChecksum;
+        qint64 written = 0;
+        bool failed = false;
+    };
+
+    void startArchiveDownload();
+
+    // Called by the archive reader while the stream is parsed
+    void entryStarted(const QString &name, qint64 size);
+    void entryData(const char *data, qint64 size);
+    void entryFinished();
+
+    /// Verifies and moves the finished entry into place; returns false if the item needs a fallback
+    bool finalizeEntry(Entry &entry);
+    void discardCurrentEntry();
+
+    void itemDone(const SyncFileItemPtr &item, SyncFileItem::Status status, const QString &errorString);
+    void startFallback();
+    void finalize();
+
+    QString _folder; // relative to the sync root, empty for the root itself
+    SyncFileItemVector _items;
+    QHash<QString, SyncFileItemPtr> _pendingItems; // by name inside _folder, not extracted yet
+    qint64 _requestedNamesSize = 0;
+
+    QPointer<GETFileJob> _job;
+    std::unique_ptr<QIODevice> _archiveReader;
+    std::unique_ptr<Entry> _currentEntry;
+    bool _archiveFinished = false;
+
+    PropagatorCompositeJob _fallbackJobs;
+    SyncFileItem::Status _status = SyncFileItem::NoStatus;
+};
+
+}
@@ -367,8 +367,7 @@ void BulkPropagatorJob::slotPutFinishedOneFile(const BulkUploadItem &singleFile,
     if (singleFile._item->_httpErrorCode != 200) {
         commonErrorHandling(singleFile._item, fileReply[QStringLiteral("message")].toString());
         const auto exceptionParsed = getExceptionFromReply(job->reply());
-        singleFile._item->_errorExceptionName = exceptionParsed.first;
-        singleFile._item->_errorExceptionMessage = exceptionParsed.second;
+        singleFile._item->setErrorException(exceptionParsed.first, exceptionParsed.second);
         return;
     }
 
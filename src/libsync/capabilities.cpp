@@ -355,6 +355,16 @@ bool Capabilities::chunkingParallelUploadDisabled() const
     return _capabilities["dav"].toMap()["chunkingParallelUploadDisabled"].toBool();
 }
 
+bool Capabilities::chunkingCopyRange() const
+{
+    return chunkingNg() && _capabilities["dav"].toMap()["chunkingCopyRange"].toBool();
+}
+
+bool Capabilities::contentChunks() const
+{
+    return _capabilities["dav"].toMap()["contentChunks"].toBool();
+}
+
 bool Capabilities::privateLinkPropertyAvailable() const
 {
     return _capabilities["files"].toMap()["privateLinks"].toBool();
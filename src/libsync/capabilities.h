@@ -82,6 +82,12 @@ public:
     /// disable parallel upload in chunking
     [[nodiscard]] bool chunkingParallelUploadDisabled() const;
 
+    /// Whether chunks of an upload can be copied from a range of the existing file
+    [[nodiscard]] bool chunkingCopyRange() const;
+
+    /// Whether the server sends the content chunks of a file, see ContentChunker
+    [[nodiscard]] bool contentChunks() const;
+
     /// Whether the "privatelink" DAV property is available
     [[nodiscard]] bool privateLinkPropertyAvailable() const;
 
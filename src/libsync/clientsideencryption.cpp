@@ -38,6 +38,7 @@
 #include <QRandomGenerator>
 #include <QJsonArray>
 #include <QCryptographicHash>
+#include <QtEndian>
 
 #include <map>
 #include <string>
@@ -81,6 +82,7 @@ constexpr char e2e_public[] = "_e2e-public";
 constexpr char e2e_mnemonic[] = "_e2e-mnemonic";
 
 constexpr qint64 blockSize = 1024;
+constexpr int aesBlockSize = 16;
 
 QList<QByteArray> oldCipherFormatSplit(const QByteArray &cipher)
 {
@@ -2303,6 +2305,180 @@ bool EncryptionHelper::StreamingDecryptor::isFinished() const
     return _isFinished;
 }
 
+EncryptionHelper::StreamingEncryptor::StreamingEncryptor(const QByteArray &key, const QByteArray &iv, quint64 offset)
+    : _key(key)
+    , _encryptedSoFar(offset)
+{
+    if (!_ctx || key.isEmpty() || iv.isEmpty()) {
+        return;
+    }
+
+    /* Initialize the encryption operation. */
+    if (!EVP_EncryptInit_ex(_ctx, EVP_aes_128_gcm(), nullptr, nullptr, nullptr)) {
+        qCritical(lcCse()) << "Could not init cipher";
+        return;
+    }
+
+    EVP_CIPHER_CTX_set_padding(_ctx, 0);
+
+    /* Set IV length. */
+    if (!EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_SET_IVLEN, iv.size(), nullptr)) {
+        qCritical(lcCse()) << "Could not set iv length";
+        return;
+    }
+
+    /* Initialize key and IV */
+    if (!EVP_EncryptInit_ex(_ctx, nullptr, nullptr, reinterpret_cast<const unsigned char *>(key.constData()), reinterpret_cast<const unsigned char *>(iv.constData()))) {
+        qCritical(lcCse()) << "Could not set key and iv";
+        return;
+    }
+
+    if (offset == 0) {
+        _authenticated = true;
+        _isInitialized = true;
+        return;
+    }
+
+    // GCM encrypts the data with the counter blocks following the one derived from the iv.
+    // Encrypting a block of zeros yields the first of them encrypted, decrypting it again
+    // gives the counter block to continue with in plain counter mode at any later block.
+    const QByteArray zeroBlock(aesBlockSize, '\0');
+    QByteArray keyStream(aesBlockSize, '\0');
+    int len = 0;
+    if (!EVP_EncryptUpdate(_ctx, unsignedData(keyStream), &len, reinterpret_cast<const unsigned char *>(zeroBlock.constData()), aesBlockSize) || len != aesBlockSize) {
+        qCritical(lcCse()) << "Could not compute the key stream";
+        return;
+    }
+
+    CipherCtx ecbCtx;
+    if (!ecbCtx || !EVP_DecryptInit_ex(ecbCtx, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const unsigned char *>(key.constData()), nullptr)) {
+        qCritical(lcCse()) << "Could not init block cipher";
+        return;
+    }
+    EVP_CIPHER_CTX_set_padding(ecbCtx, 0);
+
+    _initialCounterBlock = QByteArray(2 * aesBlockSize, '\0');
+    if (!EVP_DecryptUpdate(ecbCtx, unsignedData(_initialCounterBlock), &len, reinterpret_cast<const unsigned char *>(keyStream.constData()), aesBlockSize) || len != aesBlockSize) {
+        qCritical(lcCse()) << "Could not compute the counter block";
+        return;
+    }
+    _initialCounterBlock.truncate(aesBlockSize);
+
+    if (!initializeCounterMode(offset / aesBlockSize)) {
+        return;
+    }
+
+    // skip the part of the block before the offset
+    if (const auto skip = static_cast<int>(offset % aesBlockSize); skip > 0) {
+        QByteArray skipped(aesBlockSize, '\0');
+        if (!EVP_EncryptUpdate(_ctx, unsignedData(skipped), &len, reinterpret_cast<const unsigned char *>(zeroBlock.constData()), skip)) {
+            qCritical(lcCse()) << "Could not seek to offset" << offset;
+            return;
+        }
+    }
+
+    _isInitialized = true;
+}
+
+bool EncryptionHelper::StreamingEncryptor::initializeCounterMode(quint64 block)
+{
+    // GCM only increments the lowest 32 bits of the counter block while counter mode carries
+    // over into the higher bits, so start again from the wrapped counter when they overflow
+    auto counterBlock = _initialCounterBlock;
+    const auto counter = static_cast<quint32>(qFromBigEndian<quint32>(counterBlock.constData() + aesBlockSize - 4) + block);
+    qToBigEndian(counter, counterBlock.data() + aesBlockSize - 4);
+    _counterWrapPosition = (block + ((quint64{1} << 32) - counter)) * aesBlockSize;
+
+    if (!EVP_EncryptInit_ex(_ctx, EVP_aes_128_ctr(), nullptr, reinterpret_cast<const unsigned char *>(_key.constData()), reinterpret_cast<const unsigned char *>(counterBlock.constData()))) {
+        qCritical(lcCse()) << "Could not init counter mode cipher";
+        return false;
+    }
+    return true;
+}
+
+QByteArray EncryptionHelper::StreamingEncryptor::chunkEncryption(const char *input, quint64 chunkSize)
+{
+    Q_ASSERT(isInitialized() && !isFinished());
+    if (!isInitialized() || isFinished()) {
+        qCritical(lcCse()) << "Encryption failed. Encryptor is not initialized or already finished!";
+        return QByteArray();
+    }
+
+    Q_ASSERT(input);
+    if (!input) {
+        qCritical(lcCse()) << "Encryption failed. Incorrect input!";
+        return QByteArray();
+    }
+
+    Q_ASSERT(chunkSize > 0);
+    if (chunkSize <= 0) {
+        qCritical(lcCse()) << "Encryption failed. Incorrect chunkSize!";
+        return QByteArray();
+    }
+
+    QByteArray output(static_cast<qsizetype>(chunkSize), '\0');
+    quint64 inputPos = 0;
+
+    while (inputPos < chunkSize) {
+        auto size = qMin<quint64>(chunkSize - inputPos, blockSize);
+        if (!_authenticated) {
+            if (_encryptedSoFar == _counterWrapPosition && !initializeCounterMode(_encryptedSoFar / aesBlockSize)) {
+                return QByteArray();
+            }
+            size = qMin(size, _counterWrapPosition - _encryptedSoFar);
+        }
+
+        int outLen = 0;
+        if (!EVP_EncryptUpdate(_ctx, reinterpret_cast<unsigned char *>(output.data()) + inputPos, &outLen,
+                               reinterpret_cast<const unsigned char *>(input) + inputPos, static_cast<int>(size))
+            || static_cast<quint64>(outLen) != size) {
+            qCritical(lcCse()) << "Could not encrypt";
+            return QByteArray();
+        }
+
+        inputPos += size;
+        _encryptedSoFar += size;
+    }
+
+    return output;
+}
+
+QByteArray EncryptionHelper::StreamingEncryptor::finalize()
+{
+    Q_ASSERT(isInitialized() && !isFinished() && _authenticated);
+    if (!isInitialized() || isFinished() || !_authenticated) {
+        qCritical(lcCse()) << "Cannot compute the e2EeTag of an unfinished or partial encryption!";
+        return QByteArray();
+    }
+    _isFinished = true;
+
+    QByteArray out(aesBlockSize, '\0');
+    int len = 0;
+    if (1 != EVP_EncryptFinal_ex(_ctx, unsignedData(out), &len)) {
+        qCritical(lcCse()) << "Could finalize encryption";
+        return QByteArray();
+    }
+
+    QByteArray e2EeTag(OCC::Constants::e2EeTagSize, '\0');
+    if (1 != EVP_CIPHER_CTX_ctrl(_ctx, EVP_CTRL_GCM_GET_TAG, OCC::Constants::e2EeTagSize, unsignedData(e2EeTag))) {
+        qCritical(lcCse()) << "Could not get e2EeTag";
+        return QByteArray();
+    }
+
+    qCDebug(lcCse()) << "Encryption complete";
+    return e2EeTag;
+}
+
+bool EncryptionHelper::StreamingEncryptor::isInitialized() const
+{
+    return _isInitialized;
+}
+
+bool EncryptionHelper::StreamingEncryptor::isFinished() const
+{
+    return _isFinished;
+}
+
 NextcloudSslCertificate::NextcloudSslCertificate() = default;
 
 NextcloudSslCertificate::NextcloudSslCertificate(const NextcloudSslCertificate &other) = default;
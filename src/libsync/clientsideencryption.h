@@ -123,6 +123,45 @@ private:
     quint64 _decryptedSoFar = 0;
     quint64 _totalSize = 0;
 };
+
+/**
+ * Encrypts file data with AES-128-GCM in chunks, producing the same output
+ * as fileEncryption() without writing an encrypted copy of the file.
+ *
+ * An encryptor can also start at \a offset within the plain data, which
+ * allows resuming or uploading parts of a file in parallel. GCM encrypts in
+ * counter mode, so the data from any offset is encrypted with the counter
+ * stream of GCM directly. Only an encryptor starting at 0 authenticates the
+ * data and can provide the e2EeTag with finalize().
+ */
+class OWNCLOUDSYNC_EXPORT StreamingEncryptor
+{
+public:
+    StreamingEncryptor(const QByteArray &key, const QByteArray &iv, quint64 offset = 0);
+    ~StreamingEncryptor() = default;
+
+    /// Returns the encrypted data, which has the size of the input, or an empty array on failure
+    QByteArray chunkEncryption(const char *input, quint64 chunkSize);
+    /// Finishes the encryption and returns the e2EeTag, empty if it cannot be computed
+    QByteArray finalize();
+
+    [[nodiscard]] bool isInitialized() const;
+    [[nodiscard]] bool isFinished() const;
+
+private:
+    Q_DISABLE_COPY(StreamingEncryptor)
+
+    bool initializeCounterMode(quint64 block);
+
+    CipherCtx _ctx;
+    QByteArray _key;
+    QByteArray _initialCounterBlock;
+    bool _isInitialized = false;
+    bool _isFinished = false;
+    bool _authenticated = false;
+    quint64 _encryptedSoFar = 0;
+    quint64 _counterWrapPosition = 0;
+};
 }
 
 class OWNCLOUDSYNC_EXPORT NextcloudSslCertificate
@@ -73,6 +73,11 @@ static constexpr char chunkSizeC[] = "chunkSize";
 static constexpr char minChunkSizeC[] = "minChunkSize";
 static constexpr char maxChunkSizeC[] = "maxChunkSize";
 static constexpr char targetChunkUploadDurationC[] = "targetChunkUploadDuration";
+static constexpr char progressPublishIntervalC[] = "progressPublishInterval";
+static constexpr char bulkDownloadC[] = "bulkDownload";
+static constexpr char remoteDeltaDiscoveryC[] = "remoteDeltaDiscovery";
+static constexpr char deltaUploadC[] = "deltaUpload";
+static constexpr char deltaDownloadC[] = "deltaDownload";
 static constexpr char automaticLogDirC[] = "logToTemporaryLogDir";
 static constexpr char logDirC[] = "logDir";
 static constexpr char logDebugC[] = "logDebug";
@@ -268,6 +273,36 @@ chrono::milliseconds ConfigFile::targetChunkUploadDuration() const
     return millisecondsValue(settings, targetChunkUploadDurationC, chrono::minutes(1));
 }
 
+chrono::milliseconds ConfigFile::progressPublishInterval() const
+{
+    QSettings settings(configFile(), QSettings::IniFormat);
+    return millisecondsValue(settings, progressPublishIntervalC, chrono::milliseconds(200));
+}
+
+bool ConfigFile::bulkDownload() const
+{
+    QSettings settings(configFile(), QSettings::IniFormat);
+    return settings.value(QLatin1String(bulkDownloadC), false).toBool();
+}
+
+bool ConfigFile::remoteDeltaDiscovery() const
+{
+    QSettings settings(configFile(), QSettings::IniFormat);
+    return settings.value(QLatin1String(remoteDeltaDiscoveryC), false).toBool();
+}
+
+bool ConfigFile::deltaUpload() const
+{
+    QSettings settings(configFile(), QSettings::IniFormat);
+    return settings.value(QLatin1String(deltaUploadC), false).toBool();
+}
+
+bool ConfigFile::deltaDownload() const
+{
+    QSettings settings(configFile(), QSettings::IniFormat);
+    return settings.value(QLatin1String(deltaDownloadC), false).toBool();
+}
+
 void ConfigFile::setOptionalServerNotifications(bool show)
 {
     QSettings settings(configFile(), QSettings::IniFormat);
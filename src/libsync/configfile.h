@@ -178,6 +178,11 @@ public:
     [[nodiscard]] qint64 maxChunkSize() const;
     [[nodiscard]] qint64 minChunkSize() const;
     [[nodiscard]] std::chrono::milliseconds targetChunkUploadDuration() const;
+    [[nodiscard]] std::chrono::milliseconds progressPublishInterval() const;
+    [[nodiscard]] bool bulkDownload() const;
+    [[nodiscard]] bool remoteDeltaDiscovery() const;
+    [[nodiscard]] bool deltaUpload() const;
+    [[nodiscard]] bool deltaDownload() const;
 
     void saveGeometry(QWidget *w);
     void restoreGeometry(QWidget *w);
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "contentchunker.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QHash>
+#include <QIODevice>
+#include <QLoggingCategory>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <array>
+
+namespace OCC {
+
+Q_LOGGING_CATEGORY(lcContentChunker, "nextcloud.sync.contentchunker", QtInfoMsg)
+
+namespace {
+
+constexpr quint8 serializationVersion = 1;
+constexpr int hashSize = 32; // SHA-256
+
+constexpr quint64 splitMix64(quint64 &state)
+{
+    auto z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// The chunks stored in journals and on servers depend on this table, it must never change
+constexpr std::array<quint64, 256> makeGearTable()
+{
+    std::array<quint64, 256> table{};
+    quint64 state = 0x6e657874636c6f75ULL;
+    for (auto &value : table) {
+        value = splitMix64(state);
+    }
+    return table;
+}
+
+constexpr auto gearTable = makeGearTable();
+
+}
+
+qint64 ContentChunker::averageChunkSize(qint64 fileSize)
+{
+    // Keeps the chunk list of a file at about 2048 entries
+    constexpr qint64 minAverageSize = 64 * 1024;
+    constexpr qint64 maxAverageSize = 64 * 1024 * 1024;
+    auto averageSize = minAverageSize;
+    while (averageSize < maxAverageSize && averageSize * 2048 < fileSize) {
+        averageSize *= 2;
+    }
+    return averageSize;
+}
+
+bool ContentChunker::computeChunks(QIODevice *device, qint64 averageSize, Chunks *chunks)
+{
+    Q_ASSERT(averageSize > 0 && (averageSize & (averageSize - 1)) == 0);
+    const auto minSize = averageSize / 4;
+    const auto maxSize = averageSize * 4;
+    // A boundary where the top log2(averageSize) bits of the hash are zero
+    const auto maskBits = qCountTrailingZeroBits(quint64(averageSize));
+    const auto mask = ~quint64(0) << (64 - maskBits);
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    qint64 bufferOffset = 0;
+    qint64 chunkStart = 0;
+    quint64 fingerprint = 0;
+
+    qint64 read = 0;
+    while ((read = device->read(buffer.data(), buffer.size())) > 0) {
+        const auto data = buffer.constData();
+        qint64 pos = 0;
+        while (pos < read) {
+            auto end = pos;
+            auto boundary = false;
+            while (end < read) {
+                fingerprint = (fingerprint << 1) + gearTable[static_cast<uchar>(data[end])];
+                ++end;
+                const auto chunkSize = bufferOffset + end - chunkStart;
+                if ((chunkSize >= minSize && (fingerprint & mask) == 0) || chunkSize >= maxSize) {
+                    boundary = true;
+                    break;
+                }
+            }
+            hash.addData(data + pos, end - pos);
+            pos = end;
+            if (boundary) {
+                const auto chunkEnd = bufferOffset + end;
+                chunks->append({ chunkStart, chunkEnd - chunkStart, hash.result() });
+                hash.reset();
+                chunkStart = chunkEnd;
+                fingerprint = 0;
+            }
+        }
+        bufferOffset += read;
+    }
+    if (read < 0) {
+        qCWarning(lcContentChunker) << "Error reading the data to chunk:" << device->errorString();
+        return false;
+    }
+    if (bufferOffset > chunkStart) {
+        chunks->append({ chunkStart, bufferOffset - chunkStart, hash.result() });
+    }
+    return true;
+}
+
+QByteArray ContentChunker::serialize(const Chunks &chunks)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << serializationVersion;
+    for (const auto &chunk : chunks) {
+        Q_ASSERT(chunk.hash.size() == hashSize);
+        stream << chunk.size;
+        stream.writeRawData(chunk.hash.constData(), hashSize);
+    }
+    return data;
+}
+
+ContentChunker::Chunks ContentChunker::deserialize(const QByteArray &data)
+{
+    Chunks chunks;
+    QDataStream stream(data);
+    quint8 version = 0;
+    stream >> version;
+    if (version != serializationVersion) {
+        qCWarning(lcContentChunker) << "Unknown chunk list version" << version;
+        return {};
+    }
+
+    qint64 offset = 0;
+    while (!stream.atEnd()) {
+        Chunk chunk;
+        chunk.offset = offset;
+        stream >> chunk.size;
+        chunk.hash.resize(hashSize);
+        if (stream.readRawData(chunk.hash.data(), hashSize) != hashSize || chunk.size <= 0) {
+            qCWarning(lcContentChunker) << "Corrupt chunk list";
+            return {};
+        }
+        offset += chunk.size;
+        chunks.append(chunk);
+    }
+    return chunks;
+}
+
+ContentChunker::Segments ContentChunker::planSegments(const Chunks &previous, const Chunks &current, qint64 minSegmentSize, int maxSegments)
+{
+    QHash<QByteArray, int> previousIndexes;
+    previousIndexes.reserve(previous.size());
+    for (int i = previous.size() - 1; i >= 0; --i) {
+        previousIndexes.insert(previous.at(i).hash, i);
+    }
+
+    // Runs of adjacent chunks that are new or that follow each other in the previous version
+    Segments runs;
+    int nextPrevious = -1;
+    for (const auto &chunk : current) {
+        // Prefer the chunk after the last copied one, repeated data then
+        // doesn't split up an unchanged part
+        auto source = -1;
+        if (nextPrevious >= 0 && nextPrevious < previous.size() && previous.at(nextPrevious).hash == chunk.hash) {
+            source = nextPrevious;
+        } else if (const auto it = previousIndexes.constFind(chunk.hash); it != previousIndexes.cend()) {
+            source = *it;
+        }
+        if (source >= 0 && previous.at(source).size != chunk.size) {
+            source = -1;
+        }
+        nextPrevious = source >= 0 ? source + 1 : -1;
+
+        const auto sourceOffset = source >= 0 ? previous.at(source).offset : -1;
+        if (!runs.isEmpty()) {
+            auto &last = runs.last();
+            const auto continues = sourceOffset < 0 ? !last.isCopy() : last.isCopy() && last.sourceOffset + last.size == sourceOffset;
+            if (continues) {
+                last.size += chunk.size;
+                continue;
+            }
+        }
+        runs.append({ chunk.offset, chunk.size, sourceOffset });
+    }
+
+    Segments segments;
+    for (int i = 0; i < runs.size(); ++i) {
+        auto segment = runs.at(i);
+        if (segment.size < minSegmentSize && i + 1 < runs.size()) {
+            // Too small to be a part of its own, transfer it with the start of what follows
+            segment.sourceOffset = -1;
+            while (segment.size < minSegmentSize && i + 1 < runs.size()) {
+                auto &next = runs[i + 1];
+                const auto missing = minSegmentSize - segment.size;
+                if (next.isCopy() && next.size - missing >= minSegmentSize) {
+                    next.offset += missing;
+                    next.sourceOffset += missing;
+                    next.size -= missing;
+                    segment.size += missing;
+                } else {
+                    segment.size += next.size;
+                    ++i;
+                }
+            }
+        }
+        if (!segment.isCopy() && !segments.isEmpty() && !segments.last().isCopy()) {
+            segments.last().size += segment.size;
+        } else {
+            segments.append(segment);
+        }
+    }
+
+    if (segments.size() > maxSegments
+        || std::none_of(segments.cbegin(), segments.cend(), [](const Segment &segment) { return segment.isCopy(); })) {
+        return {};
+    }
+    return segments;
+}
+
+}
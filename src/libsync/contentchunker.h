@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudlib.h"
+
+#include <QByteArray>
+#include <QVector>
+
+class QIODevice;
+
+namespace OCC {
+
+/**
+ * @brief Splits file contents into content-defined chunks
+ *
+ * The chunk boundaries are found with a gear rolling hash over the data, so
+ * they only depend on the bytes right before them: inserting or removing
+ * data in the middle of a file changes the chunks around the edit, the
+ * chunks before and after it stay the same. Every chunk is identified by
+ * the SHA-256 hash of its data.
+ *
+ * Comparing the chunks of two versions of a file tells which parts of the
+ * new version are already known, see planSegments().
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT ContentChunker
+{
+public:
+    struct Chunk
+    {
+        qint64 offset = 0;
+        qint64 size = 0;
+        QByteArray hash; /// SHA-256 of the data
+    };
+    using Chunks = QVector<Chunk>;
+
+    /// A part of a new version of a file, either copied from the previous version or transferred
+    struct Segment
+    {
+        qint64 offset = 0;
+        qint64 size = 0;
+        qint64 sourceOffset = -1; /// offset in the previous version, -1 if the data must be transferred
+
+        [[nodiscard]] bool isCopy() const { return sourceOffset >= 0; }
+    };
+    using Segments = QVector<Segment>;
+
+    /**
+     * The average chunk size for a file of \a fileSize bytes, a power of two.
+     *
+     * Chunks are between a quarter and four times as large. Chunks of two
+     * versions can only match if they were computed with the same average.
+     */
+    static qint64 averageChunkSize(qint64 fileSize);
+
+    /// Reads \a device to its end and appends its chunks to \a chunks, returns false on read errors
+    static bool computeChunks(QIODevice *device, qint64 averageSize, Chunks *chunks);
+
+    static QByteArray serialize(const Chunks &chunks);
+    /// Returns no chunks if \a data is not the result of serialize()
+    static Chunks deserialize(const QByteArray &data);
+
+    /**
+     * Splits the \a current version of a file into the segments to copy from
+     * the \a previous version and the ones to transfer, uploads use it with
+     * the version on the server as the previous one, downloads with the local
+     * file.
+     *
+     * Adjacent chunks are merged into one segment. All segments but the last
+     * are at least \a minSegmentSize bytes large: smaller ones are transferred
+     * together with the data that follows them. Returns no segments if
+     * nothing can be copied or if there would be more than \a maxSegments.
+     */
+    static Segments planSegments(const Chunks &previous, const Chunks &current, qint64 minSegmentSize, int maxSegments);
+};
+
+}
@@ -87,7 +87,11 @@ void ProcessDirectoryJob::start()
 
     _discoveryData->_noCaseConflictRecordsInDb = _discoveryData->_statedb->caseClashConflictRecordPaths().isEmpty();
 
-    if (_queryServer == NormalQuery) {
+    if (_queryServer == NormalQuery && _dirItem && !_dirItem->isEncrypted()
+        && _discoveryData->remoteListingFromDelta(_currentFolder._server, &_serverNormalQueryEntries, &_rootPermissions)) {
+        qCInfo(lcDisco) << "Remote content of" << _currentFolder._server << "is known from the remote delta";
+        _serverQueryDone = true;
+    } else if (_queryServer == NormalQuery) {
         _serverJob = startAsyncServerQuery();
     } else {
         _serverQueryDone = true;
@@ -561,7 +565,7 @@ void ProcessDirectoryJob::processFile(PathTuple path,
     item->_originalFile = path._original;
     item->_previousSize = dbEntry._fileSize;
     item->_previousModtime = dbEntry._modtime;
-    item->_discoveryResult = std::move(processingLog);
+    item->setDiscoveryResult(processingLog);
 
     if (dbEntry._modtime == localEntry.modtime && dbEntry._type == ItemTypeVirtualFile && localEntry.type == ItemTypeFile) {
         item->_type = ItemTypeFile;
@@ -615,22 +619,6 @@ void ProcessDirectoryJob::processFile(PathTuple path,
     processFileAnalyzeLocalInfo(item, path, localEntry, serverEntry, dbEntry, _queryServer);
 }
 
-// Compute the checksum of the given file and assign the result in item->_checksumHeader
-// Returns true if the checksum was successfully computed
-static bool computeLocalChecksum(const QByteArray &header, const QString &path, const SyncFileItemPtr &item)
-{
-    auto type = parseChecksumHeaderType(header);
-    if (!type.isEmpty()) {
-        // TODO: compute async?
-        QByteArray checksum = ComputeChecksum::computeNowOnFile(path, type);
-        if (!checksum.isEmpty()) {
-            item->_checksumHeader = makeChecksumHeader(type, checksum);
-            return true;
-        }
-    }
-    return false;
-}
-
 void ProcessDirectoryJob::postProcessServerNew(const SyncFileItemPtr &item,
                                                PathTuple &path,
                                                const LocalInfo &localEntry,
@@ -641,6 +629,7 @@ void ProcessDirectoryJob::postProcessServerNew(const SyncFileItemPtr &item,
         _pendingAsyncJobs++;
         _discoveryData->checkSelectiveSyncNewFolder(path._server,
                                                     serverEntry.remotePerm,
+                                                    serverEntry.sizeOfFolder,
                                                     [=](bool result) {
                                                         --_pendingAsyncJobs;
                                                         if (!result) {
@@ -665,7 +654,7 @@ void ProcessDirectoryJob::postProcessServerNew(const SyncFileItemPtr &item,
         }
     }
 
-    if (opts._vfs->mode() != Vfs::Off && !item->_encryptedFileName.isEmpty()) {
+    if (opts._vfs->mode() != Vfs::Off && !item->encryptedFileName().isEmpty()) {
         // We are syncing a file for the first time (local entry is invalid) and it is encrypted file that will be virtual once synced
         // to avoid having error of "file has changed during sync" when trying to hydrate it explicitly - we must remove Constants::e2EeTagSize bytes from the end
         // as explicit hydration does not care if these bytes are present in the placeholder or not, but, the size must not change in the middle of the sync
@@ -691,13 +680,12 @@ void ProcessDirectoryJob::processFileAnalyzeRemoteInfo(const SyncFileItemPtr &it
     item->_lastShareStateFetchedTimestamp = QDateTime::currentMSecsSinceEpoch();
     item->_type = serverEntry.isDirectory ? ItemTypeDirectory : ItemTypeFile;
     item->_etag = serverEntry.etag;
-    item->_directDownloadUrl = serverEntry.directDownloadUrl;
-    item->_directDownloadCookies = serverEntry.directDownloadCookies;
+    item->setDirectDownload(serverEntry.directDownloadUrl, serverEntry.directDownloadCookies);
     item->_e2eEncryptionStatus = serverEntry.isE2eEncrypted() ? SyncFileItem::EncryptionStatus::Encrypted : SyncFileItem::EncryptionStatus::NotEncrypted;
     if (serverEntry.isE2eEncrypted()) {
         item->_e2eEncryptionServerCapability = EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_discoveryData->_account->capabilities().clientSideEncryptionVersion());
     }
-    item->_encryptedFileName = [=] {
+    item->setEncryptedFileName([=] {
         if (serverEntry.e2eMangledName.isEmpty()) {
             return QString();
         }
@@ -708,15 +696,15 @@ void ProcessDirectoryJob::processFileAnalyzeRemoteInfo(const SyncFileItemPtr &it
         const auto rootPath = _discoveryData->_remoteFolder.mid(1);
         Q_ASSERT(serverEntry.e2eMangledName.startsWith(rootPath));
         return serverEntry.e2eMangledName.mid(rootPath.length());
-    }();
+    }());
     item->_locked = serverEntry.locked;
-    item->_lockOwnerDisplayName = serverEntry.lockOwnerDisplayName;
-    item->_lockOwnerId = serverEntry.lockOwnerId;
+    item->setLockOwnerDisplayName(serverEntry.lockOwnerDisplayName);
+    item->setLockOwnerId(serverEntry.lockOwnerId);
     item->_lockOwnerType = serverEntry.lockOwnerType;
-    item->_lockEditorApp = serverEntry.lockEditorApp;
+    item->setLockEditorApp(serverEntry.lockEditorApp);
     item->_lockTime = serverEntry.lockTime;
     item->_lockTimeout = serverEntry.lockTimeout;
-    item->_lockToken = serverEntry.lockToken;
+    item->setLockToken(serverEntry.lockToken);
 
     // Check for missing server data
     {
@@ -765,7 +753,7 @@ void ProcessDirectoryJob::processFileAnalyzeRemoteInfo(const SyncFileItemPtr &it
 
         if (serverEntry.isDirectory) {
             // Even if over quota, continue syncing as normal for now
-            _discoveryData->checkSelectiveSyncExistingFolder(path._server);
+            _discoveryData->checkSelectiveSyncExistingFolder(path._server, serverEntry.sizeOfFolder);
         }
 
         if (serverEntry.isDirectory != dbEntry.isDirectory()) {
@@ -1058,43 +1046,7 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
     _childModified |= serverModified;
 
     auto finalize = [&] {
-        bool recurse = item->isDirectory() || localEntry.isDirectory || serverEntry.isDirectory;
-        // Even if we have a local directory: If the remote is a file that's propagated as a
-        // conflict we don't need to recurse into it. (local c1.owncloud, c1/ ; remote: c1)
-        if (item->_instruction == CSYNC_INSTRUCTION_CONFLICT && !item->isDirectory())
-            recurse = false;
-        if (_queryLocal != NormalQuery && _queryServer != NormalQuery)
-            recurse = false;
-
-        if ((item->_direction == SyncFileItem::Down || item->_instruction == CSYNC_INSTRUCTION_CONFLICT || item->_instruction == CSYNC_INSTRUCTION_NEW || item->_instruction == CSYNC_INSTRUCTION_SYNC) &&
-                (item->_modtime <= 0 || item->_modtime >= 0xFFFFFFFF)) {
-            item->_instruction = CSYNC_INSTRUCTION_ERROR;
-            item->_errorString = tr("Cannot sync due to invalid modification time");
-            item->_status = SyncFileItem::Status::NormalError;
-        }
-
-        if (item->_type != CSyncEnums::ItemTypeVirtualFile) {
-            const auto foundEditorsKeepingFileBusy = queryEditorsKeepingFileBusy(item, path);
-            if (!foundEditorsKeepingFileBusy.isEmpty()) {
-                item->_instruction = CSYNC_INSTRUCTION_ERROR;
-                const auto editorsString = foundEditorsKeepingFileBusy.join(", ");
-                qCInfo(lcDisco) << "Failed, because it is open in the editor." << item->_file << "direction" << item->_direction << editorsString;
-                item->_errorString = tr("Could not upload file, because it is open in \"%1\".").arg(editorsString);
-                item->_status = SyncFileItem::Status::SoftError;
-                _discoveryData->_anotherSyncNeeded = true;
-                _discoveryData->_filesNeedingScheduledSync.insert(path._original, delayIntervalForSyncRetryForOpenedForSigningFilesSeconds);
-            }
-        }
-
-        if (dbEntry.isValid() && item->isDirectory()) {
-            item->_e2eEncryptionStatus = EncryptionStatusEnums::fromDbEncryptionStatus(dbEntry._e2eEncryptionStatus);
-            if (item->isEncrypted()) {
-                item->_e2eEncryptionServerCapability = EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_discoveryData->_account->capabilities().clientSideEncryptionVersion());
-            }
-        }
-
-        auto recurseQueryLocal = _queryLocal == ParentNotChanged ? ParentNotChanged : localEntry.isDirectory || item->_instruction == CSYNC_INSTRUCTION_RENAME ? NormalQuery : ParentDontExist;
-        processFileFinalize(item, path, recurse, recurseQueryLocal, recurseQueryServer);
+        processFileAnalyzeLocalInfoFinalize(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer);
     };
 
     if (!localEntry.isValid()) {
@@ -1250,12 +1202,23 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
             // Checksum comparison at this stage is only enabled for .eml files,
             // check #4754 #4755
             bool isEmlFile = path._original.endsWith(QLatin1String(".eml"), Qt::CaseInsensitive);
-            if (isEmlFile && dbEntry._fileSize == localEntry.size && !dbEntry._checksumHeader.isEmpty()) {
-                if (computeLocalChecksum(dbEntry._checksumHeader, _discoveryData->_localDir + path._local, item)
-                        && item->_checksumHeader == dbEntry._checksumHeader) {
-                    qCInfo(lcDisco) << "NOTE: Checksums are identical, file did not actually change: " << path._local;
-                    item->_instruction = CSYNC_INSTRUCTION_UPDATE_METADATA;
-                }
+            const auto checksumType = parseChecksumHeaderType(dbEntry._checksumHeader);
+            if (isEmlFile && dbEntry._fileSize == localEntry.size && !checksumType.isEmpty()) {
+                _pendingAsyncJobs++;
+                _discoveryData->computeLocalChecksum(_discoveryData->_localDir + path._local, checksumType, localEntry.size, this,
+                    [=](const QByteArray &checksum) {
+                        if (!checksum.isEmpty()) {
+                            item->_checksumHeader = makeChecksumHeader(checksumType, checksum);
+                            if (item->_checksumHeader == dbEntry._checksumHeader) {
+                                qCInfo(lcDisco) << "NOTE: Checksums are identical, file did not actually change: " << path._local;
+                                item->_instruction = CSYNC_INSTRUCTION_UPDATE_METADATA;
+                            }
+                        }
+                        processFileAnalyzeLocalInfoFinalize(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer);
+                        _pendingAsyncJobs--;
+                        QTimer::singleShot(0, _discoveryData, &DiscoveryPhase::scheduleMoreJobs);
+                    });
+                return;
             }
         }
 
@@ -1301,83 +1264,6 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
         return;
     }
 
-    auto postProcessLocalNew = [item, localEntry, path, this]() {
-        // TODO: We may want to execute the same logic for non-VFS mode, as, moving/renaming the same folder by 2 or more clients at the same time is not possible in Web UI.
-        // Keeping it like this (for VFS files and folders only) just to fix a user issue.
-
-        if (!(_discoveryData && _discoveryData->_syncOptions._vfs && _discoveryData->_syncOptions._vfs->mode() != Vfs::Off)) {
-            // for VFS files and folders only
-            return;
-        }
-
-        if (!localEntry.isVirtualFile && !localEntry.isDirectory) {
-            return;
-        }
-
-        if (localEntry.isDirectory && _discoveryData->_syncOptions._vfs->mode() != Vfs::WindowsCfApi) {
-            // for VFS folders on Windows only
-            return;
-        }
-
-        Q_ASSERT(item->_instruction == CSYNC_INSTRUCTION_NEW);
-        if (item->_instruction != CSYNC_INSTRUCTION_NEW) {
-            qCWarning(lcDisco) << "Trying to wipe a virtual item" << path._local << " with item->_instruction" << item->_instruction;
-            return;
-        }
-
-        // must be a dehydrated placeholder
-        const bool isFilePlaceHolder = !localEntry.isDirectory && _discoveryData->_syncOptions._vfs->isDehydratedPlaceholder(_discoveryData->_localDir + path._local);
-
-        // either correct availability, or a result with error if the folder is new or otherwise has no availability set yet
-        const auto folderPlaceHolderAvailability = localEntry.isDirectory ? _discoveryData->_syncOptions._vfs->availability(path._local, Vfs::AvailabilityRecursivity::RecursiveAvailability) : Vfs::AvailabilityResult(Vfs::AvailabilityError::NoSuchItem);
-
-        const auto folderPinState = localEntry.isDirectory ? _discoveryData->_syncOptions._vfs->pinState(path._local) : Optional<PinState>(PinState::Unspecified);
-
-        if (!isFilePlaceHolder && !folderPlaceHolderAvailability.isValid() && !folderPinState.isValid()) {
-            // not a file placeholder and not a synced folder placeholder (new local folder)
-            return;
-        }
-
-        const auto isFolderPinStateOnlineOnly = (folderPinState.isValid() && *folderPinState == PinState::OnlineOnly);
-
-        const auto isfolderPlaceHolderAvailabilityOnlineOnly = (folderPlaceHolderAvailability.isValid() && *folderPlaceHolderAvailability == VfsItemAvailability::OnlineOnly);
-
-        // a folder is considered online-only if: no files are hydrated, or, if it's an empty folder
-        const auto isOnlineOnlyFolder = isfolderPlaceHolderAvailabilityOnlineOnly || (!folderPlaceHolderAvailability && isFolderPinStateOnlineOnly);
-
-        if (!isFilePlaceHolder && !isOnlineOnlyFolder) {
-            if (localEntry.isDirectory && folderPlaceHolderAvailability.isValid() && !isOnlineOnlyFolder) {
-                // a VFS folder but is not online-only (has some files hydrated)
-                qCInfo(lcDisco) << "Virtual directory without db entry for" << path._local << "but it contains hydrated file(s), so let's keep it and reupload.";
-                return;
-            }
-            qCWarning(lcDisco) << "Virtual file without db entry for" << path._local
-                               << "but looks odd, keeping";
-            item->_instruction = CSYNC_INSTRUCTION_IGNORE;
-
-            return;
-        }
-
-        if (isOnlineOnlyFolder) {
-            // if we're wiping a folder, we will only get this function called once and will wipe a folder along with it's files and also display one error in GUI
-            qCInfo(lcDisco) << "Wiping virtual folder without db entry for" << path._local;
-            if (isfolderPlaceHolderAvailabilityOnlineOnly && folderPlaceHolderAvailability.isValid()) {
-                qCInfo(lcDisco) << "*folderPlaceHolderAvailability:" << *folderPlaceHolderAvailability;
-            }
-            if (isFolderPinStateOnlineOnly && folderPinState.isValid()) {
-                qCInfo(lcDisco) << "*folderPinState:" << *folderPinState;
-            }
-            emit _discoveryData->addErrorToGui(SyncFileItem::SoftError, tr("Conflict when uploading a folder. It's going to get cleared!"), path._local, ErrorCategory::GenericError);
-        } else {
-            qCInfo(lcDisco) << "Wiping virtual file without db entry for" << path._local;
-            emit _discoveryData->addErrorToGui(SyncFileItem::SoftError, tr("Conflict when uploading a file. It's going to get removed!"), path._local, ErrorCategory::GenericError);
-        }
-        item->_instruction = CSYNC_INSTRUCTION_REMOVE;
-        item->_direction = SyncFileItem::Down;
-        // this flag needs to be unset, otherwise a folder would get marked as new in the processSubJobs
-        _childModified = false;
-    };
-
     // Check if it is a move
     OCC::SyncJournalFileRecord base;
     if (!_discoveryData->_statedb->getFileRecordByInode(localEntry.inode, &base)) {
@@ -1417,25 +1303,173 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
             return false;
         }
 
-        // Verify the checksum where possible
-        if (!base._checksumHeader.isEmpty() && item->_type == ItemTypeFile && base._type == ItemTypeFile) {
-            if (computeLocalChecksum(base._checksumHeader, _discoveryData->_localDir + path._original, item)) {
-                qCInfo(lcDisco) << "checking checksum of potential rename " << path._original << item->_checksumHeader << base._checksumHeader;
-                if (item->_checksumHeader != base._checksumHeader) {
-                    qCInfo(lcDisco) << "Not a move, checksums differ";
-                    return false;
+        return true;
+    };
+    if (!moveCheck()) {
+        processFileAnalyzeLocalMove(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer, base, false);
+        return;
+    }
+
+    // Verify the checksum where possible. Hashing a big file takes a while, so this
+    // happens in the background and the move detection continues with the result.
+    const auto checksumType = parseChecksumHeaderType(base._checksumHeader);
+    if (!checksumType.isEmpty() && item->_type == ItemTypeFile && base._type == ItemTypeFile) {
+        _pendingAsyncJobs++;
+        _discoveryData->computeLocalChecksum(_discoveryData->_localDir + path._original, checksumType, localEntry.size, this,
+            [=](const QByteArray &checksum) {
+                auto isMove = true;
+                if (!checksum.isEmpty()) {
+                    item->_checksumHeader = makeChecksumHeader(checksumType, checksum);
+                    qCInfo(lcDisco) << "checking checksum of potential rename " << path._original << item->_checksumHeader << base._checksumHeader;
+                    if (item->_checksumHeader != base._checksumHeader) {
+                        qCInfo(lcDisco) << "Not a move, checksums differ";
+                        isMove = false;
+                    }
                 }
-            }
+                processFileAnalyzeLocalMove(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer, base, isMove);
+                _pendingAsyncJobs--;
+                QTimer::singleShot(0, _discoveryData, &DiscoveryPhase::scheduleMoreJobs);
+            });
+        return;
+    }
+
+    processFileAnalyzeLocalMove(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer, base, true);
+}
+
+void ProcessDirectoryJob::processFileAnalyzeLocalInfoFinalize(const SyncFileItemPtr &item, const PathTuple &path, const LocalInfo &localEntry,
+    const RemoteInfo &serverEntry, const SyncJournalFileRecord &dbEntry, QueryMode recurseQueryServer)
+{
+    bool recurse = item->isDirectory() || localEntry.isDirectory || serverEntry.isDirectory;
+    // Even if we have a local directory: If the remote is a file that's propagated as a
+    // conflict we don't need to recurse into it. (local c1.owncloud, c1/ ; remote: c1)
+    if (item->_instruction == CSYNC_INSTRUCTION_CONFLICT && !item->isDirectory())
+        recurse = false;
+    if (_queryLocal != NormalQuery && _queryServer != NormalQuery)
+        recurse = false;
+
+    if ((item->_direction == SyncFileItem::Down || item->_instruction == CSYNC_INSTRUCTION_CONFLICT || item->_instruction == CSYNC_INSTRUCTION_NEW || item->_instruction == CSYNC_INSTRUCTION_SYNC) &&
+            (item->_modtime <= 0 || item->_modtime >= 0xFFFFFFFF)) {
+        item->_instruction = CSYNC_INSTRUCTION_ERROR;
+        item->_errorString = tr("Cannot sync due to invalid modification time");
+        item->_status = SyncFileItem::Status::NormalError;
+    }
+
+    if (item->_type != CSyncEnums::ItemTypeVirtualFile) {
+        const auto foundEditorsKeepingFileBusy = queryEditorsKeepingFileBusy(item, path);
+        if (!foundEditorsKeepingFileBusy.isEmpty()) {
+            item->_instruction = CSYNC_INSTRUCTION_ERROR;
+            const auto editorsString = foundEditorsKeepingFileBusy.join(", ");
+            qCInfo(lcDisco) << "Failed, because it is open in the editor." << item->_file << "direction" << item->_direction << editorsString;
+            item->_errorString = tr("Could not upload file, because it is open in \"%1\".").arg(editorsString);
+            item->_status = SyncFileItem::Status::SoftError;
+            _discoveryData->_anotherSyncNeeded = true;
+            _discoveryData->_filesNeedingScheduledSync.insert(path._original, delayIntervalForSyncRetryForOpenedForSigningFilesSeconds);
         }
+    }
 
-        if (_discoveryData->isRenamed(originalPath)) {
-            qCInfo(lcDisco) << "Not a move, base path already renamed";
-            return false;
+    if (dbEntry.isValid() && item->isDirectory()) {
+        item->_e2eEncryptionStatus = EncryptionStatusEnums::fromDbEncryptionStatus(dbEntry._e2eEncryptionStatus);
+        if (item->isEncrypted()) {
+            item->_e2eEncryptionServerCapability = EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_discoveryData->_account->capabilities().clientSideEncryptionVersion());
         }
+    }
 
-        return true;
+    auto recurseQueryLocal = _queryLocal == ParentNotChanged ? ParentNotChanged : localEntry.isDirectory || item->_instruction == CSYNC_INSTRUCTION_RENAME ? NormalQuery : ParentDontExist;
+    processFileFinalize(item, path, recurse, recurseQueryLocal, recurseQueryServer);
+}
+
+void ProcessDirectoryJob::postProcessLocalNew(const SyncFileItemPtr &item, const LocalInfo &localEntry, const PathTuple &path)
+{
+    // TODO: We may want to execute the same logic for non-VFS mode, as, moving/renaming the same folder by 2 or more clients at the same time is not possible in Web UI.
+    // Keeping it like this (for VFS files and folders only) just to fix a user issue.
+
+    if (!(_discoveryData && _discoveryData->_syncOptions._vfs && _discoveryData->_syncOptions._vfs->mode() != Vfs::Off)) {
+        // for VFS files and folders only
+        return;
+    }
+
+    if (!localEntry.isVirtualFile && !localEntry.isDirectory) {
+        return;
+    }
+
+    if (localEntry.isDirectory && _discoveryData->_syncOptions._vfs->mode() != Vfs::WindowsCfApi) {
+        // for VFS folders on Windows only
+        return;
+    }
+
+    Q_ASSERT(item->_instruction == CSYNC_INSTRUCTION_NEW);
+    if (item->_instruction != CSYNC_INSTRUCTION_NEW) {
+        qCWarning(lcDisco) << "Trying to wipe a virtual item" << path._local << " with item->_instruction" << item->_instruction;
+        return;
+    }
+
+    // must be a dehydrated placeholder
+    const bool isFilePlaceHolder = !localEntry.isDirectory && _discoveryData->_syncOptions._vfs->isDehydratedPlaceholder(_discoveryData->_localDir + path._local);
+
+    // either correct availability, or a result with error if the folder is new or otherwise has no availability set yet
+    const auto folderPlaceHolderAvailability = localEntry.isDirectory ? _discoveryData->_syncOptions._vfs->availability(path._local, Vfs::AvailabilityRecursivity::RecursiveAvailability) : Vfs::AvailabilityResult(Vfs::AvailabilityError::NoSuchItem);
+
+    const auto folderPinState = localEntry.isDirectory ? _discoveryData->_syncOptions._vfs->pinState(path._local) : Optional<PinState>(PinState::Unspecified);
+
+    if (!isFilePlaceHolder && !folderPlaceHolderAvailability.isValid() && !folderPinState.isValid()) {
+        // not a file placeholder and not a synced folder placeholder (new local folder)
+        return;
+    }
+
+    const auto isFolderPinStateOnlineOnly = (folderPinState.isValid() && *folderPinState == PinState::OnlineOnly);
+
+    const auto isfolderPlaceHolderAvailabilityOnlineOnly = (folderPlaceHolderAvailability.isValid() && *folderPlaceHolderAvailability == VfsItemAvailability::OnlineOnly);
+
+    // a folder is considered online-only if: no files are hydrated, or, if it's an empty folder
+    const auto isOnlineOnlyFolder = isfolderPlaceHolderAvailabilityOnlineOnly || (!folderPlaceHolderAvailability && isFolderPinStateOnlineOnly);
+
+    if (!isFilePlaceHolder && !isOnlineOnlyFolder) {
+        if (localEntry.isDirectory && folderPlaceHolderAvailability.isValid() && !isOnlineOnlyFolder) {
+            // a VFS folder but is not online-only (has some files hydrated)
+            qCInfo(lcDisco) << "Virtual directory without db entry for" << path._local << "but it contains hydrated file(s), so let's keep it and reupload.";
+            return;
+        }
+        qCWarning(lcDisco) << "Virtual file without db entry for" << path._local
+                           << "but looks odd, keeping";
+        item->_instruction = CSYNC_INSTRUCTION_IGNORE;
+
+        return;
+    }
+
+    if (isOnlineOnlyFolder) {
+        // if we're wiping a folder, we will only get this function called once and will wipe a folder along with it's files and also display one error in GUI
+        qCInfo(lcDisco) << "Wiping virtual folder without db entry for" << path._local;
+        if (isfolderPlaceHolderAvailabilityOnlineOnly && folderPlaceHolderAvailability.isValid()) {
+            qCInfo(lcDisco) << "*folderPlaceHolderAvailability:" << *folderPlaceHolderAvailability;
+        }
+        if (isFolderPinStateOnlineOnly && folderPinState.isValid()) {
+            qCInfo(lcDisco) << "*folderPinState:" << *folderPinState;
+        }
+        emit _discoveryData->addErrorToGui(SyncFileItem::SoftError, tr("Conflict when uploading a folder. It's going to get cleared!"), path._local, ErrorCategory::GenericError);
+    } else {
+        qCInfo(lcDisco) << "Wiping virtual file without db entry for" << path._local;
+        emit _discoveryData->addErrorToGui(SyncFileItem::SoftError, tr("Conflict when uploading a file. It's going to get removed!"), path._local, ErrorCategory::GenericError);
+    }
+    item->_instruction = CSYNC_INSTRUCTION_REMOVE;
+    item->_direction = SyncFileItem::Down;
+    // this flag needs to be unset, otherwise a folder would get marked as new in the processSubJobs
+    _childModified = false;
+}
+
+void ProcessDirectoryJob::processFileAnalyzeLocalMove(const SyncFileItemPtr &item, PathTuple path, const LocalInfo &localEntry,
+    const RemoteInfo &serverEntry, const SyncJournalFileRecord &dbEntry, QueryMode recurseQueryServer,
+    const SyncJournalFileRecord &base, bool isMove)
+{
+    auto finalize = [&] {
+        processFileAnalyzeLocalInfoFinalize(item, path, localEntry, serverEntry, dbEntry, recurseQueryServer);
     };
-    const auto isMove = moveCheck();
+
+    const auto originalPath = base.path();
+    if (isMove && _discoveryData->isRenamed(originalPath)) {
+        qCInfo(lcDisco) << "Not a move, base path already renamed";
+        isMove = false;
+    }
+
     const auto isE2eeMove = isMove && (base.isE2eEncrypted() || isInsideEncryptedTree());
     const auto isCfApiVfsMode = _discoveryData->_syncOptions._vfs && _discoveryData->_syncOptions._vfs->mode() == Vfs::WindowsCfApi;
     const bool isOnlineOnlyItem = isCfApiVfsMode && (localEntry.isDirectory || _discoveryData->_syncOptions._vfs->isDehydratedPlaceholder(_discoveryData->_localDir + path._local));
@@ -1456,7 +1490,7 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
             item->_e2eEncryptionStatus = EncryptionStatusEnums::fromDbEncryptionStatus(base._e2eEncryptionStatus);
             item->_e2eEncryptionServerCapability = EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_discoveryData->_account->capabilities().clientSideEncryptionVersion());
         }
-        postProcessLocalNew();
+        postProcessLocalNew(item, localEntry, path);
         finalize();
         return;
     }
@@ -1478,7 +1512,7 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
 
         // If we can create the destination, do that.
         // Permission errors on the destination will be handled by checkPermissions later.
-        postProcessLocalNew();
+        postProcessLocalNew(item, localEntry, path);
         finalize();
 
         // If the destination upload will work, we're fine with the source deletion.
@@ -1558,7 +1592,7 @@ void ProcessDirectoryJob::processFileAnalyzeLocalInfo(
                 || (isAnyParentBeingRestored(originalPath) && !isRename(originalPath))) {
                 qCInfo(lcDisco) << "Can't rename because the etag has changed or the directory is gone or we are restoring one of the file's parents." << originalPath;
                 // Can't be a rename, leave it as a new.
-                postProcessLocalNew();
+                postProcessLocalNew(item, localEntry, path);
             } else {
                 // In case the deleted item was discovered in parallel
                 _discoveryData->findAndCancelDeletedJob(originalPath);
@@ -2101,7 +2135,7 @@ void ProcessDirectoryJob::chopVirtualFileSuffix(QString &str) const
 
 DiscoverySingleDirectoryJob *ProcessDirectoryJob::startAsyncServerQuery()
 {
-    if (_dirItem && _dirItem->isEncrypted() && _dirItem->_encryptedFileName.isEmpty()) {
+    if (_dirItem && _dirItem->isEncrypted() && _dirItem->encryptedFileName().isEmpty()) {
         _discoveryData->_topLevelE2eeFolderPaths.insert(_discoveryData->_remoteFolder + _dirItem->_file);
     }
     auto serverJob = new DiscoverySingleDirectoryJob(_discoveryData->_account,
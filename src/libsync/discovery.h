@@ -175,6 +175,20 @@ private:
     /// processFile helper for reconciling local changes
     void processFileAnalyzeLocalInfo(const SyncFileItemPtr &item, PathTuple, const LocalInfo &, const RemoteInfo &, const SyncJournalFileRecord &, QueryMode recurseQueryServer);
 
+    /// processFileAnalyzeLocalInfo helper for common final processing, may run after an asynchronous check
+    void processFileAnalyzeLocalInfoFinalize(const SyncFileItemPtr &item, const PathTuple &, const LocalInfo &, const RemoteInfo &, const SyncJournalFileRecord &, QueryMode recurseQueryServer);
+
+    /// processFileAnalyzeLocalInfo helper for new local items: wipes virtual items without db entry
+    void postProcessLocalNew(const SyncFileItemPtr &item, const LocalInfo &, const PathTuple &);
+
+    /** processFileAnalyzeLocalInfo helper for a new local item that may have been moved from \a base
+     *
+     * Called once the checksum of a move candidate was verified, \a isMove is false
+     * if the item can't be a move of \a base.
+     */
+    void processFileAnalyzeLocalMove(const SyncFileItemPtr &item, PathTuple, const LocalInfo &, const RemoteInfo &, const SyncJournalFileRecord &,
+        QueryMode recurseQueryServer, const SyncJournalFileRecord &base, bool isMove);
+
     /// processFile helper for local/remote conflicts
     void processFileConflict(const SyncFileItemPtr &item, PathTuple, const LocalInfo &, const RemoteInfo &, const SyncJournalFileRecord &);
 
@@ -31,11 +31,14 @@
 
 #include <QLoggingCategory>
 #include <QUrl>
+#include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
 #include <QTextCodec>
 #include <cstring>
 #include <QDateTime>
+#include <QFutureWatcher>
+#include <qtconcurrentrun.h>
 
 
 namespace OCC {
@@ -67,13 +70,19 @@ bool DiscoveryPhase::notifyExistingFolderOverLimit() const
     return activeFolderSizeLimit() && ConfigFile().notifyExistingFoldersOverLimit();
 }
 
-void DiscoveryPhase::checkFolderSizeLimit(const QString &path, const std::function<void(bool)> completionCallback)
+void DiscoveryPhase::checkFolderSizeLimit(const QString &path, qint64 sizeOfFolder, const std::function<void(bool)> completionCallback)
 {
     if (!activeFolderSizeLimit()) {
         // no limit, everything is allowed;
         return completionCallback(false);
     }
 
+    const auto limit = _syncOptions._newBigFolderSizeLimit;
+    if (sizeOfFolder >= 0) {
+        qCDebug(lcDiscovery) << "Folder size check complete for" << path << "result:" << sizeOfFolder << "limit:" << limit;
+        return completionCallback(sizeOfFolder >= limit);
+    }
+
     // do a PROPFIND to know the size of this folder
     const auto propfindJob = new PropfindJob(_account, _remoteFolder + path, this);
     propfindJob->setProperties(QList<QByteArray>() << "resourcetype"
@@ -84,7 +93,6 @@ void DiscoveryPhase::checkFolderSizeLimit(const QString &path, const std::functi
     });
     connect(propfindJob, &PropfindJob::result, this, [=](const QVariantMap &values) {
         const auto result = values.value(QLatin1String("size")).toLongLong();
-        const auto limit = _syncOptions._newBigFolderSizeLimit;
         qCDebug(lcDiscovery) << "Folder size check complete for" << path << "result:" << result << "limit:" << limit;
         return completionCallback(result >= limit);
     });
@@ -93,6 +101,7 @@ void DiscoveryPhase::checkFolderSizeLimit(const QString &path, const std::functi
 
 void DiscoveryPhase::checkSelectiveSyncNewFolder(const QString &path,
                                                  const RemotePermissions remotePerm,
+                                                 qint64 sizeOfFolder,
                                                  const std::function<void(bool)> callback)
 {
     if (_syncOptions._confirmExternalStorage && _syncOptions._vfs->mode() == Vfs::Off
@@ -117,7 +126,7 @@ void DiscoveryPhase::checkSelectiveSyncNewFolder(const QString &path,
         return callback(false);
     }
 
-    checkFolderSizeLimit(path, [this, path, callback](const bool bigFolder) {
+    checkFolderSizeLimit(path, sizeOfFolder, [this, path, callback](const bool bigFolder) {
         if (bigFolder) {
             // we tell the UI there is a new folder
             emit newBigFolder(path, false);
@@ -131,7 +140,7 @@ void DiscoveryPhase::checkSelectiveSyncNewFolder(const QString &path,
     });
 }
 
-void DiscoveryPhase::checkSelectiveSyncExistingFolder(const QString &path)
+void DiscoveryPhase::checkSelectiveSyncExistingFolder(const QString &path, qint64 sizeOfFolder)
 {
     // If no size limit is enforced, or if is in whitelist (explicitly allowed) or in blacklist (explicitly disallowed), do nothing.
     if (!notifyExistingFolderOverLimit() || SyncJournalDb::findPathInSelectiveSyncList(_selectiveSyncWhiteList, path)
@@ -139,7 +148,7 @@ void DiscoveryPhase::checkSelectiveSyncExistingFolder(const QString &path)
         return;
     }
 
-    checkFolderSizeLimit(path, [this, path](const bool bigFolder) {
+    checkFolderSizeLimit(path, sizeOfFolder, [this, path](const bool bigFolder) {
         if (bigFolder) {
             // Notify the user and prompt for response.
             emit existingFolderNowBig(path);
@@ -147,22 +156,56 @@ void DiscoveryPhase::checkSelectiveSyncExistingFolder(const QString &path)
     });
 }
 
-/* Given a path on the remote, give the path as it is when the rename is done */
-QString DiscoveryPhase::adjustRenamedPath(const QString &original, SyncFileItem::Direction d) const
+void DiscoveryPhase::computeLocalChecksum(const QString &filePath, const QByteArray &checksumType, qint64 size,
+                                          QObject *context, const std::function<void(const QByteArray &)> &callback)
 {
-    return OCC::adjustRenamedPath(d == SyncFileItem::Down ? _renamedItemsRemote : _renamedItemsLocal, original);
+    _queuedLocalChecksums.push_back({filePath, checksumType, size, context, callback});
+    startLocalChecksums();
 }
 
-QString adjustRenamedPath(const QMap<QString, QString> &renamedItems, const QString &original)
+void DiscoveryPhase::startLocalChecksums()
 {
-    int slashPos = original.size();
-    while ((slashPos = original.lastIndexOf('/', slashPos - 1)) > 0) {
-        auto it = renamedItems.constFind(original.left(slashPos));
-        if (it != renamedItems.constEnd()) {
-            return *it + original.mid(slashPos);
+    // Hashing is limited by the disk: a few threads are enough, and a cap on the bytes
+    // in progress keeps a tree of big files from occupying all of them at once.
+    // A single file bigger than the cap is still hashed, just on its own.
+    static constexpr int maxRunningLocalChecksums = 4;
+    static constexpr qint64 maxLocalChecksumBytesInProgress = 512LL * 1024 * 1024;
+
+    while (!_queuedLocalChecksums.empty()) {
+        const auto &next = _queuedLocalChecksums.front();
+        if (_runningLocalChecksums > 0
+            && (_runningLocalChecksums >= maxRunningLocalChecksums
+                || _localChecksumBytesInProgress + next.size > maxLocalChecksumBytesInProgress)) {
+            return;
         }
+
+        auto request = std::move(_queuedLocalChecksums.front());
+        _queuedLocalChecksums.pop_front();
+        ++_runningLocalChecksums;
+        _localChecksumBytesInProgress += request.size;
+
+        qCDebug(lcDiscovery) << "Computing" << request.checksumType << "checksum of" << request.filePath << "in a thread";
+        auto watcher = new QFutureWatcher<QByteArray>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, request] {
+            watcher->deleteLater();
+            --_runningLocalChecksums;
+            _localChecksumBytesInProgress -= request.size;
+            if (request.context) {
+                request.callback(watcher->result());
+            }
+            startLocalChecksums();
+        });
+        // Only copies go to the thread: the discovery may be gone when the hashing is done
+        watcher->setFuture(QtConcurrent::run([filePath = request.filePath, checksumType = request.checksumType] {
+            return ComputeChecksum::computeNowOnFile(filePath, checksumType);
+        }));
     }
-    return original;
+}
+
+/* Given a path on the remote, give the path as it is when the rename is done */
+QString DiscoveryPhase::adjustRenamedPath(const QString &original, SyncFileItem::Direction d) const
+{
+    return (d == SyncFileItem::Down ? _renamedItemsRemote : _renamedItemsLocal).adjustedPath(original);
 }
 
 QPair<bool, QByteArray> DiscoveryPhase::findAndCancelDeletedJob(const QString &originalPath)
@@ -228,6 +271,10 @@ void DiscoveryPhase::enqueueDirectoryToDelete(const QString &path, ProcessDirect
 void DiscoveryPhase::startJob(ProcessDirectoryJob *job)
 {
     ENFORCE(!_currentRootJob);
+    if (_remoteDeltaSince > 0 && !_remoteDeltaFetched) {
+        fetchRemoteDelta(job);
+        return;
+    }
     connect(this, &DiscoveryPhase::itemDiscovered, this, &DiscoveryPhase::slotItemDiscovered, Qt::UniqueConnection);
     connect(job, &ProcessDirectoryJob::finished, this, [this, job] {
         ENFORCE(_currentRootJob == sender());
@@ -249,6 +296,36 @@ void DiscoveryPhase::startJob(ProcessDirectoryJob *job)
     job->start();
 }
 
+void DiscoveryPhase::fetchRemoteDelta(ProcessDirectoryJob *rootJob)
+{
+    _remoteDeltaFetched = true;
+    auto deltaJob = new DiscoveryRemoteDeltaJob(_account, _remoteFolder, _remoteDeltaSince, this);
+    connect(deltaJob, &DiscoveryRemoteDeltaJob::finishedWithResult, this, [this, rootJob](const HttpResult<RemoteDelta> &result) {
+        if (result) {
+            _remoteDelta = *result;
+            qCInfo(lcDiscovery) << "Found remote changes in" << _remoteDelta.size() << "directories";
+        } else {
+            // Not fatal, all directories are listed as usual
+            qCWarning(lcDiscovery) << "Could not search for remote changes" << result.error().code << result.error().message;
+        }
+        startJob(rootJob);
+    });
+    deltaJob->start();
+}
+
+bool DiscoveryPhase::remoteListingFromDelta(const QString &serverPath, QVector<RemoteInfo> *entries, RemotePermissions *permissions) const
+{
+    // Entries renamed, moved or deleted on the server are not found by the
+    // search, so only a directory whose entries all changed can be trusted
+    const auto it = _remoteDelta.constFind(serverPath);
+    if (it == _remoteDelta.constEnd() || !it->isComplete()) {
+        return false;
+    }
+    *entries = it->changedEntries;
+    *permissions = it->permissions;
+    return true;
+}
+
 void DiscoveryPhase::setSelectiveSyncBlackList(const QStringList &list)
 {
     _selectiveSyncBlackList = list;
@@ -369,25 +446,8 @@ void DiscoverySingleLocalDirectoryJob::run() {
     emit finished(results);
 }
 
-DiscoverySingleDirectoryJob::DiscoverySingleDirectoryJob(const AccountPtr &account,
-                                                         const QString &path,
-                                                         const QString &remoteRootFolderPath,
-                                                         const QSet<QString> &topLevelE2eeFolderPaths,
-                                                         QObject *parent)
-    : QObject(parent)
-    , _subPath(remoteRootFolderPath + path)
-    , _remoteRootFolderPath(remoteRootFolderPath)
-    , _account(account)
-    , _topLevelE2eeFolderPaths(topLevelE2eeFolderPaths)
+static QList<QByteArray> discoveryProperties(const AccountPtr &account)
 {
-    Q_ASSERT(!_remoteRootFolderPath.isEmpty());
-}
-
-void DiscoverySingleDirectoryJob::start()
-{
-    // Start the actual HTTP job
-    auto *lsColJob = new LsColJob(_account, _subPath);
-
     QList<QByteArray> props;
     props << "resourcetype"
           << "getlastmodified"
@@ -402,13 +462,11 @@ void DiscoverySingleDirectoryJob::start()
           << "http://owncloud.org/ns:checksums"
           << "http://nextcloud.org/ns:is-encrypted";
 
-    if (_isRootPath)
-        props << "http://owncloud.org/ns:data-fingerprint";
-    if (_account->serverVersionInt() >= Account::makeServerVersion(10, 0, 0)) {
+    if (account->serverVersionInt() >= Account::makeServerVersion(10, 0, 0)) {
         // Server older than 10.0 have performances issue if we ask for the share-types on every PROPFIND
         props << "http://owncloud.org/ns:share-types";
     }
-    if (_account->capabilities().filesLockAvailable()) {
+    if (account->capabilities().filesLockAvailable()) {
         props << "http://nextcloud.org/ns:lock"
               << "http://nextcloud.org/ns:lock-owner-displayname"
               << "http://nextcloud.org/ns:lock-owner"
@@ -419,6 +477,31 @@ void DiscoverySingleDirectoryJob::start()
               << "http://nextcloud.org/ns:lock-token";
     }
     props << "http://nextcloud.org/ns:is-mount-root";
+    return props;
+}
+
+DiscoverySingleDirectoryJob::DiscoverySingleDirectoryJob(const AccountPtr &account,
+                                                         const QString &path,
+                                                         const QString &remoteRootFolderPath,
+                                                         const QSet<QString> &topLevelE2eeFolderPaths,
+                                                         QObject *parent)
+    : QObject(parent)
+    , _subPath(remoteRootFolderPath + path)
+    , _remoteRootFolderPath(remoteRootFolderPath)
+    , _account(account)
+    , _topLevelE2eeFolderPaths(topLevelE2eeFolderPaths)
+{
+    Q_ASSERT(!_remoteRootFolderPath.isEmpty());
+}
+
+void DiscoverySingleDirectoryJob::start()
+{
+    // Start the actual HTTP job
+    auto *lsColJob = new LsColJob(_account, _subPath);
+
+    auto props = discoveryProperties(_account);
+    if (_isRootPath)
+        props << "http://owncloud.org/ns:data-fingerprint";
 
     lsColJob->setProperties(props);
 
@@ -553,7 +636,11 @@ static void propertyMapToRemoteInfo(const QMap<QString, QString> &map, RemotePer
     }
 
     if (result.isDirectory && map.contains("size")) {
-        result.sizeOfFolder = map.value("size").toInt();
+        bool ok = false;
+        const auto sizeOfFolder = map.value("size").toLongLong(&ok);
+        if (ok && sizeOfFolder >= 0) {
+            result.sizeOfFolder = sizeOfFolder;
+        }
     }
 }
 
@@ -760,4 +847,123 @@ void DiscoverySingleDirectoryJob::metadataError(const QByteArray &fileId, int ht
     emit finished(_results);
     deleteLater();
 }
+
+DiscoveryRemoteDeltaJob::DiscoveryRemoteDeltaJob(const AccountPtr &account,
+                                                 const QString &remoteRootFolderPath,
+                                                 qint64 changedSince,
+                                                 QObject *parent)
+    : AbstractNetworkJob(account, remoteRootFolderPath, parent)
+    , _remoteRootFolderPath(remoteRootFolderPath)
+    , _hrefPrefix(Utility::noTrailingSlashPath(Utility::concatUrlPath(account->davUrl(), remoteRootFolderPath).path()))
+    , _changedSince(changedSince)
+{
+}
+
+void DiscoveryRemoteDeltaJob::start()
+{
+    auto props = discoveryProperties(account());
+    props << "http://nextcloud.org/ns:contained-file-count"
+          << "http://nextcloud.org/ns:contained-folder-count";
+
+    QByteArray propStr;
+    for (const auto &prop : qAsConst(props)) {
+        const auto colIdx = prop.lastIndexOf(':');
+        if (colIdx < 0) {
+            propStr += "     <d:" + prop + " />\n";
+        } else {
+            propStr += "     <" + prop.mid(colIdx + 1) + " xmlns=\"" + prop.left(colIdx) + "\" />\n";
+        }
+    }
+
+    const auto scope = Utility::noTrailingSlashPath(QStringLiteral("/files/") + account()->davUser() + _remoteRootFolderPath);
+    const auto since = QByteArray::number(_changedSince);
+    const QByteArray xml("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                         "<d:searchrequest xmlns:d=\"DAV:\" xmlns:nc=\"http://nextcloud.org/ns\">\n"
+                         " <d:basicsearch>\n"
+                         "  <d:select>\n"
+                         "   <d:prop>\n"
+        + propStr + "   </d:prop>\n"
+                    "  </d:select>\n"
+                    "  <d:from>\n"
+                    "   <d:scope>\n"
+                    "    <d:href>" + scope.toHtmlEscaped().toUtf8() + "</d:href>\n"
+                    "    <d:depth>infinity</d:depth>\n"
+                    "   </d:scope>\n"
+                    "  </d:from>\n"
+                    "  <d:where>\n"
+                    "   <d:or>\n"
+                    "    <d:gt><d:prop><d:getlastmodified /></d:prop><d:literal>" + since + "</d:literal></d:gt>\n"
+                    "    <d:gt><d:prop><nc:upload_time /></d:prop><d:literal>" + since + "</d:literal></d:gt>\n"
+                    "   </d:or>\n"
+                    "  </d:where>\n"
+                    "  <d:orderby />\n"
+                    " </d:basicsearch>\n"
+                    "</d:searchrequest>\n");
+
+    QNetworkRequest req;
+    req.setHeader(QNetworkRequest::ContentTypeHeader, QByteArrayLiteral("text/xml; charset=utf-8"));
+    auto *buf = new QBuffer(this);
+    buf->setData(xml);
+    buf->open(QIODevice::ReadOnly);
+    sendRequest("SEARCH", Utility::concatUrlPath(account()->url(), QStringLiteral("remote.php/dav/")), req, buf);
+    AbstractNetworkJob::start();
+}
+
+bool DiscoveryRemoteDeltaJob::finished()
+{
+    qCInfo(lcDiscovery) << "SEARCH for remote changes since" << _changedSince << "FINISHED WITH STATUS" << replyStatusString();
+
+    const auto httpCode = reply()->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (httpCode != 207) {
+        emit finishedWithResult(HttpError{ httpCode, errorString() });
+        return true;
+    }
+
+    LsColXMLParser parser;
+    connect(&parser, &LsColXMLParser::directoryListingIterated, this, &DiscoveryRemoteDeltaJob::entryReceived);
+    QHash<QString, ExtraFolderInfo> folderInfos;
+    if (!parser.parse(reply()->readAll(), &folderInfos, _hrefPrefix)) {
+        emit finishedWithResult(HttpError{ httpCode, tr("Server error: SEARCH reply is not XML formatted!") });
+        return true;
+    }
+
+    emit finishedWithResult(_delta);
+    return true;
+}
+
+void DiscoveryRemoteDeltaJob::entryReceived(const QString &href, const QMap<QString, QString> &properties)
+{
+    const auto path = Utility::noLeadingSlashPath(href.mid(_hrefPrefix.size()));
+    const auto algorithm = account()->serverHasMountRootProperty() ? RemotePermissions::MountedPermissionAlgorithm::UseMountRootProperty
+                                                                   : RemotePermissions::MountedPermissionAlgorithm::WildGuessMountedSubProperty;
+
+    RemoteInfo result;
+    result.name = path.mid(path.lastIndexOf(QLatin1Char('/')) + 1);
+    result.size = -1;
+    propertyMapToRemoteInfo(properties, algorithm, result);
+
+    if (result.isDirectory) {
+        result.size = 0;
+
+        auto &directory = _delta[path];
+        if (properties.contains(QStringLiteral("permissions"))) {
+            directory.permissions = RemotePermissions::fromServerString(properties.value(QStringLiteral("permissions")), algorithm, properties);
+        }
+        // The content of encrypted directories needs their metadata, they are always listed
+        auto fileCountOk = false;
+        auto folderCountOk = false;
+        const auto fileCount = properties.value(QStringLiteral("contained-file-count")).toLongLong(&fileCountOk);
+        const auto folderCount = properties.value(QStringLiteral("contained-folder-count")).toLongLong(&folderCountOk);
+        if (fileCountOk && folderCountOk && !result.isE2eEncrypted()) {
+            directory.entryCount = fileCount + folderCount;
+        }
+    }
+
+    if (path.isEmpty()) {
+        // the sync root itself
+        return;
+    }
+    const auto slash = path.lastIndexOf(QLatin1Char('/'));
+    _delta[slash < 0 ? QString() : path.left(slash)].changedEntries.push_back(std::move(result));
+}
 }
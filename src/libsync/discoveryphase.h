@@ -19,6 +19,7 @@
 #include <QStringList>
 #include <csync.h>
 #include <QMap>
+#include <QHash>
 #include <QSet>
 #include "networkjobs.h"
 #include <QMutex>
@@ -27,6 +28,7 @@
 #include <deque>
 #include "syncoptions.h"
 #include "syncfileitem.h"
+#include "renamedpathtree.h"
 
 class ExcludedFiles;
 
@@ -66,7 +68,7 @@ struct RemoteInfo
     OCC::RemotePermissions remotePerm;
     time_t modtime = 0;
     int64_t size = 0;
-    int64_t sizeOfFolder = 0;
+    int64_t sizeOfFolder = -1; // -1 if the server didn't send it
     bool isDirectory = false;
     bool _isE2eEncrypted = false;
     bool isFileDropDetected = false;
@@ -89,6 +91,24 @@ struct RemoteInfo
     QString lockToken;
 };
 
+/**
+ * The remote entries of one directory that changed since the last sync
+ */
+struct RemoteDeltaDirectory
+{
+    QVector<RemoteInfo> changedEntries;
+    /// The permissions of the directory itself
+    OCC::RemotePermissions permissions;
+    /// The number of entries in the directory, -1 if unknown
+    qint64 entryCount = -1;
+
+    /// Whether changedEntries are all the entries of the directory
+    [[nodiscard]] bool isComplete() const { return entryCount >= 0 && changedEntries.size() == entryCount; }
+};
+
+/// Maps directory paths relative to the remote sync root to their changed entries
+using RemoteDelta = QHash<QString, RemoteDeltaDirectory>;
+
 struct LocalInfo
 {
     /** FileName of the entry (this does not contains any directory or path, just the plain name */
@@ -210,6 +230,43 @@ public:
     QByteArray _dataFingerprint;
 };
 
+/**
+ * @brief Run a WebDAV SEARCH for all remote entries changed since a point in time
+ *
+ * Entries modified or uploaded after \a changedSince anywhere below the remote
+ * sync root are grouped by their directory. The server also reports how many
+ * entries each of the found directories contains: when all of them were found,
+ * typically in directories created since the last sync, the directory's
+ * content is known without listing it.
+ *
+ * Deleted entries and entries moved without being modified can't be found by
+ * the search. Directories containing such changes keep needing a PROPFIND.
+ *
+ * @ingroup libsync
+ */
+class DiscoveryRemoteDeltaJob : public AbstractNetworkJob
+{
+    Q_OBJECT
+public:
+    explicit DiscoveryRemoteDeltaJob(const AccountPtr &account,
+                                     const QString &remoteRootFolderPath,
+                                     qint64 changedSince,
+                                     QObject *parent = nullptr);
+    void start() override;
+
+signals:
+    void finishedWithResult(const OCC::HttpResult<OCC::RemoteDelta> &result);
+
+private:
+    bool finished() override;
+    void entryReceived(const QString &href, const QMap<QString, QString> &properties);
+
+    QString _remoteRootFolderPath;
+    QString _hrefPrefix;
+    qint64 _changedSince = 0;
+    RemoteDelta _delta;
+};
+
 class DiscoveryPhase : public QObject
 {
     Q_OBJECT
@@ -241,8 +298,8 @@ class DiscoveryPhase : public QObject
     QMap<QString, ProcessDirectoryJob *> _queuedDeletedDirectories;
 
     // map source (original path) -> destinations (current server or local path)
-    QMap<QString, QString> _renamedItemsRemote;
-    QMap<QString, QString> _renamedItemsLocal;
+    RenamedPathTree _renamedItemsRemote;
+    RenamedPathTree _renamedItemsLocal;
 
     // set of paths that should not be removed even though they are removed locally:
     // there was a move to an invalid destination and now the source should be restored
@@ -274,16 +331,41 @@ class DiscoveryPhase : public QObject
     [[nodiscard]] bool activeFolderSizeLimit() const;
     [[nodiscard]] bool notifyExistingFolderOverLimit() const;
 
+    // \a sizeOfFolder is the size from the listing of the parent, only asked for if it is -1
     void checkFolderSizeLimit(const QString &path,
+                              qint64 sizeOfFolder,
 			      const std::function<void(bool)> callback);
 
     // Check if the new folder should be deselected or not.
     // May be async. "Return" via the callback, true if the item is blacklisted
     void checkSelectiveSyncNewFolder(const QString &path,
                                      const RemotePermissions rp,
+                                     qint64 sizeOfFolder,
                                      const std::function<void(bool)> callback);
 
-    void checkSelectiveSyncExistingFolder(const QString &path);
+    void checkSelectiveSyncExistingFolder(const QString &path, qint64 sizeOfFolder);
+
+    /** Computes the checksum of a local file in a background thread.
+     *
+     * The callback is invoked with the checksum, or an empty one on failure,
+     * unless \a context was destroyed meanwhile. Requests are queued so that
+     * only a limited number of bytes is hashed at the same time.
+     */
+    void computeLocalChecksum(const QString &filePath, const QByteArray &checksumType, qint64 size,
+                              QObject *context, const std::function<void(const QByteArray &)> &callback);
+    void startLocalChecksums();
+
+    struct LocalChecksumRequest
+    {
+        QString filePath;
+        QByteArray checksumType;
+        qint64 size = 0;
+        QPointer<QObject> context;
+        std::function<void(const QByteArray &)> callback;
+    };
+    std::deque<LocalChecksumRequest> _queuedLocalChecksums;
+    int _runningLocalChecksums = 0;
+    qint64 _localChecksumBytesInProgress = 0;
 
     /** Given an original path, return the target path obtained when renaming is done.
      *
@@ -307,6 +389,18 @@ class DiscoveryPhase : public QObject
 
     void enqueueDirectoryToDelete(const QString &path, ProcessDirectoryJob* const directoryJob);
 
+    /** Runs the DiscoveryRemoteDeltaJob before starting \a rootJob */
+    void fetchRemoteDelta(ProcessDirectoryJob *rootJob);
+
+    /** Provides the complete remote listing of the directory if the remote delta has it.
+     *
+     * Returns false when the directory has to be listed on the server.
+     */
+    [[nodiscard]] bool remoteListingFromDelta(const QString &serverPath, QVector<RemoteInfo> *entries, RemotePermissions *permissions) const;
+
+    RemoteDelta _remoteDelta;
+    bool _remoteDeltaFetched = false;
+
 public:
     // input
     QString _localDir; // absolute path to the local directory. ends with '/'
@@ -320,6 +414,8 @@ public:
     QStringList _leadingAndTrailingSpacesFilesAllowed;
     bool _ignoreHiddenFiles = false;
     std::function<bool(const QString &)> _shouldDiscoverLocaly;
+    // When set, the remote changes since this time are searched for before the discovery starts
+    qint64 _remoteDeltaSince = 0;
 
     void startJob(ProcessDirectoryJob *);
 
@@ -362,7 +458,4 @@ signals:
 private slots:
     void slotItemDiscovered(const OCC::SyncFileItemPtr &item);
 };
-
-/// Implementation of DiscoveryPhase::adjustRenamedPath
-QString adjustRenamedPath(const QMap<QString, QString> &renamedItems, const QString &original);
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "downloadfilewriter.h"
+
+#include "common/checksumcalculator.h"
+
+#include <QLoggingCategory>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace OCC {
+
+Q_LOGGING_CATEGORY(lcDownloadFileWriter, "nextcloud.sync.propagator.download.writer", QtInfoMsg)
+
+DownloadFileWriter::DownloadFileWriter(const QString &fileName, qint64 expectedSize, Checksums checksums)
+    : _file(fileName)
+    , _expectedSize(expectedSize)
+    , _checksums(std::move(checksums))
+{
+}
+
+DownloadFileWriter::~DownloadFileWriter()
+{
+    closeFile();
+}
+
+bool DownloadFileWriter::addFileToChecksums(const QString &fileName, qint64 size, const Checksums &checksums)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcDownloadFileWriter) << "Could not open" << fileName << "to checksum it" << file.errorString();
+        return false;
+    }
+    QByteArray buffer(qMin(size, 1024 * 1024ll), Qt::Uninitialized);
+    for (auto remaining = size; remaining > 0;) {
+        const auto readBytes = file.read(buffer.data(), qMin(remaining, qint64(buffer.size())));
+        if (readBytes <= 0) {
+            qCWarning(lcDownloadFileWriter) << "Error while reading" << fileName << "to checksum it" << file.errorString();
+            return false;
+        }
+        for (const auto &checksum : checksums) {
+            checksum->addData(buffer.constData(), readBytes);
+        }
+        remaining -= readBytes;
+    }
+    return true;
+}
+
+void DownloadFileWriter::open()
+{
+    if (!_file.open(QIODevice::Append | QIODevice::Unbuffered)) {
+        fail(_file.errorString());
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    const auto size = _file.size();
+    const auto fd = _file.handle();
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Reserve the blocks for the rest of the file in one go. The file size
+    // stays as it is, resuming relies on it.
+    if (_expectedSize > size) {
+        _preallocated = fallocate(fd, FALLOC_FL_KEEP_SIZE, size, _expectedSize - size) == 0;
+    }
+#endif
+}
+
+void DownloadFileWriter::write(const QByteArray &data)
+{
+    if (_failed) {
+        return;
+    }
+    if (_file.write(data) != data.size()) {
+        fail(_file.errorString());
+        return;
+    }
+    for (const auto &checksum : _checksums) {
+        checksum->addData(data.constData(), data.size());
+    }
+    emit written(data.size());
+}
+
+void DownloadFileWriter::close()
+{
+    closeFile();
+    emit closed();
+}
+
+void DownloadFileWriter::closeFile()
+{
+    if (!_file.isOpen()) {
+        return;
+    }
+    // Give back the preallocated blocks of an incomplete download
+    if (_preallocated && _file.size() < _expectedSize) {
+        _file.resize(_file.size());
+    }
+    _file.close();
+}
+
+void DownloadFileWriter::fail(const QString &errorString)
+{
+    qCWarning(lcDownloadFileWriter) << "Error while writing to" << _file.fileName() << errorString;
+    _failed = true;
+    emit failed(errorString);
+}
+
+}
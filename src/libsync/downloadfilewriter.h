@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudlib.h"
+
+#include <QFile>
+#include <QObject>
+
+#include <memory>
+#include <vector>
+
+namespace OCC {
+
+class ChecksumCalculator;
+
+/**
+ * @brief Writes the body of a download to its file on another thread
+ *
+ * GETFileJob creates one writer per download and moves it to the
+ * propagator's writer thread, the data is handed over with queued calls.
+ * The writer appends to the file, preallocates the remaining size where
+ * the file system supports it without changing the file size, and feeds
+ * the checksum calculators of the job.
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT DownloadFileWriter : public QObject
+{
+    Q_OBJECT
+public:
+    using Checksums = std::vector<std::shared_ptr<ChecksumCalculator>>;
+
+    /**
+     * \a expectedSize is the size of the complete file or -1 if unknown. The
+     * data passed to write() is added to \a checksums, the part that is
+     * already in the file must have been added before.
+     */
+    DownloadFileWriter(const QString &fileName, qint64 expectedSize, Checksums checksums);
+    ~DownloadFileWriter() override;
+
+    /// Adds the first \a size bytes of the file to \a checksums, returns false on read errors
+    static bool addFileToChecksums(const QString &fileName, qint64 size, const Checksums &checksums);
+
+public slots:
+    void open();
+    void write(const QByteArray &data);
+    void close();
+
+signals:
+    /// \a bytes of the data passed to write() are on disk
+    void written(qint64 bytes);
+    /// Emitted once, all data passed to write() afterwards is dropped
+    void failed(const QString &errorString);
+    /// Emitted when close() has finished
+    void closed();
+
+private:
+    void closeFile();
+    void fail(const QString &errorString);
+
+    QFile _file;
+    qint64 _expectedSize;
+    Checksums _checksums;
+    bool _preallocated = false;
+    bool _failed = false;
+};
+
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "networkstatistics.h"
+
+#include <QMutexLocker>
+
+namespace OCC {
+
+namespace {
+
+QJsonObject timingToJson(const NetworkStatistics::Timing &timing)
+{
+    return QJsonObject{
+        {QStringLiteral("count"), timing.count},
+        {QStringLiteral("min"), timing.minMsecs},
+        {QStringLiteral("max"), timing.maxMsecs},
+        {QStringLiteral("average"), timing.averageMsecs()},
+    };
+}
+
+}
+
+void NetworkStatistics::Timing::add(qint64 msecs)
+{
+    if (count == 0 || msecs < minMsecs) {
+        minMsecs = msecs;
+    }
+    if (count == 0 || msecs > maxMsecs) {
+        maxMsecs = msecs;
+    }
+    ++count;
+    totalMsecs += msecs;
+}
+
+void NetworkStatistics::requestStarted()
+{
+    QMutexLocker locker(&_mutex);
+    ++_runningRequestCount;
+    _maximumRunningRequestCount = qMax(_maximumRunningRequestCount, _runningRequestCount);
+}
+
+void NetworkStatistics::requestFinished(const Request &request)
+{
+    QMutexLocker locker(&_mutex);
+    _runningRequestCount = qMax(0, _runningRequestCount - 1);
+
+    ++_requestCount;
+    ++_requestCountPerVerb[request.verb];
+    if (request.http2) {
+        ++_http2RequestCount;
+    }
+    if (request.newConnection) {
+        ++_newConnectionCount;
+    }
+    if (request.failed) {
+        ++_failedRequestCount;
+    }
+    _bytesSent += request.bytesSent;
+    _bytesReceived += request.bytesReceived;
+    if (request.queueWaitMsecs >= 0) {
+        _queueWait.add(request.queueWaitMsecs);
+    }
+    if (request.timeToFirstByteMsecs >= 0) {
+        _timeToFirstByte.add(request.timeToFirstByteMsecs);
+    }
+    _duration.add(request.durationMsecs);
+}
+
+void NetworkStatistics::reset()
+{
+    QMutexLocker locker(&_mutex);
+    // requests that are still running will be reported later, keep counting them
+    const auto running = _runningRequestCount;
+    _requestCount = 0;
+    _http2RequestCount = 0;
+    _newConnectionCount = 0;
+    _failedRequestCount = 0;
+    _bytesSent = 0;
+    _bytesReceived = 0;
+    _runningRequestCount = running;
+    _maximumRunningRequestCount = running;
+    _queueWait = {};
+    _timeToFirstByte = {};
+    _duration = {};
+    _requestCountPerVerb.clear();
+}
+
+qint64 NetworkStatistics::requestCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _requestCount;
+}
+
+qint64 NetworkStatistics::http2RequestCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _http2RequestCount;
+}
+
+qint64 NetworkStatistics::newConnectionCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _newConnectionCount;
+}
+
+qint64 NetworkStatistics::failedRequestCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _failedRequestCount;
+}
+
+qint64 NetworkStatistics::bytesSent() const
+{
+    QMutexLocker locker(&_mutex);
+    return _bytesSent;
+}
+
+qint64 NetworkStatistics::bytesReceived() const
+{
+    QMutexLocker locker(&_mutex);
+    return _bytesReceived;
+}
+
+int NetworkStatistics::runningRequestCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _runningRequestCount;
+}
+
+int NetworkStatistics::maximumRunningRequestCount() const
+{
+    QMutexLocker locker(&_mutex);
+    return _maximumRunningRequestCount;
+}
+
+NetworkStatistics::Timing NetworkStatistics::queueWait() const
+{
+    QMutexLocker locker(&_mutex);
+    return _queueWait;
+}
+
+NetworkStatistics::Timing NetworkStatistics::timeToFirstByte() const
+{
+    QMutexLocker locker(&_mutex);
+    return _timeToFirstByte;
+}
+
+QJsonObject NetworkStatistics::toJson() const
+{
+    QMutexLocker locker(&_mutex);
+
+    QJsonObject perVerb;
+    for (auto it = _requestCountPerVerb.constBegin(); it != _requestCountPerVerb.constEnd(); ++it) {
+        perVerb.insert(QString::fromLatin1(it.key()), it.value());
+    }
+
+    return QJsonObject{
+        {QStringLiteral("requests"), _requestCount},
+        {QStringLiteral("requestsPerVerb"), perVerb},
+        {QStringLiteral("http2Requests"), _http2RequestCount},
+        {QStringLiteral("newConnections"), _newConnectionCount},
+        {QStringLiteral("reusedConnections"), qMax<qint64>(0, _requestCount - _newConnectionCount)},
+        {QStringLiteral("failedRequests"), _failedRequestCount},
+        {QStringLiteral("bytesSent"), _bytesSent},
+        {QStringLiteral("bytesReceived"), _bytesReceived},
+        {QStringLiteral("runningRequests"), _runningRequestCount},
+        {QStringLiteral("maximumRunningRequests"), _maximumRunningRequestCount},
+        {QStringLiteral("queueWait"), timingToJson(_queueWait)},
+        {QStringLiteral("timeToFirstByte"), timingToJson(_timeToFirstByte)},
+        {QStringLiteral("duration"), timingToJson(_duration)},
+    };
+}
+
+QString NetworkStatistics::summary() const
+{
+    QMutexLocker locker(&_mutex);
+    return QStringLiteral("requests: %1 (HTTP/2: %2, failed: %3), new connections: %4, max. parallel: %5, "
+                          "queue wait avg/max: %6/%7 ms, TTFB avg/max: %8/%9 ms, sent: %10 bytes, received: %11 bytes")
+        .arg(_requestCount)
+        .arg(_http2RequestCount)
+        .arg(_failedRequestCount)
+        .arg(_newConnectionCount)
+        .arg(_maximumRunningRequestCount)
+        .arg(_queueWait.averageMsecs())
+        .arg(_queueWait.maxMsecs)
+        .arg(_timeToFirstByte.averageMsecs())
+        .arg(_timeToFirstByte.maxMsecs)
+        .arg(_bytesSent)
+        .arg(_bytesReceived);
+}
+
+}
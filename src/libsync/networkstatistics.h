@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudlib.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+
+namespace OCC {
+
+/**
+ * @brief Collects statistics about the HTTP requests of one account
+ *
+ * Every AbstractNetworkJob reports the requests it sends here. The numbers
+ * show how many connections the network access manager actually opens,
+ * whether HTTP/2 is used and how long requests wait before they are sent,
+ * which helps tuning the number of parallel transfers against real servers.
+ *
+ * The statistics can be retrieved through the socket API
+ * (V2/NETWORK_STATISTICS) and are logged at the end of every sync run.
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT NetworkStatistics
+{
+public:
+    /// Measurements of a single finished request
+    struct Request
+    {
+        QByteArray verb;
+        qint64 queueWaitMsecs = -1; // until the request was written to the socket, -1 if unknown
+        qint64 timeToFirstByteMsecs = -1; // until the response headers arrived, -1 if none arrived
+        qint64 durationMsecs = 0;
+        qint64 bytesSent = 0;
+        qint64 bytesReceived = 0;
+        bool http2 = false;
+        bool newConnection = false; // a connection was opened or a TLS handshake made for it
+        bool failed = false;
+    };
+
+    /// Minimum, maximum and average of a timing in milliseconds
+    struct Timing
+    {
+        qint64 count = 0;
+        qint64 totalMsecs = 0;
+        qint64 minMsecs = 0;
+        qint64 maxMsecs = 0;
+
+        void add(qint64 msecs);
+        [[nodiscard]] qint64 averageMsecs() const { return count ? totalMsecs / count : 0; }
+    };
+
+    /// Called when a request is sent, to track how many run in parallel
+    void requestStarted();
+    /// Called once for every request passed to requestStarted()
+    void requestFinished(const Request &request);
+
+    void reset();
+
+    [[nodiscard]] qint64 requestCount() const;
+    [[nodiscard]] qint64 http2RequestCount() const;
+    [[nodiscard]] qint64 newConnectionCount() const;
+    [[nodiscard]] qint64 failedRequestCount() const;
+    [[nodiscard]] qint64 bytesSent() const;
+    [[nodiscard]] qint64 bytesReceived() const;
+    [[nodiscard]] int runningRequestCount() const;
+    [[nodiscard]] int maximumRunningRequestCount() const;
+    [[nodiscard]] Timing queueWait() const;
+    [[nodiscard]] Timing timeToFirstByte() const;
+
+    [[nodiscard]] QJsonObject toJson() const;
+    /// One line summary for the log
+    [[nodiscard]] QString summary() const;
+
+private:
+    mutable QMutex _mutex;
+
+    qint64 _requestCount = 0;
+    qint64 _http2RequestCount = 0;
+    qint64 _newConnectionCount = 0;
+    qint64 _failedRequestCount = 0;
+    qint64 _bytesSent = 0;
+    qint64 _bytesReceived = 0;
+    int _runningRequestCount = 0;
+    int _maximumRunningRequestCount = 0;
+    Timing _queueWait;
+    Timing _timeToFirstByte;
+    Timing _duration;
+    QHash<QByteArray, qint64> _requestCountPerVerb;
+};
+
+}
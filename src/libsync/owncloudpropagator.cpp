@@ -22,6 +22,8 @@
 #include "propagateremotemove.h"
 #include "propagateremotemkdir.h"
 #include "bulkpropagatorjob.h"
+#include "bulkpropagatordownloadjob.h"
+#include "propagateuploadencryptedbatch.h"
 #include "updatee2eefoldermetadatajob.h"
 #include "updatemigratede2eemetadatajob.h"
 #include "propagatorjobs.h"
@@ -81,7 +83,15 @@ qint64 freeSpaceLimit()
     return value;
 }
 
-OwncloudPropagator::~OwncloudPropagator() = default;
+OwncloudPropagator::~OwncloudPropagator()
+{
+    // The jobs hand their pending writes to the thread, delete them first
+    _rootJob.reset();
+    if (_downloadWriterThread) {
+        _downloadWriterThread->quit();
+        _downloadWriterThread->wait();
+    }
+}
 
 
 int OwncloudPropagator::maximumActiveTransferJob()
@@ -333,9 +343,9 @@ void PropagateItemJob::reportClientStatuses()
         if (_item->_direction == SyncFileItem::Up) {
             const auto isCodeBadReqOrUnsupportedMediaType =
                 (_item->_httpErrorCode == HttpErrorCodeBadRequest || _item->_httpErrorCode == HttpErrorCodeUnsupportedMediaType);
-            const auto isExceptionInfoPresent = !_item->_errorExceptionName.isEmpty() && !_item->_errorExceptionMessage.isEmpty();
-            if (isCodeBadReqOrUnsupportedMediaType && isExceptionInfoPresent && _item->_errorExceptionName.contains(QStringLiteral("UnsupportedMediaType"))
-                && _item->_errorExceptionMessage.contains(QStringLiteral("virus"), Qt::CaseInsensitive)) {
+            const auto isExceptionInfoPresent = !_item->errorExceptionName().isEmpty() && !_item->errorExceptionMessage().isEmpty();
+            if (isCodeBadReqOrUnsupportedMediaType && isExceptionInfoPresent && _item->errorExceptionName().contains(QStringLiteral("UnsupportedMediaType"))
+                && _item->errorExceptionMessage().contains(QStringLiteral("virus"), Qt::CaseInsensitive)) {
                 propagator()->account()->reportClientStatus(ClientStatusReportingStatus::UploadError_Virus_Detected);
             } else {
                 propagator()->account()->reportClientStatus(ClientStatusReportingStatus::UploadError_ServerError);
@@ -426,6 +436,32 @@ void OwncloudPropagator::pushDelayedUploadTask(SyncFileItemPtr item)
     _delayedTasks.push_back(item);
 }
 
+void OwncloudPropagator::appendBulkDownloadTask(const SyncFileItemPtr &item, PropagateDirectory *directoryJob)
+{
+    const auto slashPosition = item->_file.lastIndexOf(QLatin1Char('/'));
+    const auto folder = slashPosition >= 0 ? item->_file.left(slashPosition) : QString();
+
+    auto &bulkJob = _openBulkDownloadJobs[folder];
+    if (!bulkJob || bulkJob->isFull()) {
+        bulkJob = new BulkPropagatorDownloadJob(this, folder);
+        directoryJob->appendJob(bulkJob);
+    }
+    bulkJob->appendItem(item);
+}
+
+void OwncloudPropagator::appendEncryptedUploadTask(const SyncFileItemPtr &item, PropagateDirectory *directoryJob)
+{
+    const auto slashPosition = item->_file.lastIndexOf(QLatin1Char('/'));
+    const auto folder = slashPosition >= 0 ? item->_file.left(slashPosition) : QString();
+
+    auto &batch = _openEncryptedUploadBatches[folder];
+    if (!batch || batch->isFull()) {
+        batch = new PropagateUploadEncryptedBatch(this, folder);
+        directoryJob->appendJob(batch);
+    }
+    batch->appendItem(item);
+}
+
 void OwncloudPropagator::resetDelayedUploadTasks()
 {
     _scheduleDelayedTasks = false;
@@ -610,6 +646,8 @@ void OwncloudPropagator::start(SyncFileItemVector &&items)
     foreach (PropagatorJob *it, directoriesToRemove) {
         _rootJob->appendDirDeletionJob(it);
     }
+    _openBulkDownloadJobs.clear();
+    _openEncryptedUploadBatches.clear();
 
     connect(_rootJob.data(), &PropagatorJob::finished, this, &OwncloudPropagator::emitFinished);
 
@@ -683,6 +721,10 @@ void OwncloudPropagator::startFilePropagation(const SyncFileItemPtr &item,
             directoriesToRemove.prepend(job);
         }
         removedDirectory = item->_file + "/";
+    } else if (isBulkDownloadItem(item)) {
+        appendBulkDownloadTask(item, directories.top().second);
+    } else if (isEncryptedUploadBatchItem(item)) {
+        appendEncryptedUploadTask(item, directories.top().second);
     } else {
         directories.top().second->appendTask(item);
     }
@@ -730,18 +772,18 @@ void OwncloudPropagator::processE2eeMetadataMigration(const SyncFileItemPtr &ite
             const auto rootE2eeFolderPathFullRemotePath = fullRemotePath(rootE2eeFolderPath);
             const auto updateMetadataJob = new UpdateMigratedE2eeMetadataJob(this, topLevelitem, rootE2eeFolderPathFullRemotePath, remotePath());
             if (item != topLevelitem) {
-                updateMetadataJob->addSubJobItem(item->_encryptedFileName, item);
+                updateMetadataJob->addSubJobItem(item->encryptedFileName(), item);
             }
             currentDirJob->appendJob(updateMetadataJob);
         } else {
             if (item != topLevelitem) {
                 // simply append subJob item so we can set its encryption status when corresponging subjob finishes
-                existingUpdateJob->addSubJobItem(item->_encryptedFileName, item);
+                existingUpdateJob->addSubJobItem(item->encryptedFileName(), item);
             }
         }
     } else {
         // migrating to v1.2
-        const auto remoteFilename = item->_encryptedFileName.isEmpty() ? item->_file : item->_encryptedFileName;
+        const auto remoteFilename = item->encryptedFileName().isEmpty() ? item->_file : item->encryptedFileName();
         const auto currentDirJob = directories.top().second;
         currentDirJob->appendJob(new UpdateE2eeFolderMetadataJob(this, item, remoteFilename));
     }
@@ -760,6 +802,16 @@ void OwncloudPropagator::setSyncOptions(const SyncOptions &syncOptions)
     _chunkSize = syncOptions._initialChunkSize;
 }
 
+QThread *OwncloudPropagator::downloadWriterThread()
+{
+    if (!_downloadWriterThread) {
+        _downloadWriterThread.reset(new QThread);
+        _downloadWriterThread->setObjectName(QStringLiteral("DownloadWriter"));
+        _downloadWriterThread->start();
+    }
+    return _downloadWriterThread.data();
+}
+
 bool OwncloudPropagator::localFileNameClash(const QString &relFile)
 {
     const QString file(_localDir + relFile);
@@ -1050,7 +1102,7 @@ OCC::Optional<QString> OwncloudPropagator::createCaseClashConflict(const SyncFil
 
 QString OwncloudPropagator::adjustRenamedPath(const QString &original) const
 {
-    return OCC::adjustRenamedPath(_renamedDirectories, original);
+    return _renamedDirectories.adjustedPath(original);
 }
 
 Result<Vfs::ConvertToPlaceholderResult, QString> OwncloudPropagator::updateMetadata(const SyncFileItem &item, Vfs::UpdateMetadataTypes updateType)
@@ -1080,31 +1132,51 @@ Result<Vfs::ConvertToPlaceholderResult, QString> OwncloudPropagator::staticUpdat
     return Vfs::ConvertToPlaceholderResult::Ok;
 }
 
-bool OwncloudPropagator::isDelayedUploadItem(const SyncFileItemPtr &item) const
+bool OwncloudPropagator::isInEncryptedFolder(const SyncFileItemPtr &item) const
 {
-    const auto checkFileShouldBeEncrypted = [this] (const SyncFileItemPtr &item) -> bool {
-        const auto path = item->_file;
-        const auto slashPosition = path.lastIndexOf('/');
-        const auto parentPath = slashPosition >= 0 ? path.left(slashPosition) : QString();
-
-        SyncJournalFileRecord parentRec;
-        bool ok = _journal->getFileRecord(parentPath, &parentRec);
-        if (!ok) {
-            return false;
-        }
+    const auto path = item->_file;
+    const auto slashPosition = path.lastIndexOf('/');
+    const auto parentPath = slashPosition >= 0 ? path.left(slashPosition) : QString();
 
-        const auto accountPtr = account();
+    SyncJournalFileRecord parentRec;
+    bool ok = _journal->getFileRecord(parentPath, &parentRec);
+    if (!ok) {
+        return false;
+    }
 
-        if (!parentRec.isValid() ||
-            !parentRec.isE2eEncrypted()) {
-            return false;
-        }
+    if (!parentRec.isValid() ||
+        !parentRec.isE2eEncrypted()) {
+        return false;
+    }
 
-        return true;
-    };
+    return true;
+}
 
+bool OwncloudPropagator::isDelayedUploadItem(const SyncFileItemPtr &item) const
+{
     return account()->capabilities().bulkUpload() && !_scheduleDelayedTasks && !item->isEncrypted() && _syncOptions.minChunkSize() > item->_size
-        && !isInBulkUploadBlackList(item->_file) && !checkFileShouldBeEncrypted(item);
+        && !isInBulkUploadBlackList(item->_file) && !isInEncryptedFolder(item);
+}
+
+bool OwncloudPropagator::isEncryptedUploadBatchItem(const SyncFileItemPtr &item) const
+{
+    // Copying many new files into an encrypted folder is what makes locking it per file expensive
+    return item->_direction == SyncFileItem::Up && item->_instruction == CSYNC_INSTRUCTION_NEW
+        && item->_type == ItemTypeFile && item->_renameTarget.isEmpty()
+        && account()->capabilities().clientSideEncryptionAvailable() && isInEncryptedFolder(item);
+}
+
+bool OwncloudPropagator::isBulkDownloadItem(const SyncFileItemPtr &item) const
+{
+    // Anything needing more than a plain download into a new file goes through PropagateDownloadFile
+    return _syncOptions._bulkDownload && !_bulkDownloadUnsupported
+        && item->_direction == SyncFileItem::Down && item->_instruction == CSYNC_INSTRUCTION_NEW
+        && item->_type == ItemTypeFile && _syncOptions._vfs->mode() == Vfs::Off
+        && !item->isEncrypted() && item->encryptedFileName().isEmpty()
+        && !item->_isRestoration && item->directDownloadUrl().isEmpty()
+        && item->_locked != SyncFileItem::LockStatus::LockedItem
+        && item->_size < _syncOptions.minChunkSize()
+        && !item->_file.endsWith(QLatin1String(".sys.admin#recall#"));
 }
 
 void OwncloudPropagator::setScheduleDelayedTasks(bool active)
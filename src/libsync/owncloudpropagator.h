@@ -24,11 +24,13 @@
 #include <QIODevice>
 #include <QMutex>
 #include <QNetworkReply>
+#include <QThread>
 
 #include "accountfwd.h"
 #include "bandwidthmanager.h"
 #include "csync.h"
 #include "progressdispatcher.h"
+#include "renamedpathtree.h"
 #include "syncfileitem.h"
 #include "syncoptions.h"
 
@@ -58,6 +60,8 @@ void blacklistUpdate(SyncJournalDb *journal, SyncFileItem &item);
 class SyncJournalDb;
 class OwncloudPropagator;
 class PropagatorCompositeJob;
+class BulkPropagatorDownloadJob;
+class PropagateUploadEncryptedBatch;
 class FolderMetadata;
 
 /**
@@ -472,6 +476,9 @@ public:
     int _uploadLimit = 0;
     BandwidthManager _bandwidthManager;
 
+    /** The thread writing the bodies of downloads to disk, started on first use */
+    QThread *downloadWriterThread();
+
     bool _abortRequested = false;
 
     /** The list of currently active jobs.
@@ -480,11 +487,14 @@ public:
         Jobs add themself to the list when they do an asynchronous operation.
         Jobs can be several time on the list (example, when several chunks are uploaded in parallel)
      */
-    QList<PropagateItemJob *> _activeJobList;
+    QList<PropagatorJob *> _activeJobList;
 
     /** We detected that another sync is required after this one */
     bool _anotherSyncNeeded = false;
 
+    /** The server rejected an archive download, don't use bulk downloads for the rest of this sync */
+    bool _bulkDownloadUnsupported = false;
+
     /** Per-folder quota guesses.
      *
      * This starts out empty. When an upload in a folder fails due to insufficient
@@ -604,7 +614,7 @@ public:
     OCC::Optional<QString> createCaseClashConflict(const SyncFileItemPtr &item, const QString &temporaryDownloadedFile);
 
     // Map original path (as in the DB) to target final path
-    QMap<QString, QString> _renamedDirectories;
+    RenamedPathTree _renamedDirectories;
     [[nodiscard]] QString adjustRenamedPath(const QString &original) const;
 
     /** Update the database for an item.
@@ -631,6 +641,12 @@ public:
 
     Q_REQUIRED_RESULT bool isDelayedUploadItem(const SyncFileItemPtr &item) const;
 
+    /** Whether the item can be fetched as part of a BulkPropagatorDownloadJob */
+    Q_REQUIRED_RESULT bool isBulkDownloadItem(const SyncFileItemPtr &item) const;
+
+    /** Whether the item can be uploaded as part of a PropagateUploadEncryptedBatch */
+    Q_REQUIRED_RESULT bool isEncryptedUploadBatchItem(const SyncFileItemPtr &item) const;
+
     Q_REQUIRED_RESULT const std::deque<SyncFileItemPtr>& delayedTasks() const
     {
         return _delayedTasks;
@@ -692,12 +708,19 @@ private:
 
     void pushDelayedUploadTask(SyncFileItemPtr item);
 
+    void appendBulkDownloadTask(const SyncFileItemPtr &item, PropagateDirectory *directoryJob);
+
+    void appendEncryptedUploadTask(const SyncFileItemPtr &item, PropagateDirectory *directoryJob);
+
+    Q_REQUIRED_RESULT bool isInEncryptedFolder(const SyncFileItemPtr &item) const;
+
     void resetDelayedUploadTasks();
 
     static void adjustDeletedFoldersWithNewChildren(SyncFileItemVector &items);
 
     AccountPtr _account;
     QScopedPointer<PropagateRootDirectory> _rootJob;
+    QScopedPointer<QThread> _downloadWriterThread;
     SyncOptions _syncOptions;
     bool _jobScheduled = false;
 
@@ -707,6 +730,11 @@ private:
     std::deque<SyncFileItemPtr> _delayedTasks;
     bool _scheduleDelayedTasks = false;
 
+    // Bulk download job still accepting items, by folder; only used while building the job tree
+    QHash<QString, BulkPropagatorDownloadJob *> _openBulkDownloadJobs;
+    // Same for the encrypted upload batches
+    QHash<QString, PropagateUploadEncryptedBatch *> _openEncryptedUploadBatches;
+
     QSet<QString> &_bulkUploadBlackList;
 
     static bool _allowDelayedUpload;
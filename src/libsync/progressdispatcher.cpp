@@ -22,7 +22,7 @@ namespace OCC {
 
 ProgressDispatcher *ProgressDispatcher::_instance = nullptr;
 
-QString Progress::asResultString(const SyncFileItem &item)
+QString Progress::asResultString(const ProgressInfo::ItemRecord &item)
 {
     switch (item._instruction) {
     case CSYNC_INSTRUCTION_SYNC:
@@ -65,7 +65,7 @@ QString Progress::asResultString(const SyncFileItem &item)
     return QCoreApplication::translate("progress", "Unknown");
 }
 
-QString Progress::asActionString(const SyncFileItem &item)
+QString Progress::asActionString(const ProgressInfo::ItemRecord &item)
 {
     switch (item._instruction) {
     case CSYNC_INSTRUCTION_CONFLICT:
@@ -164,7 +164,8 @@ void ProgressInfo::reset()
     _maxFilesPerSecond = 10.0;
 
     _updateEstimatesTimer.stop();
-    _lastCompletedItem = SyncFileItem();
+    _lastCompletedItem = ItemRecord();
+    _completedItems.clear();
 }
 
 ProgressInfo::Status ProgressInfo::status() const
@@ -246,7 +247,8 @@ void ProgressInfo::setProgressComplete(const SyncFileItem &item)
         _totalSizeOfCompletedJobs += item._size;
     }
     recomputeCompletedSize();
-    _lastCompletedItem = item;
+    _lastCompletedItem = ItemRecord(item);
+    _completedItems.append(_lastCompletedItem);
 }
 
 void ProgressInfo::setProgressItem(const SyncFileItem &item, qint64 completed)
@@ -255,13 +257,19 @@ void ProgressInfo::setProgressItem(const SyncFileItem &item, qint64 completed)
         return;
     }
 
-    _currentItems[item._file]._item = item;
-    _currentItems[item._file]._progress._total = item._size;
-    _currentItems[item._file]._progress.setCompleted(completed);
+    // Only copy the item when its transfer starts, this is called for every chunk of data
+    auto &progressItem = _currentItems[item._file];
+    if (progressItem._item.isEmpty()) {
+        progressItem._item = ItemRecord(item);
+    } else {
+        progressItem._item._size = item._size;
+    }
+    progressItem._progress._total = item._size;
+    progressItem._progress.setCompleted(completed);
     recomputeCompletedSize();
 
     // This seems dubious!
-    _lastCompletedItem = SyncFileItem();
+    _lastCompletedItem = ItemRecord();
 }
 
 ProgressInfo::Estimates ProgressInfo::totalProgress() const
@@ -339,7 +347,7 @@ bool ProgressInfo::trustEta() const
     return totalProgress().estimatedEta < 100 * optimisticEta();
 }
 
-ProgressInfo::Estimates ProgressInfo::fileProgress(const SyncFileItem &item) const
+ProgressInfo::Estimates ProgressInfo::fileProgress(const ItemRecord &item) const
 {
     return _currentItems[item._file]._progress.estimates();
 }
@@ -102,8 +102,47 @@ public:
     /** Number of a file that is currently in progress. */
     [[nodiscard]] qint64 currentFile() const;
 
+    /**
+     * The parts of a SyncFileItem that the progress consumers look at.
+     *
+     * ProgressInfo is copied into every progress update, so it keeps these
+     * records instead of full SyncFileItem copies.
+     */
+    struct OWNCLOUDSYNC_EXPORT ItemRecord
+    {
+        ItemRecord() = default;
+        explicit ItemRecord(const SyncFileItem &item)
+            : _file(item._file)
+            , _renameTarget(item._renameTarget)
+            , _errorString(item._errorString)
+            , _size(item._size)
+            , _instruction(item._instruction)
+            , _type(item._type)
+            , _direction(item._direction)
+            , _status(item._status)
+        {
+        }
+
+        [[nodiscard]] bool isEmpty() const { return _file.isEmpty(); }
+        [[nodiscard]] bool isDirectory() const { return _type == ItemTypeDirectory; }
+
+        QString _file;
+        QString _renameTarget;
+        QString _errorString;
+        qint64 _size = 0;
+        SyncInstructions _instruction = CSYNC_INSTRUCTION_NONE;
+        ItemType _type = ItemTypeSkip;
+        SyncFileItem::Direction _direction = SyncFileItem::None;
+        SyncFileItem::Status _status = SyncFileItem::NoStatus;
+    };
+
     /** Return true if the size needs to be taken in account in the total amount of time */
     static inline bool isSizeDependent(const SyncFileItem &item)
+    {
+        return isSizeDependent(ItemRecord(item));
+    }
+
+    static inline bool isSizeDependent(const ItemRecord &item)
     {
         return !item.isDirectory()
             && (item._instruction == CSYNC_INSTRUCTION_CONFLICT
@@ -169,12 +208,14 @@ public:
 
     struct OWNCLOUDSYNC_EXPORT ProgressItem
     {
-        SyncFileItem _item;
+        ItemRecord _item;
         Progress _progress;
     };
     QHash<QString, ProgressItem> _currentItems;
 
-    SyncFileItem _lastCompletedItem;
+    ItemRecord _lastCompletedItem;
+    /// The items completed since the previous update, the SyncEngine clears them after every update
+    QVector<ItemRecord> _completedItems;
 
     // Used during local and remote update phase
     QString _currentDiscoveredRemoteFolder;
@@ -208,7 +249,7 @@ public:
     /**
      * Get the current file completion estimate structure
      */
-    [[nodiscard]] Estimates fileProgress(const SyncFileItem &item) const;
+    [[nodiscard]] Estimates fileProgress(const ItemRecord &item) const;
 
 private slots:
     /**
@@ -238,8 +279,8 @@ private:
 
 namespace Progress {
 
-    OWNCLOUDSYNC_EXPORT QString asActionString(const SyncFileItem &item);
-    OWNCLOUDSYNC_EXPORT QString asResultString(const SyncFileItem &item);
+    OWNCLOUDSYNC_EXPORT QString asActionString(const ProgressInfo::ItemRecord &item);
+    OWNCLOUDSYNC_EXPORT QString asResultString(const ProgressInfo::ItemRecord &item);
 
     OWNCLOUDSYNC_EXPORT bool isWarningKind(SyncFileItem::Status);
     OWNCLOUDSYNC_EXPORT bool isIgnoredKind(SyncFileItem::Status);
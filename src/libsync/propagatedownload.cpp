@@ -32,14 +32,33 @@
 #include <QNetworkAccessManager>
 #include <QFileInfo>
 #include <QDir>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QThread>
+#include <qtconcurrentrun.h>
 
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 
 namespace OCC {
 
 Q_LOGGING_CATEGORY(lcGetJob, "nextcloud.sync.networkjob.get", QtInfoMsg)
 Q_LOGGING_CATEGORY(lcPropagateDownload, "nextcloud.sync.propagator.download", QtInfoMsg)
 
+namespace {
+    constexpr qint64 limitedReadBufferSize = 16 * 1024;
+    constexpr qint64 writerReadBufferSize = 1024 * 1024;
+    // Data handed to the writer thread that is not on disk yet
+    constexpr qint64 maxPendingWriteBytes = 8 * 1024 * 1024;
+
+    // Smaller files are downloaded completely
+    constexpr qint64 minDeltaDownloadSize = 4 * 1024 * 1024;
+    constexpr int maxDeltaDownloadSegments = 1000;
+    constexpr char contentChunksMimeTypeC[] = "application/x-nextcloud-content-chunks";
+    constexpr char contentChunksAverageSizeHeaderC[] = "OC-Content-Chunks-Average-Size";
+}
+
 // Always coming in with forward slashes.
 // In csync_excluded_no_ctx we ignore all files with longer than 254 chars
 // This function also adds a dot at the beginning of the filename to hide the file on OS X and Linux
@@ -108,10 +127,24 @@ GETFileJob::GETFileJob(AccountPtr account, const QUrl &url, QIODevice *device,
 }
 
 
+GETFileJob::~GETFileJob()
+{
+    if (_bandwidthManager) {
+        _bandwidthManager->unregisterDownloadJob(this);
+    }
+    if (_writer) {
+        // Writes that are already queued are done before the deletion
+        _writer->deleteLater();
+    }
+}
+
 void GETFileJob::start()
 {
-    if (_resumeStart > 0) {
+    if (_resumeStart > 0 || _rangeSize >= 0) {
         _headers["Range"] = "bytes=" + QByteArray::number(_resumeStart) + '-';
+        if (_rangeSize >= 0) {
+            _headers["Range"] += QByteArray::number(_resumeStart + _rangeSize - 1);
+        }
         _headers["Accept-Ranges"] = "bytes";
         qCDebug(lcGetJob) << "Retry with range " << _headers["Range"];
     }
@@ -142,7 +175,7 @@ void GETFileJob::start()
 
 void GETFileJob::newReplyHook(QNetworkReply *reply)
 {
-    reply->setReadBufferSize(16 * 1024); // keep low so we can easier limit the bandwidth
+    reply->setReadBufferSize(readBufferSize());
 
     connect(reply, &QNetworkReply::metaDataChanged, this, &GETFileJob::slotMetaDataChanged);
     connect(reply, &QIODevice::readyRead, this, &GETFileJob::slotReadyRead);
@@ -154,7 +187,7 @@ void GETFileJob::slotMetaDataChanged()
 {
     // For some reason setting the read buffer in GETFileJob::start doesn't seem to go
     // through the HTTP layer thread(?)
-    reply()->setReadBufferSize(16 * 1024);
+    reply()->setReadBufferSize(readBufferSize());
 
     int httpStatus = reply()->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -222,6 +255,13 @@ void GETFileJob::slotMetaDataChanged()
             start = rxMatch.captured(1).toLongLong();
         }
     }
+    if (_rangeSize >= 0 && ranges.isEmpty()) {
+        qCWarning(lcGetJob) << "No content-range in the reply to" << _headers["Range"];
+        _errorString = tr("Server returned wrong content-range");
+        _errorStatus = SyncFileItem::NormalError;
+        reply()->abort();
+        return;
+    }
     if (start != _resumeStart) {
         qCWarning(lcGetJob) << "Wrong content-range: " << ranges << " while expecting start was" << _resumeStart;
         if (ranges.isEmpty()) {
@@ -247,9 +287,82 @@ void GETFileJob::slotMetaDataChanged()
         _lastModified = Utility::qDateTimeToTime_t(lastModified.toDateTime());
     }
 
+    startChecksumCalculators();
+    startWriter();
+
     _saveBodyToFile = true;
 }
 
+void GETFileJob::setComputeChecksums(const QByteArray &contentChecksumType)
+{
+    _computeChecksums = true;
+    _contentChecksumType = contentChecksumType;
+}
+
+QByteArray GETFileJob::checksumHeader() const
+{
+    if (!reply()) {
+        return {};
+    }
+    auto header = findBestChecksum(reply()->rawHeader(checkSumHeaderC));
+    const auto contentMd5Header = reply()->rawHeader(contentMd5HeaderC);
+    if (header.isEmpty() && !contentMd5Header.isEmpty()) {
+        header = "MD5:" + contentMd5Header;
+    }
+    return header;
+}
+
+QByteArray GETFileJob::computedChecksum(const QByteArray &checksumType) const
+{
+    const auto it = _checksumCalculators.find(checksumType);
+    if (checksumType.isEmpty() || it == _checksumCalculators.end()) {
+        return {};
+    }
+    return it->second->result();
+}
+
+void GETFileJob::startChecksumCalculators()
+{
+    _checksumCalculators.clear();
+    if (!_computeChecksums) {
+        return;
+    }
+
+    for (const auto &checksumType : {parseChecksumHeaderType(checksumHeader()), _contentChecksumType}) {
+        if (checksumType.isEmpty() || _checksumCalculators.count(checksumType) > 0) {
+            continue;
+        }
+        auto calculator = std::make_shared<ChecksumCalculator>(checksumType);
+        if (calculator->isInitialized()) {
+            _checksumCalculators.emplace(checksumType, std::move(calculator));
+        }
+    }
+    if (_checksumCalculators.empty() || _resumeStart == 0) {
+        return;
+    }
+
+    // The part downloaded by an earlier attempt is read on a worker thread,
+    // slotReadyRead() doesn't touch the body until it is in the checksums
+    const auto file = qobject_cast<QFile *>(_device);
+    if (!file) {
+        qCWarning(lcGetJob) << "Could not read the already downloaded part, the checksums will be computed afterwards";
+        _checksumCalculators.clear();
+        return;
+    }
+    _checksummingResumedPart = true;
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        _checksummingResumedPart = false;
+        if (!watcher->result()) {
+            qCWarning(lcGetJob) << "Could not read the already downloaded part, the checksums will be computed afterwards";
+            _checksumCalculators.clear();
+        }
+        slotReadyRead();
+    });
+    watcher->setFuture(QtConcurrent::run(&DownloadFileWriter::addFileToChecksums, file->fileName(), _resumeStart, checksums()));
+}
+
 void GETFileJob::setBandwidthManager(BandwidthManager *bwm)
 {
     _bandwidthManager = bwm;
@@ -264,6 +377,9 @@ void GETFileJob::setChoked(bool c)
 void GETFileJob::setBandwidthLimited(bool b)
 {
     _bandwidthLimited = b;
+    if (reply() && _saveBodyToFile) {
+        reply()->setReadBufferSize(readBufferSize());
+    }
     QMetaObject::invokeMethod(this, "slotReadyRead", Qt::QueuedConnection);
 }
 
@@ -276,32 +392,130 @@ void GETFileJob::giveBandwidthQuota(qint64 q)
 
 qint64 GETFileJob::currentDownloadPosition()
 {
+    if (_writer) {
+        return _resumeStart + _handedToWriter;
+    }
     if (_device && _device->pos() > 0 && _device->pos() > qint64(_resumeStart)) {
         return _device->pos();
     }
     return _resumeStart;
 }
 
+qint64 GETFileJob::readBufferSize() const
+{
+    // Keep low so we can easier limit the bandwidth
+    return _writerThread && !_bandwidthLimited ? writerReadBufferSize : limitedReadBufferSize;
+}
+
+void GETFileJob::setWriterThread(QThread *thread)
+{
+    _writerThread = thread;
+}
+
+void GETFileJob::setRangeSize(qint64 size)
+{
+    _rangeSize = size;
+    _expectedContentLength = size;
+}
+
+DownloadFileWriter::Checksums GETFileJob::checksums() const
+{
+    DownloadFileWriter::Checksums checksums;
+    for (const auto &[checksumType, calculator] : _checksumCalculators) {
+        checksums.push_back(calculator);
+    }
+    return checksums;
+}
+
+void GETFileJob::startWriter()
+{
+    if (_writer) {
+        _writer->deleteLater();
+    }
+    _writerClosing = false;
+    _handedToWriter = 0;
+    _pendingWriteBytes = 0;
+
+    const auto file = qobject_cast<QFile *>(_device);
+    if (!_writerThread || !file) {
+        return;
+    }
+    const auto expectedSize = _contentLength >= 0 ? _resumeStart + _contentLength : -1;
+    _writer = new DownloadFileWriter(file->fileName(), expectedSize, checksums());
+    _writer->moveToThread(_writerThread);
+    connect(_writer.data(), &DownloadFileWriter::written, this, &GETFileJob::slotDataWritten);
+    connect(_writer.data(), &DownloadFileWriter::failed, this, &GETFileJob::slotWriteFailed);
+    connect(_writer.data(), &DownloadFileWriter::closed, this, &GETFileJob::slotWriterClosed);
+    QMetaObject::invokeMethod(_writer.data(), &DownloadFileWriter::open);
+}
+
+void GETFileJob::slotDataWritten(qint64 bytes)
+{
+    const auto wasThrottled = _pendingWriteBytes >= maxPendingWriteBytes;
+    _pendingWriteBytes -= bytes;
+    if (wasThrottled && _pendingWriteBytes < maxPendingWriteBytes) {
+        slotReadyRead();
+    }
+}
+
+void GETFileJob::slotWriteFailed(const QString &errorString)
+{
+    _errorString = errorString;
+    _errorStatus = SyncFileItem::NormalError;
+    _saveBodyToFile = false;
+    if (reply() && reply()->isRunning()) {
+        reply()->abort();
+    }
+}
+
+void GETFileJob::slotWriterClosed()
+{
+    _writer->deleteLater();
+    _writer.clear();
+    slotReadyRead();
+}
+
 qint64 GETFileJob::writeToDevice(const QByteArray &data)
 {
-    return _device->write(data);
+    if (_writer) {
+        _handedToWriter += data.size();
+        _pendingWriteBytes += data.size();
+        QMetaObject::invokeMethod(_writer.data(), [writer = _writer.data(), data] {
+            writer->write(data);
+        });
+        return data.size();
+    }
+
+    const auto writtenBytes = _device->write(data);
+    if (writtenBytes > 0) {
+        for (const auto &[checksumType, calculator] : _checksumCalculators) {
+            calculator->addData(data.constData(), writtenBytes);
+        }
+    }
+    return writtenBytes;
 }
 
 void GETFileJob::slotReadyRead()
 {
     if (!reply())
         return;
-    int bufferSize = qMin(1024 * 8ll, reply()->bytesAvailable());
-    QByteArray buffer(bufferSize, Qt::Uninitialized);
+    if (_checksummingResumedPart) {
+        return;
+    }
 
     while (reply()->bytesAvailable() > 0 && _saveBodyToFile) {
         if (_bandwidthChoked) {
             qCWarning(lcGetJob) << "Download choked";
             break;
         }
-        qint64 toRead = bufferSize;
+        // Stop reading until the writer caught up, the full read buffer
+        // of the reply then throttles the connection
+        if (_pendingWriteBytes >= maxPendingWriteBytes) {
+            break;
+        }
+        qint64 toRead = qMin(reply()->bytesAvailable(), readBufferSize());
         if (_bandwidthLimited) {
-            toRead = qMin(qint64(bufferSize), _bandwidthQuota);
+            toRead = qMin(toRead, _bandwidthQuota);
             if (toRead == 0) {
                 qCDebug(lcGetJob) << "Out of quota";
                 break;
@@ -309,6 +523,8 @@ void GETFileJob::slotReadyRead()
             _bandwidthQuota -= toRead;
         }
 
+        // A new buffer for every read, a writer thread may still hold the previous one
+        QByteArray buffer(toRead, Qt::Uninitialized);
         const qint64 readBytes = reply()->read(buffer.data(), toRead);
         if (readBytes < 0) {
             _errorString = networkReplyErrorString(*reply());
@@ -317,8 +533,9 @@ void GETFileJob::slotReadyRead()
             reply()->abort();
             return;
         }
+        buffer.resize(readBytes);
 
-        const qint64 writtenBytes = writeToDevice(buffer.left(readBytes));
+        const qint64 writtenBytes = writeToDevice(buffer);
         if (writtenBytes != readBytes) {
             _errorString = _device->errorString();
             _errorStatus = SyncFileItem::NormalError;
@@ -329,6 +546,14 @@ void GETFileJob::slotReadyRead()
     }
 
     if (reply()->isFinished() && (reply()->bytesAvailable() == 0 || !_saveBodyToFile)) {
+        if (_writer) {
+            // Finishes in slotWriterClosed() once everything is on disk
+            if (!_writerClosing) {
+                _writerClosing = true;
+                QMetaObject::invokeMethod(_writer.data(), &DownloadFileWriter::close);
+            }
+            return;
+        }
         qCDebug(lcGetJob) << "Get file job finished bytesAvailable/_saveBodyToFile:" << reply()->bytesAvailable() << "/" << _saveBodyToFile ;
         if (_bandwidthManager) {
             _bandwidthManager->unregisterDownloadJob(this);
@@ -722,36 +947,52 @@ void PropagateDownloadFile::startDownload()
         return;
     }
 
+    const auto deltaDownload = _resumeStart == 0 && isDeltaDownloadEnabled();
     {
+        // The bytes of a delta download are only known to be right once it is verified,
+        // until then no etag is recorded so that the next sync removes the temporary file
         SyncJournalDb::DownloadInfo pi;
-        pi._etag = _item->_etag;
+        pi._etag = deltaDownload ? QByteArray() : _item->_etag;
         pi._tmpfile = tmpFileName;
         pi._valid = true;
         propagator()->_journal->setDownloadInfo(_item->_file, pi);
         propagator()->_journal->commit("download file start");
     }
 
+    if (deltaDownload) {
+        startDeltaDownload();
+        return;
+    }
+    startFullDownload(expectedEtagForResume);
+}
+
+void PropagateDownloadFile::startFullDownload(const QByteArray &expectedEtagForResume)
+{
     QMap<QByteArray, QByteArray> headers;
 
-    if (_item->_directDownloadUrl.isEmpty()) {
+    if (_item->directDownloadUrl().isEmpty()) {
         // Normal job, download from oC instance
         _job = new GETFileJob(propagator()->account(),
-            propagator()->fullRemotePath(isEncrypted() ? _item->_encryptedFileName : _item->_file),
+            propagator()->fullRemotePath(isEncrypted() ? _item->encryptedFileName() : _item->_file),
             &_tmpFile, headers, expectedEtagForResume, _resumeStart, this);
     } else {
         // We were provided a direct URL, use that one
-        qCInfo(lcPropagateDownload) << "directDownloadUrl given for " << _item->_file << _item->_directDownloadUrl;
+        qCInfo(lcPropagateDownload) << "directDownloadUrl given for " << _item->_file << _item->directDownloadUrl();
 
-        if (!_item->_directDownloadCookies.isEmpty()) {
-            headers["Cookie"] = _item->_directDownloadCookies.toUtf8();
+        if (!_item->directDownloadCookies().isEmpty()) {
+            headers["Cookie"] = _item->directDownloadCookies().toUtf8();
         }
 
-        QUrl url = QUrl::fromUserInput(_item->_directDownloadUrl);
+        QUrl url = QUrl::fromUserInput(_item->directDownloadUrl());
         _job = new GETFileJob(propagator()->account(),
             url,
             &_tmpFile, headers, expectedEtagForResume, _resumeStart, this);
     }
     _job->setBandwidthManager(&propagator()->_bandwidthManager);
+    _job->setComputeChecksums(propagator()->account()->capabilities().preferredUploadChecksumType());
+    if (propagator()->syncOptions()._downloadWriterThread) {
+        _job->setWriterThread(propagator()->downloadWriterThread());
+    }
     connect(_job.data(), &GETFileJob::finishedSignal, this, &PropagateDownloadFile::slotGetFinished);
     connect(_job.data(), &GETFileJob::downloadProgress, this, &PropagateDownloadFile::slotDownloadProgress);
     propagator()->_activeJobList.append(this);
@@ -771,6 +1012,267 @@ void PropagateDownloadFile::setDeleteExistingFolder(bool enabled)
     _deleteExisting = enabled;
 }
 
+namespace {
+    // Appends \a size bytes from \a offset of the file \a sourceFileName to the file \a fileName,
+    // stops without a result when the future is canceled
+    void appendFileRange(QPromise<bool> &promise, const QString &sourceFileName, qint64 offset, qint64 size, const QString &fileName)
+    {
+        QFile source(sourceFileName);
+        QFile target(fileName);
+        if (!source.open(QIODevice::ReadOnly) || !source.seek(offset) || !target.open(QIODevice::Append)) {
+            qCWarning(lcPropagateDownload) << "Could not copy from" << sourceFileName << "to" << fileName
+                                           << source.errorString() << target.errorString();
+            promise.addResult(false);
+            return;
+        }
+        QByteArray buffer(qMin(size, qint64(1024 * 1024)), Qt::Uninitialized);
+        for (auto remaining = size; remaining > 0;) {
+            if (promise.isCanceled()) {
+                return;
+            }
+            const auto readBytes = source.read(buffer.data(), qMin(remaining, qint64(buffer.size())));
+            if (readBytes <= 0 || target.write(buffer.constData(), readBytes) != readBytes) {
+                qCWarning(lcPropagateDownload) << "Error while copying from" << sourceFileName << "to" << fileName
+                                               << source.errorString() << target.errorString();
+                promise.addResult(false);
+                return;
+            }
+            remaining -= readBytes;
+        }
+        promise.addResult(true);
+    }
+
+    bool haveSameContent(const ContentChunker::Chunks &chunks, const ContentChunker::Chunks &otherChunks)
+    {
+        return std::equal(chunks.cbegin(), chunks.cend(), otherChunks.cbegin(), otherChunks.cend(),
+            [](const ContentChunker::Chunk &chunk, const ContentChunker::Chunk &otherChunk) {
+                return chunk.size == otherChunk.size && chunk.hash == otherChunk.hash;
+            });
+    }
+}
+
+bool PropagateDownloadFile::isDeltaDownloadEnabled() const
+{
+    // Only a modified file can be put together from its previous version
+    return propagator()->syncOptions()._deltaDownload
+        && propagator()->account()->capabilities().contentChunks()
+        && !isEncrypted()
+        && _item->directDownloadUrl().isEmpty()
+        && _item->_instruction == CSYNC_INSTRUCTION_SYNC
+        && _item->_type == ItemTypeFile
+        && _item->_size >= minDeltaDownloadSize
+        && FileSystem::fileExists(propagator()->fullLocalPath(_item->_file));
+}
+
+void PropagateDownloadFile::startDeltaDownload()
+{
+    // The temporary file is reopened for every range, the data copied from the local file is appended in a thread
+    _tmpFile.close();
+    _deltaDownload = true;
+    _contentChunksAverageSize = ContentChunker::averageChunkSize(_item->_size);
+
+    QNetworkRequest req;
+    req.setRawHeader("Accept", contentChunksMimeTypeC);
+    req.setRawHeader(contentChunksAverageSizeHeaderC, QByteArray::number(_contentChunksAverageSize));
+    _contentChunksJob = new SimpleFileJob(propagator()->account(), propagator()->fullRemotePath(_item->_file), this);
+    connect(_contentChunksJob.data(), &SimpleFileJob::finishedSignal, this, &PropagateDownloadFile::slotContentChunksFetched);
+    propagator()->_activeJobList.append(this);
+    _contentChunksJob->startRequest(QByteArrayLiteral("GET"), req);
+}
+
+void PropagateDownloadFile::slotContentChunksFetched(QNetworkReply *reply)
+{
+    if (propagator()->_abortRequested) {
+        propagator()->_activeJobList.removeOne(this);
+        return;
+    }
+
+    // The chunks must describe the version found by the discovery, that's the one the journal will record
+    const auto etag = getEtagFromReply(reply);
+    if (reply->error() != QNetworkReply::NoError || etag != _item->_etag) {
+        qCInfo(lcPropagateDownload) << "No content chunks for" << _item->_file << reply->errorString() << etag << _item->_etag;
+        fallBackToFullDownload();
+        return;
+    }
+    _contentChunks = ContentChunker::deserialize(reply->readAll());
+    const auto chunkedSize = std::accumulate(_contentChunks.cbegin(), _contentChunks.cend(), qint64(0), [](qint64 sum, const ContentChunker::Chunk &chunk) {
+        return sum + chunk.size;
+    });
+    if (_contentChunks.isEmpty() || chunkedSize != _item->_size) {
+        qCWarning(lcPropagateDownload) << "The content chunks of" << _item->_file << "don't match its size" << chunkedSize << _item->_size;
+        fallBackToFullDownload();
+        return;
+    }
+    _deltaChecksumHeader = findBestChecksum(reply->rawHeader(checkSumHeaderC));
+
+    auto watcher = new QFutureWatcher<ContentChunker::Segments>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        if (propagator()->_abortRequested) {
+            propagator()->_activeJobList.removeOne(this);
+            return;
+        }
+        _segments = watcher->result();
+        if (_segments.isEmpty()) {
+            qCInfo(lcPropagateDownload) << "Nothing of" << _item->_file << "can be reused";
+            fallBackToFullDownload();
+            return;
+        }
+        const auto copied = std::accumulate(_segments.cbegin(), _segments.cend(), qint64(0), [](qint64 sum, const ContentChunker::Segment &segment) {
+            return segment.isCopy() ? sum + segment.size : sum;
+        });
+        qCInfo(lcPropagateDownload) << "Delta download of" << _item->_file << ":" << copied << "of" << _item->_size
+                                    << "bytes are copied from the local file in" << _segments.size() << "segments";
+        _currentSegment = 0;
+        downloadNextSegment();
+    });
+    watcher->setFuture(QtConcurrent::run([filePath = propagator()->fullLocalPath(_item->_file), averageSize = _contentChunksAverageSize,
+                                             contentChunks = _contentChunks] {
+        ContentChunker::Chunks localChunks;
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly) || !ContentChunker::computeChunks(&file, averageSize, &localChunks)) {
+            qCWarning(lcPropagateDownload) << "Could not compute the content chunks of" << filePath << file.errorString();
+            return ContentChunker::Segments();
+        }
+        // Every range is a request of its own, don't let them get too small
+        return ContentChunker::planSegments(localChunks, contentChunks, averageSize, maxDeltaDownloadSegments);
+    }));
+}
+
+void PropagateDownloadFile::downloadNextSegment()
+{
+    if (_currentSegment == _segments.size()) {
+        deltaDownloadFinished();
+        return;
+    }
+
+    const auto &segment = _segments.at(_currentSegment);
+    _resumeStart = segment.offset;
+    _downloadProgress = 0;
+    propagator()->reportProgress(*_item, _resumeStart);
+
+    if (segment.isCopy()) {
+        auto watcher = new QFutureWatcher<bool>(this);
+        _appendWatcher = watcher;
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+            watcher->deleteLater();
+            if (propagator()->_abortRequested) {
+                propagator()->_activeJobList.removeOne(this);
+                return;
+            }
+            if (!watcher->result()) {
+                fallBackToFullDownload();
+                return;
+            }
+            ++_currentSegment;
+            downloadNextSegment();
+        });
+        watcher->setFuture(QtConcurrent::run(appendFileRange, propagator()->fullLocalPath(_item->_file), segment.sourceOffset, segment.size,
+                                             _tmpFile.fileName()));
+        return;
+    }
+
+    if (!_tmpFile.open(QIODevice::Append | QIODevice::Unbuffered)) {
+        qCWarning(lcPropagateDownload) << "could not open temporary file" << _tmpFile.fileName();
+        propagator()->_activeJobList.removeOne(this);
+        done(SyncFileItem::NormalError, _tmpFile.errorString(), ErrorCategory::GenericError);
+        return;
+    }
+    _job = new GETFileJob(propagator()->account(), propagator()->fullRemotePath(_item->_file),
+        &_tmpFile, {}, _item->_etag, segment.offset, this);
+    _job->setRangeSize(segment.size);
+    _job->setBandwidthManager(&propagator()->_bandwidthManager);
+    if (propagator()->syncOptions()._downloadWriterThread) {
+        _job->setWriterThread(propagator()->downloadWriterThread());
+    }
+    connect(_job.data(), &GETFileJob::finishedSignal, this, &PropagateDownloadFile::slotSegmentGetFinished);
+    connect(_job.data(), &GETFileJob::downloadProgress, this, &PropagateDownloadFile::slotDownloadProgress);
+    _job->start();
+}
+
+void PropagateDownloadFile::slotSegmentGetFinished()
+{
+    GETFileJob *job = _job;
+    ASSERT(job);
+    _tmpFile.close();
+
+    if (propagator()->_abortRequested) {
+        propagator()->_activeJobList.removeOne(this);
+        return;
+    }
+
+    const auto &segment = _segments.at(_currentSegment);
+    if (job->reply()->error() != QNetworkReply::NoError || _tmpFile.size() != segment.offset + segment.size) {
+        qCWarning(lcPropagateDownload) << "Downloading a range of" << _item->_file << "failed:" << job->errorString()
+                                       << "- downloading the whole file";
+        fallBackToFullDownload();
+        return;
+    }
+    ++_currentSegment;
+    downloadNextSegment();
+}
+
+void PropagateDownloadFile::deltaDownloadFinished()
+{
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        propagator()->_activeJobList.removeOne(this);
+        if (propagator()->_abortRequested) {
+            return;
+        }
+        if (!watcher->result()) {
+            qCWarning(lcPropagateDownload) << "The file put together from" << _item->_file << "doesn't match the content chunks, downloading it";
+            fallBackToFullDownload();
+            return;
+        }
+        setDownloadInfoEtag();
+
+        auto *validator = new ValidateChecksumHeader(this);
+        connect(validator, &ValidateChecksumHeader::validated,
+            this, &PropagateDownloadFile::transmissionChecksumValidated);
+        connect(validator, &ValidateChecksumHeader::validationFailed,
+            this, &PropagateDownloadFile::slotChecksumFail);
+        validator->start(_tmpFile.fileName(), _deltaChecksumHeader);
+    });
+    watcher->setFuture(QtConcurrent::run([fileName = _tmpFile.fileName(), averageSize = _contentChunksAverageSize, contentChunks = _contentChunks] {
+        // The local file may have changed while it was copied from
+        ContentChunker::Chunks chunks;
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) && ContentChunker::computeChunks(&file, averageSize, &chunks)
+            && haveSameContent(chunks, contentChunks);
+    }));
+}
+
+void PropagateDownloadFile::fallBackToFullDownload()
+{
+    _deltaDownload = false;
+    _contentChunks.clear();
+    _segments.clear();
+    propagator()->_activeJobList.removeOne(this);
+
+    // Nothing of the temporary file is verified, a failed copy may even have left a part of a segment
+    FileSystem::remove(_tmpFile.fileName());
+    setDownloadInfoEtag();
+    if (!_tmpFile.open(QIODevice::Append | QIODevice::Unbuffered)) {
+        qCWarning(lcPropagateDownload) << "could not open temporary file" << _tmpFile.fileName();
+        done(SyncFileItem::NormalError, _tmpFile.errorString(), ErrorCategory::GenericError);
+        return;
+    }
+    FileSystem::setFileHidden(_tmpFile.fileName(), true);
+    _resumeStart = 0;
+    _downloadProgress = 0;
+    startFullDownload(_item->_etag);
+}
+
+void PropagateDownloadFile::setDownloadInfoEtag()
+{
+    auto pi = propagator()->_journal->getDownloadInfo(_item->_file);
+    pi._etag = _item->_etag;
+    propagator()->_journal->setDownloadInfo(_item->_file, pi);
+    propagator()->_journal->commit("download file resumable");
+}
+
 const char owncloudCustomSoftErrorStringC[] = "owncloud-custom-soft-error-string";
 void PropagateDownloadFile::slotGetFinished()
 {
@@ -812,10 +1314,10 @@ void PropagateDownloadFile::slotGetFinished()
             propagator()->_journal->setDownloadInfo(_item->_file, SyncJournalDb::DownloadInfo());
         }
 
-        if (!_item->_directDownloadUrl.isEmpty() && err != QNetworkReply::OperationCanceledError) {
+        if (!_item->directDownloadUrl().isEmpty() && err != QNetworkReply::OperationCanceledError) {
             // If this was with a direct download, retry without direct download
-            qCWarning(lcPropagateDownload) << "Direct download of" << _item->_directDownloadUrl << "failed. Retrying through owncloud.";
-            _item->_directDownloadUrl.clear();
+            qCWarning(lcPropagateDownload) << "Direct download of" << _item->directDownloadUrl() << "failed. Retrying through owncloud.";
+            _item->setDirectDownload({}, {});
             start();
             return;
         }
@@ -945,19 +1447,29 @@ void PropagateDownloadFile::slotGetFinished()
         this, &PropagateDownloadFile::transmissionChecksumValidated);
     connect(validator, &ValidateChecksumHeader::validationFailed,
         this, &PropagateDownloadFile::slotChecksumFail);
-    auto checksumHeader = findBestChecksum(job->reply()->rawHeader(checkSumHeaderC));
-    auto contentMd5Header = job->reply()->rawHeader(contentMd5HeaderC);
-    if (checksumHeader.isEmpty() && !contentMd5Header.isEmpty())
-        checksumHeader = "MD5:" + contentMd5Header;
-    validator->start(_tmpFile.fileName(), checksumHeader);
+    const auto checksumHeader = job->checksumHeader();
+    _downloadedContentChecksum = job->computedChecksum(propagator()->account()->capabilities().preferredUploadChecksumType());
+    const auto checksumType = parseChecksumHeaderType(checksumHeader);
+    const auto checksum = job->computedChecksum(checksumType);
+    if (!checksum.isEmpty()) {
+        validator->validate(checksumHeader, checksumType, checksum);
+    } else {
+        validator->start(_tmpFile.fileName(), checksumHeader);
+    }
 }
 
 void PropagateDownloadFile::slotChecksumFail(const QString &errMsg,
     const QByteArray &calculatedChecksumType, const QByteArray &calculatedChecksum, const ValidateChecksumHeader::FailureReason reason)
 {
+    if (_deltaDownload) {
+        qCWarning(lcPropagateDownload) << "The file put together from" << _item->_file << "failed the checksum validation, downloading it:" << errMsg;
+        fallBackToFullDownload();
+        return;
+    }
+
     if (reason == ValidateChecksumHeader::FailureReason::ChecksumMismatch && propagator()->account()->isChecksumRecalculateRequestSupported()) {
             const QByteArray calculatedChecksumHeader(calculatedChecksumType + ':' + calculatedChecksum);
-            const QString fullRemotePathForFile(propagator()->fullRemotePath(isEncrypted() ? _item->_encryptedFileName : _item->_file));
+            const QString fullRemotePathForFile(propagator()->fullRemotePath(isEncrypted() ? _item->encryptedFileName() : _item->_file));
             auto *job = new SimpleFileJob(propagator()->account(), fullRemotePathForFile);
             QObject::connect(job, &SimpleFileJob::finishedSignal, this,
                 [this, calculatedChecksumHeader, errMsg](const QNetworkReply *reply) { processChecksumRecalculate(reply, calculatedChecksumHeader, errMsg);
@@ -1114,6 +1626,10 @@ void PropagateDownloadFile::transmissionChecksumValidated(const QByteArray &chec
         return contentChecksumComputed(checksumType, checksum);
     }
 
+    if (!_downloadedContentChecksum.isEmpty()) {
+        return contentChecksumComputed(theContentChecksumType, _downloadedContentChecksum);
+    }
+
     // Compute the content checksum.
     auto computeChecksum = new ComputeChecksum(this);
     computeChecksum->setChecksumType(theContentChecksumType);
@@ -1231,7 +1747,7 @@ void PropagateDownloadFile::downloadFinished()
         }
     }
 
-    if (_item->_locked == SyncFileItem::LockStatus::LockedItem && (_item->_lockOwnerType != SyncFileItem::LockOwnerType::UserLock || _item->_lockOwnerId != propagator()->account()->davUser())) {
+    if (_item->_locked == SyncFileItem::LockStatus::LockedItem && (_item->_lockOwnerType != SyncFileItem::LockOwnerType::UserLock || _item->lockOwnerId() != propagator()->account()->davUser())) {
         qCDebug(lcPropagateDownload()) << _tmpFile.fileName() << "file is locked: making it read only";
         FileSystem::setFileReadOnly(_tmpFile.fileName(), true);
     } else {
@@ -1372,10 +1888,20 @@ void PropagateDownloadFile::updateMetadata(bool isConflict)
         return;
     }
 
+    if (_deltaDownload) {
+        // The local file is now the version the chunks describe, uploads of its next version can use them too
+        SyncJournalDb::ContentChunksInfo contentChunks;
+        contentChunks._etag = _item->_etag;
+        contentChunks._averageSize = _contentChunksAverageSize;
+        contentChunks._chunks = ContentChunker::serialize(_contentChunks);
+        contentChunks._valid = true;
+        propagator()->_journal->setContentChunks(_item->_file, contentChunks);
+    }
+
     if (isEncrypted()) {
         propagator()->_journal->setDownloadInfo(_item->_file, SyncJournalDb::DownloadInfo());
     } else {
-        propagator()->_journal->setDownloadInfo(_item->_encryptedFileName, SyncJournalDb::DownloadInfo());
+        propagator()->_journal->setDownloadInfo(_item->encryptedFileName(), SyncJournalDb::DownloadInfo());
     }
 
     propagator()->_journal->commit("download file start2");
@@ -1389,7 +1915,7 @@ void PropagateDownloadFile::updateMetadata(bool isConflict)
         handleRecallFile(fn, propagator()->localPath(), *propagator()->_journal);
     }
 
-    const auto isLockOwnedByCurrentUser = _item->_lockOwnerId == propagator()->account()->davUser();
+    const auto isLockOwnedByCurrentUser = _item->lockOwnerId() == propagator()->account()->davUser();
 
     const auto isUserLockOwnedByCurrentUser = (_item->_lockOwnerType == SyncFileItem::LockOwnerType::UserLock && isLockOwnedByCurrentUser);
     const auto isTokenLockOwnedByCurrentUser = (_item->_lockOwnerType == SyncFileItem::LockOwnerType::TokenLock && isLockOwnedByCurrentUser);
@@ -1421,6 +1947,13 @@ void PropagateDownloadFile::abort(PropagatorJob::AbortType abortType)
 {
     if (_job && _job->reply())
         _job->reply()->abort();
+    if (_contentChunksJob && _contentChunksJob->reply())
+        _contentChunksJob->reply()->abort();
+    // Don't let a copy of a delta download write to the temporary file once the job is gone
+    if (_appendWatcher) {
+        _appendWatcher->cancel();
+        _appendWatcher->waitForFinished();
+    }
 
     if (abortType == AbortType::Asynchronous) {
         emit abortFinished();
@@ -17,11 +17,18 @@
 #include "owncloudpropagator.h"
 #include "networkjobs.h"
 #include "clientsideencryption.h"
+#include "contentchunker.h"
+#include "downloadfilewriter.h"
 #include <common/checksums.h>
+#include <common/checksumcalculator.h>
 #include "foldermetadata.h"
 
 #include <QBuffer>
 #include <QFile>
+#include <QFutureWatcher>
+
+#include <map>
+#include <memory>
 
 #if !defined(Q_OS_MACOS) || __MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_15
 #include <filesystem>
@@ -43,6 +50,7 @@ class OWNCLOUDSYNC_EXPORT GETFileJob : public AbstractNetworkJob
     QByteArray _expectedEtagForResume;
     qint64 _expectedContentLength;
     qint64 _resumeStart;
+    qint64 _rangeSize = -1;
     SyncFileItem::Status _errorStatus;
     QUrl _directDownloadUrl;
     QByteArray _etag;
@@ -56,6 +64,21 @@ class OWNCLOUDSYNC_EXPORT GETFileJob : public AbstractNetworkJob
     /// Will be set to true once we've seen a 2xx response header
     bool _saveBodyToFile = false;
 
+    bool _computeChecksums = false;
+    QByteArray _contentChecksumType;
+    /// Checksums of everything written to the device, by checksum type
+    std::map<QByteArray, std::shared_ptr<ChecksumCalculator>> _checksumCalculators;
+    /// The part of an earlier attempt is added to the checksums on a worker thread, the body waits for it
+    bool _checksummingResumedPart = false;
+
+    QThread *_writerThread = nullptr;
+    /// Lives in _writerThread while the body is written
+    QPointer<DownloadFileWriter> _writer;
+    /// Bytes handed to _writer so far and how many of them are not yet written
+    qint64 _handedToWriter = 0;
+    qint64 _pendingWriteBytes = 0;
+    bool _writerClosing = false;
+
 protected:
     qint64 _contentLength;
 
@@ -68,17 +91,13 @@ public:
     explicit GETFileJob(AccountPtr account, const QUrl &url, QIODevice *device,
         const QMap<QByteArray, QByteArray> &headers, const QByteArray &expectedEtagForResume,
         qint64 resumeStart, QObject *parent = nullptr);
-    ~GETFileJob() override
-    {
-        if (_bandwidthManager) {
-            _bandwidthManager->unregisterDownloadJob(this);
-        }
-    }
+    ~GETFileJob() override;
 
     void start() override;
     bool finished() override
     {
-        if (_saveBodyToFile && reply()->bytesAvailable()) {
+        // While the writer is busy slotReadyRead() finishes the job
+        if ((_saveBodyToFile && reply()->bytesAvailable()) || _writer) {
             return false;
         } else {
             if (_bandwidthManager) {
@@ -118,6 +137,41 @@ public:
     [[nodiscard]] qint64 expectedContentLength() const { return _expectedContentLength; }
     void setExpectedContentLength(qint64 size) { _expectedContentLength = size; }
 
+    /**
+     * Computes checksums of the data while it is written to the device
+     *
+     * The type of the checksum header sent by the server and
+     * \a contentChecksumType are computed, so the downloaded file doesn't
+     * have to be read again for them. On resume the part that is already in
+     * the device's file is read once when the reply arrives.
+     *
+     * Must be called before start(). The device must be a QFile.
+     */
+    void setComputeChecksums(const QByteArray &contentChecksumType);
+
+    /// The transmission checksum header sent by the server, if any
+    [[nodiscard]] QByteArray checksumHeader() const;
+
+    /// The checksum of the downloaded file, empty if it wasn't computed for \a checksumType
+    [[nodiscard]] QByteArray computedChecksum(const QByteArray &checksumType) const;
+
+    /**
+     * Writes the body to the device's file on \a thread
+     *
+     * The job only reads from the reply and hands the data over, it finishes
+     * once everything is on disk. Must be called before start(). Ignored if
+     * the device is not a QFile.
+     */
+    void setWriterThread(QThread *thread);
+
+    /**
+     * Only downloads \a size bytes from the resume start
+     *
+     * Fails if the server doesn't answer with that range. Must be called
+     * before start().
+     */
+    void setRangeSize(qint64 size);
+
 protected:
     virtual qint64 writeToDevice(const QByteArray &data);
 
@@ -127,6 +181,15 @@ signals:
 private slots:
     void slotReadyRead();
     void slotMetaDataChanged();
+    void slotDataWritten(qint64 bytes);
+    void slotWriteFailed(const QString &errorString);
+    void slotWriterClosed();
+
+private:
+    void startChecksumCalculators();
+    [[nodiscard]] DownloadFileWriter::Checksums checksums() const;
+    void startWriter();
+    [[nodiscard]] qint64 readBufferSize() const;
 };
 
 /**
@@ -176,14 +239,17 @@ private:
     +-> startDownload() <--------------------------+
           |                                        |
           +-> run a GETFileJob                     | checksum identical?
+          |   (or startDeltaDownload(), see below) |
                                                    |
       done?-> slotGetFinished()                    |
                 |                                  |
                 +-> validate checksum header       |
+                    (computed while downloading)   |
                                                    |
       done?-> transmissionChecksumValidated()      |
                 |                                  |
                 +-> compute the content checksum   |
+                    (unless done while downloading)|
                                                    |
       done?-> contentChecksumComputed()            |
                 |                                  |
@@ -193,6 +259,36 @@ private:
     |                                              |
     +-> updateMetadata() <-------------------------+
 
+\endcode
+
+ A delta download puts the new version together in the temporary file,
+ any failure continues with fallBackToFullDownload():
+
+\code{.unparsed}
+  startDeltaDownload()
+    |
+    +-> GET the content chunks of the new version
+          |
+  done?-> slotContentChunksFetched()
+            |
+            +-> compute the local file's chunks (in a thread)
+                and plan the segments
+                  |
+    +-----> downloadNextSegment()
+    |         |
+    |         +-> copy from the local file (in a thread)
+    |         |   or GET a range -> slotSegmentGetFinished()
+    |         |                           |
+    +---------+---------------------------+
+              |
+              +-> deltaDownloadFinished()
+                    |
+                    +-> compare the chunks of the result (in a thread)
+                          |
+                          +-> validate checksum header
+                                |
+                        done?-> transmissionChecksumValidated()
+
 \endcode
  */
 class PropagateDownloadFile : public PropagateItemJob
@@ -228,6 +324,10 @@ private slots:
     void startDownload();
     /// Called when the GETFileJob finishes
     void slotGetFinished();
+    /// Called when the server sent the content chunks of the new version
+    void slotContentChunksFetched(QNetworkReply *reply);
+    /// Called when the GETFileJob of a range of a delta download finishes
+    void slotSegmentGetFinished();
     /// Called when the download's checksum header was validated
     void transmissionChecksumValidated(const QByteArray &checksumType, const QByteArray &checksum);
     /// Called when the download's checksum computation is done
@@ -252,15 +352,39 @@ private:
     void deleteExistingFolder();
     [[nodiscard]] bool isEncrypted() const { return _isEncrypted; }
 
+    void startFullDownload(const QByteArray &expectedEtagForResume);
+    [[nodiscard]] bool isDeltaDownloadEnabled() const;
+    void startDeltaDownload();
+    void downloadNextSegment();
+    void deltaDownloadFinished();
+    /// Discards the temporary file and continues with a GET of the whole file
+    void fallBackToFullDownload();
+    /// Records the etag of the item with the temporary file, which allows resuming it
+    void setDownloadInfoEtag();
+
     qint64 _resumeStart = 0;
     qint64 _downloadProgress = 0;
     QPointer<GETFileJob> _job;
     QFile _tmpFile;
     bool _deleteExisting = false;
     bool _isEncrypted = false;
+    /// Content checksum computed by the GETFileJob while downloading, if any
+    QByteArray _downloadedContentChecksum;
     FolderMetadata::EncryptedFile _encryptedInfo;
     ConflictRecord _conflictRecord;
 
+    /// Set while the file is put together from the local file and ranges of the new version
+    bool _deltaDownload = false;
+    QPointer<SimpleFileJob> _contentChunksJob;
+    /// The content chunks of the new version as sent by the server
+    ContentChunker::Chunks _contentChunks;
+    qint64 _contentChunksAverageSize = 0;
+    ContentChunker::Segments _segments;
+    int _currentSegment = 0;
+    QByteArray _deltaChecksumHeader;
+    /// The copy from the local file that is running, if any
+    QPointer<QFutureWatcher<bool>> _appendWatcher;
+
     QElapsedTimer _stopwatch;
 
     PropagateDownloadEncrypted *_downloadEncryptedHelper = nullptr;
@@ -16,7 +16,7 @@ PropagateDownloadEncrypted::PropagateDownloadEncrypted(OwncloudPropagator *propa
     , _info(_item->_file)
 {
     const auto rootPath = Utility::noLeadingSlashPath(_propagator->remotePath());
-    const auto remoteFilename = _item->_encryptedFileName.isEmpty() ? _item->_file : _item->_encryptedFileName;
+    const auto remoteFilename = _item->encryptedFileName().isEmpty() ? _item->_file : _item->encryptedFileName();
     const auto remotePath = QString(rootPath + remoteFilename);
     const auto remoteParentPath = remotePath.left(remotePath.lastIndexOf('/'));
     _remoteParentPath = remotePath.left(remotePath.lastIndexOf('/'));
@@ -52,7 +52,7 @@ void PropagateDownloadEncrypted::slotFetchMetadataJobFinished(int statusCode, co
         return;
     }
 
-    qCDebug(lcPropagateDownloadEncrypted) << "Metadata Received reading" << _item->_instruction << _item->_file << _item->_encryptedFileName;
+    qCDebug(lcPropagateDownloadEncrypted) << "Metadata Received reading" << _item->_instruction << _item->_file << _item->encryptedFileName();
 
     const auto metadata = _encryptedFolderMetadataHandler->folderMetadata();
 
@@ -63,7 +63,7 @@ void PropagateDownloadEncrypted::slotFetchMetadataJobFinished(int statusCode, co
 
     const auto files = metadata->files();
 
-    const auto encryptedFilename = _item->_encryptedFileName.section(QLatin1Char('/'), -1);
+    const auto encryptedFilename = _item->encryptedFileName().section(QLatin1Char('/'), -1);
     for (const FolderMetadata::EncryptedFile &file : files) {
         if (encryptedFilename == file.encryptedFilename) {
             _encryptedInfo = file;
@@ -29,13 +29,13 @@ Q_LOGGING_CATEGORY(lcPropagateRemoteDelete, "nextcloud.sync.propagator.remotedel
 void PropagateRemoteDelete::start()
 {
     qCInfo(lcPropagateRemoteDelete) << "Start propagate remote delete job for" << _item->_file;
-    qCInfo(lcPermanentLog) << "delete" << _item->_file << _item->_discoveryResult;
+    qCInfo(lcPermanentLog) << "delete" << _item->_file << _item->discoveryResult();
 
     if (propagator()->_abortRequested)
         return;
 
-    if (!_item->_encryptedFileName.isEmpty() || _item->isEncrypted()) {
-        if (!_item->_encryptedFileName.isEmpty()) {
+    if (!_item->encryptedFileName().isEmpty() || _item->isEncrypted()) {
+        if (!_item->encryptedFileName().isEmpty()) {
             _deleteEncryptedHelper = new PropagateRemoteDeleteEncrypted(propagator(), _item, this);
         } else {
             _deleteEncryptedHelper = new PropagateRemoteDeleteEncryptedRootFolder(propagator(), _item, this);
@@ -27,6 +27,7 @@
 #include "syncengine.h"
 #include "deletejob.h"
 #include "common/asserts.h"
+#include "common/constants.h"
 #include "networkjobs.h"
 #include "clientsideencryption.h"
 #include "clientsideencryptionjobs.h"
@@ -93,6 +94,30 @@ bool PUTFileJob::finished()
     return true;
 }
 
+void CopyRangeJob::start()
+{
+    QNetworkRequest req;
+    req.setRawHeader("Destination", QUrl::toPercentEncoding(_destination.path(), "/"));
+    req.setRawHeader("OC-Source-Range", "bytes=" + QByteArray::number(_start) + '-' + QByteArray::number(_start + _size - 1));
+    req.setRawHeader("If-Match", '"' + _etag + '"');
+    req.setPriority(QNetworkRequest::LowPriority);
+    sendRequest("COPY", makeDavUrl(path()), req);
+
+    if (reply()->error() != QNetworkReply::NoError) {
+        qCWarning(lcPutJob) << " Network error: " << reply()->errorString();
+    }
+    AbstractNetworkJob::start();
+}
+
+bool CopyRangeJob::finished()
+{
+    qCInfo(lcPutJob) << "COPY of" << _size << "bytes from" << _start << "to" << _destination.toString() << "FINISHED WITH STATUS"
+                     << replyStatusString();
+
+    emit finishedSignal();
+    return true;
+}
+
 void PollJob::start()
 {
     setTimeout(120 * 1000);
@@ -113,8 +138,7 @@ bool PollJob::finished()
         _item->_status = classifyError(err, _item->_httpErrorCode);
         _item->_errorString = errorString();
         const auto exceptionParsed = getExceptionFromReply(reply());
-        _item->_errorExceptionName = exceptionParsed.first;
-        _item->_errorExceptionMessage = exceptionParsed.second;
+        _item->setErrorException(exceptionParsed.first, exceptionParsed.second);
 
         if (_item->_status == SyncFileItem::FatalError || _item->_httpErrorCode >= 400) {
             if (_item->_status != SyncFileItem::FatalError
@@ -200,6 +224,21 @@ void PropagateUploadFileCommon::setDeleteExisting(bool enabled)
     _deleteExisting = enabled;
 }
 
+void PropagateUploadFileCommon::setPreparedEncryption(PropagateUploadEncrypted *helper)
+{
+    Q_ASSERT(helper && helper->isPrepared());
+    helper->setParent(this);
+    _uploadEncryptedHelper = helper;
+}
+
+PropagatorJob::JobParallelism PropagateUploadFileCommon::parallelism() const
+{
+    if (_uploadEncryptedHelper && _uploadEncryptedHelper->isPrepared()) {
+        return FullParallelism;
+    }
+    return PropagateItemJob::parallelism();
+}
+
 void PropagateUploadFileCommon::start()
 {
     if (!_item->_originalFile.isEmpty() && !_item->_renameTarget.isEmpty() && _item->_renameTarget != _item->_originalFile) {
@@ -235,7 +274,9 @@ void PropagateUploadFileCommon::start()
     }
 
     const auto remoteParentPath = parentRec._e2eMangledName.isEmpty() ? parentPath : parentRec._e2eMangledName;
-    _uploadEncryptedHelper = new PropagateUploadEncrypted(propagator(), remoteParentPath, _item, this);
+    if (!_uploadEncryptedHelper) {
+        _uploadEncryptedHelper = new PropagateUploadEncrypted(propagator(), remoteParentPath, _item, this);
+    }
     connect(_uploadEncryptedHelper, &PropagateUploadEncrypted::finalized,
             this, &PropagateUploadFileCommon::setupEncryptedFile);
     connect(_uploadEncryptedHelper, &PropagateUploadEncrypted::error, [this] {
@@ -319,7 +360,8 @@ void PropagateUploadFileCommon::slotComputeContentChecksum()
     // change during the checksum calculation - This goes inside of the _item->_file
     // and not the _fileToUpload because we are checking the original file, not there
     // probably temporary one.
-    _item->_modtime = FileSystem::getModTime(filePath);
+    // Encrypted files were already read when preparing the encryption, a change since then matters.
+    _item->_modtime = _uploadingEncrypted ? _uploadEncryptedHelper->encryptedModtime() : FileSystem::getModTime(filePath);
     if (_item->_modtime <= 0) {
         slotOnErrorStartFolderUnlock(SyncFileItem::NormalError, tr("File %1 has invalid modification time. Do not upload to the server.").arg(QDir::toNativeSeparators(_item->_file)));
         return;
@@ -338,6 +380,16 @@ void PropagateUploadFileCommon::slotComputeContentChecksum()
         return;
     }
 
+    // The checksum of the encrypted data was computed while preparing the encryption
+    if (_uploadingEncrypted) {
+        QByteArray encryptedChecksumType, encryptedChecksum;
+        parseChecksumHeader(_uploadEncryptedHelper->encryptedChecksumHeader(), &encryptedChecksumType, &encryptedChecksum);
+        if (encryptedChecksumType == checksumType) {
+            slotComputeTransmissionChecksum(checksumType, encryptedChecksum);
+            return;
+        }
+    }
+
     // Compute the content checksum.
     auto computeChecksum = new ComputeChecksum(this);
     computeChecksum->setChecksumType(checksumType);
@@ -361,6 +413,15 @@ void PropagateUploadFileCommon::slotComputeTransmissionChecksum(const QByteArray
         return;
     }
 
+    if (_uploadingEncrypted && uploadChecksumEnabled()) {
+        QByteArray encryptedChecksumType, encryptedChecksum;
+        parseChecksumHeader(_uploadEncryptedHelper->encryptedChecksumHeader(), &encryptedChecksumType, &encryptedChecksum);
+        if (encryptedChecksumType == propagator()->account()->capabilities().uploadChecksumType()) {
+            slotStartUpload(encryptedChecksumType, encryptedChecksum);
+            return;
+        }
+    }
+
     // Compute the transmission checksum.
     auto computeChecksum = new ComputeChecksum(this);
     if (uploadChecksumEnabled()) {
@@ -423,6 +484,10 @@ void PropagateUploadFileCommon::slotStartUpload(const QByteArray &transmissionCh
     }
 
     _fileToUpload._size = FileSystem::getSize(fullFilePath);
+    if (_uploadingEncrypted) {
+        // the encrypted file is the local file with the tag appended
+        _fileToUpload._size += OCC::Constants::e2EeTagSize;
+    }
     _item->_size = FileSystem::getSize(originalFilePath);
 
     // But skip the file if the mtime is too close to 'now'!
@@ -482,15 +547,24 @@ bool UploadDevice::open(QIODevice::OpenMode mode)
     // Get the file size now: _file.fileName() is no longer reliable
     // on all platforms after openAndSeekFileSharedRead().
     auto fileDiskSize = FileSystem::getSize(_file.fileName());
+    const auto encrypting = !_encryptionKey.isEmpty();
 
     QString openError;
-    if (!FileSystem::openAndSeekFileSharedRead(&_file, &openError, _start)) {
+    if (!FileSystem::openAndSeekFileSharedRead(&_file, &openError, encrypting ? qMin(_start, fileDiskSize) : _start)) {
         setErrorString(openError);
         return false;
     }
 
-    _size = qBound(0ll, _size, fileDiskSize - _start);
     _read = 0;
+    if (encrypting) {
+        _plainSize = fileDiskSize;
+        fileDiskSize += _encryptionTag.size();
+        if (!startEncryption()) {
+            _file.close();
+            return false;
+        }
+    }
+    _size = qBound(0ll, _size, fileDiskSize - _start);
 
     return QIODevice::open(mode);
 }
@@ -531,6 +605,10 @@ qint64 UploadDevice::readData(char *data, qint64 maxlen)
         _bandwidthQuota -= maxlen;
     }
 
+    if (!_encryptionKey.isEmpty()) {
+        return readEncryptedData(data, maxlen);
+    }
+
     auto c = _file.read(data, maxlen);
     if (c < 0) {
         setErrorString(_file.errorString());
@@ -540,6 +618,71 @@ qint64 UploadDevice::readData(char *data, qint64 maxlen)
     return c;
 }
 
+void UploadDevice::setEncryption(const QByteArray &key, const QByteArray &iv, const QByteArray &tag)
+{
+    Q_ASSERT(!isOpen());
+    _encryptionKey = key;
+    _encryptionIv = iv;
+    _encryptionTag = tag;
+}
+
+bool UploadDevice::startEncryption()
+{
+    const auto position = _start + _read;
+    _encryptor.reset();
+    _verifyEncryptionTag = position == 0;
+    if (position >= _plainSize) {
+        // only the tag is left
+        return true;
+    }
+
+    _encryptor = std::make_unique<EncryptionHelper::StreamingEncryptor>(_encryptionKey, _encryptionIv, position);
+    if (!_encryptor->isInitialized()) {
+        setErrorString(tr("Could not start the encryption of the file"));
+        return false;
+    }
+    return true;
+}
+
+qint64 UploadDevice::readEncryptedData(char *data, qint64 maxlen)
+{
+    const auto position = _start + _read;
+    if (position >= _plainSize) {
+        // the tag follows the encrypted file data
+        const auto tagPosition = position - _plainSize;
+        const auto c = qMin<qint64>(maxlen, _encryptionTag.size() - tagPosition);
+        std::memcpy(data, _encryptionTag.constData() + tagPosition, c);
+        _read += c;
+        return c;
+    }
+
+    const auto c = _file.read(data, qMin(maxlen, _plainSize - position));
+    if (c < 0) {
+        setErrorString(_file.errorString());
+        return -1;
+    }
+    if (c == 0) {
+        setErrorString(tr("Local file changed during sync."));
+        return -1;
+    }
+
+    const auto encrypted = _encryptor->chunkEncryption(data, c);
+    if (encrypted.size() != c) {
+        setErrorString(tr("Could not encrypt the file"));
+        return -1;
+    }
+    std::memcpy(data, encrypted.constData(), c);
+    _read += c;
+
+    // The tag was computed when the upload was prepared, the data uploaded
+    // must not differ from the data it was computed for
+    if (_verifyEncryptionTag && position + c == _plainSize && _encryptor->finalize() != _encryptionTag) {
+        setErrorString(tr("Local file changed during sync."));
+        return -1;
+    }
+    return c;
+}
+
 void UploadDevice::slotJobUploadProgress(qint64 sent, qint64 t)
 {
     if (sent == 0 || t == 0) {
@@ -578,6 +721,10 @@ bool UploadDevice::seek(qint64 pos)
         return false;
     }
     _read = pos;
+    if (!_encryptionKey.isEmpty()) {
+        _file.seek(qMin(_start + pos, _plainSize));
+        return startEncryption();
+    }
     _file.seek(_start + pos);
     return true;
 }
@@ -604,6 +751,17 @@ void UploadDevice::setChoked(bool b)
     }
 }
 
+std::unique_ptr<UploadDevice> PropagateUploadFileCommon::makeUploadDevice(qint64 start, qint64 size)
+{
+    auto device = std::make_unique<UploadDevice>(_fileToUpload._path, start, size, &propagator()->_bandwidthManager);
+    if (_uploadingEncrypted) {
+        device->setEncryption(_uploadEncryptedHelper->encryptionKey(),
+                              _uploadEncryptedHelper->encryptionIv(),
+                              _uploadEncryptedHelper->encryptionTag());
+    }
+    return device;
+}
+
 void PropagateUploadFileCommon::startPollJob(const QString &path)
 {
     auto *job = new PollJob(propagator()->account(), path, _item,
@@ -15,6 +15,7 @@
 
 #include "owncloudpropagator.h"
 #include "networkjobs.h"
+#include "contentchunker.h"
 
 #include <QBuffer>
 #include <QFile>
@@ -30,6 +31,10 @@ Q_DECLARE_LOGGING_CATEGORY(lcPropagateUploadNG)
 
 class BandwidthManager;
 
+namespace EncryptionHelper {
+class StreamingEncryptor;
+}
+
 /**
  * @brief The UploadDevice class
  * @ingroup libsync
@@ -52,6 +57,16 @@ public:
     [[nodiscard]] bool isSequential() const override;
     bool seek(qint64 pos) override;
 
+    /**
+     * Encrypts the file data for end to end encryption while reading it.
+     *
+     * The device then provides the encrypted file: the file data encrypted
+     * with \a key and \a iv followed by the \a tag that was computed before.
+     * The start and size passed to the constructor refer to the encrypted file.
+     * Must be called before open().
+     */
+    void setEncryption(const QByteArray &key, const QByteArray &iv, const QByteArray &tag);
+
     void setBandwidthLimited(bool);
     bool isBandwidthLimited() { return _bandwidthLimited; }
     void setChoked(bool);
@@ -61,6 +76,9 @@ public:
 signals:
 
 private:
+    bool startEncryption();
+    qint64 readEncryptedData(char *data, qint64 maxlen);
+
     /// The local file to read data from
     QFile _file;
 
@@ -71,6 +89,14 @@ private:
     /// Position between _start and _start+_size
     qint64 _read = 0;
 
+    // Encryption related, see setEncryption()
+    QByteArray _encryptionKey;
+    QByteArray _encryptionIv;
+    QByteArray _encryptionTag;
+    std::unique_ptr<EncryptionHelper::StreamingEncryptor> _encryptor;
+    qint64 _plainSize = 0; // size of the local file
+    bool _verifyEncryptionTag = false; // if the encryption started at the beginning of the file
+
     // Bandwidth manager related
     QPointer<BandwidthManager> _bandwidthManager;
     qint64 _bandwidthQuota = 0;
@@ -147,6 +173,40 @@ signals:
 
 };
 
+/**
+ * @brief Creates a chunk of a chunked upload from a range of the existing file
+ *
+ * Sends a COPY of the file at \a path with the chunk as the Destination and
+ * the range to copy in the OC-Source-Range header. The If-Match header makes
+ * sure the range is taken from the version of the file the client knows.
+ * @ingroup libsync
+ */
+class CopyRangeJob : public AbstractNetworkJob
+{
+    Q_OBJECT
+    QUrl _destination;
+    qint64 _start;
+    qint64 _size;
+    QByteArray _etag;
+
+public:
+    explicit CopyRangeJob(AccountPtr account, const QString &path, const QUrl &destination,
+        qint64 start, qint64 size, const QByteArray &etag, QObject *parent = nullptr)
+        : AbstractNetworkJob(account, path, parent)
+        , _destination(destination)
+        , _start(start)
+        , _size(size)
+        , _etag(etag)
+    {
+    }
+
+    void start() override;
+    bool finished() override;
+
+signals:
+    void finishedSignal();
+};
+
 /**
  * @brief This job implements the asynchronous PUT
  *
@@ -248,6 +308,15 @@ public:
      */
     void setDeleteExisting(bool enabled);
 
+    /**
+     * Uploads with the encryption prepared by a PropagateUploadEncryptedBatch,
+     * see PropagateUploadEncrypted::setPreparedEncryption(). Takes ownership of \a helper.
+     */
+    void setPreparedEncryption(PropagateUploadEncrypted *helper);
+
+    /// Uploads of a PropagateUploadEncryptedBatch share its folder lock and run in parallel
+    [[nodiscard]] JobParallelism parallelism() const override;
+
     /* start should setup the file, path and size that will be send to the server */
     void start() override;
     void setupEncryptedFile(const QString& path, const QString& filename, quint64 size);
@@ -316,6 +385,16 @@ protected:
 
     /** Bases headers that need to be sent on the PUT, or in the MOVE for chunking-ng */
     QMap<QByteArray, QByteArray> headers();
+
+    /**
+     * Creates the device for \a size bytes from \a start of the data to upload.
+     *
+     * End to end encrypted files are encrypted while they are read.
+     */
+    std::unique_ptr<UploadDevice> makeUploadDevice(qint64 start, qint64 size);
+
+    /// Whether the file is encrypted for end to end encryption while it is uploaded
+    [[nodiscard]] bool isUploadingEncrypted() const { return _uploadingEncrypted; }
 private:
   PropagateUploadEncrypted *_uploadEncryptedHelper = nullptr;
   bool _uploadingEncrypted = false;
@@ -397,6 +476,7 @@ private slots:
     void slotDeleteJobFinished();
     void slotMkColFinished();
     void slotPutFinished();
+    void slotCopyRangeFinished();
     void slotMoveJobFinished();
     void slotUploadProgress(qint64, qint64);
 
@@ -412,10 +492,20 @@ private:
     [[nodiscard]] QUrl chunkUrl(const int chunk) const;
     [[nodiscard]] QByteArray destinationHeader() const;
 
+    /// Computes the content chunks of the file and plans which parts to copy, then starts the upload
+    void startContentChunking();
+    void startOrResumeUpload();
     void startNewUpload();
     void startNextChunk();
+    void startCopyRange(const ContentChunker::Segment &segment);
+    /// Checks that the local file didn't change and continues with the next chunk
+    void chunkFinished();
     void finishUpload();
 
+    [[nodiscard]] bool isDeltaUploadEnabled() const;
+    /// The segment of the delta upload plan containing \a offset
+    [[nodiscard]] ContentChunker::Segments::const_iterator segmentAt(qint64 offset) const;
+
     QMap<qint64, ServerChunkInfo> _serverChunks;
 
     qint64 _sent = 0; /// amount of data (bytes) that was already sent
@@ -423,5 +513,10 @@ private:
     int _currentChunk = 1; /// Id of the next chunk that will be sent
     qint64 _currentChunkSize = 0; /// current chunk size
     bool _removeJobError = false; /// If not null, there was an error removing the job
+
+    // Delta upload, see startContentChunking()
+    ContentChunker::Chunks _contentChunks; /// of the file being uploaded, stored in the journal when done
+    qint64 _contentChunksAverageSize = 0;
+    ContentChunker::Segments _segments; /// what to copy from the previous version, empty to upload everything
 };
 }
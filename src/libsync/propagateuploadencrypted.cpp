@@ -6,13 +6,18 @@
 #include "encryptedfoldermetadatahandler.h"
 #include "filesystem.h"
 #include "account.h"
+#include "common/checksumcalculator.h"
+#include "common/checksums.h"
+#include "common/constants.h"
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QDir>
 #include <QUrl>
 #include <QFile>
 #include <QTemporaryFile>
 #include <QLoggingCategory>
 #include <QMimeDatabase>
+#include <qtconcurrentrun.h>
 
 namespace OCC {
 
@@ -30,6 +35,13 @@ PropagateUploadEncrypted::PropagateUploadEncrypted(OwncloudPropagator *propagato
 
 void PropagateUploadEncrypted::start()
 {
+    if (_isPrepared) {
+        qCDebug(lcPropagateUploadEncrypted) << "Encryption of" << _item->_file << "was prepared, starting the upload";
+        setupItem(_encryptedFolderMetadataHandler->folderMetadata());
+        emitFinalized();
+        return;
+    }
+
     /* If the file is in a encrypted folder, which we know, we wouldn't be here otherwise,
      * we need to do the long road:
      * find the ID of the folder.
@@ -48,11 +60,12 @@ void PropagateUploadEncrypted::start()
         emit error();
         return;
     }
-    _encryptedFolderMetadataHandler.reset(new EncryptedFolderMetadataHandler(_propagator->account(),
-                                                                                       _remoteParentAbsolutePath,
-                                                                                       _propagator->remotePath(),
-                                                                                       _propagator->_journal,
-                                                                                       rec.path()));
+    _encryptedFolderMetadataHandler = new EncryptedFolderMetadataHandler(_propagator->account(),
+                                                                         _remoteParentAbsolutePath,
+                                                                         _propagator->remotePath(),
+                                                                         _propagator->_journal,
+                                                                         rec.path(),
+                                                                         this);
 
     connect(_encryptedFolderMetadataHandler.data(), &EncryptedFolderMetadataHandler::fetchFinished,
         this, &PropagateUploadEncrypted::slotFetchMetadataJobFinished);
@@ -61,6 +74,11 @@ void PropagateUploadEncrypted::start()
 
 void PropagateUploadEncrypted::unlockFolder()
 {
+    if (_isPrepared) {
+        // the batch the upload belongs to unlocks the folder after all of its uploads
+        emit folderUnlocked(_encryptedFolderMetadataHandler ? _encryptedFolderMetadataHandler->folderId() : QByteArray(), 200);
+        return;
+    }
     connect(_encryptedFolderMetadataHandler.data(), &EncryptedFolderMetadataHandler::folderUnlocked, this, &PropagateUploadEncrypted::folderUnlocked);
     _encryptedFolderMetadataHandler->unlockFolder();
 }
@@ -99,12 +117,137 @@ void PropagateUploadEncrypted::slotFetchMetadataJobFinished(int statusCode, cons
     const auto metadata = _encryptedFolderMetadataHandler->folderMetadata();
 
     QFileInfo info(_propagator->fullLocalPath(_item->_file));
+    const auto encryptedFile = encryptedFileFor(*metadata, info);
+    _encryptedFile = encryptedFile;
+    setupItem(metadata);
+
+    qCDebug(lcPropagateUploadEncrypted) << "Creating the encrypted file.";
+
+    if (info.isDir()) {
+        _completeFileName = encryptedFile.encryptedFilename;
+        uploadMetadata();
+        return;
+    }
+
+    // The file is encrypted while it is uploaded, only compute the tag for the
+    // metadata and the checksum of the encrypted data now, off the main thread.
+    _completeFileName = info.absoluteFilePath();
+    auto watcher = new QFutureWatcher<EncryptionResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        const auto result = watcher->result();
+        if (result.tag.isEmpty()) {
+            qCDebug(lcPropagateUploadEncrypted()) << "There was an error encrypting the file, aborting upload.";
+            emit error();
+            return;
+        }
+
+        _encryptedFile.authenticationTag = result.tag;
+        _encryptedChecksumHeader = result.checksumHeader;
+        _encryptedModtime = result.modtime;
+        _encryptedSize = result.size + OCC::Constants::e2EeTagSize;
+        uploadMetadata();
+    });
+    watcher->setFuture(QtConcurrent::run(&PropagateUploadEncrypted::computeEncryption,
+                                         _completeFileName,
+                                         encryptedFile.encryptionKey,
+                                         encryptedFile.initializationVector,
+                                         _propagator->account()->capabilities().uploadChecksumType()));
+}
+
+void PropagateUploadEncrypted::uploadMetadata()
+{
+    const auto metadata = _encryptedFolderMetadataHandler->folderMetadata();
+
+    qCDebug(lcPropagateUploadEncrypted) << "Creating the metadata for the encrypted file.";
+
+    metadata->addEncryptedFile(_encryptedFile);
+
+    qCDebug(lcPropagateUploadEncrypted) << "Metadata created, sending to the server.";
+
+    connect(_encryptedFolderMetadataHandler.data(), &EncryptedFolderMetadataHandler::uploadFinished, this, &PropagateUploadEncrypted::slotUploadMetadataFinished);
+    _encryptedFolderMetadataHandler->uploadMetadata(EncryptedFolderMetadataHandler::UploadMode::KeepLock);
+}
+
+void PropagateUploadEncrypted::slotUploadMetadataFinished(int statusCode, const QString &message)
+{
+    if (statusCode != 200) {
+        qCDebug(lcPropagateUploadEncrypted) << "Update metadata error for folder" << _encryptedFolderMetadataHandler->folderId() << "with error" << message;
+        qCDebug(lcPropagateUploadEncrypted()) << "Unlocking the folder.";
+        emit error();
+        return;
+    }
+
+    qCDebug(lcPropagateUploadEncrypted) << "Uploading of the metadata success, Encrypting the file";
+    emitFinalized();
+}
+
+void PropagateUploadEncrypted::emitFinalized()
+{
+    QFileInfo outputInfo(_completeFileName);
+
+    qCDebug(lcPropagateUploadEncrypted) << "Encrypted Info:" << outputInfo.path() << _encryptedFile.encryptedFilename << _encryptedSize;
+    qCDebug(lcPropagateUploadEncrypted) << "Finalizing the upload part, now the actuall uploader will take over";
+    emit finalized(Utility::trailingSlashPath(outputInfo.path()) + outputInfo.fileName(),
+                   Utility::trailingSlashPath(_remoteParentPath) + _encryptedFile.encryptedFilename,
+                   _encryptedSize);
+}
+
+PropagateUploadEncrypted::EncryptionResult PropagateUploadEncrypted::computeEncryption(const QString &filePath, const QByteArray &key, const QByteArray &iv, const QByteArray &checksumType)
+{
+    EncryptionResult result;
+    result.modtime = FileSystem::getModTime(filePath);
+
+    QFile input(filePath);
+    QString openError;
+    if (!FileSystem::openAndSeekFileSharedRead(&input, &openError, 0)) {
+        qCWarning(lcPropagateUploadEncrypted) << "Could not open" << filePath << openError;
+        return result;
+    }
+
+    EncryptionHelper::StreamingEncryptor encryptor(key, iv);
+    ChecksumCalculator checksumCalculator(checksumType);
+    if (!encryptor.isInitialized()) {
+        return result;
+    }
+
+    QByteArray buffer(64 * 1024, Qt::Uninitialized);
+    while (true) {
+        const auto size = input.read(buffer.data(), buffer.size());
+        if (size < 0) {
+            qCWarning(lcPropagateUploadEncrypted) << "Could not read" << filePath << input.errorString();
+            return result;
+        }
+        if (size == 0) {
+            break;
+        }
+        const auto encrypted = encryptor.chunkEncryption(buffer.constData(), size);
+        if (encrypted.size() != size) {
+            return result;
+        }
+        if (checksumCalculator.isInitialized()) {
+            checksumCalculator.addData(encrypted.constData(), encrypted.size());
+        }
+        result.size += size;
+    }
+
+    const auto tag = encryptor.finalize();
+    if (checksumCalculator.isInitialized()) {
+        checksumCalculator.addData(tag.constData(), tag.size());
+        result.checksumHeader = makeChecksumHeader(checksumType, checksumCalculator.result());
+    }
+    result.tag = tag;
+    return result;
+}
+
+FolderMetadata::EncryptedFile PropagateUploadEncrypted::encryptedFileFor(const FolderMetadata &metadata, const QFileInfo &info)
+{
     const QString fileName = info.fileName();
 
     // Find existing metadata for this file
     bool found = false;
     FolderMetadata::EncryptedFile encryptedFile;
-    const QVector<FolderMetadata::EncryptedFile> files = metadata->files();
+    const QVector<FolderMetadata::EncryptedFile> files = metadata.files();
 
     for (const FolderMetadata::EncryptedFile &file : files) {
         if (file.originalFilename == fileName) {
@@ -130,60 +273,60 @@ void PropagateUploadEncrypted::slotFetchMetadataJobFinished(int statusCode, cons
     }
 
     encryptedFile.initializationVector = EncryptionHelper::generateRandom(16);
+    return encryptedFile;
+}
+
+void PropagateUploadEncrypted::setPreparedEncryption(EncryptedFolderMetadataHandler *handler,
+                                                     const FolderMetadata::EncryptedFile &encryptedFile,
+                                                     const EncryptionResult &result)
+{
+    Q_ASSERT(handler && handler->isFolderLocked());
+    _isPrepared = true;
+    _encryptedFolderMetadataHandler = handler;
+    _encryptedFile = encryptedFile;
+    _encryptedFile.authenticationTag = result.tag;
+    _encryptedChecksumHeader = result.checksumHeader;
+    _encryptedModtime = result.modtime;
+    _encryptedSize = result.size + OCC::Constants::e2EeTagSize;
+    _completeFileName = _propagator->fullLocalPath(_item->_file);
+}
 
-    _item->_encryptedFileName =  Utility::trailingSlashPath(_remoteParentPath) + encryptedFile.encryptedFilename;
+bool PropagateUploadEncrypted::isPrepared() const
+{
+    return _isPrepared;
+}
+
+void PropagateUploadEncrypted::setupItem(const QSharedPointer<FolderMetadata> &metadata)
+{
+    _item->setEncryptedFileName(Utility::trailingSlashPath(_remoteParentPath) + _encryptedFile.encryptedFilename);
     _item->_e2eEncryptionStatusRemote = metadata->existingMetadataEncryptionStatus();
     _item->_e2eEncryptionServerCapability =
         EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_propagator->account()->capabilities().clientSideEncryptionVersion());
+}
 
-    qCDebug(lcPropagateUploadEncrypted) << "Creating the encrypted file.";
-
-    if (info.isDir()) {
-        _completeFileName = encryptedFile.encryptedFilename;
-    } else {
-        QFile input(info.absoluteFilePath());
-        QFile output(QDir::tempPath() + QDir::separator() + encryptedFile.encryptedFilename);
-
-        QByteArray tag;
-        bool encryptionResult = EncryptionHelper::fileEncryption(encryptedFile.encryptionKey, encryptedFile.initializationVector, &input, &output, tag);
-
-        if (!encryptionResult) {
-            qCDebug(lcPropagateUploadEncrypted()) << "There was an error encrypting the file, aborting upload.";
-            emit error();
-            return;
-        }
-
-        encryptedFile.authenticationTag = tag;
-        _completeFileName = output.fileName();
-    }
-
-    qCDebug(lcPropagateUploadEncrypted) << "Creating the metadata for the encrypted file.";
-
-    metadata->addEncryptedFile(encryptedFile);
-
-    qCDebug(lcPropagateUploadEncrypted) << "Metadata created, sending to the server.";
+QByteArray PropagateUploadEncrypted::encryptionKey() const
+{
+    return _encryptedFile.encryptionKey;
+}
 
-    connect(_encryptedFolderMetadataHandler.data(), &EncryptedFolderMetadataHandler::uploadFinished, this, &PropagateUploadEncrypted::slotUploadMetadataFinished);
-    _encryptedFolderMetadataHandler->uploadMetadata(EncryptedFolderMetadataHandler::UploadMode::KeepLock);
+QByteArray PropagateUploadEncrypted::encryptionIv() const
+{
+    return _encryptedFile.initializationVector;
 }
 
-void PropagateUploadEncrypted::slotUploadMetadataFinished(int statusCode, const QString &message)
+QByteArray PropagateUploadEncrypted::encryptionTag() const
 {
-    if (statusCode != 200) {
-        qCDebug(lcPropagateUploadEncrypted) << "Update metadata error for folder" << _encryptedFolderMetadataHandler->folderId() << "with error" << message;
-        qCDebug(lcPropagateUploadEncrypted()) << "Unlocking the folder.";
-        emit error();
-        return;
-    }
+    return _encryptedFile.authenticationTag;
+}
 
-    qCDebug(lcPropagateUploadEncrypted) << "Uploading of the metadata success, Encrypting the file";
-    QFileInfo outputInfo(_completeFileName);
+QByteArray PropagateUploadEncrypted::encryptedChecksumHeader() const
+{
+    return _encryptedChecksumHeader;
+}
 
-    qCDebug(lcPropagateUploadEncrypted) << "Encrypted Info:" << outputInfo.path() << outputInfo.fileName() << outputInfo.size();
-    qCDebug(lcPropagateUploadEncrypted) << "Finalizing the upload part, now the actuall uploader will take over";
-    emit finalized(Utility::trailingSlashPath(outputInfo.path()) + outputInfo.fileName(),
-                   Utility::trailingSlashPath(_remoteParentPath) + outputInfo.fileName(),
-                   FileSystem::getSize(_completeFileName));
+time_t PropagateUploadEncrypted::encryptedModtime() const
+{
+    return _encryptedModtime;
 }
 
 } // namespace OCC
\ No newline at end of file
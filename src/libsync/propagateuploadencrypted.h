@@ -9,10 +9,13 @@
 #include <QNetworkReply>
 #include <QScopedPointer>
 #include <QFile>
+#include <QFileInfo>
 #include <QTemporaryFile>
+#include <QPointer>
 
 #include "owncloudpropagator.h"
 #include "clientsideencryption.h"
+#include "foldermetadata.h"
 
 namespace OCC {
 
@@ -21,6 +24,10 @@ namespace OCC {
  * client starts the upload request we don't know if the folder is
  * encrypted on the server.
  *
+ * The file is not written encrypted to disk: only its e2EeTag and the checksum
+ * of the encrypted data are computed in advance, as the metadata containing the
+ * tag is uploaded before the file. The upload encrypts the data while sending it.
+ *
  * emits:
  * finalized() if the encrypted file is ready to be uploaded
  * error() if there was an error with the encryption
@@ -34,9 +41,34 @@ class PropagateUploadEncrypted : public QObject
 {
   Q_OBJECT
 public:
+    /// The tag and the checksum of a file encrypted by computeEncryption()
+    struct EncryptionResult
+    {
+        QByteArray tag; // empty on errors
+        QByteArray checksumHeader; // of the encrypted data including the tag
+        time_t modtime = 0; // of the file before it was read
+        qint64 size = 0; // of the unencrypted data
+    };
+
     PropagateUploadEncrypted(OwncloudPropagator *propagator, const QString &remoteParentPath, SyncFileItemPtr item, QObject *parent = nullptr);
     ~PropagateUploadEncrypted() override = default;
 
+    /// Encrypts the file without storing the result, for the tag and the checksum of the encrypted data
+    static EncryptionResult computeEncryption(const QString &filePath, const QByteArray &key, const QByteArray &iv, const QByteArray &checksumType);
+
+    /// The metadata entry to upload the local file \a info with, an existing one of the same name is reused
+    static FolderMetadata::EncryptedFile encryptedFileFor(const FolderMetadata &metadata, const QFileInfo &info);
+
+    /**
+     * Uploads with the encryption prepared by a PropagateUploadEncryptedBatch.
+     *
+     * The batch locked the folder with \a handler and already stored the metadata
+     * of \a encryptedFile, so start() emits finalized() right away and unlockFolder()
+     * leaves unlocking the folder to the batch.
+     */
+    void setPreparedEncryption(EncryptedFolderMetadataHandler *handler, const FolderMetadata::EncryptedFile &encryptedFile, const EncryptionResult &result);
+    [[nodiscard]] bool isPrepared() const;
+
     void start();
 
     void unlockFolder();
@@ -45,10 +77,22 @@ public:
     [[nodiscard]] bool isFolderLocked() const;
     [[nodiscard]] const QByteArray folderToken() const;
 
+    // The encryption of the file, available once finalized() was emitted
+    [[nodiscard]] QByteArray encryptionKey() const;
+    [[nodiscard]] QByteArray encryptionIv() const;
+    [[nodiscard]] QByteArray encryptionTag() const;
+    [[nodiscard]] QByteArray encryptedChecksumHeader() const;
+    [[nodiscard]] time_t encryptedModtime() const;
+
 private slots:
     void slotFetchMetadataJobFinished(int statusCode, const QString &message);
     void slotUploadMetadataFinished(int statusCode, const QString &message);
 
+private:
+    void setupItem(const QSharedPointer<FolderMetadata> &metadata);
+    void uploadMetadata();
+    void emitFinalized();
+
 signals:
     // Emitted after the file is encrypted and everything is setup.
     void finalized(const QString& path, const QString& filename, quint64 size);
@@ -68,10 +112,15 @@ private:
 
   QByteArray _generatedKey;
   QByteArray _generatedIv;
+  FolderMetadata::EncryptedFile _encryptedFile;
+  QByteArray _encryptedChecksumHeader;
+  time_t _encryptedModtime = 0;
+  qint64 _encryptedSize = 0;
   QString _completeFileName;
   QString _remoteParentAbsolutePath;
 
-  QScopedPointer<EncryptedFolderMetadataHandler> _encryptedFolderMetadataHandler;
+  QPointer<EncryptedFolderMetadataHandler> _encryptedFolderMetadataHandler;
+  bool _isPrepared = false;
 };
 
 
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "propagateuploadencryptedbatch.h"
+#include "propagateupload.h"
+#include "encryptedfoldermetadatahandler.h"
+#include "foldermetadata.h"
+#include "account.h"
+#include "common/syncjournaldb.h"
+#include "common/utility.h"
+
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <qtconcurrentrun.h>
+
+namespace OCC {
+
+Q_LOGGING_CATEGORY(lcPropagateUploadEncryptedBatch, "nextcloud.sync.propagator.upload.encrypted.batch", QtInfoMsg)
+
+PropagateUploadEncryptedBatch::PropagateUploadEncryptedBatch(OwncloudPropagator *propagator, const QString &folder)
+    : PropagatorJob(propagator)
+    , _folder(folder)
+    , _uploadJobs(propagator)
+    , _fallbackJobs(propagator)
+{
+    connect(&_uploadJobs, &PropagatorJob::finished, this, &PropagateUploadEncryptedBatch::slotUploadJobsFinished);
+    connect(&_fallbackJobs, &PropagatorJob::finished, this, &PropagateUploadEncryptedBatch::slotFallbackJobsFinished);
+}
+
+PropagateUploadEncryptedBatch::~PropagateUploadEncryptedBatch() = default;
+
+void PropagateUploadEncryptedBatch::appendItem(const SyncFileItemPtr &item)
+{
+    _items.append(item);
+}
+
+bool PropagateUploadEncryptedBatch::isFull() const
+{
+    return _items.size() >= batchSize;
+}
+
+bool PropagateUploadEncryptedBatch::scheduleSelfOrChild()
+{
+    if (_state == Finished) {
+        return false;
+    }
+
+    if (_state == NotYetStarted) {
+        _state = Running;
+        qCInfo(lcPropagateUploadEncryptedBatch) << "Starting encrypted upload of" << _items.size() << "files into" << _folder << "by" << this;
+        QMetaObject::invokeMethod(this, &PropagateUploadEncryptedBatch::start, Qt::QueuedConnection);
+        return true;
+    }
+
+    if (_uploading) {
+        return _uploadJobs.scheduleSelfOrChild();
+    }
+    if (_fallingBack) {
+        return _fallbackJobs.scheduleSelfOrChild();
+    }
+    return false;
+}
+
+PropagatorJob::JobParallelism PropagateUploadEncryptedBatch::parallelism() const
+{
+    // like every job locking an encrypted folder
+    return WaitForFinished;
+}
+
+void PropagateUploadEncryptedBatch::abort(PropagatorJob::AbortType abortType)
+{
+    // A folder left locked is unlocked by the next sync, its token is kept in the journal
+    auto &jobs = _fallingBack ? _fallbackJobs : _uploadJobs;
+    if (abortType == AbortType::Asynchronous) {
+        connect(&jobs, &PropagatorCompositeJob::abortFinished, this, &PropagateUploadEncryptedBatch::abortFinished);
+    }
+    jobs.abort(abortType);
+}
+
+void PropagateUploadEncryptedBatch::start()
+{
+    if (propagator()->_abortRequested) {
+        finishAborted();
+        return;
+    }
+
+    SyncJournalFileRecord parentRec;
+    if (!propagator()->_journal->getFileRecord(_folder, &parentRec) || !parentRec.isValid()) {
+        _fallbackItems = _items;
+        startFallback();
+        return;
+    }
+    _remoteParentPath = parentRec._e2eMangledName.isEmpty() ? _folder : parentRec._e2eMangledName;
+
+    const auto rootPath = Utility::trailingSlashPath(Utility::noLeadingSlashPath(propagator()->remotePath()));
+    const auto remoteParentAbsolutePath = Utility::noTrailingSlashPath(rootPath + Utility::noLeadingSlashPath(_remoteParentPath));
+
+    SyncJournalFileRecord rootRec;
+    if (!propagator()->_journal->getRootE2eFolderRecord(Utility::fullRemotePathToRemoteSyncRootRelative(remoteParentAbsolutePath, propagator()->remotePath()), &rootRec)
+        || !rootRec.isValid()) {
+        _fallbackItems = _items;
+        startFallback();
+        return;
+    }
+
+    _metadataHandler = new EncryptedFolderMetadataHandler(propagator()->account(),
+                                                          remoteParentAbsolutePath,
+                                                          propagator()->remotePath(),
+                                                          propagator()->_journal,
+                                                          rootRec.path(),
+                                                          this);
+    connect(_metadataHandler.data(), &EncryptedFolderMetadataHandler::fetchFinished, this, &PropagateUploadEncryptedBatch::slotMetadataFetched);
+    _metadataHandler->fetchMetadata(EncryptedFolderMetadataHandler::FetchMode::AllowEmptyMetadata);
+}
+
+void PropagateUploadEncryptedBatch::slotMetadataFetched(int statusCode, const QString &message)
+{
+    if (propagator()->_abortRequested) {
+        finishAborted();
+        return;
+    }
+
+    if (!_preparedFiles.empty()) {
+        // the handler reports a failure to lock the folder for storing the metadata this way
+        slotMetadataUploaded(statusCode, message);
+        return;
+    }
+
+    const auto metadata = _metadataHandler->folderMetadata();
+    if (statusCode != 200 || !metadata || !metadata->isValid()) {
+        qCWarning(lcPropagateUploadEncryptedBatch) << "Could not fetch the metadata of" << _folder << statusCode << message;
+        _fallbackItems = _items;
+        startFallback();
+        return;
+    }
+
+    // Compute the tags of all files, the metadata can only be stored with them
+    const auto checksumType = propagator()->account()->capabilities().uploadChecksumType();
+    _preparedFiles.resize(_items.size());
+    for (int i = 0; i < _items.size(); ++i) {
+        auto &prepared = _preparedFiles[i];
+        prepared.item = _items.at(i);
+        const QFileInfo info(propagator()->fullLocalPath(prepared.item->_file));
+        prepared.encryptedFile = PropagateUploadEncrypted::encryptedFileFor(*metadata, info);
+
+        auto watcher = new QFutureWatcher<PropagateUploadEncrypted::EncryptionResult>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, i] {
+            watcher->deleteLater();
+            _preparedFiles[i].result = watcher->result();
+            if (--_runningPreparations == 0) {
+                filesPrepared();
+            }
+        });
+        ++_runningPreparations;
+        watcher->setFuture(QtConcurrent::run(&PropagateUploadEncrypted::computeEncryption,
+                                             info.absoluteFilePath(),
+                                             prepared.encryptedFile.encryptionKey,
+                                             prepared.encryptedFile.initializationVector,
+                                             checksumType));
+    }
+}
+
+void PropagateUploadEncryptedBatch::filesPrepared()
+{
+    if (propagator()->_abortRequested) {
+        finishAborted();
+        return;
+    }
+
+    const auto metadata = _metadataHandler->folderMetadata();
+    auto preparedCount = 0;
+    for (auto &prepared : _preparedFiles) {
+        if (prepared.result.tag.isEmpty()) {
+            qCWarning(lcPropagateUploadEncryptedBatch) << "Could not encrypt" << prepared.item->_file << ", uploading it on its own";
+            _fallbackItems.append(prepared.item);
+            continue;
+        }
+        prepared.encryptedFile.authenticationTag = prepared.result.tag;
+        metadata->addEncryptedFile(prepared.encryptedFile);
+        ++preparedCount;
+    }
+
+    if (preparedCount == 0) {
+        startFallback();
+        return;
+    }
+
+    qCInfo(lcPropagateUploadEncryptedBatch) << "Storing the metadata of" << preparedCount << "files in" << _folder;
+    connect(_metadataHandler.data(), &EncryptedFolderMetadataHandler::uploadFinished, this, &PropagateUploadEncryptedBatch::slotMetadataUploaded);
+    _metadataHandler->uploadMetadata(EncryptedFolderMetadataHandler::UploadMode::KeepLock);
+}
+
+void PropagateUploadEncryptedBatch::slotMetadataUploaded(int statusCode, const QString &message)
+{
+    disconnect(_metadataHandler.data(), &EncryptedFolderMetadataHandler::uploadFinished, this, &PropagateUploadEncryptedBatch::slotMetadataUploaded);
+
+    if (propagator()->_abortRequested) {
+        finishAborted();
+        return;
+    }
+
+    if (statusCode != 200) {
+        qCWarning(lcPropagateUploadEncryptedBatch) << "Could not store the metadata of" << _folder << statusCode << message;
+        _fallbackItems = _items;
+        if (_metadataHandler->isFolderLocked()) {
+            unlockFolder();
+        } else {
+            startFallback();
+        }
+        return;
+    }
+
+    for (const auto &prepared : _preparedFiles) {
+        if (prepared.result.tag.isEmpty()) {
+            continue;
+        }
+        const auto job = propagator()->createJob(prepared.item);
+        const auto uploadJob = qobject_cast<PropagateUploadFileCommon *>(job);
+        if (!uploadJob) {
+            delete job;
+            _fallbackItems.append(prepared.item);
+            continue;
+        }
+        const auto helper = new PropagateUploadEncrypted(propagator(), _remoteParentPath, prepared.item, uploadJob);
+        helper->setPreparedEncryption(_metadataHandler, prepared.encryptedFile, prepared.result);
+        uploadJob->setPreparedEncryption(helper);
+        _uploadJobs.appendJob(uploadJob);
+    }
+
+    _uploading = true;
+    propagator()->scheduleNextJob();
+}
+
+void PropagateUploadEncryptedBatch::slotUploadJobsFinished(SyncFileItem::Status status)
+{
+    if (status != SyncFileItem::Success && status != SyncFileItem::NoStatus) {
+        _status = status;
+    }
+    _uploading = false;
+    unlockFolder();
+}
+
+void PropagateUploadEncryptedBatch::unlockFolder()
+{
+    connect(_metadataHandler.data(), &EncryptedFolderMetadataHandler::folderUnlocked, this, &PropagateUploadEncryptedBatch::slotFolderUnlocked);
+    _metadataHandler->unlockFolder();
+}
+
+void PropagateUploadEncryptedBatch::slotFolderUnlocked(const QByteArray &folderId, int httpStatus)
+{
+    disconnect(_metadataHandler.data(), &EncryptedFolderMetadataHandler::folderUnlocked, this, &PropagateUploadEncryptedBatch::slotFolderUnlocked);
+    if (httpStatus != 200) {
+        // the uploads are complete, the lock expires or is released by the next sync
+        qCWarning(lcPropagateUploadEncryptedBatch) << "Failed to unlock encrypted folder" << folderId << httpStatus;
+    }
+
+    if (propagator()->_abortRequested) {
+        if (_status == SyncFileItem::NoStatus) {
+            _status = SyncFileItem::NormalError;
+        }
+        finalize();
+        return;
+    }
+    startFallback();
+}
+
+void PropagateUploadEncryptedBatch::finishAborted()
+{
+    // The propagator schedules no more jobs after an abort, so nothing is uploaded
+    // anymore. The batch still has to finish, after releasing a lock it holds.
+    _fallbackItems.clear();
+    _status = SyncFileItem::NormalError;
+    if (_metadataHandler && _metadataHandler->isFolderLocked()) {
+        unlockFolder();
+        return;
+    }
+    finalize();
+}
+
+void PropagateUploadEncryptedBatch::startFallback()
+{
+    for (const auto &item : qAsConst(_fallbackItems)) {
+        _fallbackJobs.appendTask(item);
+    }
+    _fallbackItems.clear();
+    _fallingBack = true;
+    propagator()->scheduleNextJob();
+}
+
+void PropagateUploadEncryptedBatch::slotFallbackJobsFinished(SyncFileItem::Status status)
+{
+    if (status != SyncFileItem::Success && status != SyncFileItem::NoStatus) {
+        _status = status;
+    }
+    finalize();
+}
+
+void PropagateUploadEncryptedBatch::finalize()
+{
+    if (_state == Finished) {
+        return;
+    }
+
+    _state = Finished;
+    qCInfo(lcPropagateUploadEncryptedBatch) << "Encrypted upload into" << _folder << "finished, status" << _status;
+    emit finished(_status == SyncFileItem::NoStatus ? SyncFileItem::Success : _status);
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudpropagator.h"
+#include "propagateuploadencrypted.h"
+
+#include <QLoggingCategory>
+#include <QPointer>
+
+#include <vector>
+
+namespace OCC {
+
+Q_DECLARE_LOGGING_CATEGORY(lcPropagateUploadEncryptedBatch)
+
+class EncryptedFolderMetadataHandler;
+
+/**
+ * @brief Uploads many new files into one end to end encrypted folder with a single lock
+ *
+ * Uploading a file on its own locks the folder, stores the metadata with
+ * the new file, uploads the file and unlocks the folder again, which makes
+ * all uploads into the folder wait for each other.
+ *
+ * The batch fetches the metadata once and computes the tags of all its files
+ * in worker threads. The metadata of all of them is then stored with one
+ * lock, the uploads run in parallel while the folder stays locked and the
+ * folder is unlocked once they are all done.
+ *
+ * Files that could not be prepared, or all of them if the metadata could not
+ * be stored, are uploaded on their own afterwards.
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT PropagateUploadEncryptedBatch : public PropagatorJob
+{
+    Q_OBJECT
+
+public:
+    explicit PropagateUploadEncryptedBatch(OwncloudPropagator *propagator, const QString &folder);
+    ~PropagateUploadEncryptedBatch() override;
+
+    // The folder lock expires on the server, very large copies are split into several batches
+    static constexpr int batchSize = 500;
+
+    void appendItem(const SyncFileItemPtr &item);
+    /// Whether no more items should be added to this batch
+    [[nodiscard]] bool isFull() const;
+
+    bool scheduleSelfOrChild() override;
+    [[nodiscard]] JobParallelism parallelism() const override;
+    void abort(PropagatorJob::AbortType abortType) override;
+
+private slots:
+    void slotMetadataFetched(int statusCode, const QString &message);
+    void slotMetadataUploaded(int statusCode, const QString &message);
+    void slotUploadJobsFinished(OCC::SyncFileItem::Status status);
+    void slotFolderUnlocked(const QByteArray &folderId, int httpStatus);
+    void slotFallbackJobsFinished(OCC::SyncFileItem::Status status);
+
+private:
+    struct PreparedFile
+    {
+        SyncFileItemPtr item;
+        FolderMetadata::EncryptedFile encryptedFile;
+        PropagateUploadEncrypted::EncryptionResult result;
+    };
+
+    void start();
+    void filesPrepared();
+    void unlockFolder();
+    /// Finishes the batch after the sync was aborted
+    void finishAborted();
+    void startFallback();
+    void finalize();
+
+    QString _folder; // relative to the sync root
+    QString _remoteParentPath; // _folder with mangled names
+    SyncFileItemVector _items;
+
+    QPointer<EncryptedFolderMetadataHandler> _metadataHandler;
+    std::vector<PreparedFile> _preparedFiles;
+    int _runningPreparations = 0;
+    SyncFileItemVector _fallbackItems;
+
+    PropagatorCompositeJob _uploadJobs;
+    PropagatorCompositeJob _fallbackJobs;
+    bool _uploading = false;
+    bool _fallingBack = false;
+    SyncFileItem::Status _status = SyncFileItem::NoStatus;
+};
+
+}
@@ -29,13 +29,18 @@
 
 #include <QNetworkAccessManager>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QDir>
+#include <qtconcurrentrun.h>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <numeric>
 
 namespace OCC {
 
 constexpr auto relativeUploadsPath = "remote.php/dav/uploads/";
+constexpr auto maxChunkCount = 10000; // Chunk V2: max num of chunks
 
 QUrl PropagateUploadFileNG::chunkUploadFolderUrl() const
 {
@@ -58,6 +63,11 @@ QUrl PropagateUploadFileNG::chunkUrl(const int chunk) const
   State machine:
 
      *----> doStartUpload()
+              |
+              +-- delta upload? --> startContentChunking() (computes the chunks in a thread)
+              |                           |
+              v                           v
+            startOrResumeUpload()  <------+
             Check the db: is there an entry?
               /               \
              no                yes
@@ -76,7 +86,7 @@ QUrl PropagateUploadFileNG::chunkUrl(const int chunk) const
     |
     +---->  startNextChunk()  ---finished?  --+
                   ^               |          |
-                  +---------------+          |
+                  +- PUT or COPY -+          |
                                              |
     +----------------------------------------+
     |
@@ -93,10 +103,84 @@ QByteArray PropagateUploadFileNG::destinationHeader() const
     return destination.toUtf8();
 }
 
+bool PropagateUploadFileNG::isDeltaUploadEnabled() const
+{
+    // The chunks describe the plain data, encrypted uploads always differ completely
+    return propagator()->syncOptions()._deltaUpload
+        && propagator()->account()->capabilities().chunkingCopyRange()
+        && !isUploadingEncrypted()
+        && _fileToUpload._size >= 2 * propagator()->syncOptions().minChunkSize();
+}
+
+ContentChunker::Segments::const_iterator PropagateUploadFileNG::segmentAt(qint64 offset) const
+{
+    return std::find_if(_segments.cbegin(), _segments.cend(), [offset](const ContentChunker::Segment &segment) {
+        return segment.offset + segment.size > offset;
+    });
+}
+
 void PropagateUploadFileNG::doStartUpload()
 {
     propagator()->_activeJobList.append(this);
 
+    if (isDeltaUploadEnabled()) {
+        startContentChunking();
+        return;
+    }
+    startOrResumeUpload();
+}
+
+void PropagateUploadFileNG::startContentChunking()
+{
+    // The chunks of the previous version are only of use if that's still the version on the server
+    const auto previous = propagator()->_journal->getContentChunks(_item->_file);
+    const auto previousIsOnServer = previous._valid && _item->_instruction == CSYNC_INSTRUCTION_SYNC
+        && !_item->_etag.isEmpty() && previous._etag == _item->_etag && !_deleteExisting;
+    const auto previousChunks = previousIsOnServer ? ContentChunker::deserialize(previous._chunks) : ContentChunker::Chunks();
+
+    // Keep the average of the earlier versions, chunks of different averages don't match
+    _contentChunksAverageSize = previous._valid && previous._averageSize > 0 ? previous._averageSize : ContentChunker::averageChunkSize(_fileToUpload._size);
+
+    struct ChunkingResult
+    {
+        ContentChunker::Chunks chunks; // empty on errors
+        ContentChunker::Segments segments;
+    };
+    auto watcher = new QFutureWatcher<ChunkingResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        if (propagator()->_abortRequested) {
+            return;
+        }
+        const auto result = watcher->result();
+        _contentChunks = result.chunks;
+        _segments = result.segments;
+        if (!_segments.isEmpty()) {
+            const auto copied = std::accumulate(_segments.cbegin(), _segments.cend(), qint64(0), [](qint64 sum, const ContentChunker::Segment &segment) {
+                return segment.isCopy() ? sum + segment.size : sum;
+            });
+            qCInfo(lcPropagateUploadNG) << "Delta upload of" << _item->_file << ":" << copied << "of" << _fileToUpload._size
+                                        << "bytes are copied on the server in" << _segments.size() << "segments";
+        }
+        startOrResumeUpload();
+    });
+    watcher->setFuture(QtConcurrent::run([filePath = _fileToUpload._path, averageSize = _contentChunksAverageSize, previousChunks,
+                                             minSegmentSize = propagator()->syncOptions().minChunkSize()] {
+        ChunkingResult result;
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly) || !ContentChunker::computeChunks(&file, averageSize, &result.chunks)) {
+            qCWarning(lcPropagateUploadNG) << "Could not compute the content chunks of" << filePath << file.errorString();
+            return ChunkingResult();
+        }
+        if (!previousChunks.isEmpty()) {
+            result.segments = ContentChunker::planSegments(previousChunks, result.chunks, minSegmentSize, maxChunkCount);
+        }
+        return result;
+    }));
+}
+
+void PropagateUploadFileNG::startOrResumeUpload()
+{
     const SyncJournalDb::UploadInfo progressInfo = propagator()->_journal->getUploadInfo(_item->_file);
     Q_ASSERT(_item->_modtime > 0);
     if (_item->_modtime <= 0) {
@@ -177,6 +261,12 @@ void PropagateUploadFileNG::slotPropfindFinished()
 
     qCInfo(lcPropagateUploadNG) << "Resuming " << _item->_file << " from chunk " << _currentChunk << "; sent =" << _sent;
 
+    if (const auto segment = segmentAt(_sent); segment != _segments.cend() && segment->isCopy() && segment->offset != _sent) {
+        // The chunks on the server don't end where a copy starts, upload the rest
+        qCInfo(lcPropagateUploadNG) << "Resuming in the middle of a copied segment, uploading the rest of" << _item->_file;
+        _segments.clear();
+    }
+
     if (!_serverChunks.isEmpty()) {
         qCInfo(lcPropagateUploadNG) << "To Delete" << _serverChunks.keys();
         propagator()->_activeJobList.append(this);
@@ -330,7 +420,7 @@ void PropagateUploadFileNG::finishUpload()
     headers[QByteArrayLiteral("OC-Total-Length")] = QByteArray::number(fileSize);
     if (_item->_lockOwnerType == SyncFileItem::LockOwnerType::TokenLock &&
         _item->_locked == SyncFileItem::LockStatus::LockedItem) {
-        headers[QByteArrayLiteral("If")] = (QLatin1String("<") + propagator()->account()->davUrl().toString() + _fileToUpload._file + "> (<opaquelocktoken:" + _item->_lockToken.toUtf8() + ">)").toUtf8();
+        headers[QByteArrayLiteral("If")] = (QLatin1String("<") + propagator()->account()->davUrl().toString() + _fileToUpload._file + "> (<opaquelocktoken:" + _item->lockToken().toUtf8() + ">)").toUtf8();
     }
 
     const auto job = new MoveJob(propagator()->account(), Utility::concatUrlPath(chunkUploadFolderUrl(), "/.file"), destination, headers, this);
@@ -358,8 +448,22 @@ void PropagateUploadFileNG::startNextChunk()
         return;
     }
 
+    if (const auto segment = segmentAt(_sent); segment != _segments.cend()) {
+        if (segment->isCopy()) {
+            startCopyRange(*segment);
+            return;
+        }
+        // Chunks of an uploaded segment must not leave a rest too small for a chunk of its own
+        const auto minChunkSize = propagator()->syncOptions().minChunkSize();
+        const auto segmentRest = segment->offset + segment->size - _sent;
+        _currentChunkSize = qMin(qMax(propagator()->_chunkSize, minChunkSize), segmentRest);
+        if (segmentRest - _currentChunkSize < minChunkSize) {
+            _currentChunkSize = segmentRest;
+        }
+    }
+
     const auto fileName = _fileToUpload._path;
-    auto device = std::make_unique<UploadDevice>(fileName, _sent, _currentChunkSize, &propagator()->_bandwidthManager);
+    auto device = makeUploadDevice(_sent, _currentChunkSize);
     if (!device->open(QIODevice::ReadOnly)) {
         qCWarning(lcPropagateUploadNG) << "Could not prepare upload device: " << device->errorString();
 
@@ -395,6 +499,62 @@ void PropagateUploadFileNG::startNextChunk()
     _currentChunk++;
 }
 
+void PropagateUploadFileNG::startCopyRange(const ContentChunker::Segment &segment)
+{
+    ASSERT(segment.isCopy());
+    _currentChunkSize = segment.offset + segment.size - _sent;
+    const auto sourceOffset = segment.sourceOffset + _sent - segment.offset;
+
+    _sent += _currentChunkSize;
+    const auto job = new CopyRangeJob(propagator()->account(), propagator()->fullRemotePath(_fileToUpload._file), chunkUrl(_currentChunk),
+                                      sourceOffset, _currentChunkSize, _item->_etag, this);
+    _jobs.append(job);
+    connect(job, &CopyRangeJob::finishedSignal, this, &PropagateUploadFileNG::slotCopyRangeFinished);
+    connect(job, &QObject::destroyed, this, &PropagateUploadFileCommon::slotJobDestroyed);
+    job->start();
+    propagator()->_activeJobList.append(this);
+    _currentChunk++;
+}
+
+void PropagateUploadFileNG::slotCopyRangeFinished()
+{
+    auto *job = qobject_cast<CopyRangeJob *>(sender());
+    ASSERT(job);
+
+    slotJobDestroyed(job); // remove it from the _jobs list
+
+    propagator()->_activeJobList.removeOne(this);
+
+    if (_finished) {
+        // We have sent the finished signal already. We don't need to handle any remaining jobs
+        return;
+    }
+
+    const auto err = job->reply()->error();
+    if (err != QNetworkReply::NoError) {
+        const auto httpStatus = job->reply()->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (httpStatus == 400 || httpStatus == 405 || httpStatus == 412 || httpStatus == 416 || httpStatus == 501) {
+            // The server can't copy from the file (any more), start over and upload everything
+            qCWarning(lcPropagateUploadNG) << "Copying a range of" << _item->_file << "failed with status" << httpStatus
+                                           << "- uploading the whole file";
+            _segments.clear();
+            // Fire and forget. Any error will be ignored.
+            (new DeleteJob(propagator()->account(), chunkUploadFolderUrl(), this))->start();
+            propagator()->_activeJobList.append(this);
+            startNewUpload();
+            return;
+        }
+
+        _item->_httpErrorCode = httpStatus;
+        _item->_requestId = job->requestId();
+        commonErrorHandling(job);
+        return;
+    }
+
+    propagator()->reportProgress(*_item, _sent);
+    chunkFinished();
+}
+
 void PropagateUploadFileNG::slotPutFinished()
 {
     auto *job = qobject_cast<PUTFileJob *>(sender());
@@ -416,8 +576,7 @@ void PropagateUploadFileNG::slotPutFinished()
         _item->_requestId = job->requestId();
         commonErrorHandling(job);
         const auto exceptionParsed = getExceptionFromReply(job->reply());
-        _item->_errorExceptionName = exceptionParsed.first;
-        _item->_errorExceptionMessage = exceptionParsed.second;
+        _item->setErrorException(exceptionParsed.first, exceptionParsed.second);
         return;
     }
 
@@ -449,6 +608,11 @@ void PropagateUploadFileNG::slotPutFinished()
                                   << propagator()->_chunkSize << "bytes";
     }
 
+    chunkFinished();
+}
+
+void PropagateUploadFileNG::chunkFinished()
+{
     _finished = _sent == _item->_size;
 
     // Check if the file still exists
@@ -504,8 +668,7 @@ void PropagateUploadFileNG::slotMoveJobFinished()
     if (err != QNetworkReply::NoError) {
         commonErrorHandling(job);
         const auto exceptionParsed = getExceptionFromReply(job->reply());
-        _item->_errorExceptionName = exceptionParsed.first;
-        _item->_errorExceptionMessage = exceptionParsed.second;
+        _item->setErrorException(exceptionParsed.first, exceptionParsed.second);
         return;
     }
 
@@ -551,6 +714,15 @@ void PropagateUploadFileNG::slotMoveJobFinished()
         abortWithError(SyncFileItem::NormalError, tr("Missing ETag from server"));
         return;
     }
+
+    if (!_contentChunks.isEmpty()) {
+        SyncJournalDb::ContentChunksInfo contentChunks;
+        contentChunks._etag = _item->_etag;
+        contentChunks._averageSize = _contentChunksAverageSize;
+        contentChunks._chunks = ContentChunker::serialize(_contentChunks);
+        contentChunks._valid = true;
+        propagator()->_journal->setContentChunks(_item->_file, contentChunks);
+    }
     finalize();
 }
 
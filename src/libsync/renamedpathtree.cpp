@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#include "renamedpathtree.h"
+
+namespace OCC {
+
+RenamedPathTree::RenamedPathTree()
+{
+    clear();
+}
+
+void RenamedPathTree::clear()
+{
+    _nodes.clear();
+    _nodes.emplace_back();
+    _children.clear();
+    _renamedCount = 0;
+}
+
+int RenamedPathTree::findChild(int parent, QStringView name) const
+{
+    const auto key = qMakePair(parent, qHash(name));
+    for (auto it = _children.constFind(key); it != _children.cend() && it.key() == key; ++it) {
+        if (_nodes[*it].name == name) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+void RenamedPathTree::insert(const QString &original, const QString &target)
+{
+    const QStringView path(original);
+    int node = 0;
+    qsizetype start = 0;
+    while (true) {
+        const auto slash = original.indexOf(QLatin1Char('/'), start);
+        const auto name = path.mid(start, slash < 0 ? -1 : slash - start);
+        auto child = findChild(node, name);
+        if (child < 0) {
+            child = static_cast<int>(_nodes.size());
+            _nodes.push_back(Node{name.toString(), {}, false});
+            _children.insert(qMakePair(node, qHash(name)), child);
+        }
+        node = child;
+        if (slash < 0) {
+            break;
+        }
+        start = slash + 1;
+    }
+
+    auto &entry = _nodes[node];
+    if (!entry.isRenamed) {
+        entry.isRenamed = true;
+        ++_renamedCount;
+    }
+    entry.target = target;
+}
+
+bool RenamedPathTree::contains(const QString &original) const
+{
+    const QStringView path(original);
+    int node = 0;
+    qsizetype start = 0;
+    while (true) {
+        const auto slash = original.indexOf(QLatin1Char('/'), start);
+        node = findChild(node, path.mid(start, slash < 0 ? -1 : slash - start));
+        if (node < 0) {
+            return false;
+        }
+        if (slash < 0) {
+            return _nodes[node].isRenamed;
+        }
+        start = slash + 1;
+    }
+}
+
+QString RenamedPathTree::adjustedPath(const QString &original) const
+{
+    if (_renamedCount == 0) {
+        return original;
+    }
+
+    const QStringView path(original);
+    const QString *deepestTarget = nullptr;
+    qsizetype deepestEnd = -1;
+    int node = 0;
+    qsizetype start = 0;
+    // The last component is the path itself, which is deliberately not considered
+    qsizetype slash = 0;
+    while ((slash = original.indexOf(QLatin1Char('/'), start)) >= 0) {
+        node = findChild(node, path.mid(start, slash - start));
+        if (node < 0) {
+            break;
+        }
+        if (slash > 0 && _nodes[node].isRenamed) {
+            deepestTarget = &_nodes[node].target;
+            deepestEnd = slash;
+        }
+        start = slash + 1;
+    }
+
+    if (!deepestTarget) {
+        return original;
+    }
+    return *deepestTarget + original.mid(deepestEnd);
+}
+
+}
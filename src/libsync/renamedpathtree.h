@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 by Nextcloud GmbH
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ */
+
+#pragma once
+
+#include "owncloudlib.h"
+
+#include <QMultiHash>
+#include <QString>
+#include <QStringView>
+
+#include <vector>
+
+namespace OCC {
+
+/**
+ * @brief Maps renamed paths (as in the db) to their new location
+ *
+ * The source paths are stored as a tree of interned path components: every
+ * node only holds its own name, children are found through a hash keyed by
+ * the parent node and the component name. Looking up a path walks its
+ * components one hash lookup at a time, so neither contains() nor
+ * adjustedPath() allocate intermediate prefix strings, and the cost does
+ * not depend on the number of renames recorded.
+ *
+ * @ingroup libsync
+ */
+class OWNCLOUDSYNC_EXPORT RenamedPathTree
+{
+public:
+    RenamedPathTree();
+
+    /// Record that @a original was renamed to @a target; replaces an earlier entry
+    void insert(const QString &original, const QString &target);
+
+    /// Whether @a original itself was recorded as renamed
+    [[nodiscard]] bool contains(const QString &original) const;
+
+    /** Given an original path, return the target path obtained when renaming is done.
+     *
+     * Only parent directory renames are considered. So if A/B got renamed to C/D,
+     * checking A/B/file yields C/D/file, but checking A/B yields A/B.
+     */
+    [[nodiscard]] QString adjustedPath(const QString &original) const;
+
+    [[nodiscard]] bool isEmpty() const { return _renamedCount == 0; }
+    [[nodiscard]] int size() const { return _renamedCount; }
+
+    void clear();
+
+private:
+    struct Node
+    {
+        QString name;
+        QString target;
+        bool isRenamed = false;
+    };
+
+    [[nodiscard]] int findChild(int parent, QStringView name) const;
+
+    // Node 0 is the root (the empty path)
+    std::vector<Node> _nodes;
+    // (parent index, name hash) -> child indexes
+    QMultiHash<QPair<int, size_t>, int> _children;
+    int _renamedCount = 0;
+};
+
+}
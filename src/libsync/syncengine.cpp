@@ -63,7 +63,7 @@ namespace OCC {
 
 Q_LOGGING_CATEGORY(lcEngine, "nextcloud.sync.engine", QtInfoMsg)
 
-bool SyncEngine::s_anySyncRunning = false;
+QSet<QString> SyncEngine::s_runningJournals;
 
 /** When the client touches a file, block change notifications for this duration (ms)
  *
@@ -112,6 +112,13 @@ SyncEngine::SyncEngine(AccountPtr account,
     _clearTouchedFilesTimer.setSingleShot(true);
     _clearTouchedFilesTimer.setInterval(30 * 1000);
     connect(&_clearTouchedFilesTimer, &QTimer::timeout, this, &SyncEngine::slotClearTouchedFiles);
+
+    _progressPublishTimer.setSingleShot(true);
+    connect(&_progressPublishTimer, &QTimer::timeout, this, [this] {
+        if (_progressPublishPending) {
+            publishProgress();
+        }
+    });
     connect(this, &SyncEngine::finished, [this](bool /* finished */) {
         _journal->keyValueStoreSet("last_sync", QDateTime::currentSecsSinceEpoch());
     });
@@ -389,7 +396,7 @@ void OCC::SyncEngine::slotItemDiscovered(const OCC::SyncFileItemPtr &item)
                     ? SyncFileItem::LockOwnerType::TokenLock
                     : SyncFileItem::LockOwnerType::UserLock;
                 if (item->_locked == SyncFileItem::LockStatus::LockedItem
-                    && (item->_lockOwnerType != lockOwnerTypeToSkipReadonly || item->_lockOwnerId != account()->davUser())) {
+                    && (item->_lockOwnerType != lockOwnerTypeToSkipReadonly || item->lockOwnerId() != account()->davUser())) {
                     qCDebug(lcEngine()) << filePath << "file is locked: making it read only";
                     FileSystem::setFileReadOnly(filePath, true);
                 } else {
@@ -436,11 +443,11 @@ void OCC::SyncEngine::slotItemDiscovered(const OCC::SyncFileItemPtr &item)
             lockInfo._locked = item->_locked == SyncFileItem::LockStatus::LockedItem;
             lockInfo._lockTime = item->_lockTime;
             lockInfo._lockTimeout = item->_lockTimeout;
-            lockInfo._lockOwnerId = item->_lockOwnerId;
+            lockInfo._lockOwnerId = item->lockOwnerId();
             lockInfo._lockOwnerType = static_cast<qint64>(item->_lockOwnerType);
-            lockInfo._lockOwnerDisplayName = item->_lockOwnerDisplayName;
-            lockInfo._lockEditorApp = item->_lockOwnerDisplayName;
-            lockInfo._lockToken = item->_lockToken;
+            lockInfo._lockOwnerDisplayName = item->lockOwnerDisplayName();
+            lockInfo._lockEditorApp = item->lockOwnerDisplayName();
+            lockInfo._lockToken = item->lockToken();
 
             if (!_journal->updateLocalMetadata(item->_file, item->_modtime, item->_size, item->_inode, lockInfo)) {
                 qCWarning(lcEngine) << "Could not update local metadata for file" << item->_file;
@@ -518,7 +525,11 @@ void SyncEngine::startSync()
         }
     }
 
-    if (s_anySyncRunning || _syncRunning) {
+    if (_syncRunning) {
+        return;
+    }
+    if (s_runningJournals.contains(_journal->databaseFilePath())) {
+        qCWarning(lcEngine) << "Another sync is already running with the journal" << _journal->databaseFilePath();
         return;
     }
     const auto currentEncryptionStatus = EncryptionStatusEnums::toDbEncryptionStatus(EncryptionStatusEnums::fromEndToEndEncryptionApiVersion(_account->capabilities().clientSideEncryptionVersion()));
@@ -526,7 +537,7 @@ void SyncEngine::startSync()
         _journal->schedulePathForRemoteDiscovery(record.path());
     });
 
-    s_anySyncRunning = true;
+    s_runningJournals.insert(_journal->databaseFilePath());
     _syncRunning = true;
     _anotherSyncNeeded = NoFollowUpSync;
     _clearTouchedFilesTimer.stop();
@@ -623,13 +634,13 @@ void SyncEngine::startSync()
 
     _stopWatch.start();
     _progressInfo->_status = ProgressInfo::Starting;
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
 
     qCInfo(lcEngine) << "#### Discovery start ####################################################";
     qCInfo(lcEngine) << "Server" << account()->serverVersion()
                      << (account()->isHttp2Supported() ? "Using HTTP/2" : "");
     _progressInfo->_status = ProgressInfo::Discovery;
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
 
     _remnantReadOnlyFolders.clear();
 
@@ -730,10 +741,15 @@ void SyncEngine::startSync()
             _discoveryPhase.data()
         );
     } else {
+        const auto lastSyncTimestamp = _journal->keyValueStoreGetInt("last_sync", 0);
+        if (_syncOptions._remoteDeltaDiscovery && lastSyncTimestamp > 0) {
+            // A margin for clock differences with the server only makes the search result larger
+            _discoveryPhase->_remoteDeltaSince = lastSyncTimestamp - std::chrono::seconds(std::chrono::hours(1)).count();
+        }
         discoveryJob = new ProcessDirectoryJob(
             _discoveryPhase.data(),
             PinState::AlwaysLocal,
-            _journal->keyValueStoreGetInt("last_sync", 0),
+            lastSyncTimestamp,
             _discoveryPhase.data()
         );
     }
@@ -759,7 +775,7 @@ void SyncEngine::slotFolderDiscovered(bool local, const QString &folder)
         _progressInfo->_currentDiscoveredRemoteFolder = folder;
         _progressInfo->_currentDiscoveredLocalFolder.clear();
     }
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
 }
 
 void SyncEngine::slotRootEtagReceived(const QByteArray &e, const QDateTime &time)
@@ -799,7 +815,7 @@ void SyncEngine::slotDiscoveryFinished()
     _progressInfo->_currentDiscoveredRemoteFolder.clear();
     _progressInfo->_currentDiscoveredLocalFolder.clear();
     _progressInfo->_status = ProgressInfo::Reconcile;
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
 
     if (handleMassDeletion()) {
         return;
@@ -866,7 +882,7 @@ void SyncEngine::slotItemCompleted(const SyncFileItemPtr &item, const ErrorCateg
 {
     _progressInfo->setProgressComplete(*item);
 
-    emit transmissionProgress(*_progressInfo);
+    publishProgressThrottled();
     emit itemCompleted(item, category);
 
     detectFileLock(item);
@@ -890,10 +906,12 @@ void SyncEngine::slotPropagationFinished(OCC::SyncFileItem::Status status)
 
     // Send final progress information even if no
     // files needed propagation, but clear the lastCompletedItem
-    // so we don't count this twice (like Recent Files)
-    _progressInfo->_lastCompletedItem = SyncFileItem();
+    // so we don't count this twice (like Recent Files).
+    // Items completed since the last throttled update are still
+    // in _completedItems and get delivered with it.
+    _progressInfo->_lastCompletedItem = ProgressInfo::ItemRecord();
     _progressInfo->_status = ProgressInfo::Done;
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
 
     finalize(status == SyncFileItem::Success);
 }
@@ -904,11 +922,14 @@ void SyncEngine::finalize(bool success)
 
     qCInfo(lcEngine) << "Sync run took " << _stopWatch.addLapTime(QLatin1String("Sync Finished")) << "ms";
     _stopWatch.stop();
+    qCInfo(lcEngine) << "Network statistics of the account:" << _account->networkStatistics().summary();
 
     if (_discoveryPhase) {
         _discoveryPhase.take()->deleteLater();
     }
-    s_anySyncRunning = false;
+    if (_syncRunning) {
+        s_runningJournals.remove(_journal->databaseFilePath());
+    }
     _syncRunning = false;
     emit finished(success);
 
@@ -926,6 +947,9 @@ void SyncEngine::finalize(bool success)
 
     _clearTouchedFilesTimer.start();
     _leadingAndTrailingSpacesFilesAllowed.clear();
+
+    _progressPublishTimer.stop();
+    _progressPublishPending = false;
 }
 
 void SyncEngine::processCaseClashConflictsBeforeDiscovery()
@@ -948,7 +972,27 @@ void SyncEngine::processCaseClashConflictsBeforeDiscovery()
 void SyncEngine::slotProgress(const SyncFileItem &item, qint64 current)
 {
     _progressInfo->setProgressItem(item, current);
+    publishProgressThrottled();
+}
+
+void SyncEngine::publishProgress()
+{
+    _progressPublishPending = false;
+    if (_syncOptions._minProgressPublishInterval.count() > 0) {
+        _progressPublishTimer.start(_syncOptions._minProgressPublishInterval);
+    }
     emit transmissionProgress(*_progressInfo);
+    _progressInfo->_completedItems.clear();
+}
+
+void SyncEngine::publishProgressThrottled()
+{
+    if (_progressPublishTimer.isActive()) {
+        // The state is aggregated in _progressInfo, the timer will publish it
+        _progressPublishPending = true;
+        return;
+    }
+    publishProgress();
 }
 
 
@@ -1040,7 +1084,7 @@ void SyncEngine::finishSync()
 
     // it's important to do this before ProgressInfo::start(), to announce start of new sync
     _progressInfo->_status = ProgressInfo::Propagation;
-    emit transmissionProgress(*_progressInfo);
+    publishProgress();
     _progressInfo->startEstimateUpdates();
 
            // post update phase script: allow to tweak stuff by a custom script in debug mode.
@@ -1102,12 +1146,10 @@ bool SyncEngine::handleMassDeletion()
     for (const auto &oneItem : qAsConst(_syncItems)) {
         if (oneItem->_instruction == CSYNC_INSTRUCTION_REMOVE) {
             if (oneItem->isDirectory()) {
-                const auto result = _journal->listFilesInPath(oneItem->_file.toUtf8(), [&deletionCounter] (const auto &oneRecord) {
-                    if (oneRecord.isFile()) {
-                        ++deletionCounter;
-                    }
-                });
-                if (!result) {
+                const auto aggregate = _journal->getDirectoryAggregate(oneItem->_file);
+                if (aggregate._valid) {
+                    deletionCounter += aggregate._fileCount;
+                } else {
                     qCDebug(lcEngine()) << "unable to find the number of files within a deleted folder:" << oneItem->_file;
                 }
             } else {
@@ -307,6 +307,12 @@ private:
     // cleanup and emit the finished signal
     void finalize(bool success);
 
+    // emit transmissionProgress() now and start a new throttling window
+    void publishProgress();
+
+    // emit transmissionProgress() at most once per SyncOptions::_minProgressPublishInterval
+    void publishProgressThrottled();
+
     void processCaseClashConflictsBeforeDiscovery();
 
     // Aggregate scheduled sync runs into interval buckets. Can be used to
@@ -327,7 +333,7 @@ private:
     QSharedPointer<SyncEngine::ScheduledSyncTimer> nearbyScheduledSyncTimer(const qint64 scheduledSyncTimerSecs,
                                                                             const qint64 intervalSecs) const;
 
-    static bool s_anySyncRunning; //true when one sync is running somewhere (for debugging)
+    static QSet<QString> s_runningJournals; // journal files with a running sync, no two engines may sync into the same one
 
     // Must only be accessed during update and reconcile
     QVector<SyncFileItemPtr> _syncItems;
@@ -348,6 +354,8 @@ private:
     QSet<QString> _seenConflictFiles;
 
     QScopedPointer<ProgressInfo> _progressInfo;
+    QTimer _progressPublishTimer;
+    bool _progressPublishPending = false;
 
     QScopedPointer<ExcludedFiles> _excludedFiles;
     QScopedPointer<SyncFileStatusTracker> _syncFileStatusTracker;
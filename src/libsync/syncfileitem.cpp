@@ -116,16 +116,16 @@ SyncJournalFileRecord SyncFileItem::toSyncJournalFileRecordWithInode(const QStri
     rec._lastShareStateFetchedTimestamp = _lastShareStateFetchedTimestamp;
     rec._serverHasIgnoredFiles = _serverHasIgnoredFiles;
     rec._checksumHeader = _checksumHeader;
-    rec._e2eMangledName = _encryptedFileName.toUtf8();
+    rec._e2eMangledName = encryptedFileName().toUtf8();
     rec._e2eEncryptionStatus = EncryptionStatusEnums::toDbEncryptionStatus(_e2eEncryptionStatus);
     rec._lockstate._locked = _locked == LockStatus::LockedItem;
-    rec._lockstate._lockOwnerDisplayName = _lockOwnerDisplayName;
-    rec._lockstate._lockOwnerId = _lockOwnerId;
+    rec._lockstate._lockOwnerDisplayName = lockOwnerDisplayName();
+    rec._lockstate._lockOwnerId = lockOwnerId();
     rec._lockstate._lockOwnerType = static_cast<qint64>(_lockOwnerType);
-    rec._lockstate._lockEditorApp = _lockEditorApp;
+    rec._lockstate._lockEditorApp = lockEditorApp();
     rec._lockstate._lockTime = _lockTime;
     rec._lockstate._lockTimeout = _lockTimeout;
-    rec._lockstate._lockToken = _lockToken;
+    rec._lockstate._lockToken = lockToken();
 
     // Update the inode if possible
     rec._inode = _inode;
@@ -153,17 +153,17 @@ SyncFileItemPtr SyncFileItem::fromSyncJournalFileRecord(const SyncJournalFileRec
     item->_remotePerm = rec._remotePerm;
     item->_serverHasIgnoredFiles = rec._serverHasIgnoredFiles;
     item->_checksumHeader = rec._checksumHeader;
-    item->_encryptedFileName = rec.e2eMangledName();
+    item->setEncryptedFileName(rec.e2eMangledName());
     item->_e2eEncryptionStatus = EncryptionStatusEnums::fromDbEncryptionStatus(rec._e2eEncryptionStatus);
     item->_e2eEncryptionServerCapability = item->_e2eEncryptionStatus;
     item->_locked = rec._lockstate._locked ? LockStatus::LockedItem : LockStatus::UnlockedItem;
-    item->_lockOwnerDisplayName = rec._lockstate._lockOwnerDisplayName;
-    item->_lockOwnerId = rec._lockstate._lockOwnerId;
+    item->setLockOwnerDisplayName(rec._lockstate._lockOwnerDisplayName);
+    item->setLockOwnerId(rec._lockstate._lockOwnerId);
     item->_lockOwnerType = static_cast<LockOwnerType>(rec._lockstate._lockOwnerType);
-    item->_lockEditorApp = rec._lockstate._lockEditorApp;
+    item->setLockEditorApp(rec._lockstate._lockEditorApp);
     item->_lockTime = rec._lockstate._lockTime;
     item->_lockTimeout = rec._lockstate._lockTimeout;
-    item->_lockToken = rec._lockstate._lockToken;
+    item->setLockToken(rec._lockstate._lockToken);
     item->_sharedByMe = rec._sharedByMe;
     item->_isShared = rec._isShared;
     item->_lastShareStateFetchedTimestamp = rec._lastShareStateFetchedTimestamp;
@@ -172,7 +172,7 @@ SyncFileItemPtr SyncFileItem::fromSyncJournalFileRecord(const SyncJournalFileRec
 
 SyncFileItemPtr SyncFileItem::fromProperties(const QString &filePath, const QMap<QString, QString> &properties, RemotePermissions::MountedPermissionAlgorithm algorithm)
 {
-    SyncFileItemPtr item(new SyncFileItem);
+    auto item = SyncFileItemPtr::create();
     item->_file = filePath;
     item->_originalFile = filePath;
 
@@ -199,9 +199,9 @@ SyncFileItemPtr SyncFileItem::fromProperties(const QString &filePath, const QMap
     }
     item->_locked =
         properties.value(QStringLiteral("lock")) == QStringLiteral("1") ? SyncFileItem::LockStatus::LockedItem : SyncFileItem::LockStatus::UnlockedItem;
-    item->_lockOwnerDisplayName = properties.value(QStringLiteral("lock-owner-displayname"));
-    item->_lockOwnerId = properties.value(QStringLiteral("lock-owner"));
-    item->_lockEditorApp = properties.value(QStringLiteral("lock-owner-editor"));
+    item->setLockOwnerDisplayName(properties.value(QStringLiteral("lock-owner-displayname")));
+    item->setLockOwnerId(properties.value(QStringLiteral("lock-owner")));
+    item->setLockEditorApp(properties.value(QStringLiteral("lock-owner-editor")));
 
     {
         auto ok = false;
@@ -221,7 +221,7 @@ SyncFileItemPtr SyncFileItem::fromProperties(const QString &filePath, const QMap
         item->_lockTimeout = ok ? intConvertedValue : 0;
     }
 
-    item->_lockToken = properties.value(QStringLiteral("lock-token"));
+    item->setLockToken(properties.value(QStringLiteral("lock-token")));
 
     const auto date = QDateTime::fromString(properties.value(QStringLiteral("getlastmodified")), Qt::RFC2822Date);
     Q_ASSERT(date.isValid());
@@ -247,13 +247,13 @@ SyncFileItemPtr SyncFileItem::fromProperties(const QString &filePath, const QMap
 void SyncFileItem::updateLockStateFromDbRecord(const SyncJournalFileRecord &dbRecord)
 {
     _locked = dbRecord._lockstate._locked ? LockStatus::LockedItem : LockStatus::UnlockedItem;
-    _lockOwnerId = dbRecord._lockstate._lockOwnerId;
-    _lockOwnerDisplayName = dbRecord._lockstate._lockOwnerDisplayName;
+    setLockOwnerId(dbRecord._lockstate._lockOwnerId);
+    setLockOwnerDisplayName(dbRecord._lockstate._lockOwnerDisplayName);
     _lockOwnerType = static_cast<LockOwnerType>(dbRecord._lockstate._lockOwnerType);
-    _lockEditorApp = dbRecord._lockstate._lockEditorApp;
+    setLockEditorApp(dbRecord._lockstate._lockEditorApp);
     _lockTime = dbRecord._lockstate._lockTime;
     _lockTimeout = dbRecord._lockstate._lockTimeout;
-    _lockToken = dbRecord._lockstate._lockToken;
+    setLockToken(dbRecord._lockstate._lockToken);
 }
 
 }
@@ -20,6 +20,7 @@
 #include <QDateTime>
 #include <QMetaType>
 #include <QSharedPointer>
+#include <QSharedDataPointer>
 
 #include <csync.h>
 
@@ -145,6 +146,12 @@ public:
         , _status(NoStatus)
         , _isRestoration(false)
         , _isSelectiveSync(false)
+        , _isShared(false)
+        , _sharedByMe(false)
+        , _isFileDropDetected(false)
+        , _isEncryptedMetadataNeedUpdate(false)
+        , _isAnyInvalidCharChild(false)
+        , _isAnyCaseClashChild(false)
     {
     }
 
@@ -238,6 +245,49 @@ public:
 
     void updateLockStateFromDbRecord(const SyncJournalFileRecord &dbRecord);
 
+    /// Whether there's end to end encryption on this file.
+    /// If the file is encrypted, the encryptedFileName is
+    /// the encrypted name on the server.
+    [[nodiscard]] QString encryptedFileName() const { return extraString(&Extra::encryptedFileName); }
+    void setEncryptedFileName(const QString &name) { setExtraString(&Extra::encryptedFileName, name); }
+
+    /// The server exception of a failed request, only in case of error
+    [[nodiscard]] QString errorExceptionName() const { return extraString(&Extra::errorExceptionName); }
+    [[nodiscard]] QString errorExceptionMessage() const { return extraString(&Extra::errorExceptionMessage); }
+    void setErrorException(const QString &name, const QString &message)
+    {
+        setExtraString(&Extra::errorExceptionName, name);
+        setExtraString(&Extra::errorExceptionMessage, message);
+    }
+
+    [[nodiscard]] QString directDownloadUrl() const { return extraString(&Extra::directDownloadUrl); }
+    [[nodiscard]] QString directDownloadCookies() const { return extraString(&Extra::directDownloadCookies); }
+    void setDirectDownload(const QString &url, const QString &cookies)
+    {
+        setExtraString(&Extra::directDownloadUrl, url);
+        setExtraString(&Extra::directDownloadCookies, cookies);
+    }
+
+    [[nodiscard]] QString lockOwnerId() const { return extraString(&Extra::lockOwnerId); }
+    void setLockOwnerId(const QString &id) { setExtraString(&Extra::lockOwnerId, id); }
+    [[nodiscard]] QString lockOwnerDisplayName() const { return extraString(&Extra::lockOwnerDisplayName); }
+    void setLockOwnerDisplayName(const QString &name) { setExtraString(&Extra::lockOwnerDisplayName, name); }
+    [[nodiscard]] QString lockEditorApp() const { return extraString(&Extra::lockEditorApp); }
+    void setLockEditorApp(const QString &app) { setExtraString(&Extra::lockEditorApp, app); }
+    [[nodiscard]] QString lockToken() const { return extraString(&Extra::lockToken); }
+    void setLockToken(const QString &token) { setExtraString(&Extra::lockToken, token); }
+
+    /** The discovery decision log for this item.
+     *
+     * Only kept for items that end up being removed (see SyncFileStatusTracker::slotAboutToPropagate),
+     * since it is a few hundred characters per item and would dominate memory on large syncs.
+     */
+    [[nodiscard]] QString discoveryResult() const { return extraString(&Extra::discoveryResult); }
+    void setDiscoveryResult(const QString &log) { setExtraString(&Extra::discoveryResult, log); }
+
+    /** Whether any of the rarely set strings above is allocated */
+    [[nodiscard]] bool hasExtraStrings() const { return _extra.constData() != nullptr; }
+
     // Variables useful for everybody
 
     /** The syncfolder-relative filesystem path that the operation is about
@@ -258,11 +308,6 @@ public:
      */
     QString _originalFile;
 
-    /// Whether there's end to end encryption on this file.
-    /// If the file is encrypted, the _encryptedFilename is
-    /// the encrypted name on the server.
-    QString _encryptedFileName;
-
     ItemType _type BITFIELD(3);
     Direction _direction BITFIELD(3);
     bool _serverHasIgnoredFiles BITFIELD(1);
@@ -283,14 +328,21 @@ public:
     Status _status BITFIELD(4);
     bool _isRestoration BITFIELD(1); // The original operation was forbidden, and this is a restoration
     bool _isSelectiveSync BITFIELD(1); // The file is removed or ignored because it is in the selective sync list
+
+    // Share and e2ee state, kept next to the other bitfields so they pack into the same word
+    bool _isShared BITFIELD(1);
+    bool _sharedByMe BITFIELD(1);
+    bool _isFileDropDetected BITFIELD(1);
+    bool _isEncryptedMetadataNeedUpdate BITFIELD(1);
+    bool _isAnyInvalidCharChild BITFIELD(1);
+    bool _isAnyCaseClashChild BITFIELD(1);
+
     EncryptionStatus _e2eEncryptionStatus = EncryptionStatus::NotEncrypted; // The file is E2EE or the content of the directory should be E2EE
     EncryptionStatus _e2eEncryptionServerCapability = EncryptionStatus::NotEncrypted;
     EncryptionStatus _e2eEncryptionStatusRemote = EncryptionStatus::NotEncrypted;
     quint16 _httpErrorCode = 0;
     RemotePermissions _remotePerm;
     QString _errorString; // Contains a string only in case of error
-    QString _errorExceptionName; // Contains a server exception string only in case of error
-    QString _errorExceptionMessage; // Contains a server exception message string only in case of error
     QByteArray _responseTimeStamp;
     QByteArray _requestId; // X-Request-Id of the failed request
     quint32 _affectedItems = 1; // the number of affected items by the operation on this item.
@@ -316,31 +368,60 @@ public:
     qint64 _previousSize = 0;
     time_t _previousModtime = 0;
 
-    QString _directDownloadUrl;
-    QString _directDownloadCookies;
-
     LockStatus _locked = LockStatus::UnlockedItem;
-    QString _lockOwnerId;
-    QString _lockOwnerDisplayName;
     LockOwnerType _lockOwnerType = LockOwnerType::UserLock;
-    QString _lockEditorApp;
     qint64 _lockTime = 0;
     qint64 _lockTimeout = 0;
-    QString _lockToken;
 
-    bool _isShared = false;
     time_t _lastShareStateFetchedTimestamp = 0;
 
-    bool _sharedByMe = false;
-
-    bool _isFileDropDetected = false;
+private:
+    /** Strings that only a few items of a sync have
+     *
+     * They are allocated together when the first of them is set and freed when
+     * the last one is cleared, so that most items of a large sync only pay for a pointer.
+     */
+    struct Extra : public QSharedData
+    {
+        QString encryptedFileName;
+        QString errorExceptionName;
+        QString errorExceptionMessage;
+        QString directDownloadUrl;
+        QString directDownloadCookies;
+        QString lockOwnerId;
+        QString lockOwnerDisplayName;
+        QString lockEditorApp;
+        QString lockToken;
+        QString discoveryResult;
+
+        [[nodiscard]] bool isEmpty() const
+        {
+            return encryptedFileName.isEmpty() && errorExceptionName.isEmpty() && errorExceptionMessage.isEmpty()
+                && directDownloadUrl.isEmpty() && directDownloadCookies.isEmpty() && lockOwnerId.isEmpty()
+                && lockOwnerDisplayName.isEmpty() && lockEditorApp.isEmpty() && lockToken.isEmpty() && discoveryResult.isEmpty();
+        }
+    };
 
-    bool _isEncryptedMetadataNeedUpdate = false;
+    [[nodiscard]] QString extraString(QString Extra::*field) const
+    {
+        return _extra ? _extra.constData()->*field : QString();
+    }
 
-    bool _isAnyInvalidCharChild = false;
-    bool _isAnyCaseClashChild = false;
+    void setExtraString(QString Extra::*field, const QString &value)
+    {
+        if (!_extra) {
+            if (value.isEmpty()) {
+                return;
+            }
+            _extra.reset(new Extra);
+        }
+        _extra.data()->*field = value;
+        if (value.isEmpty() && _extra.constData()->isEmpty()) {
+            _extra.reset();
+        }
+    }
 
-    QString _discoveryResult;
+    QSharedDataPointer<Extra> _extra;
 };
 
 inline bool operator<(const SyncFileItemPtr &item1, const SyncFileItemPtr &item2)
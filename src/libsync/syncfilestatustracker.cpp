@@ -250,7 +250,7 @@ void SyncFileStatusTracker::slotAboutToPropagate(SyncFileItemVector &items)
 
         SharedFlag sharedFlag = item->_remotePerm.hasPermission(RemotePermissions::IsShared) ? Shared : NotShared;
         if (item->_instruction != CSyncEnums::CSYNC_INSTRUCTION_REMOVE) {
-            item->_discoveryResult.clear();
+            item->setDiscoveryResult({});
         }
         if (item->_instruction != CSYNC_INSTRUCTION_NONE
             && item->_instruction != CSYNC_INSTRUCTION_UPDATE_METADATA
@@ -68,6 +68,26 @@ void SyncOptions::fillFromEnvironmentVariables()
     int maxParallel = qgetenv("OWNCLOUD_MAX_PARALLEL").toInt();
     if (maxParallel > 0)
         _parallelNetworkJobs = maxParallel;
+
+    QByteArray bulkDownloadEnv = qgetenv("OWNCLOUD_BULK_DOWNLOAD");
+    if (!bulkDownloadEnv.isEmpty())
+        _bulkDownload = bulkDownloadEnv != "0";
+
+    QByteArray remoteDeltaDiscoveryEnv = qgetenv("OWNCLOUD_REMOTE_DELTA_DISCOVERY");
+    if (!remoteDeltaDiscoveryEnv.isEmpty())
+        _remoteDeltaDiscovery = remoteDeltaDiscoveryEnv != "0";
+
+    QByteArray downloadWriterThreadEnv = qgetenv("OWNCLOUD_DOWNLOAD_WRITER_THREAD");
+    if (!downloadWriterThreadEnv.isEmpty())
+        _downloadWriterThread = downloadWriterThreadEnv != "0";
+
+    QByteArray deltaUploadEnv = qgetenv("OWNCLOUD_DELTA_UPLOAD");
+    if (!deltaUploadEnv.isEmpty())
+        _deltaUpload = deltaUploadEnv != "0";
+
+    QByteArray deltaDownloadEnv = qgetenv("OWNCLOUD_DELTA_DOWNLOAD");
+    if (!deltaDownloadEnv.isEmpty())
+        _deltaDownload = deltaDownloadEnv != "0";
 }
 
 void SyncOptions::verifyChunkSizes()
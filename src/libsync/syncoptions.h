@@ -66,6 +66,46 @@ public:
     /** The maximum number of active jobs in parallel  */
     int _parallelNetworkJobs = 6;
 
+    /** The minimum time between two transmissionProgress() updates during propagation.
+     *
+     * Byte progress and completed items arriving in between are aggregated into
+     * the next update. Set to 0 to publish every single progress change.
+     */
+    std::chrono::milliseconds _minProgressPublishInterval = std::chrono::milliseconds(0);
+
+    /** Download new small files of a folder in batches through one archive request.
+     *
+     * Files that can't be extracted from the archive are downloaded individually.
+     */
+    bool _bulkDownload = false;
+
+    /** Find the remote changes since the last sync with one WebDAV SEARCH first.
+     *
+     * Directories entirely known from the search result, typically directories
+     * created on the server, are not listed with a PROPFIND of their own.
+     */
+    bool _remoteDeltaDiscovery = false;
+
+    /** Write downloaded files on a separate thread.
+     *
+     * Keeps the file system writes of downloads off the thread running the sync.
+     */
+    bool _downloadWriterThread = true;
+
+    /** Upload only the changed parts of modified files if the server can copy the rest.
+     *
+     * The content-defined chunks of uploaded files are kept in the journal to
+     * find the parts of the next version that are already on the server.
+     */
+    bool _deltaUpload = false;
+
+    /** Download only the changed parts of modified files and copy the rest from the local file.
+     *
+     * Needs the content chunks of the new version from the server, the
+     * reconstructed file is checked against them before it replaces the old one.
+     */
+    bool _deltaDownload = false;
+
     static constexpr auto chunkV2MinChunkSize = 5LL * 1000LL * 1000LL; // 5 MB
     static constexpr auto chunkV2MaxChunkSize = 5LL * 1000LL * 1000LL * 1000LL; // 5 GB
 
@@ -80,7 +120,9 @@ public:
     /** Reads settings from env vars where available.
      *
      * Currently reads _initialChunkSize, _minChunkSize, _maxChunkSize,
-     * _targetChunkUploadDuration, _parallelNetworkJobs.
+     * _targetChunkUploadDuration, _parallelNetworkJobs, _bulkDownload,
+     * _remoteDeltaDiscovery, _downloadWriterThread, _deltaUpload,
+     * _deltaDownload.
      */
     void fillFromEnvironmentVariables();
 
@@ -0,0 +1,76 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include "syncenginetestutils.h"
+#include <syncengine.h>
+
+#include <QElapsedTimer>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+// Usage: DownloadBench [number of files] [size of a file in MB]
+
+using namespace OCC;
+
+namespace {
+
+// CPU time of the calling thread or of the whole process, only measured on Linux
+qint64 cpuTimeMs(bool callingThread)
+{
+#ifdef Q_OS_LINUX
+    rusage usage{};
+    getrusage(callingThread ? RUSAGE_THREAD : RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+    Q_UNUSED(callingThread)
+    return 0;
+#endif
+}
+
+bool benchmark(bool writerThread, int numFiles, qint64 fileSize)
+{
+    FakeFolder fakeFolder{FileInfo{}};
+    auto options = fakeFolder.syncEngine().syncOptions();
+    options._downloadWriterThread = writerThread;
+    fakeFolder.syncEngine().setSyncOptions(options);
+
+    for (int i = 0; i < numFiles; ++i) {
+        fakeFolder.remoteModifier().insert(QStringLiteral("file%1").arg(i), fileSize, 'D');
+    }
+
+    const auto mainThreadStart = cpuTimeMs(true);
+    const auto processStart = cpuTimeMs(false);
+    QElapsedTimer timer;
+    timer.start();
+    const auto result = fakeFolder.syncOnce();
+    const auto elapsed = timer.elapsed();
+    const auto mainThread = cpuTimeMs(true) - mainThreadStart;
+    const auto process = cpuTimeMs(false) - processStart;
+
+    const auto gigabytes = double(numFiles) * fileSize / (1000. * 1000. * 1000.);
+    qDebug() << (writerThread ? "WRITER THREAD" : "MAIN THREAD") << ":" << result << elapsed << "ms,"
+             << "main thread CPU" << mainThread / gigabytes << "ms/GB,"
+             << "process CPU" << process / gigabytes << "ms/GB";
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const auto numFiles = argc > 1 ? QByteArray(argv[1]).toInt() : 20;
+    const auto fileSize = (argc > 2 ? QByteArray(argv[2]).toLongLong() : 50) * 1000 * 1000;
+
+    const auto result1 = benchmark(false, numFiles, fileSize);
+    const auto result2 = benchmark(true, numFiles, fileSize);
+    return (result1 && result2) ? 0 : -1;
+}
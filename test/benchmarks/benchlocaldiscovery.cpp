@@ -0,0 +1,103 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include "csync.h"
+#include "vio/csync_vio_local.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+// Usage: LocalDiscoveryBench [number of files] [parent directory, a tmpfs by default]
+
+namespace {
+
+constexpr int filesPerDir = 1000;
+constexpr int dirsPerGroup = 100;
+
+bool createTree(const QString &root, int numFiles)
+{
+    for (int file = 0; file < numFiles; ++file) {
+        const auto dir = file / filesPerDir;
+        const auto dirPath = QStringLiteral("%1/group%2/dir%3").arg(root).arg(dir / dirsPerGroup).arg(dir);
+        if (file % filesPerDir == 0 && !QDir().mkpath(dirPath)) {
+            return false;
+        }
+        QFile f(QStringLiteral("%1/file%2").arg(dirPath).arg(file));
+        if (!f.open(QFile::WriteOnly)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qint64 scan(const QString &path)
+{
+    const auto dh = csync_vio_local_opendir(path);
+    if (!dh) {
+        return 0;
+    }
+    qint64 count = 0;
+    while (const auto dirent = csync_vio_local_readdir(dh, nullptr)) {
+        ++count;
+        if (dirent->type == ItemTypeDirectory) {
+            count += scan(path + QLatin1Char('/') + QString::fromUtf8(dirent->path));
+        }
+    }
+    csync_vio_local_closedir(dh);
+    return count;
+}
+
+void benchmark(const QString &root, const char *name)
+{
+    // The first scan warms the caches for both variants
+    for (int run = 1; run <= 2; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        const auto count = scan(root);
+        qDebug() << name << "RUN" << run << ":" << count << "entries in" << timer.elapsed() << "ms";
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const auto numFiles = argc > 1 ? QByteArray(argv[1]).toInt() : 1000000;
+    const auto parent = argc > 2 ? QString::fromLocal8Bit(argv[2])
+                                 : QDir(QStringLiteral("/dev/shm")).exists() ? QStringLiteral("/dev/shm") : QDir::tempPath();
+
+    QTemporaryDir dir(parent + QStringLiteral("/localdiscoverybench-XXXXXX"));
+    if (!dir.isValid()) {
+        qWarning() << "Could not create a directory in" << parent;
+        return -1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!createTree(dir.path(), numFiles)) {
+        qWarning() << "Could not create the files in" << dir.path();
+        return -1;
+    }
+    qDebug() << "CREATED" << numFiles << "FILES IN" << dir.path() << timer.elapsed() << "ms";
+
+    csync_vio_local_set_batched_stat_enabled(false);
+    benchmark(dir.path(), "ONE BY ONE");
+
+    csync_vio_local_set_batched_stat_enabled(true);
+    if (!csync_vio_local_batched_stat_available()) {
+        qDebug() << "BATCHED: not available";
+        return 0;
+    }
+    benchmark(dir.path(), "BATCHED");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include "configfile.h"
+#include "folderman.h"
+#include "theme.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <vector>
+
+// Usage: SocketApiBench [number of requests] [requests in flight]
+//
+// Sends RETRIEVE_FILE_STATUS requests like a file manager opening a large
+// directory and reports the throughput and the latency of the replies.
+
+using namespace OCC;
+
+namespace {
+
+class StatusClient : public QThread
+{
+public:
+    StatusClient(const QString &socketPath, int numRequests, int window)
+        : _socketPath(socketPath)
+        , _numRequests(numRequests)
+        , _window(window)
+    {
+    }
+
+    std::vector<qint64> latencies; // nanoseconds
+    qint64 elapsedMs = 0;
+    bool success = false;
+
+protected:
+    void run() override
+    {
+        QLocalSocket socket;
+        socket.connectToServer(_socketPath);
+        if (!socket.waitForConnected(5000)) {
+            qWarning() << "Could not connect to" << _socketPath << socket.errorString();
+            return;
+        }
+
+        std::vector<qint64> sendTimes(_numRequests);
+        latencies.reserve(_numRequests);
+        QElapsedTimer timer;
+        timer.start();
+        int sent = 0;
+        int received = 0;
+        while (received < _numRequests) {
+            for (; sent < _numRequests && sent - received < _window; ++sent) {
+                socket.write(QByteArrayLiteral("RETRIEVE_FILE_STATUS:/nonexistent/directory/file") + QByteArray::number(sent) + '\n');
+                sendTimes[sent] = timer.nsecsElapsed();
+            }
+            socket.flush();
+            if (!socket.canReadLine() && !socket.waitForReadyRead(5000)) {
+                qWarning() << "No reply after" << received << "requests";
+                return;
+            }
+            while (socket.canReadLine()) {
+                // Skip the REGISTER_PATH messages of the sync folders
+                if (socket.readLine().startsWith("STATUS:")) {
+                    latencies.push_back(timer.nsecsElapsed() - sendTimes[received]);
+                    ++received;
+                }
+            }
+        }
+        elapsedMs = timer.elapsed();
+        success = true;
+    }
+
+private:
+    QString _socketPath;
+    int _numRequests;
+    int _window;
+};
+
+qint64 percentile(const std::vector<qint64> &sorted, double p)
+{
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const auto numRequests = argc > 1 ? QByteArray(argv[1]).toInt() : 100000;
+    const auto window = argc > 2 ? QByteArray(argv[2]).toInt() : 64;
+
+#ifndef Q_OS_LINUX
+    qWarning() << "The socket path is only known on Linux";
+    return 0;
+#endif
+
+    QTemporaryDir configDir;
+    ConfigFile::setConfDir(configDir.path()); // we don't want to pollute the user's config file
+
+    // Starts the SocketApi server
+    FolderMan folderMan;
+    const auto socketPath = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+        + QLatin1Char('/') + Theme::instance()->appName() + QStringLiteral("/socket");
+
+    StatusClient client(socketPath, numRequests, window);
+    QObject::connect(&client, &QThread::finished, &app, &QCoreApplication::quit);
+    client.start();
+    app.exec();
+    client.wait();
+
+    if (!client.success) {
+        return -1;
+    }
+    auto latencies = client.latencies;
+    std::sort(latencies.begin(), latencies.end());
+    qDebug() << "REQUESTS:" << numRequests << "IN FLIGHT:" << window;
+    qDebug() << "THROUGHPUT:" << numRequests * 1000. / std::max(client.elapsedMs, qint64(1)) << "requests/s";
+    qDebug() << "LATENCY p50:" << percentile(latencies, 0.5) / 1000. << "us"
+             << "p99:" << percentile(latencies, 0.99) / 1000. << "us"
+             << "max:" << latencies.back() / 1000. << "us";
+    return 0;
+}
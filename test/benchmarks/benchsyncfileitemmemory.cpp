@@ -0,0 +1,84 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include "syncenginetestutils.h"
+#include <syncengine.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace OCC;
+
+namespace {
+
+int numFiles = 0;
+
+template<int filesPerDir, int dirPerDir, int maxDepth>
+void addBunchOfFiles(int depth, const QString &path, FileModifier &fi) {
+    for (int fileNum = 1; fileNum <= filesPerDir; ++fileNum) {
+        QString name = QStringLiteral("file") + QString::number(fileNum);
+        fi.insert(path.isEmpty() ? name : path + "/" + name);
+        numFiles++;
+    }
+    if (depth >= maxDepth)
+        return;
+    for (int dirNum = 1; dirNum <= dirPerDir; ++dirNum) {
+        QString name = QStringLiteral("dir") + QString::number(dirNum);
+        QString subPath = path.isEmpty() ? name : path + "/" + name;
+        fi.mkdir(subPath);
+        addBunchOfFiles<filesPerDir, dirPerDir, maxDepth>(depth + 1, subPath, fi);
+    }
+}
+
+qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<qint64>(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    FakeFolder fakeFolder{FileInfo{}};
+    addBunchOfFiles<10, 8, 4>(0, "", fakeFolder.remoteModifier());
+
+    qint64 heapAtPropagation = 0;
+    qsizetype itemCount = 0;
+    qsizetype itemsWithExtraStrings = 0;
+    QObject::connect(&fakeFolder.syncEngine(), &SyncEngine::aboutToPropagate, [&](SyncFileItemVector &items) {
+        heapAtPropagation = heapInUse();
+        itemCount = items.size();
+        itemsWithExtraStrings = std::count_if(items.cbegin(), items.cend(), [](const SyncFileItemPtr &item) {
+            return item->hasExtraStrings();
+        });
+    });
+
+    const auto heapBeforeSync = heapInUse();
+    QElapsedTimer timer;
+    timer.start();
+    const auto result = fakeFolder.syncOnce();
+
+    qDebug() << "NUMFILES" << numFiles;
+    qDebug() << "SYNC:" << result << timer.elapsed() << "ms";
+    // The ten rarely set strings used to be members of every item, they now share one pointer
+    constexpr auto movedStrings = 10;
+    qDebug() << "sizeof(SyncFileItem):" << sizeof(SyncFileItem)
+             << "with the rarely set strings inline:" << sizeof(SyncFileItem) - sizeof(void *) + movedStrings * sizeof(QString);
+    qDebug() << "ITEMS WITH RARELY SET STRINGS" << itemsWithExtraStrings;
+    if (heapBeforeSync < 0 || itemCount == 0) {
+        qDebug() << "Heap statistics not available on this platform";
+    } else {
+        qDebug() << "ITEMS" << itemCount << "HEAP BYTES PER ITEM AT PROPAGATION:" << (heapAtPropagation - heapBeforeSync) / itemCount;
+    }
+    return result ? 0 : -1;
+}
@@ -11,10 +11,13 @@
 #include "gui/sharepermissions.h"
 #include "httplogger.h"
 
+#include <QBuffer>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QRandomGenerator>
+#include <QUrlQuery>
 
 #include <memory>
 #if !defined(Q_OS_MACOS) || __MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_15
@@ -337,6 +340,70 @@ FileInfo *FileInfo::findInvalidatingEtags(PathComponents pathComponents)
     return find(std::move(pathComponents), true);
 }
 
+namespace {
+const QString davUri { QStringLiteral("DAV:") };
+const QString ocUri { QStringLiteral("http://owncloud.org/ns") };
+const QString ncUri { QStringLiteral("http://nextcloud.org/ns") };
+
+void writeFileResponse(QXmlStreamWriter &xml, QBuffer &buffer, const QString &prefix, const FileInfo &fileInfo, bool withContainedCounts = false)
+{
+    xml.writeStartElement(davUri, QStringLiteral("response"));
+
+    const auto url = OCC::Utility::trailingSlashPath(QString::fromUtf8(QUrl::toPercentEncoding(fileInfo.absolutePath(), "/")));
+    const auto href = OCC::Utility::concatUrlPath(prefix, url).path();
+    xml.writeTextElement(davUri, QStringLiteral("href"), href);
+    xml.writeStartElement(davUri, QStringLiteral("propstat"));
+    xml.writeStartElement(davUri, QStringLiteral("prop"));
+
+    if (fileInfo.isDir) {
+        xml.writeStartElement(davUri, QStringLiteral("resourcetype"));
+        xml.writeEmptyElement(davUri, QStringLiteral("collection"));
+        xml.writeEndElement(); // resourcetype
+
+        auto totalSize = 0;
+        for (const auto &child : fileInfo.children.values()) {
+            totalSize += child.size;
+        }
+        xml.writeTextElement(ocUri, QStringLiteral("size"), QString::number(totalSize));
+        if (withContainedCounts) {
+            const auto folderCount = std::count_if(fileInfo.children.cbegin(), fileInfo.children.cend(), [](const FileInfo &child) { return child.isDir; });
+            xml.writeTextElement(ncUri, QStringLiteral("contained-folder-count"), QString::number(folderCount));
+            xml.writeTextElement(ncUri, QStringLiteral("contained-file-count"), QString::number(fileInfo.children.size() - folderCount));
+        }
+    } else
+        xml.writeEmptyElement(davUri, QStringLiteral("resourcetype"));
+
+    auto gmtDate = fileInfo.lastModified.toUTC();
+    auto stringDate = QLocale::c().toString(gmtDate, QStringLiteral("ddd, dd MMM yyyy HH:mm:ss 'GMT'"));
+    xml.writeTextElement(davUri, QStringLiteral("getlastmodified"), stringDate);
+    xml.writeTextElement(davUri, QStringLiteral("getcontentlength"), QString::number(fileInfo.size));
+    xml.writeTextElement(davUri, QStringLiteral("getetag"), QStringLiteral("\"%1\"").arg(QString::fromLatin1(fileInfo.etag)));
+    xml.writeTextElement(ocUri, QStringLiteral("permissions"), !fileInfo.permissions.isNull() ? QString(fileInfo.permissions.toString()) : fileInfo.isShared ? QStringLiteral("SRDNVCKW") : QStringLiteral("RDNVCKW"));
+    xml.writeTextElement(ocUri, QStringLiteral("share-permissions"), QString::number(static_cast<int>(OCC::SharePermissions(OCC::SharePermissionRead |
+                                                                                                                            OCC::SharePermissionUpdate |
+                                                                                                                            OCC::SharePermissionCreate |
+                                                                                                                            OCC::SharePermissionDelete |
+                                                                                                                            OCC::SharePermissionShare))));
+    xml.writeTextElement(ocUri, QStringLiteral("id"), QString::fromUtf8(fileInfo.fileId));
+    xml.writeTextElement(ocUri, QStringLiteral("fileid"), QString::fromUtf8(fileInfo.fileId));
+    xml.writeTextElement(ocUri, QStringLiteral("checksums"), QString::fromUtf8(fileInfo.checksums));
+    xml.writeTextElement(ocUri, QStringLiteral("privatelink"), href);
+    xml.writeTextElement(ncUri, QStringLiteral("lock-owner"), fileInfo.lockOwnerId);
+    xml.writeTextElement(ncUri, QStringLiteral("lock"), fileInfo.lockState == FileInfo::LockState::FileLocked ? QStringLiteral("1") : QStringLiteral("0"));
+    xml.writeTextElement(ncUri, QStringLiteral("lock-owner-type"), fileInfo.lockOwnerId);
+    xml.writeTextElement(ncUri, QStringLiteral("lock-owner-displayname"), fileInfo.lockOwnerId);
+    xml.writeTextElement(ncUri, QStringLiteral("lock-owner-editor"), fileInfo.lockOwnerId);
+    xml.writeTextElement(ncUri, QStringLiteral("lock-time"), QString::number(fileInfo.lockTime));
+    xml.writeTextElement(ncUri, QStringLiteral("lock-timeout"), QString::number(fileInfo.lockTimeout));
+    xml.writeTextElement(ncUri, QStringLiteral("is-encrypted"), fileInfo.isEncrypted ? QString::number(1) : QString::number(0));
+    buffer.write(fileInfo.extraDavProperties);
+    xml.writeEndElement(); // prop
+    xml.writeTextElement(davUri, QStringLiteral("status"), QStringLiteral("HTTP/1.1 200 OK"));
+    xml.writeEndElement(); // propstat
+    xml.writeEndElement(); // response
+}
+}
+
 FakePropfindReply::FakePropfindReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
     : FakeReply { parent }
 {
@@ -355,9 +422,6 @@ FakePropfindReply::FakePropfindReply(FileInfo &remoteRootFileInfo, QNetworkAcces
     const QString prefix = request.url().path().left(request.url().path().size() - fileName.size());
 
     // Don't care about the request and just return a full propfind
-    const QString davUri { QStringLiteral("DAV:") };
-    const QString ocUri { QStringLiteral("http://owncloud.org/ns") };
-    const QString ncUri { QStringLiteral("http://nextcloud.org/ns") };
     QBuffer buffer { &payload };
     buffer.open(QIODevice::WriteOnly);
     QXmlStreamWriter xml(&buffer);
@@ -366,61 +430,10 @@ FakePropfindReply::FakePropfindReply(FileInfo &remoteRootFileInfo, QNetworkAcces
     xml.writeNamespace(ncUri, QStringLiteral("nc"));
     xml.writeStartDocument();
     xml.writeStartElement(davUri, QStringLiteral("multistatus"));
-    auto writeFileResponse = [&](const FileInfo &fileInfo) {
-        xml.writeStartElement(davUri, QStringLiteral("response"));
-
-        const auto url = OCC::Utility::trailingSlashPath(QString::fromUtf8(QUrl::toPercentEncoding(fileInfo.absolutePath(), "/")));
-        const auto href = OCC::Utility::concatUrlPath(prefix, url).path();
-        xml.writeTextElement(davUri, QStringLiteral("href"), href);
-        xml.writeStartElement(davUri, QStringLiteral("propstat"));
-        xml.writeStartElement(davUri, QStringLiteral("prop"));
-
-        if (fileInfo.isDir) {
-            xml.writeStartElement(davUri, QStringLiteral("resourcetype"));
-            xml.writeEmptyElement(davUri, QStringLiteral("collection"));
-            xml.writeEndElement(); // resourcetype
-
-            auto totalSize = 0;
-            for (const auto &child : fileInfo.children.values()) {
-                totalSize += child.size;
-            }
-            xml.writeTextElement(ocUri, QStringLiteral("size"), QString::number(totalSize));
-        } else
-            xml.writeEmptyElement(davUri, QStringLiteral("resourcetype"));
-
-        auto gmtDate = fileInfo.lastModified.toUTC();
-        auto stringDate = QLocale::c().toString(gmtDate, QStringLiteral("ddd, dd MMM yyyy HH:mm:ss 'GMT'"));
-        xml.writeTextElement(davUri, QStringLiteral("getlastmodified"), stringDate);
-        xml.writeTextElement(davUri, QStringLiteral("getcontentlength"), QString::number(fileInfo.size));
-        xml.writeTextElement(davUri, QStringLiteral("getetag"), QStringLiteral("\"%1\"").arg(QString::fromLatin1(fileInfo.etag)));
-        xml.writeTextElement(ocUri, QStringLiteral("permissions"), !fileInfo.permissions.isNull() ? QString(fileInfo.permissions.toString()) : fileInfo.isShared ? QStringLiteral("SRDNVCKW") : QStringLiteral("RDNVCKW"));
-        xml.writeTextElement(ocUri, QStringLiteral("share-permissions"), QString::number(static_cast<int>(OCC::SharePermissions(OCC::SharePermissionRead |
-                                                                                                                                OCC::SharePermissionUpdate |
-                                                                                                                                OCC::SharePermissionCreate |
-                                                                                                                                OCC::SharePermissionDelete |
-                                                                                                                                OCC::SharePermissionShare))));
-        xml.writeTextElement(ocUri, QStringLiteral("id"), QString::fromUtf8(fileInfo.fileId));
-        xml.writeTextElement(ocUri, QStringLiteral("fileid"), QString::fromUtf8(fileInfo.fileId));
-        xml.writeTextElement(ocUri, QStringLiteral("checksums"), QString::fromUtf8(fileInfo.checksums));
-        xml.writeTextElement(ocUri, QStringLiteral("privatelink"), href);
-        xml.writeTextElement(ncUri, QStringLiteral("lock-owner"), fileInfo.lockOwnerId);
-        xml.writeTextElement(ncUri, QStringLiteral("lock"), fileInfo.lockState == FileInfo::LockState::FileLocked ? QStringLiteral("1") : QStringLiteral("0"));
-        xml.writeTextElement(ncUri, QStringLiteral("lock-owner-type"), fileInfo.lockOwnerId);
-        xml.writeTextElement(ncUri, QStringLiteral("lock-owner-displayname"), fileInfo.lockOwnerId);
-        xml.writeTextElement(ncUri, QStringLiteral("lock-owner-editor"), fileInfo.lockOwnerId);
-        xml.writeTextElement(ncUri, QStringLiteral("lock-time"), QString::number(fileInfo.lockTime));
-        xml.writeTextElement(ncUri, QStringLiteral("lock-timeout"), QString::number(fileInfo.lockTimeout));
-        xml.writeTextElement(ncUri, QStringLiteral("is-encrypted"), fileInfo.isEncrypted ? QString::number(1) : QString::number(0));
-        buffer.write(fileInfo.extraDavProperties);
-        xml.writeEndElement(); // prop
-        xml.writeTextElement(davUri, QStringLiteral("status"), QStringLiteral("HTTP/1.1 200 OK"));
-        xml.writeEndElement(); // propstat
-        xml.writeEndElement(); // response
-    };
 
-    writeFileResponse(*fileInfo);
+    writeFileResponse(xml, buffer, prefix, *fileInfo);
     foreach (const FileInfo &childFileInfo, fileInfo->children)
-        writeFileResponse(childFileInfo);
+        writeFileResponse(xml, buffer, prefix, childFileInfo);
     xml.writeEndElement(); // multistatus
     xml.writeEndDocument();
 
@@ -472,6 +485,63 @@ qint64 FakePropfindReply::readData(char *data, qint64 maxlen)
     return len;
 }
 
+namespace {
+QByteArray searchResponse(FileInfo &remoteRootFileInfo, const QByteArray &searchRequest)
+{
+    // Only the scope and the modification time of the search are looked at
+    QString scope;
+    qint64 changedSince = 0;
+    QXmlStreamReader reader(searchRequest);
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        if (reader.name() == QLatin1String("href")) {
+            scope = reader.readElementText();
+        } else if (reader.name() == QLatin1String("literal")) {
+            changedSince = reader.readElementText().toLongLong();
+        }
+    }
+
+    QByteArray payload;
+    // The scope is /files/<dav user>/<remote folder>
+    const auto filesPrefix = QStringLiteral("/files/");
+    Q_ASSERT(scope.startsWith(filesPrefix));
+    const auto userEnd = scope.indexOf(QLatin1Char('/'), filesPrefix.size());
+    const auto userScope = userEnd < 0 ? scope : scope.left(userEnd);
+    const FileInfo *scopeInfo = remoteRootFileInfo.find(userEnd < 0 ? QString() : scope.mid(userEnd + 1));
+    Q_ASSERT(scopeInfo);
+    const auto hrefPrefix = OCC::Utility::trailingSlashPath(sRootUrl.path() + userScope.mid(1));
+
+    QBuffer buffer { &payload };
+    buffer.open(QIODevice::WriteOnly);
+    QXmlStreamWriter xml(&buffer);
+    xml.writeNamespace(davUri, QStringLiteral("d"));
+    xml.writeNamespace(ocUri, QStringLiteral("oc"));
+    xml.writeNamespace(ncUri, QStringLiteral("nc"));
+    xml.writeStartDocument();
+    xml.writeStartElement(davUri, QStringLiteral("multistatus"));
+    const std::function<void(const FileInfo &)> writeChanged = [&](const FileInfo &fileInfo) {
+        if (fileInfo.lastModified.toSecsSinceEpoch() > changedSince) {
+            writeFileResponse(xml, buffer, hrefPrefix, fileInfo, true);
+        }
+        for (const auto &child : fileInfo.children) {
+            writeChanged(child);
+        }
+    };
+    writeChanged(*scopeInfo);
+    xml.writeEndElement(); // multistatus
+    xml.writeEndDocument();
+    return payload;
+}
+}
+
+FakeSearchReply::FakeSearchReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, const QByteArray &searchRequest, QObject *parent)
+    : FakePropfindReply { searchResponse(remoteRootFileInfo, searchRequest), op, request, parent }
+{
+    open(QIODevice::ReadOnly);
+}
+
 FakePutReply::FakePutReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, const QByteArray &putPayload, QObject *parent)
     : FakeReply { parent }
 {
@@ -723,8 +793,19 @@ void FakeGetReply::respond()
     }
     payload = fileInfo->contentChar;
     size = fileInfo->size;
+    auto httpStatus = 200;
+    // Only closed ranges, resumed downloads keep getting the whole file
+    static const QRegularExpression rangePattern(QStringLiteral("^bytes=(\\d+)-(\\d+)$"));
+    if (const auto match = rangePattern.match(QString::fromLatin1(request().rawHeader("Range"))); match.hasMatch()) {
+        const auto start = match.captured(1).toLongLong();
+        const auto end = qMin(match.captured(2).toLongLong(), fileInfo->size - 1);
+        size = end - start + 1;
+        httpStatus = 206;
+        setRawHeader("Content-Range", "bytes " + QByteArray::number(start) + '-' + QByteArray::number(end)
+                + '/' + QByteArray::number(fileInfo->size));
+    }
     setHeader(QNetworkRequest::ContentLengthHeader, size);
-    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, httpStatus);
     setRawHeader("OC-ETag", fileInfo->etag);
     setRawHeader("ETag", fileInfo->etag);
     setRawHeader("OC-FileId", fileInfo->fileId);
@@ -917,6 +998,60 @@ void FakeChunkMoveReply::abort()
     emit finished();
 }
 
+FakeCopyRangeReply::FakeCopyRangeReply(FileInfo &remoteRootFileInfo, FileInfo &uploadsFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+    : FakeReply { parent }
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly);
+    const auto httpStatus = perform(remoteRootFileInfo, uploadsFileInfo, request);
+    QMetaObject::invokeMethod(this, "respond", Qt::QueuedConnection, Q_ARG(int, httpStatus));
+}
+
+int FakeCopyRangeReply::perform(FileInfo &remoteRootFileInfo, FileInfo &uploadsFileInfo, const QNetworkRequest &request)
+{
+    const auto source = remoteRootFileInfo.find(getFilePathFromUrl(request.url()));
+    if (!source || source->isDir) {
+        return 404;
+    }
+    if (request.rawHeader("If-Match") != '"' + source->etag + '"') {
+        return 412;
+    }
+
+    const auto range = request.rawHeader("OC-Source-Range");
+    Q_ASSERT(range.startsWith("bytes="));
+    const auto bounds = range.mid(qstrlen("bytes=")).split('-');
+    Q_ASSERT(bounds.size() == 2);
+    const auto start = bounds.at(0).toLongLong();
+    const auto end = bounds.at(1).toLongLong();
+    if (start < 0 || end < start || end >= source->size) {
+        return 416;
+    }
+
+    const auto destination = getFilePathFromUrl(QUrl::fromEncoded(request.rawHeader("Destination")));
+    Q_ASSERT(!destination.isEmpty());
+    // Like the moved chunks, only the size and the content character are tracked
+    uploadsFileInfo.create(destination, end - start + 1, source->contentChar);
+    return 201;
+}
+
+void FakeCopyRangeReply::respond(int httpStatus)
+{
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, httpStatus);
+    if (httpStatus >= 400) {
+        setError(InternalServerError, QStringLiteral("Copy failed"));
+    }
+    emit metaDataChanged();
+    emit finished();
+}
+
+void FakeCopyRangeReply::abort()
+{
+    setError(OperationCanceledError, QStringLiteral("abort"));
+    emit finished();
+}
+
 FakePayloadReply::FakePayloadReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, const QByteArray &body, QObject *parent)
     : FakePayloadReply(op, request, body, FakePayloadReply::defaultDelay, parent)
 {
@@ -960,6 +1095,106 @@ qint64 FakePayloadReply::bytesAvailable() const
     return _body.size();
 }
 
+namespace {
+
+void appendTarEntry(QByteArray &archive, const QByteArray &name, const QByteArray &data, char typeFlag, const QDateTime &mtime)
+{
+    QByteArray header(512, '\0');
+    const auto setField = [&header](int offset, const QByteArray &value) {
+        std::copy(value.cbegin(), value.cend(), header.begin() + offset);
+    };
+    setField(0, name.left(100));
+    setField(100, "0000644");
+    setField(108, "0000000");
+    setField(116, "0000000");
+    setField(124, QByteArray::number(data.size(), 8).rightJustified(11, '0'));
+    setField(136, QByteArray::number(mtime.toSecsSinceEpoch(), 8).rightJustified(11, '0'));
+    setField(148, QByteArray(8, ' '));
+    header[156] = typeFlag;
+    setField(257, QByteArray("ustar\0" "00", 8));
+
+    int checksum = 0;
+    for (const auto c : std::as_const(header)) {
+        checksum += static_cast<unsigned char>(c);
+    }
+    setField(148, QByteArray::number(checksum, 8).rightJustified(6, '0') + '\0' + ' ');
+
+    archive += header;
+    archive += data;
+    archive += QByteArray((512 - data.size() % 512) % 512, '\0');
+}
+
+}
+
+FakeArchiveGetReply::FakeArchiveGetReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+    : FakePayloadReply(op, request, makeArchive(remoteRootFileInfo, request), parent)
+{
+    _additionalHeaders.insert(QNetworkRequest::ContentTypeHeader, "application/x-tar");
+}
+
+QByteArray FakeArchiveGetReply::makeArchive(FileInfo &remoteRootFileInfo, const QNetworkRequest &request)
+{
+    QByteArray archive;
+    const auto folder = remoteRootFileInfo.find(getFilePathFromUrl(request.url()));
+    Q_ASSERT_X(folder, Q_FUNC_INFO, "Could not find folder on the remote");
+    const auto files = QJsonDocument::fromJson(QUrlQuery(request.url()).queryItemValue(QStringLiteral("files"), QUrl::FullyDecoded).toUtf8()).array();
+    for (const auto &file : files) {
+        const auto it = folder->children.constFind(file.toString());
+        if (it == folder->children.constEnd() || it->isDir) {
+            continue;
+        }
+        const auto name = it->name.toUtf8();
+        if (name.size() > 100) {
+            // GNU long name entry in front of the file
+            appendTarEntry(archive, "././@LongLink", name + '\0', 'L', it->lastModified);
+        }
+        appendTarEntry(archive, name, QByteArray(it->size, it->contentChar), '0', it->lastModified);
+    }
+    archive += QByteArray(2 * 512, '\0');
+    return archive;
+}
+
+FakeContentChunksGetReply::FakeContentChunksGetReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+    : FakePayloadReply(op, request, makeChunks(remoteRootFileInfo, request), parent)
+{
+    const auto fileInfo = remoteRootFileInfo.find(getFilePathFromUrl(request.url()));
+    setRawHeader("OC-ETag", fileInfo->etag);
+    setRawHeader("ETag", fileInfo->etag);
+}
+
+QByteArray FakeContentChunksGetReply::makeChunks(FileInfo &remoteRootFileInfo, const QNetworkRequest &request)
+{
+    const auto fileInfo = remoteRootFileInfo.find(getFilePathFromUrl(request.url()));
+    Q_ASSERT_X(fileInfo, Q_FUNC_INFO, "Could not find file on the remote");
+    QBuffer content;
+    content.setData(QByteArray(fileInfo->size, fileInfo->contentChar));
+    content.open(QIODevice::ReadOnly);
+    OCC::ContentChunker::Chunks chunks;
+    OCC::ContentChunker::computeChunks(&content, request.rawHeader("OC-Content-Chunks-Average-Size").toLongLong(), &chunks);
+    return OCC::ContentChunker::serialize(chunks);
+}
+
+QByteArray randomContent(qint64 size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (auto &byte : data) {
+        byte = static_cast<char>(QRandomGenerator::global()->bounded(256));
+    }
+    return data;
+}
+
+OCC::ContentChunker::Chunks contentChunksOf(const QByteArray &data, qint64 averageSize)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    OCC::ContentChunker::Chunks chunks;
+    if (!OCC::ContentChunker::computeChunks(&buffer, averageSize, &chunks)) {
+        chunks.clear();
+    }
+    return chunks;
+}
+
 FakeErrorReply::FakeErrorReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent, int httpErrorCode, const QByteArray &body)
     : FakeReply { parent }
     , _body(body)
@@ -1086,6 +1321,14 @@ QNetworkReply *FakeQNAM::createRequest(QNetworkAccessManager::Operation op, cons
         if (verb == QLatin1String("PROPFIND")) {
             // Ignore outgoingData always returning something good enough, works for now.
             reply = new FakePropfindReply { info, op, newRequest, this };
+        } else if (verb == QLatin1String("SEARCH")) {
+            reply = new FakeSearchReply { info, op, newRequest, outgoingData->readAll(), this };
+        } else if ((verb == QLatin1String("GET") || op == QNetworkAccessManager::GetOperation)
+                   && newRequest.rawHeader("Accept") == "application/x-tar") {
+            reply = new FakeArchiveGetReply { info, op, newRequest, this };
+        } else if ((verb == QLatin1String("GET") || op == QNetworkAccessManager::GetOperation)
+                   && newRequest.rawHeader("Accept") == "application/x-nextcloud-content-chunks") {
+            reply = new FakeContentChunksGetReply { info, op, newRequest, this };
         } else if (verb == QLatin1String("GET") || op == QNetworkAccessManager::GetOperation) {
             reply = new FakeGetReply { info, op, newRequest, this };
         } else if (verb == QLatin1String("PUT") || op == QNetworkAccessManager::PutOperation) {
@@ -1103,6 +1346,8 @@ QNetworkReply *FakeQNAM::createRequest(QNetworkAccessManager::Operation op, cons
             reply = new FakeMoveReply { info, op, newRequest, this };
         } else if (verb == QLatin1String("MOVE") && isUpload) {
             reply = new FakeChunkMoveReply { info, _remoteRootFileInfo, op, newRequest, this };
+        } else if (verb == QLatin1String("COPY") && newRequest.hasRawHeader("OC-Source-Range")) {
+            reply = new FakeCopyRangeReply { _remoteRootFileInfo, _uploadFileInfo, op, newRequest, this };
         } else if (verb == QLatin1String("POST") || op == QNetworkAccessManager::PostOperation) {
             if (contentType.startsWith(QStringLiteral("multipart/related; boundary="))) {
                 reply = new FakePutMultiFileReply { info, op, newRequest, contentType, outgoingData->readAll(), this };
@@ -15,6 +15,7 @@
 #include "common/syncjournaldb.h"
 #include "common/syncjournalfilerecord.h"
 #include "common/vfs.h"
+#include "contentchunker.h"
 #include "csync_exclude.h"
 
 #include <QDir>
@@ -230,6 +231,13 @@ public:
     qint64 readData(char *data, qint64 maxlen) override;
 };
 
+class FakeSearchReply : public FakePropfindReply
+{
+    Q_OBJECT
+public:
+    explicit FakeSearchReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, const QByteArray &searchRequest, QObject *parent);
+};
+
 class FakePutReply : public FakeReply
 {
     Q_OBJECT
@@ -361,6 +369,25 @@ public:
     qint64 readData(char *, qint64) override { return 0; }
 };
 
+// Creates a chunk of a chunked upload from a range of a remote file, see OCC::CopyRangeJob
+class FakeCopyRangeReply : public FakeReply
+{
+    Q_OBJECT
+public:
+    FakeCopyRangeReply(FileInfo &remoteRootFileInfo, FileInfo &uploadsFileInfo,
+        QNetworkAccessManager::Operation op, const QNetworkRequest &request,
+        QObject *parent);
+
+    /// Returns the HTTP status code of the reply
+    static int perform(FileInfo &remoteRootFileInfo, FileInfo &uploadsFileInfo, const QNetworkRequest &request);
+
+    Q_INVOKABLE void respond(int httpStatus);
+
+    void abort() override;
+
+    qint64 readData(char *, qint64) override { return 0; }
+};
+
 class FakePayloadReply : public FakeReply
 {
     Q_OBJECT
@@ -383,6 +410,28 @@ public:
     static const int defaultDelay = 10;
 };
 
+/* Answers a GET on a folder with "Accept: application/x-tar" like the server's
+ * archive download: a tar stream of the files named in the "files" query parameter */
+class FakeArchiveGetReply : public FakePayloadReply
+{
+    Q_OBJECT
+public:
+    FakeArchiveGetReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent);
+
+    static QByteArray makeArchive(FileInfo &remoteRootFileInfo, const QNetworkRequest &request);
+};
+
+/* Answers a GET on a file with "Accept: application/x-nextcloud-content-chunks" with
+ * the file's content chunks, see OCC::ContentChunker */
+class FakeContentChunksGetReply : public FakePayloadReply
+{
+    Q_OBJECT
+public:
+    FakeContentChunksGetReply(FileInfo &remoteRootFileInfo, QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent);
+
+    static QByteArray makeChunks(FileInfo &remoteRootFileInfo, const QNetworkRequest &request);
+};
+
 
 class FakeErrorReply : public FakeReply
 {
@@ -585,6 +634,12 @@ private:
     static void fromDisk(QDir &dir, FileInfo &templateFi);
 };
 
+/* Returns \a size random bytes, for files whose actual content matters to a test */
+QByteArray randomContent(qint64 size);
+
+/* Returns the content chunks of \a data, or none if they can't be computed */
+OCC::ContentChunker::Chunks contentChunksOf(const QByteArray &data, qint64 averageSize);
+
 /* Return the FileInfo for a conflict file for the specified relative filename */
 inline const FileInfo *findConflict(FileInfo &dir, const QString &filename)
 {
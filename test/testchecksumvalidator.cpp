@@ -222,6 +222,30 @@ private slots:
 #endif
     }
 
+    void testValidateCalculatedChecksum()
+    {
+        ValidateChecksumHeader vali;
+        connect(&vali, &ValidateChecksumHeader::validated, this, &TestChecksumValidator::slotDownValidated);
+        connect(&vali, &ValidateChecksumHeader::validationFailed, this, &TestChecksumValidator::slotDownError);
+
+        const QByteArray sha1 = "19b1928d58a2030d08023f3d7054516dbc186f20";
+
+        // The result is known before validate() returns
+        _successDown = false;
+        vali.validate("SHA1:" + sha1, checkSumSHA1C, sha1);
+        QVERIFY(_successDown);
+
+        _expectedError = QStringLiteral("The downloaded file does not match the checksum, it will be resumed. \"%1\" != \"bad\"").arg(QString::fromUtf8(sha1));
+        _expectedFailureReason = ValidateChecksumHeader::FailureReason::ChecksumMismatch;
+        _errorSeen = false;
+        vali.validate("SHA1:" + sha1, checkSumSHA1C, "bad");
+        QVERIFY(_errorSeen);
+
+        _successDown = false;
+        vali.validate(QByteArray(), QByteArray(), QByteArray());
+        QVERIFY(_successDown);
+    }
+
 
     void cleanupTestCase() {
     }
@@ -7,6 +7,7 @@
 
 #include "syncenginetestutils.h"
 
+#include <contentchunker.h>
 #include <owncloudpropagator.h>
 #include <syncengine.h>
 
@@ -53,6 +54,79 @@ static void setChunkSize(SyncEngine &engine, qint64 size)
     engine.setSyncOptions(options);
 }
 
+static void enableDeltaUpload(FakeFolder &fakeFolder, bool serverSupport)
+{
+    fakeFolder.syncEngine().account()->setCapabilities({ { "dav", QVariantMap{ { "chunking", "1.0" }, { "chunkingCopyRange", serverSupport } } } });
+    setChunkSize(fakeFolder.syncEngine(), 1 * 1000 * 1000);
+    auto options = fakeFolder.syncEngine().syncOptions();
+    options._deltaUpload = true;
+    fakeFolder.syncEngine().setSyncOptions(options);
+}
+
+static void writeLocalFile(FakeFolder &fakeFolder, const QString &relativePath, const QByteArray &data)
+{
+    QFile file(fakeFolder.localPath() + relativePath);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+/* The bytes of the chunked uploads, which the fake server only tracks by size and content character */
+struct ServerBytes
+{
+    QHash<QString, QByteArray> files; // by remote path
+    QHash<QString, QByteArray> chunks; // by path in the uploads folder
+    QByteArrayList copyRanges; // OC-Source-Range of the COPY requests
+    QList<qint64> putOffsets; // OC-Chunk-Offset of the PUT requests
+};
+
+/* The chunks are passed on to the fake server filled with 'W': files whose
+ * content is tracked must start with a 'W' for the local and remote states to compare equal */
+static void trackServerBytes(FakeFolder &fakeFolder, ServerBytes &bytes, QObject *parent)
+{
+    fakeFolder.setServerOverride([&fakeFolder, &bytes, parent](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *outgoingData) -> QNetworkReply * {
+        const auto isUpload = request.url().path().startsWith(sUploadUrl.path());
+        const auto path = getFilePathFromUrl(request.url());
+        const auto verb = request.attribute(QNetworkRequest::CustomVerbAttribute).toString();
+        if (op == QNetworkAccessManager::PutOperation && isUpload) {
+            const auto data = outgoingData->readAll();
+            bytes.chunks[path] = data;
+            bytes.putOffsets.append(request.rawHeader("OC-Chunk-Offset").toLongLong());
+            return new FakePutReply(fakeFolder.uploadState(), op, request, QByteArray(data.size(), 'W'), parent);
+        } else if (verb == QLatin1String("COPY") && request.hasRawHeader("OC-Source-Range")) {
+            const auto range = request.rawHeader("OC-Source-Range");
+            const auto bounds = range.mid(qstrlen("bytes=")).split('-');
+            const auto start = bounds.at(0).toLongLong();
+            const auto end = bounds.at(1).toLongLong();
+            bytes.copyRanges.append(range);
+            bytes.chunks[getFilePathFromUrl(QUrl::fromEncoded(request.rawHeader("Destination")))] = bytes.files.value(path).mid(start, end - start + 1);
+        } else if (verb == QLatin1String("MOVE") && isUpload) {
+            // Assemble the chunks in the order of their numbers
+            const auto folder = path.chopped(qstrlen(".file"));
+            QMap<qint64, QByteArray> chunks;
+            for (auto it = bytes.chunks.cbegin(); it != bytes.chunks.cend(); ++it) {
+                if (it.key().startsWith(folder)) {
+                    chunks.insert(it.key().mid(folder.size()).toLongLong(), it.value());
+                }
+            }
+            QByteArray content;
+            for (const auto &chunk : std::as_const(chunks)) {
+                content += chunk;
+            }
+            bytes.files[getFilePathFromUrl(QUrl::fromEncoded(request.rawHeader("Destination")))] = content;
+        } else if (op == QNetworkAccessManager::DeleteOperation && isUpload) {
+            const auto deleted = path.endsWith('/') ? path.chopped(1) : path;
+            for (auto it = bytes.chunks.begin(); it != bytes.chunks.end();) {
+                if (it.key() == deleted || it.key().startsWith(deleted + '/')) {
+                    it = bytes.chunks.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return nullptr;
+    });
+}
+
 class TestChunkingNG : public QObject
 {
     Q_OBJECT
@@ -673,7 +747,206 @@ private slots:
         QCOMPARE(fakeFolder.currentRemoteState().find("A/a0")->size, size + 1);
     }
 
+    void testContentChunker()
+    {
+        const auto previous = randomContent(3 * 1000 * 1000);
+        auto current = previous;
+        current.insert(1000 * 1000, QByteArray(1000, 'x'));
+        current.remove(2 * 1000 * 1000, 500);
+
+        const auto chunksOf = [](const QByteArray &data) {
+            return contentChunksOf(data, ContentChunker::averageChunkSize(data.size()));
+        };
+        const auto previousChunks = chunksOf(previous);
+        QVERIFY(!previousChunks.isEmpty());
+        QCOMPARE(ContentChunker::deserialize(ContentChunker::serialize(previousChunks)).size(), previousChunks.size());
+        QCOMPARE(ContentChunker::deserialize(ContentChunker::serialize(previousChunks)).last().hash, previousChunks.last().hash);
+
+        constexpr auto minSegmentSize = 200 * 1000;
+        const auto segments = ContentChunker::planSegments(ContentChunker::deserialize(ContentChunker::serialize(previousChunks)),
+                                                         chunksOf(current), minSegmentSize, 10000);
+        QVERIFY(segments.size() >= 3);
+
+        // The segments rebuild the current version and most of it is copied
+        QByteArray rebuilt;
+        qint64 copied = 0;
+        for (const auto &segment : segments) {
+            QCOMPARE(segment.offset, qint64(rebuilt.size()));
+            if (&segment != &segments.last()) {
+                QVERIFY(segment.size >= minSegmentSize);
+            }
+            if (segment.isCopy()) {
+                rebuilt += previous.mid(segment.sourceOffset, segment.size);
+                copied += segment.size;
+            } else {
+                rebuilt += current.mid(segment.offset, segment.size);
+            }
+        }
+        QCOMPARE(rebuilt, current);
+        QVERIFY(copied > current.size() / 2);
+
+        // Nothing in common, nothing to copy
+        QVERIFY(ContentChunker::planSegments(chunksOf(QByteArray(previous.size(), 'a')), previousChunks, minSegmentSize, 10000).isEmpty());
+    }
+
+    void testDeltaUpload()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaUpload(fakeFolder, true);
+        const qint64 size = 30 * 1000 * 1000; // 30 MB
+
+        fakeFolder.localModifier().insert("A/a0", size);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        const auto contentChunks = fakeFolder.syncJournal().getContentChunks(QStringLiteral("A/a0"));
+        QVERIFY(contentChunks._valid);
+        QCOMPARE(contentChunks._etag, fakeFolder.currentRemoteState().find("A/a0")->etag);
+
+        int copyRequests = 0;
+        qint64 uploadedSize = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *outgoingData) -> QNetworkReply * {
+            if (request.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QStringLiteral("COPY")) {
+                ++copyRequests;
+            } else if (op == QNetworkAccessManager::PutOperation) {
+                uploadedSize += outgoingData->size();
+            }
+            return nullptr;
+        });
+
+        // Only the end of the file changed
+        fakeFolder.localModifier().appendByte("A/a0");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(fakeFolder.currentRemoteState().find("A/a0")->size, size + 1);
+        QCOMPARE(copyRequests, 1);
+        QVERIFY(uploadedSize > 0);
+        QVERIFY(uploadedSize < size / 10);
+        QCOMPARE(fakeFolder.syncJournal().getContentChunks(QStringLiteral("A/a0"))._etag, fakeFolder.currentRemoteState().find("A/a0")->etag);
+    }
+
+    void testDeltaUploadFallback()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaUpload(fakeFolder, true);
+        const qint64 size = 30 * 1000 * 1000; // 30 MB
+
+        fakeFolder.localModifier().insert("A/a0", size);
+        QVERIFY(fakeFolder.syncOnce());
+
+        // The server can't copy after all: everything is uploaded
+        int copyRequests = 0;
+        qint64 uploadedSize = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *outgoingData) -> QNetworkReply * {
+            if (request.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QStringLiteral("COPY")) {
+                ++copyRequests;
+                return new FakeErrorReply(op, request, this, 501);
+            } else if (op == QNetworkAccessManager::PutOperation) {
+                uploadedSize += outgoingData->size();
+            }
+            return nullptr;
+        });
+        fakeFolder.localModifier().appendByte("A/a0");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(copyRequests, 1);
+        QCOMPARE(uploadedSize, size + 1);
+
+        // Without the capability nothing is copied
+        enableDeltaUpload(fakeFolder, false);
+        copyRequests = 0;
+        uploadedSize = 0;
+        fakeFolder.localModifier().appendByte("A/a0");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(fakeFolder.currentRemoteState().find("A/a0")->size, size + 2);
+        QCOMPARE(copyRequests, 0);
+        QCOMPARE(uploadedSize, size + 2);
+    }
+
+    void testDeltaUploadContent()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaUpload(fakeFolder, true);
+        ServerBytes serverBytes;
+        trackServerBytes(fakeFolder, serverBytes, this);
+
+        auto previous = randomContent(30 * 1000 * 1000); // 30 MB
+        previous[0] = 'W';
+        writeLocalFile(fakeFolder, "A/a0", previous);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(serverBytes.files.value("A/a0"), previous);
+
+        // A region in the middle is edited and grows, everything after it moves
+        auto current = previous;
+        current.replace(15 * 1000 * 1000, 1000, randomContent(3000));
+        writeLocalFile(fakeFolder, "A/a0", current);
+
+        // Each copy is one of the segments planned from the chunks of the previous version
+        const auto contentChunks = fakeFolder.syncJournal().getContentChunks(QStringLiteral("A/a0"));
+        QVERIFY(contentChunks._valid);
+        const auto segments = ContentChunker::planSegments(ContentChunker::deserialize(contentChunks._chunks),
+            contentChunksOf(current, contentChunks._averageSize), fakeFolder.syncEngine().syncOptions().minChunkSize(), 10000);
+        QByteArrayList expectedRanges;
+        for (const auto &segment : segments) {
+            if (segment.isCopy()) {
+                expectedRanges.append("bytes=" + QByteArray::number(segment.sourceOffset) + '-' + QByteArray::number(segment.sourceOffset + segment.size - 1));
+            }
+        }
+        QVERIFY(expectedRanges.size() >= 2);
+
+        serverBytes.copyRanges.clear();
+        serverBytes.putOffsets.clear();
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(serverBytes.copyRanges, expectedRanges);
+        QVERIFY(!serverBytes.putOffsets.isEmpty());
+        QCOMPARE(serverBytes.files.value("A/a0"), current);
+    }
 
+    // The chunks on the server end in the middle of a segment that would be copied
+    void testDeltaUploadResumeInCopiedSegment()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaUpload(fakeFolder, true);
+        ServerBytes serverBytes;
+        trackServerBytes(fakeFolder, serverBytes, this);
+
+        auto previous = randomContent(30 * 1000 * 1000); // 30 MB
+        previous[0] = 'W';
+        writeLocalFile(fakeFolder, "A/a0", previous);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(serverBytes.files.value("A/a0"), previous);
+
+        // Only the end changes, the first copied segment covers most of the file
+        auto current = previous;
+        current.replace(25 * 1000 * 1000, 1000, randomContent(3000));
+        writeLocalFile(fakeFolder, "A/a0", current);
+
+        // A first attempt without delta upload is aborted after its first chunk
+        enableDeltaUpload(fakeFolder, false);
+        serverBytes.putOffsets.clear();
+        const auto con = connect(&fakeFolder.syncEngine(), &SyncEngine::transmissionProgress, [&](const ProgressInfo &progress) {
+            if (progress.completedSize() > 0) {
+                fakeFolder.syncEngine().abort();
+            }
+        });
+        QVERIFY(!fakeFolder.syncOnce());
+        disconnect(con);
+        QVERIFY(!serverBytes.putOffsets.isEmpty());
+        QVERIFY(serverBytes.putOffsets.last() < 20 * 1000 * 1000);
+
+        // The resumed upload can't start with a copy, it uploads the rest
+        enableDeltaUpload(fakeFolder, true);
+        serverBytes.copyRanges.clear();
+        serverBytes.putOffsets.clear();
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QVERIFY(serverBytes.copyRanges.isEmpty());
+        QVERIFY(!serverBytes.putOffsets.isEmpty());
+        QVERIFY(serverBytes.putOffsets.first() > 0);
+        QCOMPARE(serverBytes.files.value("A/a0"), current);
+    }
 };
 
 QTEST_GUILESS_MAIN(TestChunkingNG)
@@ -257,6 +257,60 @@ private slots:
         chunkedOutputDecrypted.close();
     }
 
+    void testStreamingEncryptor_data()
+    {
+        QTest::addColumn<int>("totalBytes");
+        QTest::addColumn<int>("bytesToRead");
+
+        QTest::newRow("data1") << 64 << 3;
+        QTest::newRow("data2") << 1000 << 16;
+        QTest::newRow("data3") << 5000 << 1500;
+    }
+
+    void testStreamingEncryptor()
+    {
+        QFETCH(int, totalBytes);
+        QFETCH(int, bytesToRead);
+
+        const auto contents = EncryptionHelper::generateRandom(totalBytes);
+        const auto encryptionKey = EncryptionHelper::generateRandom(16);
+        const auto initializationVector = EncryptionHelper::generateRandom(16);
+
+        QTemporaryFile inputFile;
+        QVERIFY(inputFile.open());
+        QCOMPARE(inputFile.write(contents), contents.size());
+        inputFile.close();
+
+        QTemporaryFile encryptedFile;
+        QByteArray tag;
+        QVERIFY(EncryptionHelper::fileEncryption(encryptionKey, initializationVector, &inputFile, &encryptedFile, tag));
+        QVERIFY(encryptedFile.open());
+        const auto expected = encryptedFile.readAll();
+        QCOMPARE(expected.size(), totalBytes + OCC::Constants::e2EeTagSize);
+
+        // encrypting from the start yields the same data and tag
+        EncryptionHelper::StreamingEncryptor encryptor(encryptionKey, initializationVector);
+        QVERIFY(encryptor.isInitialized());
+        QByteArray encrypted;
+        for (int pos = 0; pos < totalBytes; pos += bytesToRead) {
+            const auto size = qMin(bytesToRead, totalBytes - pos);
+            const auto chunk = encryptor.chunkEncryption(contents.constData() + pos, size);
+            QCOMPARE(chunk.size(), size);
+            encrypted += chunk;
+        }
+        encrypted += encryptor.finalize();
+        QVERIFY(encryptor.isFinished());
+        QCOMPARE(encrypted, expected);
+
+        // encrypting from any offset matches the data at that offset
+        for (const auto offset : {1, 15, 16, 17, totalBytes / 2, totalBytes - 1}) {
+            EncryptionHelper::StreamingEncryptor partialEncryptor(encryptionKey, initializationVector, offset);
+            QVERIFY(partialEncryptor.isInitialized());
+            const auto chunk = partialEncryptor.chunkEncryption(contents.constData() + offset, totalBytes - offset);
+            QCOMPARE(chunk, expected.mid(offset, totalBytes - offset));
+        }
+    }
+
     void testGzipThenEncryptDataAndBack()
     {
         const auto metadataKeySize = 16;
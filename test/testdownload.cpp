@@ -7,8 +7,10 @@
 
 #include <QtTest>
 #include "syncenginetestutils.h"
+#include <contentchunker.h>
 #include <syncengine.h>
 #include <owncloudpropagator.h>
+#include <propagatorjobs.h>
 
 using namespace OCC;
 
@@ -39,6 +41,84 @@ public:
     }
 };
 
+/* A reply that sends the given content of the file, honors a Range header and sends a checksum header for the whole file */
+class RangeFakeGetReply : public FakeReply
+{
+    Q_OBJECT
+public:
+    RangeFakeGetReply(const FileInfo &fileInfo, const QByteArray &content, const QByteArray &checksumHeader,
+        QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+        : FakeReply(parent)
+    {
+        setRequest(request);
+        setUrl(request.url());
+        setOperation(op);
+        open(QIODevice::ReadOnly);
+
+        static const QRegularExpression rangePattern(QStringLiteral("bytes=(\\d+)-(\\d*)"));
+        const auto match = rangePattern.match(QString::fromUtf8(request.rawHeader("Range")));
+        const auto start = match.hasMatch() ? match.captured(1).toLongLong() : 0;
+        const auto end = match.hasMatch() && !match.captured(2).isEmpty() ? match.captured(2).toLongLong() : content.size() - 1;
+        payload = content.mid(start, end - start + 1);
+
+        setHeader(QNetworkRequest::ContentLengthHeader, payload.size());
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, match.hasMatch() ? 206 : 200);
+        if (match.hasMatch()) {
+            setRawHeader("Content-Range", "bytes " + QByteArray::number(start) + '-'
+                    + QByteArray::number(end) + '/' + QByteArray::number(content.size()));
+        }
+        setRawHeader("OC-ETag", fileInfo.etag);
+        setRawHeader("ETag", fileInfo.etag);
+        setRawHeader("OC-FileId", fileInfo.fileId);
+        if (!checksumHeader.isEmpty()) {
+            setRawHeader(checkSumHeaderC, checksumHeader);
+        }
+
+        QMetaObject::invokeMethod(this, [this] {
+            emit metaDataChanged();
+            emit readyRead();
+            emit finished();
+        }, Qt::QueuedConnection);
+    }
+
+    void abort() override
+    {
+        setError(OperationCanceledError, QStringLiteral("Operation Canceled"));
+    }
+
+    [[nodiscard]] qint64 bytesAvailable() const override
+    {
+        return payload.size() - offset + QIODevice::bytesAvailable();
+    }
+
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        const auto len = std::min(payload.size() - offset, maxlen);
+        std::memcpy(data, payload.constData() + offset, len);
+        offset += len;
+        return len;
+    }
+
+    QByteArray payload;
+    qint64 offset = 0;
+};
+
+static void enableDeltaDownload(FakeFolder &fakeFolder, bool serverSupport)
+{
+    fakeFolder.syncEngine().account()->setCapabilities({ { "dav", QVariantMap{ { "contentChunks", serverSupport } } } });
+    auto options = fakeFolder.syncEngine().syncOptions();
+    options._deltaDownload = true;
+    fakeFolder.syncEngine().setSyncOptions(options);
+}
+
+static QByteArray readLocalFile(FakeFolder &fakeFolder, const QString &relativePath)
+{
+    QFile file(fakeFolder.localPath() + relativePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
 
 SyncFileItemPtr getItem(const QSignalSpy &spy, const QString &path)
 {
@@ -98,6 +178,50 @@ private slots:
         QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
     }
 
+    void testResumeWithChecksum_data()
+    {
+        QTest::addColumn<bool>("writerThread");
+
+        QTest::newRow("writer thread") << true;
+        QTest::newRow("no writer thread") << false;
+    }
+
+    void testResumeWithChecksum()
+    {
+        QFETCH(bool, writerThread);
+
+        FakeFolder fakeFolder{ FileInfo::A12_B12_C12_S12() };
+        fakeFolder.syncEngine().setIgnoreHiddenFiles(true);
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._downloadWriterThread = writerThread;
+        fakeFolder.syncEngine().setSyncOptions(options);
+        const auto size = 30 * 1000 * 1000;
+        fakeFolder.remoteModifier().insert("A/a0", size);
+
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::GetOperation && request.url().path().endsWith("A/a0")) {
+                return new BrokenFakeGetReply(fakeFolder.remoteModifier(), op, request, this);
+            }
+            return nullptr;
+        });
+        QVERIFY(!fakeFolder.syncOnce());
+
+        // The checksum computed while downloading must include the part downloaded before
+        const auto checksumHeader = "SHA1:" + QCryptographicHash::hash(QByteArray(size, 'W'), QCryptographicHash::Sha1).toHex();
+        QByteArray ranges;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::GetOperation && request.url().path().endsWith("A/a0")) {
+                ranges = request.rawHeader("Range");
+                const auto fileInfo = fakeFolder.remoteModifier().find("A/a0");
+                return new RangeFakeGetReply(*fileInfo, QByteArray(fileInfo->size, fileInfo->contentChar), checksumHeader, op, request, this);
+            }
+            return nullptr;
+        });
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(ranges, QByteArray("bytes=" + QByteArray::number(stopAfter) + "-"));
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+    }
+
     void testErrorMessage () {
         // This test's main goal is to test that the error string from the server is shown in the UI
 
@@ -249,6 +373,342 @@ private slots:
         QCOMPARE(getItem(completeSpy, "A/resendme")->_status, SyncFileItem::NormalError);
         QVERIFY(getItem(completeSpy, "A/resendme")->_errorString.contains(serverMessage));
     }
+
+    void testBulkDownload()
+    {
+        FakeFolder fakeFolder{FileInfo{}};
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._bulkDownload = true;
+        fakeFolder.syncEngine().setSyncOptions(options);
+
+        fakeFolder.remoteModifier().mkdir("A");
+        for (int i = 0; i < 150; ++i) {
+            fakeFolder.remoteModifier().insert(QStringLiteral("A/file%1").arg(i), 100 + i, 'a' + i % 26);
+        }
+        fakeFolder.remoteModifier().insert("A/empty", 0);
+        fakeFolder.remoteModifier().mkdir("B");
+        // needs a GNU long name entry in the archive
+        fakeFolder.remoteModifier().insert(QStringLiteral("B/") + QString(120, 'x'), 700);
+        // too large for a bulk download
+        fakeFolder.remoteModifier().insert("B/large", options.minChunkSize());
+        fakeFolder.remoteModifier().insert("rootfile", 10);
+
+        // a correct checksum is verified, a wrong one makes the file fall back to a regular download
+        auto &remoteRoot = fakeFolder.remoteModifier();
+        remoteRoot.find("A/file1")->checksums = "SHA1:" + QCryptographicHash::hash(QByteArray(101, 'b'), QCryptographicHash::Sha1).toHex();
+        remoteRoot.find("A/file2")->checksums = "SHA1:0000000000000000000000000000000000000000";
+
+        int archiveRequests = 0;
+        QStringList fileRequests;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::GetOperation) {
+                if (request.rawHeader("Accept") == "application/x-tar") {
+                    ++archiveRequests;
+                } else {
+                    fileRequests.append(getFilePathFromUrl(request.url()));
+                }
+            }
+            return nullptr;
+        });
+
+        ItemCompletedSpy completeSpy(fakeFolder);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+
+        // A is split into two batches, B and the root need one archive each
+        QCOMPARE(archiveRequests, 4);
+        fileRequests.sort();
+        QCOMPARE(fileRequests, QStringList({"A/file2", "B/large"}));
+        QVERIFY(completeSpy.findItem("A/file42")->_status == SyncFileItem::Success);
+        QVERIFY(completeSpy.findItem("A/file2")->_status == SyncFileItem::Success);
+
+        SyncJournalFileRecord record;
+        QVERIFY(fakeFolder.syncJournal().getFileRecord(QByteArrayLiteral("A/file42"), &record));
+        QVERIFY(record.isValid());
+        QCOMPARE(record._etag, remoteRoot.find("A/file42")->etag);
+        QCOMPARE(record._fileSize, qint64{142});
+
+        // Nothing left to do
+        archiveRequests = 0;
+        fileRequests.clear();
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(archiveRequests, 0);
+        QVERIFY(fileRequests.isEmpty());
+    }
+
+    void testBulkDownloadNotSupported()
+    {
+        FakeFolder fakeFolder{FileInfo{}};
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._bulkDownload = true;
+        fakeFolder.syncEngine().setSyncOptions(options);
+
+        fakeFolder.remoteModifier().mkdir("A");
+        fakeFolder.remoteModifier().mkdir("B");
+        for (int i = 0; i < 10; ++i) {
+            fakeFolder.remoteModifier().insert(QStringLiteral("A/a%1").arg(i));
+            fakeFolder.remoteModifier().insert(QStringLiteral("B/b%1").arg(i));
+        }
+
+        int fileRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::GetOperation) {
+                if (request.rawHeader("Accept") == "application/x-tar") {
+                    return new FakeErrorReply(op, request, this, 405);
+                }
+                ++fileRequests;
+            }
+            return nullptr;
+        });
+
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(fileRequests, 20);
+    }
+
+    void testBulkDownloadAbort()
+    {
+        FakeFolder fakeFolder{FileInfo{}};
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._bulkDownload = true;
+        fakeFolder.syncEngine().setSyncOptions(options);
+
+        for (int i = 0; i < 5; ++i) {
+            const auto folder = QStringLiteral("F%1").arg(i);
+            fakeFolder.remoteModifier().mkdir(folder);
+            for (int j = 0; j < 3; ++j) {
+                fakeFolder.remoteModifier().insert(QStringLiteral("%1/file%2").arg(folder).arg(j));
+            }
+        }
+
+        // The sync is aborted while the first archive is downloading and the
+        // other batches are still waiting to start: they have to finish anyway.
+        QObject parent;
+        int archiveRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::GetOperation && request.rawHeader("Accept") == "application/x-tar") {
+                if (archiveRequests++ == 0) {
+                    QTimer::singleShot(0, &fakeFolder.syncEngine(), [&]() { fakeFolder.syncEngine().abort(); });
+                }
+                return new FakeHangingReply(op, request, &parent);
+            }
+            return nullptr;
+        });
+
+        QVERIFY(!fakeFolder.syncOnce());
+        QVERIFY(!fakeFolder.syncEngine().isSyncRunning());
+
+        fakeFolder.setServerOverride(nullptr);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+    }
+
+    void testDeltaDownload()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaDownload(fakeFolder, true);
+        const qint64 size = 30 * 1000 * 1000; // 30 MB
+
+        fakeFolder.remoteModifier().insert("A/big", size);
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+
+        int chunkRequests = 0;
+        int rangeRequests = 0;
+        int fullRequests = 0;
+        qint64 rangeSize = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op != QNetworkAccessManager::GetOperation) {
+                return nullptr;
+            }
+            static const QRegularExpression rangePattern(QStringLiteral("^bytes=(\\d+)-(\\d+)$"));
+            const auto match = rangePattern.match(QString::fromLatin1(request.rawHeader("Range")));
+            if (request.rawHeader("Accept") == "application/x-nextcloud-content-chunks") {
+                ++chunkRequests;
+            } else if (match.hasMatch()) {
+                ++rangeRequests;
+                rangeSize += match.captured(2).toLongLong() - match.captured(1).toLongLong() + 1;
+            } else {
+                ++fullRequests;
+            }
+            return nullptr;
+        });
+
+        // Only the end of the file changed
+        fakeFolder.remoteModifier().appendByte("A/big");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(fakeFolder.currentLocalState().find("A/big")->size, size + 1);
+        QCOMPARE(chunkRequests, 1);
+        QCOMPARE(rangeRequests, 1);
+        QCOMPARE(fullRequests, 0);
+        QVERIFY(rangeSize < size / 10);
+        // The chunks of the downloaded version are kept for uploads
+        QCOMPARE(fakeFolder.syncJournal().getContentChunks(QStringLiteral("A/big"))._etag, fakeFolder.currentRemoteState().find("A/big")->etag);
+    }
+
+    void testDeltaDownloadFallback()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaDownload(fakeFolder, true);
+        const qint64 size = 30 * 1000 * 1000; // 30 MB
+
+        fakeFolder.remoteModifier().insert("A/big", size);
+        QVERIFY(fakeFolder.syncOnce());
+
+        int chunkRequests = 0;
+        int rangeRequests = 0;
+        int fullRequests = 0;
+        bool failRanges = false;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op != QNetworkAccessManager::GetOperation) {
+                return nullptr;
+            }
+            static const QRegularExpression rangePattern(QStringLiteral("^bytes=\\d+-\\d+$"));
+            if (request.rawHeader("Accept") == "application/x-nextcloud-content-chunks") {
+                ++chunkRequests;
+            } else if (rangePattern.match(QString::fromLatin1(request.rawHeader("Range"))).hasMatch()) {
+                ++rangeRequests;
+                if (failRanges) {
+                    return new FakeErrorReply(op, request, this, 416);
+                }
+            } else {
+                ++fullRequests;
+            }
+            return nullptr;
+        });
+
+        // Nothing can be reused: the whole file is downloaded
+        fakeFolder.remoteModifier().setContents("A/big", 'X');
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(chunkRequests, 1);
+        QCOMPARE(rangeRequests, 0);
+        QCOMPARE(fullRequests, 1);
+
+        // The server doesn't answer the range: the whole file is downloaded with a normal GET
+        chunkRequests = rangeRequests = fullRequests = 0;
+        failRanges = true;
+        fakeFolder.remoteModifier().appendByte("A/big");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(fakeFolder.currentLocalState().find("A/big")->size, size + 1);
+        QCOMPARE(chunkRequests, 1);
+        QCOMPARE(rangeRequests, 1);
+        QCOMPARE(fullRequests, 1);
+
+        // Without the capability the chunks aren't asked for
+        enableDeltaDownload(fakeFolder, false);
+        chunkRequests = rangeRequests = fullRequests = 0;
+        fakeFolder.remoteModifier().appendByte("A/big");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(chunkRequests, 0);
+        QCOMPARE(rangeRequests, 0);
+        QCOMPARE(fullRequests, 1);
+    }
+
+    void testDeltaDownloadContent_data()
+    {
+        QTest::addColumn<bool>("failRange");
+        QTest::addColumn<bool>("abortSync");
+
+        QTest::newRow("ranges downloaded") << false << false;
+        QTest::newRow("range fails") << true << false;
+        QTest::newRow("sync aborted") << false << true;
+    }
+
+    void testDeltaDownloadContent()
+    {
+        QFETCH(bool, failRange);
+        QFETCH(bool, abortSync);
+
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        enableDeltaDownload(fakeFolder, true);
+
+        // The fake server only tracks a size and a content character, the override sends the actual bytes.
+        // They start with the content character for the local and remote states to compare equal.
+        auto content = randomContent(30 * 1000 * 1000); // 30 MB
+        content[0] = 'W';
+        fakeFolder.remoteModifier().insert("A/big", content.size());
+
+        int chunkRequests = 0;
+        int fullRequests = 0;
+        QByteArrayList ranges;
+        QObject parent;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op != QNetworkAccessManager::GetOperation || getFilePathFromUrl(request.url()) != QStringLiteral("A/big")) {
+                return nullptr;
+            }
+            const auto fileInfo = fakeFolder.remoteModifier().find("A/big");
+            if (request.rawHeader("Accept") == "application/x-nextcloud-content-chunks") {
+                ++chunkRequests;
+                const auto chunks = contentChunksOf(content, request.rawHeader("OC-Content-Chunks-Average-Size").toLongLong());
+                const auto reply = new FakePayloadReply(op, request, ContentChunker::serialize(chunks), this);
+                reply->setRawHeader("OC-ETag", fileInfo->etag);
+                reply->setRawHeader("ETag", fileInfo->etag);
+                return reply;
+            }
+            if (!request.hasRawHeader("Range")) {
+                ++fullRequests;
+            } else {
+                ranges.append(request.rawHeader("Range"));
+                if (failRange && ranges.size() == 1) {
+                    return new FakeErrorReply(op, request, this, 416);
+                }
+                if (abortSync && ranges.size() == 1) {
+                    QTimer::singleShot(0, &fakeFolder.syncEngine(), [&]() { fakeFolder.syncEngine().abort(); });
+                    return new FakeHangingReply(op, request, &parent);
+                }
+            }
+            return new RangeFakeGetReply(*fileInfo, content, {}, op, request, this);
+        });
+
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(readLocalFile(fakeFolder, "A/big"), content);
+
+        // A region in the middle is edited and grows, everything after it moves
+        const auto previous = content;
+        content.replace(15 * 1000 * 1000, 1000, randomContent(3000));
+        fakeFolder.remoteModifier().find("A/big")->size = content.size();
+        fakeFolder.remoteModifier().find("A/big", /*invalidateEtags=*/true);
+
+        // Only what can't be copied from the local file is downloaded
+        const auto averageSize = ContentChunker::averageChunkSize(content.size());
+        const auto segments = ContentChunker::planSegments(contentChunksOf(previous, averageSize), contentChunksOf(content, averageSize), averageSize, 1000);
+        QByteArrayList expectedRanges;
+        for (const auto &segment : segments) {
+            if (!segment.isCopy()) {
+                expectedRanges.append("bytes=" + QByteArray::number(segment.offset) + '-' + QByteArray::number(segment.offset + segment.size - 1));
+            }
+        }
+        QVERIFY(!expectedRanges.isEmpty());
+
+        chunkRequests = fullRequests = 0;
+        ranges.clear();
+        if (abortSync) {
+            QVERIFY(!fakeFolder.syncOnce());
+            QCOMPARE(ranges, QByteArrayList{ expectedRanges.first() });
+
+            // The part put together before the abort isn't verified, it is not resumed
+            abortSync = false;
+            chunkRequests = 0;
+            ranges.clear();
+        }
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(chunkRequests, 1);
+        if (failRange) {
+            // Nothing of the part put together so far is kept
+            QCOMPARE(fullRequests, 1);
+            QCOMPARE(ranges, QByteArrayList{ expectedRanges.first() });
+        } else {
+            QCOMPARE(fullRequests, 0);
+            QCOMPARE(ranges, expectedRanges);
+        }
+        QCOMPARE(readLocalFile(fakeFolder, "A/big"), content);
+    }
 };
 
 QTEST_GUILESS_MAIN(TestDownload)
@@ -104,14 +104,14 @@ private slots:
         QCOMPARE(check_file_full("/tmp/check_csync2/foo"), CSYNC_NOT_EXCLUDED);
         QVERIFY(excludedFiles->_allExcludes[QStringLiteral("/")].contains("/tmp/check_csync1/*"));
 
-        QVERIFY(excludedFiles->_fullRegexFile[QStringLiteral("/")].pattern().contains("csync1"));
-        QVERIFY(excludedFiles->_fullTraversalRegexFile[QStringLiteral("/")].pattern().contains("csync1"));
-        QVERIFY(!excludedFiles->_bnameTraversalRegexFile[QStringLiteral("/")].pattern().contains("csync1"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/")]->fullRegexFile.pattern().contains("csync1"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/")]->fullTraversalRegexFile.pattern().contains("csync1"));
+        QVERIFY(!excludedFiles->_patternSets[QStringLiteral("/")]->bnameTraversalRegexFile.pattern().contains("csync1"));
 
         excludedFiles->addManualExclude("foo");
-        QVERIFY(excludedFiles->_bnameTraversalRegexFile[QStringLiteral("/")].pattern().contains("foo"));
-        QVERIFY(excludedFiles->_fullRegexFile[QStringLiteral("/")].pattern().contains("foo"));
-        QVERIFY(!excludedFiles->_fullTraversalRegexFile[QStringLiteral("/")].pattern().contains("foo"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/")]->bnameTraversalRegexFile.pattern().contains("foo"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/")]->fullRegexFile.pattern().contains("foo"));
+        QVERIFY(!excludedFiles->_patternSets[QStringLiteral("/")]->fullTraversalRegexFile.pattern().contains("foo"));
     }
 
     void check_csync_exclude_add_per_dir()
@@ -123,12 +123,34 @@ private slots:
         QVERIFY(excludedFiles->_allExcludes[QStringLiteral("/tmp/check_csync1/")].contains("*"));
 
         excludedFiles->addManualExclude("foo");
-        QVERIFY(excludedFiles->_fullRegexFile[QStringLiteral("/")].pattern().contains("foo"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/")]->fullRegexFile.pattern().contains("foo"));
 
         excludedFiles->addManualExclude("foo/bar", "/tmp/check_csync1/");
-        QVERIFY(excludedFiles->_fullRegexFile[QStringLiteral("/tmp/check_csync1/")].pattern().contains("bar"));
-        QVERIFY(excludedFiles->_fullTraversalRegexFile[QStringLiteral("/tmp/check_csync1/")].pattern().contains("bar"));
-        QVERIFY(!excludedFiles->_bnameTraversalRegexFile[QStringLiteral("/tmp/check_csync1/")].pattern().contains("foo"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/tmp/check_csync1/")]->fullRegexFile.pattern().contains("bar"));
+        QVERIFY(excludedFiles->_patternSets[QStringLiteral("/tmp/check_csync1/")]->fullTraversalRegexFile.pattern().contains("bar"));
+        QVERIFY(!excludedFiles->_patternSets[QStringLiteral("/tmp/check_csync1/")]->bnameTraversalRegexFile.pattern().contains("foo"));
+    }
+
+    void check_csync_exclude_pattern_sets_shared()
+    {
+        ExcludedFiles excludes1(QStringLiteral("/folder1/"));
+        ExcludedFiles excludes2(QStringLiteral("/folder2/"));
+        excludes1.addManualExclude("foo");
+        excludes2.addManualExclude("foo");
+        QVERIFY(excludes1._patternSets[QStringLiteral("/folder1/")]);
+        QVERIFY(excludes1._patternSets[QStringLiteral("/folder1/")] == excludes2._patternSets[QStringLiteral("/folder2/")]);
+
+        // The per-directory patterns are layered on top without touching the shared set
+        const auto sharedSet = excludes1._patternSets[QStringLiteral("/folder1/")];
+        excludes1.addManualExclude("bar/baz", QStringLiteral("/folder1/sub/"));
+        QVERIFY(excludes1._patternSets[QStringLiteral("/folder1/")] == sharedSet);
+        QVERIFY(excludes1.isExcluded("/folder1/sub/bar/baz", "/folder1/", false));
+        QVERIFY(!excludes2.isExcluded("/folder2/sub/bar/baz", "/folder2/", false));
+        QVERIFY(excludes2.isExcluded("/folder2/sub/foo", "/folder2/", false));
+
+        excludes2.addManualExclude("other");
+        QVERIFY(excludes2._patternSets[QStringLiteral("/folder2/")] != sharedSet);
+        QVERIFY(excludes1._patternSets[QStringLiteral("/folder1/")] == sharedSet);
     }
 
     void check_csync_excluded()
@@ -250,6 +250,89 @@ private slots:
         OCC::AccountManager::instance()->deleteAccount(accountState);
     }
 
+    void testBatchedEtagCheck()
+    {
+        QTemporaryDir dir;
+        ConfigFile::setConfDir(dir.path()); // we don't want to pollute the user's config file
+        QVERIFY(dir.isValid());
+
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        const auto accountState = new FakeAccountState(fakeFolder.account());
+        auto folderman = FolderMan::instance();
+
+        // Sibling folders of one account are checked with one request
+        QList<Folder *> folders;
+        for (const auto &name : {QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C")}) {
+            QVERIFY(QDir(dir.path()).mkpath(name));
+            auto definition = folderDefinition(dir.path() + QLatin1Char('/') + name);
+            definition.targetPath = QLatin1Char('/') + name;
+            const auto folder = folderman->addFolder(accountState, definition);
+            QVERIFY(folder);
+            folders.append(folder);
+        }
+        QCOMPARE(folderman->etagBatches(folders).size(), 1);
+
+        QSet<Folder *> scheduled;
+        connect(folderman, &FolderMan::scheduleQueueChanged, this, [&] {
+            const auto queue = folderman->scheduleQueue();
+            for (const auto folder : queue) {
+                scheduled.insert(folder);
+            }
+        });
+        const auto waitUntilIdle = [&] {
+            return folderman->_foldersInEtagBatch.isEmpty() && !folderman->isAnySyncRunning() && folderman->scheduleQueue().isEmpty();
+        };
+        auto batchedRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (request.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QLatin1String("PROPFIND")
+                && request.url().path() == sRootUrl2.path() && request.rawHeader("Depth") == "1") {
+                ++batchedRequests;
+            }
+            return nullptr;
+        });
+
+        // The folders don't know any ETag yet, all of them sync
+        folderman->slotProcessFilesPushNotification(fakeFolder.account().data());
+        QTRY_VERIFY_WITH_TIMEOUT(waitUntilIdle(), 20000);
+        QCOMPARE(batchedRequests, 1);
+        QCOMPARE(scheduled, QSet<Folder *>(folders.begin(), folders.end()));
+
+        // Only the folder whose ETag changed syncs
+        scheduled.clear();
+        batchedRequests = 0;
+        fakeFolder.remoteModifier().insert(QStringLiteral("B/new"));
+        folderman->slotProcessFilesPushNotification(fakeFolder.account().data());
+        QTRY_VERIFY_WITH_TIMEOUT(waitUntilIdle(), 20000);
+        QCOMPARE(batchedRequests, 1);
+        QCOMPARE(scheduled, QSet<Folder *>{folders.at(1)});
+
+        // Nothing changed, nothing syncs
+        scheduled.clear();
+        folderman->slotProcessFilesPushNotification(fakeFolder.account().data());
+        QTRY_VERIFY_WITH_TIMEOUT(waitUntilIdle(), 20000);
+        QVERIFY(scheduled.isEmpty());
+
+        // Without the listing of the parent folder, every folder syncs
+        scheduled.clear();
+        batchedRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (request.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QLatin1String("PROPFIND")
+                && request.url().path() == sRootUrl2.path() && request.rawHeader("Depth") == "1") {
+                ++batchedRequests;
+                return new FakeErrorReply(op, request, this, 500);
+            }
+            return nullptr;
+        });
+        folderman->slotProcessFilesPushNotification(fakeFolder.account().data());
+        QTRY_VERIFY_WITH_TIMEOUT(waitUntilIdle(), 20000);
+        QCOMPARE(batchedRequests, 1);
+        QCOMPARE(scheduled, QSet<Folder *>(folders.begin(), folders.end()));
+
+        for (const auto folder : folders) {
+            folderman->removeFolder(folder);
+        }
+    }
+
     void testCheckPathValidityForNewFolder()
     {
 #ifdef Q_OS_WIN
@@ -180,6 +180,111 @@ private slots:
         QVERIFY(completeSpy.findItem("nofileid")->_errorString.contains("file id"));
         QVERIFY(completeSpy.findItem("nopermissions/A")->_errorString.contains("permission"));
     }
+
+    void testRemoteDeltaDiscovery()
+    {
+        FakeFolder fakeFolder{ FileInfo::A12_B12_C12_S12() };
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._remoteDeltaDiscovery = true;
+        fakeFolder.syncEngine().setSyncOptions(options);
+        QVERIFY(fakeFolder.syncOnce());
+
+        // A new tree, the server gives new entries the current time
+        auto &remote = fakeFolder.remoteModifier();
+        const auto now = QDateTime::currentDateTimeUtc();
+        remote.mkdir("new");
+        remote.mkdir("new/sub");
+        remote.mkdir("new/empty");
+        remote.insert("new/file");
+        remote.insert("new/sub/file");
+        for (const auto path : {"new", "new/sub", "new/empty", "new/file", "new/sub/file"}) {
+            remote.setModTime(path, now);
+        }
+        // Neither moved nor deleted entries are found by the search
+        remote.mkdir("moved");
+        remote.setModTime("moved", now);
+        remote.rename("A/a1", "moved/a1");
+        remote.remove("B/b1");
+        remote.setContents("C/c1", 'N');
+
+        QStringList propfinds;
+        int searches = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation, const QNetworkRequest &req, QIODevice *) -> QNetworkReply * {
+            const auto verb = req.attribute(QNetworkRequest::CustomVerbAttribute).toString();
+            if (verb == QLatin1String("PROPFIND")) {
+                propfinds.append(getFilePathFromUrl(req.url()));
+            } else if (verb == QLatin1String("SEARCH")) {
+                ++searches;
+            }
+            return nullptr;
+        });
+
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(searches, 1);
+        QVERIFY(!propfinds.contains("new"));
+        QVERIFY(!propfinds.contains("new/sub"));
+        QVERIFY(!propfinds.contains("new/empty"));
+        QVERIFY(propfinds.contains("moved"));
+        QVERIFY(propfinds.contains("A"));
+        QVERIFY(propfinds.contains("B"));
+        QVERIFY(propfinds.contains("C"));
+
+        // Without the search every changed directory is listed
+        options._remoteDeltaDiscovery = false;
+        fakeFolder.syncEngine().setSyncOptions(options);
+        remote.mkdir("new2");
+        remote.setModTime("new2", QDateTime::currentDateTimeUtc());
+        propfinds.clear();
+        searches = 0;
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(searches, 0);
+        QVERIFY(propfinds.contains("new2"));
+    }
+
+    void testRemoteDeltaDiscoveryRenames()
+    {
+        FakeFolder fakeFolder{ FileInfo::A12_B12_C12_S12() };
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._remoteDeltaDiscovery = true;
+        fakeFolder.syncEngine().setSyncOptions(options);
+        QVERIFY(fakeFolder.syncOnce());
+
+        // Renames and moves keep the modification time of the entries, only
+        // their parent directories change, and keep their number of entries
+        auto &remote = fakeFolder.remoteModifier();
+        const auto now = QDateTime::currentDateTimeUtc();
+        remote.rename("A/a1", "A/renamed");
+        remote.rename("B/b1", "C/b1");
+        remote.rename("C/c1", "B/c1");
+        for (const auto path : {"A", "B", "C"}) {
+            remote.setModTime(path, now);
+        }
+
+        QStringList propfinds;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation, const QNetworkRequest &req, QIODevice *) -> QNetworkReply * {
+            if (req.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QLatin1String("PROPFIND")) {
+                propfinds.append(getFilePathFromUrl(req.url()));
+            }
+            return nullptr;
+        });
+
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QVERIFY(fakeFolder.currentLocalState().find("A/renamed"));
+        QVERIFY(!fakeFolder.currentLocalState().find("A/a1"));
+        QVERIFY(fakeFolder.currentLocalState().find("B/c1"));
+        QVERIFY(fakeFolder.currentLocalState().find("C/b1"));
+        // The search does not find the renamed entries, so their directories are listed
+        QVERIFY(propfinds.contains("A"));
+        QVERIFY(propfinds.contains("B"));
+        QVERIFY(propfinds.contains("C"));
+
+        // Nothing left to do
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+    }
 };
 
 QTEST_GUILESS_MAIN(TestRemoteDiscovery)
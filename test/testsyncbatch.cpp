@@ -0,0 +1,98 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include <QtTest>
+#include "syncenginetestutils.h"
+#include "cmd/syncbatch.h"
+#include "cmd/synclimiter.h"
+#include <syncengine.h>
+
+using namespace OCC;
+
+class TestSyncBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        OCC::Logger::instance()->setLogFlush(true);
+        OCC::Logger::instance()->setLogDebug(true);
+
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void testAllFoldersFinish_data()
+    {
+        QTest::addColumn<int>("maxConcurrentSyncs");
+
+        QTest::newRow("one at a time") << 1;
+        QTest::newRow("two at a time") << 2;
+        QTest::newRow("all at once") << 4;
+    }
+
+    void testAllFoldersFinish()
+    {
+        QFETCH(int, maxConcurrentSyncs);
+
+        std::vector<std::unique_ptr<FakeFolder>> fakeFolders;
+        for (int i = 0; i < 3; ++i) {
+            auto fakeFolder = std::make_unique<FakeFolder>(FileInfo::A12_B12_C12_S12());
+            fakeFolder->localModifier().insert(QStringLiteral("A/new%1").arg(i));
+            fakeFolder->remoteModifier().appendByte(QStringLiteral("B/b1"));
+            fakeFolders.push_back(std::move(fakeFolder));
+        }
+
+        SyncLimiter limiter(maxConcurrentSyncs);
+        SyncBatch batch(&limiter, 3);
+        auto maxRunning = 0;
+        for (const auto &fakeFolder : fakeFolders) {
+            batch.addEngine(fakeFolder->localPath(), &fakeFolder->syncEngine());
+            connect(&fakeFolder->syncEngine(), &SyncEngine::started, this, [&] {
+                maxRunning = qMax(maxRunning, limiter.runningSyncs());
+            });
+        }
+        QSignalSpy finishedSpy(&batch, &SyncBatch::finished);
+        batch.start();
+
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(finishedSpy.size(), 1);
+        QCOMPARE(finishedSpy.first().first().toBool(), true);
+        QCOMPARE(limiter.runningSyncs(), 0);
+        QVERIFY(maxRunning <= maxConcurrentSyncs);
+        for (const auto &fakeFolder : fakeFolders) {
+            QVERIFY(!fakeFolder->syncEngine().isSyncRunning());
+            QCOMPARE(fakeFolder->currentLocalState(), fakeFolder->currentRemoteState());
+        }
+    }
+
+    void testFailedFolder()
+    {
+        FakeFolder failingFolder{FileInfo::A12_B12_C12_S12()};
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        failingFolder.localModifier().insert(QStringLiteral("A/new"));
+        failingFolder.serverErrorPaths().append(QStringLiteral("A/new"), 500);
+        fakeFolder.localModifier().insert(QStringLiteral("A/new"));
+
+        SyncLimiter limiter(4);
+        SyncBatch batch(&limiter, 3);
+        batch.addEngine(QStringLiteral("failing"), &failingFolder.syncEngine());
+        batch.addEngine(QStringLiteral("working"), &fakeFolder.syncEngine());
+        QSignalSpy finishedSpy(&batch, &SyncBatch::finished);
+        batch.start();
+
+        // The batch still finishes, but reports the failure
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(finishedSpy.first().first().toBool(), false);
+        QCOMPARE(limiter.runningSyncs(), 0);
+        QVERIFY(!failingFolder.currentRemoteState().find("A/new"));
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestSyncBatch)
+#include "testsyncbatch.moc"
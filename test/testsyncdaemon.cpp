@@ -0,0 +1,71 @@
+/*
+ *    This software is in the public domain, furnished "as is", without technical
+ *    support, and with no warranty, express or implied, as to its usefulness for
+ *    any purpose.
+ *
+ */
+
+#include <QtTest>
+#include "syncenginetestutils.h"
+#include "cmd/syncdaemon.h"
+#include <syncengine.h>
+
+using namespace OCC;
+
+class TestSyncDaemon : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        OCC::Logger::instance()->setLogFlush(true);
+        OCC::Logger::instance()->setLogDebug(true);
+
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void testLocalChangeAndRetry()
+    {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+
+        auto failRemoteDiscovery = false;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (failRemoteDiscovery && request.attribute(QNetworkRequest::CustomVerbAttribute).toString() == QLatin1String("PROPFIND")) {
+                return new FakeErrorReply(op, request, this, 500);
+            }
+            return nullptr;
+        });
+
+        SyncDaemon daemon(fakeFolder.account(), &fakeFolder.syncEngine(), &fakeFolder.syncJournal(),
+            fakeFolder.localPath(), QStringLiteral("/"), std::chrono::seconds(1));
+        QSignalSpy finishedSpy(&fakeFolder.syncEngine(), &SyncEngine::finished);
+        const auto lastSyncSucceeded = [&] {
+            return !fakeFolder.syncEngine().isSyncRunning() && !finishedSpy.isEmpty() && finishedSpy.last().at(0).toBool();
+        };
+        const auto lastSyncFailed = [&] {
+            return !fakeFolder.syncEngine().isSyncRunning() && !finishedSpy.isEmpty() && !finishedSpy.last().at(0).toBool();
+        };
+
+        daemon.start();
+        QTRY_VERIFY_WITH_TIMEOUT(lastSyncSucceeded(), 10000);
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+
+        // The local change starts a sync on its own, the server fails it
+        finishedSpy.clear();
+        failRemoteDiscovery = true;
+        fakeFolder.localModifier().appendByte("A/a1");
+        QTRY_VERIFY_WITH_TIMEOUT(lastSyncFailed(), 10000);
+        QVERIFY(fakeFolder.currentLocalState() != fakeFolder.currentRemoteState());
+
+        // Nothing changes anymore and the remote ETag stays the same, the
+        // failed sync is still retried
+        finishedSpy.clear();
+        failRemoteDiscovery = false;
+        QTRY_VERIFY_WITH_TIMEOUT(lastSyncSucceeded(), 10000);
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestSyncDaemon)
+#include "testsyncdaemon.moc"
@@ -11,6 +11,7 @@
 #include "syncenginetestutils.h"
 
 #include "caseclashconflictsolver.h"
+#include "clientsideencryption.h"
 #include "configfile.h"
 #include "propagatorjobs.h"
 #include "syncengine.h"
@@ -85,6 +86,75 @@ int itemSuccessfullyCompletedGetRank(const ItemCompletedSpy &spy, const QString
     return -1;
 }
 
+// Answers the end-to-end encryption API requests of uploads into an encrypted folder
+struct FakeE2eApi
+{
+    int lockRequests = 0;
+    int unlockRequests = 0;
+    int metadataFetches = 0;
+    int metadataStores = 0;
+    std::function<void()> onMetadataFetch;
+
+    QNetworkReply *reply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, QObject *parent)
+    {
+        const auto path = request.url().path();
+        if (!path.contains(QStringLiteral("/apps/end_to_end_encryption/api/"))) {
+            return nullptr;
+        }
+
+        if (path.contains(QStringLiteral("/lock/"))) {
+            if (op == QNetworkAccessManager::PostOperation) {
+                ++lockRequests;
+                return new FakePayloadReply(op, request, R"({"ocs":{"data":{"e2e-token":"token"},"meta":{"statuscode":200}}})", parent);
+            }
+            ++unlockRequests;
+            return new FakePayloadReply(op, request, R"({"ocs":{"data":{},"meta":{"statuscode":200}}})", parent);
+        }
+        if (path.contains(QStringLiteral("/meta-data/"))) {
+            if (op == QNetworkAccessManager::GetOperation) {
+                ++metadataFetches;
+                if (onMetadataFetch) {
+                    onMetadataFetch();
+                }
+                // no metadata yet, the first upload creates it
+                return new FakeErrorReply(op, request, parent, 404);
+            }
+            ++metadataStores;
+            return new FakePayloadReply(op, request, R"({"ocs":{"data":{},"meta":{"statuscode":200}}})", parent);
+        }
+        return new FakeErrorReply(op, request, parent, 404);
+    }
+};
+
+// Syncs an end-to-end encrypted folder "encrypted" and gives the account the keys to upload into it,
+// the server override has to answer the encryption API with FakeE2eApi already
+void setUpEncryptedFolder(FakeFolder &fakeFolder)
+{
+    const auto account = fakeFolder.account();
+    account->setCapabilities({{QStringLiteral("end-to-end-encryption"), QVariantMap{{QStringLiteral("enabled"), true}, {QStringLiteral("api-version"), "2.0"}}}});
+
+    QFile certificate(QStringLiteral("e2etestsfakecert.pem"));
+    QVERIFY(certificate.open(QFile::ReadOnly));
+    account->e2e()->_certificate = QSslCertificate(certificate.readAll());
+    QFile publicKey(QStringLiteral("e2etestsfakecertpublickey.pem"));
+    QVERIFY(publicKey.open(QFile::ReadOnly));
+    account->e2e()->_publicKey = QSslKey(publicKey.readAll(), QSsl::KeyAlgorithm::Rsa, QSsl::EncodingFormat::Pem, QSsl::KeyType::PublicKey);
+    QFile privateKey(QStringLiteral("e2etestsfakecertprivatekey.pem"));
+    QVERIFY(privateKey.open(QFile::ReadOnly));
+    account->e2e()->_privateKey = privateKey.readAll();
+
+    fakeFolder.remoteModifier().mkdir("encrypted");
+    fakeFolder.remoteModifier().setE2EE("encrypted", true);
+    QVERIFY(fakeFolder.syncOnce());
+
+    // Like in the other sync tests, the metadata the server would send for
+    // the folder is not replicated, its journal record is marked directly
+    SyncJournalFileRecord record;
+    QVERIFY(fakeFolder.syncJournal().getFileRecord(QStringLiteral("encrypted"), &record));
+    record._e2eEncryptionStatus = SyncJournalFileRecord::EncryptionStatus::EncryptedMigratedV2_0;
+    QVERIFY(fakeFolder.syncJournal().setFileRecord(record));
+}
+
 }
 
 class TestSyncEngine : public QObject
@@ -114,6 +184,41 @@ private slots:
         QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
     }
 
+    void testNetworkStatistics() {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        auto &statistics = fakeFolder.account()->networkStatistics();
+        statistics.reset();
+        QCOMPARE(statistics.requestCount(), qint64{0});
+
+        qint64 requestCount = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation, const QNetworkRequest &, QIODevice *) -> QNetworkReply * {
+            ++requestCount;
+            return nullptr;
+        });
+        fakeFolder.remoteModifier().insert("A/a0");
+        fakeFolder.remoteModifier().insert("B/b0");
+        fakeFolder.localModifier().insert("C/c0");
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+
+        QVERIFY(requestCount > 0);
+        QCOMPARE(statistics.requestCount(), requestCount);
+        QCOMPARE(statistics.failedRequestCount(), qint64{0});
+        QCOMPARE(statistics.http2RequestCount(), qint64{0});
+        QCOMPARE(statistics.runningRequestCount(), 0);
+        QVERIFY(statistics.maximumRunningRequestCount() >= 1);
+        QVERIFY(statistics.timeToFirstByte().count > 0);
+
+        const auto json = statistics.toJson();
+        QCOMPARE(json.value("requests").toInt(), requestCount);
+        QCOMPARE(json.value("requestsPerVerb").toObject().value("PUT").toInt(), 1);
+        QCOMPARE(json.value("requestsPerVerb").toObject().value("GET").toInt(), 2);
+
+        statistics.reset();
+        QCOMPARE(statistics.requestCount(), qint64{0});
+        QCOMPARE(statistics.toJson().value("requestsPerVerb").toObject().size(), 0);
+    }
+
     void testFileUpload() {
         FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
         ItemCompletedSpy completeSpy(fakeFolder);
@@ -180,6 +285,65 @@ private slots:
         QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
     }
 
+    void testProgressPublishingIsThrottled() {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        for (int i = 0; i < 20; ++i) {
+            fakeFolder.remoteModifier().insert(QStringLiteral("A/new%1").arg(i));
+        }
+
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._minProgressPublishInterval = std::chrono::hours(1);
+        fakeFolder.syncEngine().setSyncOptions(options);
+
+        int propagationUpdates = 0;
+        qint64 completedFilesWhenDone = 0;
+        connect(&fakeFolder.syncEngine(), &SyncEngine::transmissionProgress, this, [&](const ProgressInfo &progress) {
+            if (progress.status() == ProgressInfo::Propagation) {
+                ++propagationUpdates;
+            } else if (progress.status() == ProgressInfo::Done) {
+                completedFilesWhenDone = progress.completedFiles();
+            }
+        });
+
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        // Only the announcement of the propagation phase gets through, everything
+        // else is aggregated and shows up in the final update
+        QCOMPARE(propagationUpdates, 1);
+        QCOMPARE(completedFilesWhenDone, qint64{20});
+    }
+
+    void testThrottledProgressReportsEveryCompletedItem() {
+        FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
+        QSet<QString> expectedFiles;
+        for (int i = 0; i < 20; ++i) {
+            fakeFolder.remoteModifier().insert(QStringLiteral("A/new%1").arg(i));
+            expectedFiles.insert(QStringLiteral("A/new%1").arg(i));
+        }
+        fakeFolder.serverErrorPaths().append("A/new7", 500);
+
+        auto options = fakeFolder.syncEngine().syncOptions();
+        options._minProgressPublishInterval = std::chrono::hours(1);
+        fakeFolder.syncEngine().setSyncOptions(options);
+
+        QStringList reportedFiles;
+        int reportedErrors = 0;
+        connect(&fakeFolder.syncEngine(), &SyncEngine::transmissionProgress, this, [&](const ProgressInfo &progress) {
+            for (const auto &item : progress._completedItems) {
+                reportedFiles.append(item._file);
+                if (item._status == SyncFileItem::NormalError) {
+                    ++reportedErrors;
+                }
+            }
+        });
+
+        QVERIFY(!fakeFolder.syncOnce());
+        // All completions are delivered, each exactly once
+        QCOMPARE(reportedFiles.size(), expectedFiles.size());
+        QCOMPARE(QSet<QString>(reportedFiles.cbegin(), reportedFiles.cend()), expectedFiles);
+        QCOMPARE(reportedErrors, 1);
+    }
+
     void testLocalDelete() {
         FakeFolder fakeFolder{FileInfo::A12_B12_C12_S12()};
         ItemCompletedSpy completeSpy(fakeFolder);
@@ -2021,6 +2185,89 @@ private slots:
 
         QVERIFY(fakeFolder.syncOnce());
     }
+
+    void testEncryptedUploadBatch()
+    {
+        FakeFolder fakeFolder{FileInfo{}};
+        FakeE2eApi e2eApi;
+        int putRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::PutOperation) {
+                ++putRequests;
+                // the second upload of the batch fails
+                if (putRequests == 2) {
+                    return new FakeErrorReply(op, request, this, 500);
+                }
+            }
+            return e2eApi.reply(op, request, this);
+        });
+        setUpEncryptedFolder(fakeFolder);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+        e2eApi = {};
+
+        for (int i = 0; i < 5; ++i) {
+            fakeFolder.localModifier().insert(QStringLiteral("encrypted/file%1").arg(i));
+        }
+
+        ItemCompletedSpy completeSpy(fakeFolder);
+        QVERIFY(!fakeFolder.syncOnce());
+
+        // One lock and one metadata update for all files of the folder
+        QCOMPARE(e2eApi.lockRequests, 1);
+        QCOMPARE(e2eApi.metadataStores, 1);
+        QCOMPARE(e2eApi.unlockRequests, 1);
+        QCOMPARE(putRequests, 5);
+
+        int succeeded = 0;
+        int failed = 0;
+        for (int i = 0; i < 5; ++i) {
+            const auto item = completeSpy.findItem(QStringLiteral("encrypted/file%1").arg(i));
+            QVERIFY(item);
+            if (item->_status == SyncFileItem::Success) {
+                ++succeeded;
+            } else {
+                QCOMPARE(item->_status, SyncFileItem::NormalError);
+                ++failed;
+            }
+        }
+        QCOMPARE(succeeded, 4);
+        QCOMPARE(failed, 1);
+    }
+
+    void testEncryptedUploadBatchAbort()
+    {
+        FakeFolder fakeFolder{FileInfo{}};
+        FakeE2eApi e2eApi;
+        int putRequests = 0;
+        fakeFolder.setServerOverride([&](QNetworkAccessManager::Operation op, const QNetworkRequest &request, QIODevice *) -> QNetworkReply * {
+            if (op == QNetworkAccessManager::PutOperation) {
+                ++putRequests;
+            }
+            return e2eApi.reply(op, request, this);
+        });
+        setUpEncryptedFolder(fakeFolder);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+
+        // The sync is aborted while the batch fetches the metadata of the folder
+        e2eApi = {};
+        e2eApi.onMetadataFetch = [&] {
+            QTimer::singleShot(0, &fakeFolder.syncEngine(), [&]() { fakeFolder.syncEngine().abort(); });
+        };
+
+        for (int i = 0; i < 5; ++i) {
+            fakeFolder.localModifier().insert(QStringLiteral("encrypted/file%1").arg(i));
+        }
+
+        QVERIFY(!fakeFolder.syncOnce());
+        QVERIFY(!fakeFolder.syncEngine().isSyncRunning());
+        QCOMPARE(e2eApi.metadataFetches, 1);
+        QCOMPARE(e2eApi.lockRequests, 0);
+        QCOMPARE(putRequests, 0);
+    }
 };
 
 QTEST_GUILESS_MAIN(TestSyncEngine)
@@ -10,6 +10,7 @@
 
 #include "common/syncjournaldb.h"
 #include "common/syncjournalfilerecord.h"
+#include "common/ownsql.h"
 #include "logger.h"
 
 using namespace OCC;
@@ -172,6 +173,33 @@ private slots:
         QVERIFY(!wipedRecord._valid);
     }
 
+    void testContentChunks()
+    {
+        using Info = SyncJournalDb::ContentChunksInfo;
+        QVERIFY(!_db.getContentChunks("nonexistent")._valid);
+
+        Info info;
+        info._etag = "ABCDEF";
+        info._averageSize = 65536;
+        info._chunks = QByteArray("\x01\x00binary", 8);
+        info._valid = true;
+        _db.setContentChunks("chunks/foo", info);
+        _db.setContentChunks("chunks/bar", info);
+
+        const auto stored = _db.getContentChunks("chunks/foo");
+        QVERIFY(stored._valid);
+        QCOMPARE(stored._etag, info._etag);
+        QCOMPARE(stored._averageSize, info._averageSize);
+        QCOMPARE(stored._chunks, info._chunks);
+
+        _db.setContentChunks("chunks/foo", Info());
+        QVERIFY(!_db.getContentChunks("chunks/foo")._valid);
+
+        // Removed with the records
+        QVERIFY(_db.deleteFileRecord("chunks", true));
+        QVERIFY(!_db.getContentChunks("chunks/bar")._valid);
+    }
+
     void testNumericId()
     {
         SyncJournalFileRecord record;
@@ -324,6 +352,129 @@ private slots:
         QVERIFY(checkElements());
     }
 
+    void testListSubdirectories()
+    {
+        auto makeEntry = [&](const QByteArray &path, ItemType type) {
+            SyncJournalFileRecord record;
+            record._path = path;
+            record._type = type;
+            record._etag = "etag-" + path;
+            record._remotePerm = RemotePermissions::fromDbValue("RWDNVCK");
+            QVERIFY(_db.setFileRecord(record));
+        };
+        makeEntry("tree", ItemTypeDirectory);
+        makeEntry("tree/b", ItemTypeDirectory);
+        makeEntry("tree/a", ItemTypeDirectory);
+        makeEntry("tree/a/deep", ItemTypeDirectory);
+        makeEntry("tree/file", ItemTypeFile);
+        makeEntry("tree/virtual", ItemTypeVirtualFile);
+        makeEntry("tree2", ItemTypeDirectory);
+
+        auto list = [&](const QByteArray &path) {
+            QByteArrayList result;
+            const auto ok = _db.listSubdirectoriesInPath(path, [&](const SyncJournalFileRecord &rec) {
+                QCOMPARE(rec._etag, "etag-" + rec._path);
+                result.append(rec._path);
+            });
+            return ok ? result : QByteArrayList{"error"};
+        };
+        QCOMPARE(list("tree"), (QByteArrayList{"tree/a", "tree/b"}));
+        QCOMPARE(list("tree/a"), QByteArrayList{"tree/a/deep"});
+        QVERIFY(list("tree/b").isEmpty());
+        QVERIFY(list("").contains("tree"));
+        QVERIFY(list("").contains("tree2"));
+        QVERIFY(!list("").contains("tree/a"));
+    }
+
+    void testDirectoryAggregates()
+    {
+        auto makeEntry = [&](const QByteArray &path, ItemType type, qint64 size, qint64 modtime) {
+            SyncJournalFileRecord record;
+            record._path = path;
+            record._type = type;
+            record._fileSize = size;
+            record._modtime = modtime;
+            record._etag = "etag";
+            record._remotePerm = RemotePermissions::fromDbValue("RWDNVCK");
+            QVERIFY(_db.setFileRecord(record));
+        };
+        auto aggregate = [&](const QString &path) {
+            const auto aggregate = _db.getDirectoryAggregate(path);
+            return aggregate._valid ? QVector<qint64>{aggregate._size, aggregate._fileCount, aggregate._latestModtime} : QVector<qint64>{};
+        };
+        const auto rootBefore = _db.getDirectoryAggregate(QString());
+        QVERIFY(rootBefore._valid);
+
+        makeEntry("totals", ItemTypeDirectory, 0, 1);
+        makeEntry("totals/a", ItemTypeFile, 10, 100);
+        makeEntry("totals/sub", ItemTypeDirectory, 0, 1);
+        makeEntry("totals/sub/b", ItemTypeFile, 20, 200);
+        makeEntry("totals/sub/placeholder", ItemTypeVirtualFile, 40, 50);
+        QCOMPARE(aggregate("totals"), (QVector<qint64>{70, 2, 200}));
+        QCOMPARE(aggregate("totals/sub"), (QVector<qint64>{60, 1, 200}));
+        QCOMPARE(aggregate("totals/empty"), (QVector<qint64>{0, 0, 0}));
+
+        const auto rootAfter = _db.getDirectoryAggregate(QString());
+        QCOMPARE(rootAfter._size - rootBefore._size, 70);
+        QCOMPARE(rootAfter._fileCount - rootBefore._fileCount, 2);
+
+        // Changing a file replaces its share
+        makeEntry("totals/sub/b", ItemTypeFile, 25, 300);
+        QCOMPARE(aggregate("totals"), (QVector<qint64>{75, 2, 300}));
+        QVERIFY(_db.updateLocalMetadata("totals/a", 100, 5, 0, {}));
+        QCOMPARE(aggregate("totals"), (QVector<qint64>{70, 2, 300}));
+        makeEntry("totals/sub/placeholder", ItemTypeFile, 40, 50);
+        QCOMPARE(aggregate("totals/sub"), (QVector<qint64>{65, 2, 300}));
+
+        QVERIFY(_db.deleteFileRecord("totals/a"));
+        QCOMPARE(aggregate("totals"), (QVector<qint64>{65, 2, 300}));
+        QVERIFY(_db.deleteFileRecord("totals/sub", true));
+        QCOMPARE(aggregate("totals"), (QVector<qint64>{0, 0, 300}));
+        QCOMPARE(aggregate("totals/sub"), (QVector<qint64>{0, 0, 0}));
+        QCOMPARE(_db.getDirectoryAggregate(QString())._size, rootBefore._size);
+    }
+
+    void testFilenameIndex()
+    {
+        if (!_db.isFilenameIndexAvailable()) {
+            QSKIP("SQLite has no trigram tokenizer");
+        }
+
+        auto makeEntry = [&](const QByteArray &path, ItemType type) {
+            SyncJournalFileRecord record;
+            record._path = path;
+            record._type = type;
+            record._etag = "etag";
+            record._remotePerm = RemotePermissions::fromDbValue("RWDNVCK");
+            QVERIFY(_db.setFileRecord(record));
+        };
+        makeEntry("search", ItemTypeDirectory);
+        makeEntry("search/Quarterly Report.pdf", ItemTypeFile);
+        makeEntry("search/reports", ItemTypeDirectory);
+        makeEntry("search/reports/report-2025.ods", ItemTypeFile);
+        makeEntry("search/other/holiday.jpg", ItemTypeFile);
+
+        auto find = [&](const QString &term) {
+            QByteArrayList result;
+            const auto ok = _db.findFileRecordsByName(term, 10, [&](const SyncJournalFileRecord &rec) {
+                result.append(rec._path);
+            });
+            result.sort();
+            return ok ? result : QByteArrayList{"error"};
+        };
+        QCOMPARE(find("REPORT"), (QByteArrayList{"search/Quarterly Report.pdf", "search/reports", "search/reports/report-2025.ods"}));
+        QCOMPARE(find("2025.o"), QByteArrayList{"search/reports/report-2025.ods"});
+        // only the names are indexed, not the whole paths
+        QCOMPARE(find("search"), QByteArrayList{"search"});
+        QVERIFY(find("re").isEmpty());
+        QVERIFY(find("\"rep").isEmpty());
+
+        QVERIFY(_db.deleteFileRecord("search/reports", true));
+        QCOMPARE(find("report"), QByteArrayList{"search/Quarterly Report.pdf"});
+        QVERIFY(_db.deleteFileRecord("search/other/holiday.jpg"));
+        QVERIFY(find("holiday").isEmpty());
+    }
+
     void testPinState()
     {
         auto make = [&](const QByteArray &path, PinState state) {
@@ -448,6 +599,14 @@ private slots:
         list = _db.internalPinStates().rawList();
         QCOMPARE(list->size(), 4 + 9 + 27 - 4);
 
+        // Reopening reads the pin states from the database again
+        _db.close();
+        QCOMPARE(getRaw("local"), PinState::AlwaysLocal);
+        QCOMPARE(getRaw("local/local"), PinState::Inherited);
+        QCOMPARE(get("online/local/inherit"), PinState::AlwaysLocal);
+        QCOMPARE(getRecursive("online"), PinState::Inherited);
+        QCOMPARE(getRecursive("inherit/online/inherit"), PinState::OnlineOnly);
+
         // Wiping everything
         _db.internalPinStates().wipeForPathAndBelow("");
         QCOMPARE(getRaw(""), PinState::Inherited);
@@ -457,6 +616,45 @@ private slots:
         QCOMPARE(list->size(), 0);
     }
 
+    void testSchemaVersion()
+    {
+        const auto userVersion = [this] {
+            SqlDatabase db;
+            db.openOrCreateReadWrite(_db.databaseFilePath());
+            SqlQuery query(db);
+            query.prepare("PRAGMA user_version;");
+            query.exec();
+            query.next();
+            return query.intValue(0);
+        };
+
+        QVERIFY(_db.open());
+        _db.close();
+        QVERIFY(userVersion() > 0);
+
+        // Pretend the database was created by a client that predates the schema version
+        {
+            SqlDatabase db;
+            QVERIFY(db.openOrCreateReadWrite(_db.databaseFilePath()));
+            SqlQuery query(db);
+            query.prepare("DROP TABLE conflicts;");
+            QVERIFY(query.exec());
+            query.prepare("PRAGMA user_version = 0;");
+            QVERIFY(query.exec() && query.next().ok);
+        }
+        QCOMPARE(userVersion(), 0);
+
+        // The schema is verified again and the missing table created
+        ConflictRecord record;
+        record.path = "abc";
+        record.baseFileId = "def";
+        _db.setConflictRecord(record);
+        QVERIFY(_db.conflictRecord(record.path).isValid());
+        _db.deleteConflictRecord(record.path);
+        _db.close();
+        QVERIFY(userVersion() > 0);
+    }
+
 private:
     SyncJournalDb _db;
 };
@@ -9,6 +9,7 @@
 #include "common/result.h"
 #include "syncenginetestutils.h"
 #include <syncengine.h>
+#include <renamedpathtree.h>
 
 using namespace OCC;
 
@@ -106,6 +107,37 @@ private slots:
         QStandardPaths::setTestModeEnabled(true);
     }
 
+    void testRenamedPathTree()
+    {
+        RenamedPathTree tree;
+        QVERIFY(tree.isEmpty());
+        QCOMPARE(tree.adjustedPath("A/B/file"), QStringLiteral("A/B/file"));
+
+        tree.insert("A/B", "C/D");
+        QVERIFY(tree.contains("A/B"));
+        QVERIFY(!tree.contains("A"));
+        QVERIFY(!tree.contains("A/B/file"));
+        QCOMPARE(tree.adjustedPath("A/B/file"), QStringLiteral("C/D/file"));
+        QCOMPARE(tree.adjustedPath("A/B/sub/file"), QStringLiteral("C/D/sub/file"));
+        // Only parent renames are considered
+        QCOMPARE(tree.adjustedPath("A/B"), QStringLiteral("A/B"));
+        QCOMPARE(tree.adjustedPath("A/BB/file"), QStringLiteral("A/BB/file"));
+
+        // The deepest renamed parent wins
+        tree.insert("A/B/sub", "E");
+        QCOMPARE(tree.adjustedPath("A/B/sub/file"), QStringLiteral("E/file"));
+        QCOMPARE(tree.adjustedPath("A/B/other"), QStringLiteral("C/D/other"));
+
+        // Re-inserting replaces the target
+        tree.insert("A/B", "F");
+        QCOMPARE(tree.size(), 2);
+        QCOMPARE(tree.adjustedPath("A/B/other"), QStringLiteral("F/other"));
+
+        tree.clear();
+        QVERIFY(!tree.contains("A/B"));
+        QCOMPARE(tree.adjustedPath("A/B/file"), QStringLiteral("A/B/file"));
+    }
+
     void testMoveCustomRemoteRoot()
     {
         FileInfo subFolder(QStringLiteral("AS"), { { QStringLiteral("f1"), 4 } });
@@ -320,6 +352,40 @@ private slots:
         QCOMPARE(printDbData(fakeFolder.dbState()), printDbData(remoteInfo));
     }
 
+    void testLocalMoveDetectionManyChecksums()
+    {
+        FakeFolder fakeFolder{{}};
+        fakeFolder.localModifier().mkdir("A");
+        const auto fileCount = 10;
+        for (int i = 0; i < fileCount; ++i) {
+            fakeFolder.localModifier().insert(QStringLiteral("A/file%1").arg(i), 100);
+        }
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+
+        OperationCounter counter;
+        fakeFolder.setServerOverride(counter.functor());
+
+        // All files are move candidates, the checksums computed in the background
+        // tell the real moves from the changed files
+        for (int i = 0; i < fileCount; ++i) {
+            const auto name = QStringLiteral("A/file%1").arg(i);
+            const auto movedName = QStringLiteral("A/moved%1").arg(i);
+            const auto mtime = fakeFolder.remoteModifier().find(name)->lastModified;
+            fakeFolder.localModifier().rename(name, movedName);
+            if (i % 2) {
+                fakeFolder.localModifier().setContents(movedName, 'C');
+                fakeFolder.localModifier().setModTime(movedName, mtime);
+            }
+        }
+        QVERIFY(fakeFolder.syncOnce());
+        QCOMPARE(counter.nMOVE, fileCount / 2);
+        QCOMPARE(counter.nPUT, fileCount / 2);
+        QCOMPARE(counter.nDELETE, fileCount / 2);
+        QCOMPARE(fakeFolder.currentLocalState(), fakeFolder.currentRemoteState());
+        QCOMPARE(printDbData(fakeFolder.dbState()), printDbData(fakeFolder.remoteModifier()));
+    }
+
     void testLocalExternalStorageRenameDetection()
     {
         FakeFolder fakeFolder{{}};